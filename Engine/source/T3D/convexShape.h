@@ -173,6 +173,7 @@ public:
    virtual void buildConvex( const Box3F &box, Convex *convex );
    virtual bool buildPolyList( PolyListContext context, AbstractPolyList *polyList, const Box3F &box, const SphereF &sphere );
    virtual bool castRay( const Point3F &start, const Point3F &end, RayInfo *info );
+   virtual bool isCastRayThreadSafe() const { return true; }
    virtual bool collideBox( const Point3F &start, const Point3F &end, RayInfo *info );
 
 
@@ -136,6 +136,7 @@ void ExtendedMoveList::collectMove()
       if(!mConnection->isPlayingBack() && getNextExtMove(mv))
       {
          mv.checksum=Move::ChecksumMismatch;
+         mConnection->recordDemoTick();
          pushMove(mv);
          mConnection->recordBlock(GameConnection::BlockTypeMove, sizeof(ExtendedMove), &mv);
       }
@@ -53,8 +53,8 @@
 
 #define ControlRequestTime 5000
 
-const U32 GameConnection::CurrentProtocolVersion = 12;
-const U32 GameConnection::MinRequiredProtocolVersion = 12;
+const U32 GameConnection::CurrentProtocolVersion = 13;
+const U32 GameConnection::MinRequiredProtocolVersion = 13;
 
 //----------------------------------------------------------------------------
 
@@ -208,6 +208,7 @@ GameConnection::GameConnection()
    mUpdateCameraFov = false;
 
    mAIControlled = false;
+   mSimulatedClient = false;
 
    mDisconnectReason[0] = 0;
 
@@ -315,7 +316,8 @@ void GameConnection::onConnectionEstablished(bool isInitiator)
       setSendingEvents(true);
       setTranslatesStrings(true);
       setIsConnectionToServer();
-      mServerConnection = this;
+      if(!mSimulatedClient)
+         mServerConnection = this;
       Con::printf("Connection established %d", getId());
       onConnectionAccepted_callback();
    }
@@ -818,6 +820,9 @@ void GameConnection::handleRecordedBlock(U32 type, U32 size, void *data)
    switch(type)
    {
       case BlockTypeMove:
+         advanceDemoReadTick();
+         if(isRecording())
+            recordDemoTick();
          mMoveList->pushMove(*((Move *) data));
          if(isRecording()) // put it back into the stream
             recordBlock(type, size, data);
@@ -876,7 +881,31 @@ void GameConnection::writeDemoStartBlock(ResizeBitStream *stream)
    Parent::writeDemoStartBlock(stream);
 
    stream->validate();
+   writeDemoControlObjects(stream);
+}
+
+void GameConnection::writeDemoKeyframe(ResizeBitStream *stream)
+{
+   // same as the start block, minus the datablocks, mission and
+   // demo vars which don't change during a recording.
+   stream->write(mFirstPerson);
+   stream->write(mCameraPos);
+   stream->write(mCameraSpeed);
 
+   // Control scheme
+   stream->write(mAbsoluteRotation);
+   stream->write(mAddYawToAbsRot);
+   stream->write(mAddPitchToAbsRot);
+
+   mMoveList->writeDemoStartBlock(stream);
+   Parent::writeDemoKeyframe(stream);
+
+   stream->validate();
+   writeDemoControlObjects(stream);
+}
+
+void GameConnection::writeDemoControlObjects(ResizeBitStream *stream)
+{
    // dump out the control object ghost id
    S32 idx = mControlObject ? getGhostIndex(mControlObject) : -1;
    stream->write(idx);
@@ -954,6 +983,32 @@ bool GameConnection::readDemoStartBlock(BitStream *stream)
       setDataField(slotName, array, value);
    }
    bool ret = Parent::readDemoStartBlock(stream);
+   readDemoControlObjects(stream);
+   return ret;
+}
+
+bool GameConnection::readDemoKeyframe(BitStream *stream)
+{
+   stream->read(&mFirstPerson);
+   stream->read(&mCameraPos);
+   stream->read(&mCameraSpeed);
+
+   // Control scheme
+   stream->read(&mAbsoluteRotation);
+   stream->read(&mAddYawToAbsRot);
+   stream->read(&mAddPitchToAbsRot);
+
+   mMoveList->readDemoStartBlock(stream);
+
+   if(!Parent::readDemoKeyframe(stream))
+      return false;
+
+   readDemoControlObjects(stream);
+   return true;
+}
+
+void GameConnection::readDemoControlObjects(BitStream *stream)
+{
    // grab the control object
    S32 idx;
    stream->read(&idx);
@@ -976,7 +1031,6 @@ bool GameConnection::readDemoStartBlock(BitStream *stream)
       setCameraObject(obj);
       obj->readPacketData(this, stream);
    }
-   return ret;
 }
 
 void GameConnection::demoPlaybackComplete()
@@ -986,6 +1040,24 @@ void GameConnection::demoPlaybackComplete()
    Parent::demoPlaybackComplete();
 }
 
+bool GameConnection::seekDemo(U32 tick)
+{
+   PROFILE_SCOPE(GameConnection_SeekDemo);
+
+   if(!seekDemoKeyframe(tick))
+      return false;
+
+   // play forward from the keyframe; playback may end and delete us
+   // on the way.
+   SimObjectPtr<GameConnection> safePtr = this;
+   ClientProcessList *processList = ClientProcessList::get();
+   U32 ticks = tick - getDemoReadTick();
+   while(ticks-- && safePtr && isPlayingBack() && getDemoReadTick() < tick)
+      processList->advanceTime(TickMs);
+
+   return !safePtr.isNull();
+}
+
 void GameConnection::ghostPreRead(NetObject * nobj, bool newGhost)
 {
    Parent::ghostPreRead( nobj, newGhost );
@@ -1830,6 +1902,29 @@ DefineEngineMethod( GameConnection, isAIControlled, bool, (),,
    return object->isAIControlled();
 }
 
+DefineEngineMethod( GameConnection, setSimulatedClient, void, (bool simulated),,
+   "@brief Mark this connection as made on behalf of a simulated client.\n\n"
+
+   "Simulated client connections never become the connection to the server, so any number of "
+   "them can be connected from one process.  Remote commands received on them are run with the "
+   "connection temporarily set as the connection to the server, so that commandToServer() replies "
+   "on the same connection.  Must be called before connecting.\n\n"
+
+   "@param simulated True to mark the connection as simulated.\n\n"
+
+   "@see GameConnection::isSimulatedClient()")
+{
+   object->setSimulatedClient(simulated);
+}
+
+DefineEngineMethod( GameConnection, isSimulatedClient, bool, (),,
+   "@brief Returns true if this connection was made on behalf of a simulated client.\n\n"
+
+   "@see GameConnection::setSimulatedClient()")
+{
+   return object->isSimulatedClient();
+}
+
 DefineEngineMethod( GameConnection, isControlObjectRotDampedCamera, bool, (),,
    "@brief Returns true if the object being controlled by the client is making use "
    "of a rotation damped camera.\n\n"
@@ -2111,6 +2206,42 @@ DefineEngineMethod( GameConnection, isDemoRecording, bool, (),,
    return object->isRecording();
 }
 
+DefineEngineMethod( GameConnection, seekDemo, bool, (S32 tick),,
+   "@brief Jump to the given tick of the demo being played back.\n\n"
+
+   "Playback restores the closest keyframe before the tick and plays forward from there, so "
+   "seeking costs at most $Net::demoKeyframeInterval ticks of playback.\n\n"
+
+   "@param tick The tick to jump to, counted from the start of the demo.\n"
+   "@returns True if the demo is now at the given tick.  False if the demo has no seek index, "
+   "or if reading the keyframe failed, in which case playback is stopped.\n\n"
+
+   "@see GameConnection::getDemoTick(), GameConnection::getDemoLength()")
+{
+   if(!object->isPlayingBack() || tick < 0)
+      return false;
+
+   return object->seekDemo(tick);
+}
+
+DefineEngineMethod( GameConnection, getDemoTick, S32, (),,
+   "@brief Returns the number of ticks played back from the current demo.\n\n"
+
+   "@see GameConnection::seekDemo()")
+{
+   return object->getDemoReadTick();
+}
+
+DefineEngineMethod( GameConnection, getDemoLength, S32, (),,
+   "@brief Returns the number of ticks in the demo being played back.\n\n"
+
+   "@returns The length of the demo in ticks, or 0 if the demo has no seek index.\n\n"
+
+   "@see GameConnection::seekDemo()")
+{
+   return object->getDemoTickCount();
+}
+
 DefineEngineMethod( GameConnection, listClassIDs, void, (),,
    "@brief List all of the classes that this connection knows about, and what their IDs are. Useful for debugging network problems.\n\n"
    "@note The list is sent to the console.\n\n")
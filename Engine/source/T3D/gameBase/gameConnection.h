@@ -117,6 +117,10 @@ public:
    ///
    /// Torque SDK 1.1 uses protocol = 2
    /// Torque SDK 1.4 uses protocol = 12
+   ///
+   /// Protocol 13 adds the packet compression flag after the packet header
+   /// and the snapshot delta flag to ghost updates.  It also adds the
+   /// animation throttle settings to ShapeBaseData and TSStatic updates.
    /// @{
    static const U32 CurrentProtocolVersion;
    static const U32 MinRequiredProtocolVersion;
@@ -190,6 +194,10 @@ protected:
    bool        mAIControlled;
    AuthInfo *  mAuthInfo;
 
+   /// True for connections to the server made on behalf of a simulated
+   /// client.  They never become the connection to the server.
+   bool        mSimulatedClient;
+
    static S32  mLagThresholdMS;
    S32         mLastPacketTime;
    bool        mLagging;
@@ -219,7 +227,13 @@ protected:
 
    void writeDemoStartBlock   (ResizeBitStream *stream);
    bool readDemoStartBlock    (BitStream *stream);
+   void writeDemoKeyframe     (ResizeBitStream *stream);
+   bool readDemoKeyframe      (BitStream *stream);
    void handleRecordedBlock   (U32 type, U32 size, void *data);
+
+   /// Write/read the control and camera objects for the start block and keyframes.
+   void writeDemoControlObjects(ResizeBitStream *stream);
+   void readDemoControlObjects (BitStream *stream);
    /// @}
    void ghostWriteExtra(NetObject *,BitStream *);
    void ghostReadExtra(NetObject *,BitStream *, bool newGhost);
@@ -342,9 +356,16 @@ public:
    bool isFirstPerson() const  { return mCameraPos == 0; }
    bool isAIControlled() { return mAIControlled; }
 
+   bool isSimulatedClient() const { return mSimulatedClient; }
+   void setSimulatedClient(bool simulated) { mSimulatedClient = simulated; }
+
    void doneScopingScene();
    void demoPlaybackComplete();
 
+   /// Jump to @a tick in the demo being played back.  Restores the closest
+   /// keyframe before it and plays the remaining ticks forward.
+   bool seekDemo(U32 tick);
+
    void setMissionCRC(U32 crc)           { mMissionCRC = crc; }
    U32  getMissionCRC()           { return(mMissionCRC); }
    /// @}
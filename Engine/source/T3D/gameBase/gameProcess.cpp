@@ -26,6 +26,9 @@
 #include "T3D/gameBase/gameBase.h"
 #include "T3D/gameBase/gameConnection.h"
 #include "T3D/gameBase/moveList.h"
+#include "T3D/lagCompensation.h"
+#include "console/consoleTypes.h"
+#include "core/module.h"
 
 //----------------------------------------------------------------------------
 
@@ -132,7 +135,24 @@ void ClientProcessList::onPreTickObject( ProcessObject *pobj )
 // ServerProcessList
 //--------------------------------------------------------------------------
    
+F32 ServerProcessList::smTickTimeAvg = 0.0f;
+S32 ServerProcessList::smTickTimeMax = 0;
+
+AFTER_MODULE_INIT( Sim )
+{
+   Con::addVariable( "$Stats::serverTickMs", TypeF32, &ServerProcessList::smTickTimeAvg,
+      "Average real time in milliseconds the server spent per tick over the last second.\n"
+      "@ingroup Game\n" );
+   Con::addVariable( "$Stats::serverTickMaxMs", TypeS32, &ServerProcessList::smTickTimeMax,
+      "Longest real time in milliseconds the server spent on a tick over the last second.\n"
+      "@ingroup Game\n" );
+}
+
 ServerProcessList::ServerProcessList()
+   : mTickTimeWindowStart( 0 ),
+     mTickTimeTotal( 0 ),
+     mTickTimeCount( 0 ),
+     mTickTimeWindowMax( 0 )
 {
 }
 
@@ -171,14 +191,48 @@ void ServerProcessList::advanceObjects()
    Con::printf("Advance server time...");
    #endif
 
+   const U32 startTime = Platform::getRealMilliseconds();
+
    Parent::advanceObjects();
 
+   LagCompensation::recordTick( getTotalTicks() );
+
+   _updateTickTime( Platform::getRealMilliseconds() - startTime );
+
    #ifdef TORQUE_DEBUG_NET_MOVES
    Con::printf("---------");
    #endif
 }
 
+void ServerProcessList::_updateTickTime( U32 elapsedMs )
+{
+   mTickTimeTotal += elapsedMs;
+   mTickTimeCount++;
+   mTickTimeWindowMax = getMax( mTickTimeWindowMax, elapsedMs );
+
+   const U32 time = Platform::getRealMilliseconds();
+   if ( time - mTickTimeWindowStart < 1000 )
+      return;
+
+   smTickTimeAvg = F32( mTickTimeTotal ) / F32( mTickTimeCount );
+   smTickTimeMax = mTickTimeWindowMax;
+
+   mTickTimeWindowStart = time;
+   mTickTimeTotal = 0;
+   mTickTimeCount = 0;
+   mTickTimeWindowMax = 0;
+}
+
 void ServerProcessList::onPreTickObject( ProcessObject *pobj )
 {
 }
 
+bool ServerProcessList::allowParallelTicks() const
+{
+   #ifdef TORQUE_MULTITHREAD
+   return smParallelTicks;
+   #else
+   return false;
+   #endif
+}
+
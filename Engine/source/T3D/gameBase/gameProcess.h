@@ -81,11 +81,25 @@ public:
 
    static ServerProcessList* get() { return smServerProcessList; }
 
+   /// Average and longest real time in milliseconds spent per tick over
+   /// the last second.
+   static F32 smTickTimeAvg;
+   static S32 smTickTimeMax;
+
 protected:
 
    // ProcessList
    void onPreTickObject( ProcessObject *pobj );
    void advanceObjects();
+   bool allowParallelTicks() const;
+
+   /// Add a tick taking @a elapsedMs to the tick time statistics.
+   void _updateTickTime( U32 elapsedMs );
+
+   U32 mTickTimeWindowStart;
+   U32 mTickTimeTotal;
+   U32 mTickTimeCount;
+   U32 mTickTimeWindowMax;
 
 protected:
 
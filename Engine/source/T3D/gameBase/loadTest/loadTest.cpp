@@ -0,0 +1,392 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "T3D/gameBase/loadTest/loadTest.h"
+
+#include "T3D/gameBase/gameProcess.h"
+#include "T3D/gameBase/moveList.h"
+#include "T3D/gameBase/moveManager.h"
+#include "console/consoleTypes.h"
+#include "console/engineAPI.h"
+#include "math/mRandom.h"
+#include "platform/profiler.h"
+
+
+IMPLEMENT_CONOBJECT( LoadTest );
+
+ConsoleDocClass( LoadTest,
+   "@brief Spawns simulated clients to load test a server.\n\n"
+
+   "LoadTest opens a number of GameConnections to a server from within a single process.  "
+   "Each connection is marked as a simulated client, so that it never replaces the "
+   "connection to the server, and sends one move per tick once it is established.  Moves "
+   "are generated by the onClientMove() callback when it is defined, which may set the "
+   "usual $mv* variables, or otherwise by a simple built-in wander pattern.\n\n"
+
+   "It is intended to be run from a headless client built with the TORQUE_LOADTEST option, "
+   "which uses the null GFX and SFX devices.\n\n"
+
+   "@tsexample\n"
+   "new LoadTest( ServerLoad )\n"
+   "{\n"
+   "   address = \"IP:127.0.0.1:28000\";\n"
+   "   numClients = 64;\n"
+   "};\n"
+   "ServerLoad.start();\n"
+   "@endtsexample\n\n"
+
+   "@see GameConnection::setSimulatedClient()\n\n"
+
+   "@ingroup Networking\n"
+);
+
+IMPLEMENT_CALLBACK( LoadTest, onClientMove, void, ( GameConnection *client, S32 tick ), ( client, tick ),
+   "@brief Called once per tick for every established client, before its move is collected.\n\n"
+   "All $mv* variables are cleared before the call.\n"
+   "@param client The simulated client connection.\n"
+   "@param tick Number of ticks since the test was started.\n" );
+
+IMPLEMENT_CALLBACK( LoadTest, onReport, void, ( S32 connected, F32 bytesSent, F32 bytesReceived, F32 ghosts, F32 packetLoss ),
+   ( connected, bytesSent, bytesReceived, ghosts, packetLoss ),
+   "@brief Called by report() with the statistics gathered since the previous report.\n\n"
+   "@param connected Number of established clients.\n"
+   "@param bytesSent Average bytes per second sent by each client.\n"
+   "@param bytesReceived Average bytes per second received by each client.\n"
+   "@param ghosts Average number of ghosts per client.\n"
+   "@param packetLoss Average packet loss per client, from 0 to 1.\n" );
+
+
+namespace
+{
+   /// The MoveManager input state is global, so it is saved before
+   /// generating the simulated moves and restored afterwards to leave
+   /// any real local client untouched.
+   struct MoveManagerState
+   {
+      F32 actions[6];
+      F32 speeds[6];
+      F32 pitch, yaw, roll;
+      F32 axes[4];
+      bool freeLook;
+      U32 triggerCount[MaxTriggerKeys];
+      U32 prevTriggerCount[MaxTriggerKeys];
+
+      void save()
+      {
+         actions[0] = MoveManager::mForwardAction;
+         actions[1] = MoveManager::mBackwardAction;
+         actions[2] = MoveManager::mUpAction;
+         actions[3] = MoveManager::mDownAction;
+         actions[4] = MoveManager::mLeftAction;
+         actions[5] = MoveManager::mRightAction;
+         speeds[0] = MoveManager::mPitchUpSpeed;
+         speeds[1] = MoveManager::mPitchDownSpeed;
+         speeds[2] = MoveManager::mYawLeftSpeed;
+         speeds[3] = MoveManager::mYawRightSpeed;
+         speeds[4] = MoveManager::mRollLeftSpeed;
+         speeds[5] = MoveManager::mRollRightSpeed;
+         pitch = MoveManager::mPitch;
+         yaw = MoveManager::mYaw;
+         roll = MoveManager::mRoll;
+         axes[0] = MoveManager::mXAxis_L;
+         axes[1] = MoveManager::mYAxis_L;
+         axes[2] = MoveManager::mXAxis_R;
+         axes[3] = MoveManager::mYAxis_R;
+         freeLook = MoveManager::mFreeLook;
+         dMemcpy( triggerCount, MoveManager::mTriggerCount, sizeof( triggerCount ) );
+         dMemcpy( prevTriggerCount, MoveManager::mPrevTriggerCount, sizeof( prevTriggerCount ) );
+      }
+
+      void restore() const
+      {
+         MoveManager::mForwardAction = actions[0];
+         MoveManager::mBackwardAction = actions[1];
+         MoveManager::mUpAction = actions[2];
+         MoveManager::mDownAction = actions[3];
+         MoveManager::mLeftAction = actions[4];
+         MoveManager::mRightAction = actions[5];
+         MoveManager::mPitchUpSpeed = speeds[0];
+         MoveManager::mPitchDownSpeed = speeds[1];
+         MoveManager::mYawLeftSpeed = speeds[2];
+         MoveManager::mYawRightSpeed = speeds[3];
+         MoveManager::mRollLeftSpeed = speeds[4];
+         MoveManager::mRollRightSpeed = speeds[5];
+         MoveManager::mPitch = pitch;
+         MoveManager::mYaw = yaw;
+         MoveManager::mRoll = roll;
+         MoveManager::mXAxis_L = axes[0];
+         MoveManager::mYAxis_L = axes[1];
+         MoveManager::mXAxis_R = axes[2];
+         MoveManager::mYAxis_R = axes[3];
+         MoveManager::mFreeLook = freeLook;
+         dMemcpy( MoveManager::mTriggerCount, triggerCount, sizeof( triggerCount ) );
+         dMemcpy( MoveManager::mPrevTriggerCount, prevTriggerCount, sizeof( prevTriggerCount ) );
+      }
+
+      void clear()
+      {
+         dMemset( this, 0, sizeof( *this ) );
+      }
+   };
+}
+
+
+LoadTest::LoadTest()
+   :  mAddress( "IP:127.0.0.1:28000" ),
+      mNumClients( 16 ),
+      mConnectInterval( 100 ),
+      mReportInterval( 5000 ),
+      mRunning( false ),
+      mTick( 0 ),
+      mNextConnectTime( 0 ),
+      mLastReportTime( 0 )
+{
+}
+
+LoadTest::~LoadTest()
+{
+}
+
+void LoadTest::initPersistFields()
+{
+   addField( "address", TypeRealString, Offset( mAddress, LoadTest ),
+      "Address of the server to connect the simulated clients to." );
+   addField( "numClients", TypeS32, Offset( mNumClients, LoadTest ),
+      "Number of simulated clients to connect." );
+   addField( "connectInterval", TypeS32, Offset( mConnectInterval, LoadTest ),
+      "Milliseconds between successive client connection attempts." );
+   addField( "reportInterval", TypeS32, Offset( mReportInterval, LoadTest ),
+      "Milliseconds between automatic calls to report(), or 0 to disable them." );
+
+   Parent::initPersistFields();
+}
+
+void LoadTest::onRemove()
+{
+   stop();
+   Parent::onRemove();
+}
+
+void LoadTest::start()
+{
+   if ( mRunning )
+      return;
+
+   mRunning = true;
+   mTick = 0;
+   mNextConnectTime = Platform::getRealMilliseconds();
+   mLastReportTime = mNextConnectTime;
+
+   ClientProcessList::get()->postTickSignal().notify( this, &LoadTest::_onClientTick );
+}
+
+void LoadTest::stop()
+{
+   if ( !mRunning )
+      return;
+
+   ClientProcessList::get()->postTickSignal().remove( this, &LoadTest::_onClientTick );
+   mRunning = false;
+
+   for ( U32 i = 0; i < mClients.size(); i++ )
+   {
+      GameConnection *conn = mClients[i].connection;
+      if ( conn )
+         conn->deleteObject();
+   }
+   mClients.clear();
+}
+
+void LoadTest::_connectClient()
+{
+   NetAddress addr;
+   if ( !Net::stringToAddress( mAddress, &addr ) )
+   {
+      Con::errorf( "LoadTest::_connectClient - invalid address: %s", mAddress.c_str() );
+      stop();
+      return;
+   }
+
+   char name[32];
+   dSprintf( name, sizeof( name ), "LoadTest%d", mClients.size() );
+   const char *args[] = { name };
+
+   GameConnection *conn = new GameConnection;
+   conn->setSimulatedClient( true );
+   conn->setConnectArgs( 1, args );
+   if ( !conn->registerObject() )
+   {
+      delete conn;
+      return;
+   }
+
+   ClientState state;
+   state.connection = conn;
+   state.lastBytesSent = 0;
+   state.lastBytesReceived = 0;
+   state.turnRate = 0.0f;
+   mClients.push_back( state );
+
+   conn->connect( &addr );
+}
+
+void LoadTest::_generateMove( ClientState &client )
+{
+   // Run forward while slowly varying the turn rate, and jump now and then.
+   client.turnRate = mClampF( client.turnRate + gRandGen.randF( -0.005f, 0.005f ), -0.05f, 0.05f );
+   MoveManager::mForwardAction = 1.0f;
+   MoveManager::mYaw = client.turnRate;
+
+   if ( gRandGen.randI( 0, 199 ) == 0 )
+      MoveManager::mTriggerCount[2] = 1;
+}
+
+void LoadTest::_onClientTick( SimTime tickDelta )
+{
+   PROFILE_SCOPE( LoadTest_OnClientTick );
+
+   const U32 now = Platform::getRealMilliseconds();
+
+   if ( S32( mClients.size() ) < mNumClients && now >= mNextConnectTime )
+   {
+      _connectClient();
+      mNextConnectTime = now + mConnectInterval;
+   }
+
+   const bool scripted = isMethod( "onClientMove" );
+
+   MoveManagerState saved, clean;
+   saved.save();
+   clean.clear();
+
+   for ( U32 ticks = tickDelta / TickMs; ticks > 0; ticks-- )
+   {
+      for ( U32 i = 0; i < mClients.size(); i++ )
+      {
+         ClientState &client = mClients[i];
+         GameConnection *conn = client.connection;
+         if ( !conn || !conn->isEstablished() || !conn->mMoveList )
+            continue;
+
+         clean.restore();
+         if ( scripted )
+            onClientMove_callback( conn, mTick );
+         else
+            _generateMove( client );
+
+         // The callback may have deleted the connection.
+         if ( client.connection )
+            conn->mMoveList->collectMove();
+      }
+
+      mTick++;
+   }
+
+   saved.restore();
+
+   if ( mReportInterval > 0 && now - mLastReportTime >= U32( mReportInterval ) )
+      report();
+}
+
+void LoadTest::report()
+{
+   const U32 now = Platform::getRealMilliseconds();
+   const F32 seconds = getMax( ( now - mLastReportTime ) / 1000.0f, 0.001f );
+   mLastReportTime = now;
+
+   S32 connected = 0;
+   F32 sent = 0.0f;
+   F32 received = 0.0f;
+   F32 ghosts = 0.0f;
+   F32 loss = 0.0f;
+   F32 ping = 0.0f;
+
+   for ( U32 i = 0; i < mClients.size(); i++ )
+   {
+      ClientState &client = mClients[i];
+      GameConnection *conn = client.connection;
+      if ( !conn )
+         continue;
+
+      const U32 bytesSent = conn->getBytesSent();
+      const U32 bytesReceived = conn->getBytesReceived();
+
+      if ( conn->isEstablished() )
+      {
+         connected++;
+         sent += bytesSent - client.lastBytesSent;
+         received += bytesReceived - client.lastBytesReceived;
+         ghosts += conn->getLocalGhostCount();
+         loss += conn->getPacketLoss();
+         ping += conn->getRoundTripTime();
+      }
+
+      client.lastBytesSent = bytesSent;
+      client.lastBytesReceived = bytesReceived;
+   }
+
+   if ( connected > 0 )
+   {
+      sent /= connected * seconds;
+      received /= connected * seconds;
+      ghosts /= connected;
+      loss /= connected;
+      ping /= connected;
+   }
+
+   Con::printf( "LoadTest: %d/%d clients, up %.0f B/s, down %.0f B/s, %.1f ghosts, %.1f%% loss, %.0f ms ping per client",
+      connected, mClients.size(), sent, received, ghosts, loss * 100.0f, ping );
+
+   // Only available when the server runs in this process.
+   if ( Sim::getClientGroup()->size() > 0 )
+      Con::printf( "LoadTest: server tick %.2f ms avg, %d ms max",
+         ServerProcessList::smTickTimeAvg, ServerProcessList::smTickTimeMax );
+
+   onReport_callback( connected, sent, received, ghosts, loss );
+}
+
+
+DefineEngineMethod( LoadTest, start, void, (),,
+   "@brief Start connecting the simulated clients and sending moves.\n\n" )
+{
+   object->start();
+}
+
+DefineEngineMethod( LoadTest, stop, void, (),,
+   "@brief Disconnect and delete all the simulated clients.\n\n" )
+{
+   object->stop();
+}
+
+DefineEngineMethod( LoadTest, isRunning, bool, (),,
+   "@brief Returns true if the test has been started.\n\n" )
+{
+   return object->isRunning();
+}
+
+DefineEngineMethod( LoadTest, report, void, (),,
+   "@brief Print the per client bandwidth, ghost count and packet loss since the last report.\n\n"
+   "Also prints the server tick time when the server runs in the same process.\n\n" )
+{
+   object->report();
+}
@@ -0,0 +1,103 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _LOADTEST_H_
+#define _LOADTEST_H_
+
+#ifndef _SIMOBJECT_H_
+#include "console/simObject.h"
+#endif
+#ifndef _GAMECONNECTION_H_
+#include "T3D/gameBase/gameConnection.h"
+#endif
+
+/// Drives a number of simulated clients against a (usually dedicated)
+/// server from a single headless process.
+///
+/// Each simulated client is a regular GameConnection flagged with
+/// GameConnection::setSimulatedClient(), so the server treats it like
+/// any other player.  Once per client tick every established client
+/// produces one move through the MoveManager, either from the
+/// onClientMove() script callback or from a built-in wander pattern,
+/// and the results are periodically summarized by report().
+class LoadTest : public SimObject
+{
+   typedef SimObject Parent;
+
+protected:
+
+   struct ClientState
+   {
+      SimObjectPtr<GameConnection> connection;
+      U32 lastBytesSent;
+      U32 lastBytesReceived;
+      F32 turnRate;
+   };
+
+   /// Server address the clients connect to.
+   String mAddress;
+
+   /// Number of simulated clients to spawn.
+   S32 mNumClients;
+
+   /// Milliseconds between successive connection attempts.
+   S32 mConnectInterval;
+
+   /// Milliseconds between automatic reports, or 0 for none.
+   S32 mReportInterval;
+
+   Vector<ClientState> mClients;
+
+   bool mRunning;
+   U32 mTick;
+   U32 mNextConnectTime;
+   U32 mLastReportTime;
+
+   void _onClientTick( SimTime tickDelta );
+   void _connectClient();
+   void _generateMove( ClientState &client );
+
+public:
+
+   LoadTest();
+   virtual ~LoadTest();
+
+   DECLARE_CONOBJECT( LoadTest );
+   DECLARE_CALLBACK( void, onClientMove, ( GameConnection *client, S32 tick ) );
+   DECLARE_CALLBACK( void, onReport, ( S32 connected, F32 bytesSent, F32 bytesReceived, F32 ghosts, F32 packetLoss ) );
+
+   static void initPersistFields();
+   virtual void onRemove();
+
+   /// Starts connecting clients and generating moves.
+   void start();
+
+   /// Disconnects and deletes all simulated clients.
+   void stop();
+
+   bool isRunning() const { return mRunning; }
+
+   /// Prints the statistics gathered since the previous report.
+   void report();
+};
+
+#endif // _LOADTEST_H_
@@ -117,6 +117,7 @@ void MoveList::collectMove()
       if(!mConnection->isPlayingBack() && getNextMove(mv))
       {
          mv.checksum=Move::ChecksumMismatch;
+         mConnection->recordDemoTick();
          pushMove(mv);
          mConnection->recordBlock(GameConnection::BlockTypeMove, sizeof(Move), &mv);
       }
@@ -25,7 +25,31 @@
 
 #include "T3D/gameBase/gameBase.h"
 #include "platform/profiler.h"
+#include "platform/threads/jobSystem.h"
 #include "console/consoleTypes.h"
+#include "core/module.h"
+#include "core/util/tDictionary.h"
+#include "scene/sceneManager.h"
+#include "sim/netObject.h"
+
+//----------------------------------------------------------------------------
+
+bool ProcessList::smParallelTicks = false;
+U32 ProcessList::smMinParallelTickObjects = 32;
+
+AFTER_MODULE_INIT( Sim )
+{
+   Con::addVariable( "$ProcessList::parallelTicks", TypeBool, &ProcessList::smParallelTicks,
+      "If true, the server ticks objects that support it on the global job system.\n"
+      "Objects that are linked by processAfter() or share a mount are ticked in the same "
+      "group.  Other objects are ticked afterwards in list order.\n"
+      "Only game classes that override ProcessObject::isTickThreadSafe() are ticked in "
+      "parallel; no stock class does, so this has no effect on stock objects such as AIPlayer.\n"
+      "@ingroup Game\n" );
+   Con::addVariable( "$ProcessList::minParallelTickObjects", TypeS32, &ProcessList::smMinParallelTickObjects,
+      "Minimum number of thread-safe objects needed before the server ticks them in parallel.\n"
+      "@ingroup Game\n" );
+}
 
 //----------------------------------------------------------------------------
 
@@ -33,7 +57,8 @@ ProcessObject::ProcessObject()
  : mProcessTag( 0 ),   
    mOrderGUID( 0 ),
    mProcessTick( false ),
-   mIsGameBase( false )
+   mIsGameBase( false ),
+   mTickedInParallel( false )
 { 
    mProcessLink.next = mProcessLink.prev = this;
 }
@@ -257,6 +282,11 @@ void ProcessList::advanceObjects()
 
    // A little link list shuffling is done here to avoid problems
    // with objects being deleted from within the process method.
+   // Thread-safe objects are ticked up front when allowed; the loop
+   // below skips them.
+   if (allowParallelTicks())
+      tickParallelGroups();
+
    ProcessObject list;
    list.plLinkBefore(mHead.mProcessLink.next);
    mHead.plUnlink();
@@ -265,7 +295,10 @@ void ProcessList::advanceObjects()
       pobj->plUnlink();
       pobj->plLinkBefore(&mHead);
       
-      onTickObject(pobj);
+      if (pobj->mTickedInParallel)
+         pobj->mTickedInParallel = false;
+      else
+         onTickObject(pobj);
    }
 
    mTotalTicks++;
@@ -273,5 +306,205 @@ void ProcessList::advanceObjects()
    PROFILE_END();
 }
 
+//----------------------------------------------------------------------------
+
+namespace {
+
+   U32 findGroup( Vector< U32 >& parent, U32 index )
+   {
+      while ( parent[ index ] != index )
+      {
+         parent[ index ] = parent[ parent[ index ] ];
+         index = parent[ index ];
+      }
+      return index;
+   }
+
+   void joinGroups( Vector< U32 >& parent, U32 a, U32 b )
+   {
+      a = findGroup( parent, a );
+      b = findGroup( parent, b );
+
+      // Keep the earlier object as the group root so that
+      // groups are numbered in list order.
+      if ( a < b )
+         parent[ b ] = a;
+      else if ( b < a )
+         parent[ a ] = b;
+   }
+}
+
+void ProcessList::tickParallelGroups()
+{
+   if ( JobSystem::GLOBAL().getNumThreads() == 0 )
+      return;
+
+   PROFILE_SCOPE( ProcessList_TickParallelGroups );
+
+   // Collect all objects in list order.  Objects are looked up both by
+   // their ProcessObject and, for GameBases, their SceneObject address so
+   // that processAfter() targets and mount roots can be found.
+
+   Vector< ProcessObject* > objects;
+
+   HashTable< const void*, U32 > indices;
+   for ( ProcessObject * pobj = mHead.mProcessLink.next; pobj != &mHead; pobj = pobj->mProcessLink.next )
+   {
+      indices.insertUnique( pobj, objects.size() );
+      if ( pobj->mIsGameBase )
+         indices.insertUnique( static_cast< SceneObject* >( getGameBase( pobj ) ), objects.size() );
+      objects.push_back( pobj );
+   }
+
+   const U32 numObjects = objects.size();
+   if ( numObjects < smMinParallelTickObjects )
+      return;
+
+   // Join objects with their processAfter() targets and with all
+   // objects that are mounted to the same root.
+
+   Vector< U32 > parent;
+   parent.setSize( numObjects );
+   for ( U32 i = 0; i < numObjects; i++ )
+      parent[ i ] = i;
+
+   for ( U32 i = 0; i < numObjects; i++ )
+   {
+      ProcessObject *pobj = objects[ i ];
+
+      ProcessObject *afterObject = pobj->getAfterObject();
+      if ( afterObject )
+      {
+         HashTable< const void*, U32 >::Iterator iter = indices.find( afterObject );
+         if ( iter != indices.end() )
+            joinGroups( parent, i, iter->value );
+      }
+
+      GameBase *gameBase = getGameBase( pobj );
+      if ( gameBase && gameBase->getObjectMount() )
+      {
+         SceneObject *root = gameBase->getObjectMount();
+         while ( root->getObjectMount() )
+            root = root->getObjectMount();
+
+         HashTable< const void*, U32 >::Iterator iter = indices.find( root );
+         if ( iter != indices.end() )
+            joinGroups( parent, i, iter->value );
+         else
+            indices.insertUnique( root, i );
+      }
+   }
+
+   // A group can only be ticked in parallel if all its objects are
+   // thread-safe.  Client controlled objects are ticked with their
+   // connection's moves and always stay on the main thread.
+
+   Vector< bool > serialGroup;
+   serialGroup.setSize( numObjects );
+   dMemset( serialGroup.address(), 0, numObjects * sizeof( bool ) );
+
+   for ( U32 i = 0; i < numObjects; i++ )
+   {
+      ProcessObject *pobj = objects[ i ];
+      if ( !pobj->isTickThreadSafe() || pobj->getControllingClient() )
+         serialGroup[ findGroup( parent, i ) ] = true;
+   }
+
+   // Number the parallel groups in the order of their first object and
+   // sort the objects by group while keeping them in list order.
+
+   Vector< U32 > groupOf;
+   groupOf.setSize( numObjects );
+
+   Vector< U32 >& groupStart = mParallelGroupStart;
+   groupStart.clear();
+
+   U32 numParallelObjects = 0;
+   for ( U32 i = 0; i < numObjects; i++ )
+   {
+      const U32 root = findGroup( parent, i );
+      if ( serialGroup[ root ] )
+      {
+         groupOf[ i ] = U32( -1 );
+         continue;
+      }
+
+      if ( root == i )
+      {
+         groupOf[ i ] = groupStart.size();
+         groupStart.push_back( 0 );
+      }
+      else
+         groupOf[ i ] = groupOf[ root ];
+
+      groupStart[ groupOf[ i ] ]++;
+      numParallelObjects++;
+   }
+
+   if ( numParallelObjects == 0 )
+   {
+      static bool sWarned = false;
+      if ( !sWarned )
+      {
+         Con::warnf( "ProcessList::tickParallelGroups - $ProcessList::parallelTicks is set but no ticking object supports parallel ticks" );
+         sWarned = true;
+      }
+      return;
+   }
+
+   if ( numParallelObjects < smMinParallelTickObjects )
+      return;
+
+   const U32 numGroups = groupStart.size();
+   U32 offset = 0;
+   for ( U32 i = 0; i < numGroups; i++ )
+   {
+      const U32 count = groupStart[ i ];
+      groupStart[ i ] = offset;
+      offset += count;
+   }
+   groupStart.push_back( offset );
+
+   Vector< U32 > fill( groupStart );
+   Vector< ProcessObject* >& sorted = mParallelObjects;
+   sorted.setSize( numParallelObjects );
+   for ( U32 i = 0; i < numObjects; i++ )
+   {
+      if ( groupOf[ i ] == U32( -1 ) )
+         continue;
+
+      ProcessObject *pobj = objects[ i ];
+      pobj->mTickedInParallel = true;
+      sorted[ fill[ groupOf[ i ] ] ++ ] = pobj;
+   }
+
+   // Tick the groups.  Container and ghost updates are deferred while
+   // the workers run and applied in a fixed order afterwards so the
+   // result does not depend on which thread got to an object first.
+
+   SceneManager::beginDeferredUpdates();
+   NetObject::beginDeferredMaskBits();
+
+   JobSystem::GLOBAL().parallelFor( numGroups, &_tickGroups, this );
+
+   NetObject::endDeferredMaskBits();
+   SceneManager::endDeferredUpdates();
+}
+
+void ProcessList::_tickGroups( void* data, U32 begin, U32 end )
+{
+   ProcessList *list = reinterpret_cast< ProcessList* >( data );
+
+   ProcessObject** objects = list->mParallelObjects.address();
+   const U32* groupStart = list->mParallelGroupStart.address();
+
+   for ( U32 i = groupStart[ begin ]; i < groupStart[ end ]; i++ )
+   {
+      ProcessObject *pobj = objects[ i ];
+      if ( pobj->isTicking() )
+         pobj->processTick( NULL );
+   }
+}
+
 
 
@@ -29,6 +29,9 @@
 #ifndef _TSIGNAL_H_
 #include "core/util/tSignal.h"
 #endif
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
 
 //----------------------------------------------------------------------------
 
@@ -110,6 +113,26 @@ public:
    /// This is only called for the control object on the client-side.
    virtual void preprocessMove( Move *move ) {}
 
+   /// Returns true if processTick() may be called on a worker thread.
+   ///
+   /// When parallel ticks are enabled on a process list, objects that are
+   /// linked through processAfter() or mounted to the same object are put
+   /// in a group and groups of objects returning true here are ticked in
+   /// parallel.  During processTick() such an object must not call into
+   /// script, create or delete objects, or rely on the current tick's state
+   /// of objects outside its group.  Container updates and net mask bits
+   /// are recorded and applied once all groups have been ticked.
+   ///
+   /// This is an opt-in for game classes whose ticks meet these rules.
+   /// No stock class returns true, Player and AIPlayer included: besides
+   /// firing script callbacks, their ticks share the container query
+   /// sequence key, the collision working lists and free lists, and the
+   /// TSShapeInstance animation scratch buffers with every other object.
+   /// Parallel ticks have no effect until a class opts in.
+   ///
+   /// @see ProcessList::smParallelTicks
+   virtual bool isTickThreadSafe() const { return false; }
+
 //protected:
 
    struct Link
@@ -131,6 +154,8 @@ public:
    bool mProcessTick;
 
    bool mIsGameBase;
+
+   bool mTickedInParallel;                // Already ticked by the parallel pass of the current tick
 };
 
 //----------------------------------------------------------------------------
@@ -164,11 +189,29 @@ public:
    /// Returns true if a tick was processed.
    virtual bool advanceTime( SimTime timeDelta );
 
+   /// If true, lists that allow it tick objects which are thread-safe
+   /// in parallel before ticking the remaining objects in order.
+   /// @see ProcessObject::isTickThreadSafe
+   static bool smParallelTicks;
+
+   /// Minimum number of thread-safe objects needed for a parallel tick.
+   static U32 smMinParallelTickObjects;
+
 protected:
  
    void orderList();
    GameBase* getGameBase( ProcessObject *obj );
 
+   /// Returns true if this list may tick objects in parallel.
+   virtual bool allowParallelTicks() const { return false; }
+
+   /// Split the thread-safe objects into independent groups and tick the
+   /// groups on the global job system.  Each group is ticked in list order.
+   /// Objects ticked here are flagged with ProcessObject::mTickedInParallel.
+   void tickParallelGroups();
+
+   static void _tickGroups( void* data, U32 begin, U32 end );
+
    virtual void advanceObjects();
    virtual void onAdvanceObjects() { advanceObjects(); }
    virtual void onPreTickObject( ProcessObject* ) {}
@@ -188,6 +231,19 @@ protected:
 
    PreTickSignal mPreTick;
    PostTickSignal mPostTick;
+
+   /// @name Parallel Ticks
+   /// Scratch space for tickParallelGroups().
+   /// @{
+
+   /// Objects to tick in parallel sorted by group.
+   Vector< ProcessObject* > mParallelObjects;
+
+   /// Index of the first object of each group in #mParallelObjects
+   /// followed by the total object count.
+   Vector< U32 > mParallelGroupStart;
+
+   /// @}
 };
 
 #endif // _PROCESSLIST_H_
\ No newline at end of file
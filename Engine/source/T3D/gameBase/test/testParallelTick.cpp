@@ -0,0 +1,216 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "T3D/gameBase/processList.h"
+#include "platform/threads/jobSystem.h"
+#include "sim/netObject.h"
+#include "console/console.h"
+#include "core/util/tVector.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Ticks chains of objects linked through processAfter() with parallel ticks
+// enabled and checks how they were grouped, that each chain was ticked in
+// order, and that the mask bits set on the workers were applied in the
+// order of the object IDs.
+
+/// Object that records how and when it was ticked.
+class ParallelTickTestObject : public NetObject, public ProcessObject
+{
+   public:
+
+      typedef NetObject Parent;
+
+      ParallelTickTestObject* mAfter;
+      U32 mChain;
+      bool mThreadSafe;
+
+      U32 mNumTicks;
+      bool mTickedAfterTarget;
+      bool mTickedSerially;
+
+      ParallelTickTestObject()
+         : mAfter( NULL ),
+           mChain( 0 ),
+           mThreadSafe( true ),
+           mNumTicks( 0 ),
+           mTickedAfterTarget( false ),
+           mTickedSerially( false ) {}
+
+      ProcessObject* getAfterObject() const { return mAfter; }
+      bool isTickThreadSafe() const { return mThreadSafe; }
+
+      void processTick( const Move* move )
+      {
+         mTickedAfterTarget = ( !mAfter || mAfter->mNumTicks > 0 );
+         mNumTicks ++;
+         setMaskBits( BIT( 0 ) );
+      }
+};
+
+/// Process list that always allows parallel ticks and ticks the remaining
+/// objects itself.
+class ParallelTickTestList : public ProcessList
+{
+   public:
+
+      typedef ProcessList Parent;
+
+      void tick()
+      {
+         if( isDirty() )
+            orderList();
+         advanceObjects();
+      }
+
+      U32 getNumGroups() const { return mParallelGroupStart.empty() ? 0 : mParallelGroupStart.size() - 1; }
+      U32 getGroupStart( U32 group ) const { return mParallelGroupStart[ group ]; }
+      ProcessObject* getParallelObject( U32 index ) const { return mParallelObjects[ index ]; }
+
+   protected:
+
+      bool allowParallelTicks() const { return true; }
+
+      void onTickObject( ProcessObject* pobj )
+      {
+         static_cast< ParallelTickTestObject* >( pobj )->mTickedSerially = true;
+         pobj->processTick( NULL );
+      }
+};
+
+CreateUnitTest( TestParallelTick, "T3D/GameBase/ParallelTick" )
+{
+   enum
+   {
+      NUM_CHAINS = 24,
+      CHAIN_LENGTH = 4,
+      NUM_OBJECTS = NUM_CHAINS * CHAIN_LENGTH,
+   };
+
+   /// Every fifth chain holds an object that isn't thread-safe.
+   static bool isSerialChain( U32 chain ) { return ( chain % 5 ) == 2; }
+
+   void run()
+   {
+      const U32 oldMinObjects = ProcessList::smMinParallelTickObjects;
+      ProcessList::smMinParallelTickObjects = 1;
+
+      // Create the objects in ID order but add them to the list in reverse,
+      // so list order and ID order disagree.
+
+      Vector< ParallelTickTestObject* > objects;
+      for( U32 i = 0; i < NUM_OBJECTS; ++ i )
+      {
+         ParallelTickTestObject* object = new ParallelTickTestObject;
+         object->mChain = i / CHAIN_LENGTH;
+         if( i % CHAIN_LENGTH )
+            object->mAfter = objects.last();
+         if( isSerialChain( object->mChain ) && i % CHAIN_LENGTH == 1 )
+            object->mThreadSafe = false;
+         object->setProcessTick( true );
+         object->registerObject();
+         objects.push_back( object );
+      }
+
+      ParallelTickTestList list;
+      for( S32 i = NUM_OBJECTS - 1; i >= 0; -- i )
+         list.addObject( objects[ i ] );
+      list.markDirty();
+      list.tick();
+
+      // Every object is ticked once, after its processAfter() target.
+
+      bool tickedOnce = true;
+      bool inOrder = true;
+      for( U32 i = 0; i < NUM_OBJECTS; ++ i )
+      {
+         tickedOnce &= ( objects[ i ]->mNumTicks == 1 );
+         inOrder &= objects[ i ]->mTickedAfterTarget;
+      }
+      TEST( tickedOnce );
+      TEST( inOrder );
+
+      if( JobSystem::GLOBAL().getNumThreads() == 0 )
+         Con::warnf( "TestParallelTick: job system has no worker threads, only checked serial ticks" );
+      else
+      {
+         // Chains with an object that isn't thread-safe are ticked serially
+         // as a whole; every other chain forms one group.
+
+         bool serialMatches = true;
+         U32 numParallelChains = 0;
+         for( U32 i = 0; i < NUM_OBJECTS; ++ i )
+         {
+            ParallelTickTestObject* object = objects[ i ];
+            serialMatches &= ( object->mTickedSerially == isSerialChain( object->mChain ) );
+            if( i % CHAIN_LENGTH == 0 && !isSerialChain( object->mChain ) )
+               numParallelChains ++;
+         }
+         TEST( serialMatches );
+         TEST( list.getNumGroups() == numParallelChains );
+
+         bool groupsMatch = true;
+         for( U32 group = 0; group < list.getNumGroups(); ++ group )
+         {
+            const U32 start = list.getGroupStart( group );
+            const U32 end = list.getGroupStart( group + 1 );
+            groupsMatch &= ( end - start == CHAIN_LENGTH );
+
+            const U32 chain = static_cast< ParallelTickTestObject* >( list.getParallelObject( start ) )->mChain;
+            for( U32 i = start; i < end; ++ i )
+               groupsMatch &= ( static_cast< ParallelTickTestObject* >( list.getParallelObject( i ) )->mChain == chain );
+         }
+         TEST( groupsMatch );
+
+         // The mask bits set on the workers were applied in ID order, so
+         // walking the dirty list from the front yields descending IDs.
+
+         bool idOrder = true;
+         U32 numDirty = 0;
+         SimObjectId lastId = SimObjectId( -1 );
+         for( NetObject* obj = NetObject::getDirtyList(); obj; obj = obj->getNextDirtyObject() )
+         {
+            ParallelTickTestObject* object = dynamic_cast< ParallelTickTestObject* >( obj );
+            if( !object || object->mTickedSerially )
+               continue;
+
+            idOrder &= ( object->getId() < lastId );
+            lastId = object->getId();
+            numDirty ++;
+         }
+         TEST( idOrder );
+         TEST( numDirty == numParallelChains * CHAIN_LENGTH );
+      }
+
+      for( U32 i = 0; i < NUM_OBJECTS; ++ i )
+         objects[ i ]->deleteObject();
+
+      ProcessList::smMinParallelTickObjects = oldMinObjects;
+   }
+};
+
+#endif // !TORQUE_SHIPPING
@@ -0,0 +1,196 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "T3D/gameBase/tickCache.h"
+#include "core/stream/bitStream.h"
+#include "console/console.h"
+#include "math/mRandom.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Checks the ordering rules of the tick cache, then measures the cost of
+// the hifi client's rewind and replay cycle over many objects.
+
+CreateUnitTest( TestTickCache, "T3D/GameBase/TickCache" )
+{
+   enum
+   {
+      DEFAULT_NUM_OBJECTS = 500,
+      DEFAULT_NUM_UPDATES = 200,
+      TICKS_PER_UPDATE = 3,
+      REWIND_TICKS = 32,
+   };
+
+   static void setTick( TickCacheEntry* entry, U32 tick )
+   {
+      dMemcpy( entry->packetData, &tick, sizeof( tick ) );
+   }
+
+   static U32 getTick( TickCacheEntry* entry )
+   {
+      U32 tick;
+      dMemcpy( &tick, entry->packetData, sizeof( tick ) );
+      return tick;
+   }
+
+   /// Return true if iterating @a cache yields exactly @a ticks.
+   bool check( TickCache& cache, const U32* ticks, U32 count )
+   {
+      cache.beginCacheList();
+      for( U32 i = 0; i < count; ++ i )
+      {
+         TickCacheEntry* entry = cache.incCacheList( false );
+         if( !entry || getTick( entry ) != ticks[ i ] )
+            return false;
+      }
+      return cache.incCacheList( false ) == NULL;
+   }
+
+   void testOrdering()
+   {
+      TickCache cache;
+      for( U32 i = 0; i < 5; ++ i )
+         setTick( cache.addCacheEntry(), i );
+
+      const U32 all[] = { 0, 1, 2, 3, 4 };
+      TEST( check( cache, all, 5 ) );
+
+      cache.dropNextOldest();
+      const U32 skipped[] = { 0, 2, 3, 4 };
+      TEST( check( cache, skipped, 4 ) );
+
+      cache.dropOldest();
+      const U32 dropped[] = { 2, 3, 4 };
+      TEST( check( cache, dropped, 3 ) );
+
+      // Age by one tick and pad back out to five entries.
+      cache.ageCache( 1, 5 );
+      cache.beginCacheList();
+      TEST( getTick( cache.incCacheList() ) == 3 );
+      TEST( getTick( cache.incCacheList() ) == 4 );
+      for( U32 i = 0; i < 3; ++ i )
+         setTick( cache.incCacheList(), 5 + i );
+      const U32 aged[] = { 3, 4, 5, 6, 7 };
+      TEST( check( cache, aged, 5 ) );
+
+      // Iterating past the end adds entries.
+      cache.beginCacheList();
+      for( U32 i = 0; i < 5; ++ i )
+         cache.incCacheList();
+      setTick( cache.incCacheList(), 8 );
+      const U32 extended[] = { 3, 4, 5, 6, 7, 8 };
+      TEST( check( cache, extended, 6 ) );
+
+      // Wrap around the ring several times and grow it while wrapped.
+      TickCache ring;
+      U32 next = 0;
+      U32 oldest = 0;
+      for( U32 round = 0; round < 10; ++ round )
+      {
+         for( U32 i = 0; i < TickCache::smHorizon / 2 + round * 3; ++ i )
+            setTick( ring.addCacheEntry(), next ++ );
+         for( U32 i = 0; i < TickCache::smHorizon / 3; ++ i, ++ oldest )
+            ring.dropOldest();
+      }
+
+      bool ordered = true;
+      ring.beginCacheList();
+      for( U32 tick = oldest; tick < next; ++ tick )
+      {
+         TickCacheEntry* entry = ring.incCacheList( false );
+         if( !entry || getTick( entry ) != tick )
+            ordered = false;
+      }
+      TEST( ordered && ring.incCacheList( false ) == NULL );
+
+      ring.setCacheSize( 0 );
+      TEST( ring.incCacheList( false ) == NULL );
+   }
+
+   void benchmark()
+   {
+      const U32 numObjects = Con::getIntVariable( "$testTickCache::numObjects", DEFAULT_NUM_OBJECTS );
+      const U32 numUpdates = Con::getIntVariable( "$testTickCache::numUpdates", DEFAULT_NUM_UPDATES );
+
+      MRandomLCG rand( 42 );
+
+      TickCache* caches = new TickCache[ numObjects ];
+      U32 checksum = 0;
+
+      const U32 start = Platform::getRealMilliseconds();
+      for( U32 update = 0; update < numUpdates; ++ update )
+      {
+         // Normal client ticks record each object's state.
+         for( U32 tick = 0; tick < TICKS_PER_UPDATE; ++ tick )
+            for( U32 i = 0; i < numObjects; ++ i )
+            {
+               TickCacheEntry* entry = caches[ i ].addCacheEntry();
+               BitStream stream( entry->packetData, TickCacheEntry::MaxPacketSize );
+               for( U32 j = 0; j < 24; ++ j )
+                  stream.write( rand.randF() );
+            }
+
+         // A server update arrives: age the caches, rewind to the
+         // oldest state and replay up to the present.
+         for( U32 i = 0; i < numObjects; ++ i )
+         {
+            TickCache& cache = caches[ i ];
+            if( update )
+               cache.ageCache( TICKS_PER_UPDATE, REWIND_TICKS + 1 );
+            else
+               cache.setCacheSize( REWIND_TICKS + 1 );
+
+            cache.beginCacheList();
+            TickCacheEntry* entry = cache.incCacheList();
+            BitStream base( entry->packetData, TickCacheEntry::MaxPacketSize );
+            checksum += base.readInt( 8 );
+
+            for( U32 tick = 0; tick < REWIND_TICKS; ++ tick )
+            {
+               entry = cache.incCacheList();
+               BitStream stream( entry->packetData, TickCacheEntry::MaxPacketSize );
+               for( U32 j = 0; j < 24; ++ j )
+                  stream.write( F32( tick ) );
+            }
+         }
+      }
+      const U32 elapsed = Platform::getRealMilliseconds() - start;
+
+      delete [] caches;
+
+      Con::printf( "TickCache: %d objects, %d updates rewinding %d ticks: %dms (checksum %d)",
+         numObjects, numUpdates, REWIND_TICKS, elapsed, checksum );
+   }
+
+   void run()
+   {
+      testOrdering();
+      benchmark();
+   }
+};
+
+#endif // !TORQUE_SHIPPING
@@ -31,39 +31,61 @@
 #include "T3D/gameBase/moveManager.h"
 #include "T3D/gameBase/gameProcess.h"
 
-struct TickCacheHead
-{
-   TickCacheEntry * oldest;
-   TickCacheEntry * newest;
-   TickCacheEntry * next;
-   U32 numEntry;
-};
+#include "console/consoleTypes.h"
+#include "core/module.h"
 
 namespace
 {
-   FreeListChunker<TickCacheHead>  sgTickCacheHeadStore;
-   FreeListChunker<TickCacheEntry> sgTickCacheEntryStore;
    FreeListChunker<Move>           sgMoveStore;
 
-   static TickCacheHead * allocHead() { return sgTickCacheHeadStore.alloc(); }
-   static void freeHead(TickCacheHead * head) { sgTickCacheHeadStore.free(head); }
-
-   static TickCacheEntry * allocEntry() { return sgTickCacheEntryStore.alloc(); }
-   static void freeEntry(TickCacheEntry * entry) { sgTickCacheEntryStore.free(entry); }
-
    static Move * allocMove() { return sgMoveStore.alloc(); }
    static void freeMove(Move * move) { sgMoveStore.free(move); }
+
+   enum { MaxRingSizeClass = 16 };
+
+   /// Free rings by log2 of their capacity, linked through their first bytes.
+   void * sgFreeRings[MaxRingSizeClass + 1];
+
+   static TickCacheEntry * allocRing(U32 capacity)
+   {
+      U32 sizeClass = getBinLog2(capacity, true);
+      AssertFatal(sizeClass <= MaxRingSizeClass, "Tick cache ring too large");
+
+      void * ring = sgFreeRings[sizeClass];
+      if (ring)
+         sgFreeRings[sizeClass] = *(void **)ring;
+      else
+         ring = dMalloc(capacity * sizeof(TickCacheEntry));
+      return (TickCacheEntry *)ring;
+   }
+
+   static void freeRing(TickCacheEntry * ring, U32 capacity)
+   {
+      U32 sizeClass = getBinLog2(capacity, true);
+      *(void **)ring = sgFreeRings[sizeClass];
+      sgFreeRings[sizeClass] = ring;
+   }
+}
+
+S32 TickCache::smHorizon = 32;
+
+AFTER_MODULE_INIT( Sim )
+{
+   Con::addVariable( "$Net::tickCacheHorizon", TypeS32, &TickCache::smHorizon,
+      "Number of ticks of history the client tick cache of each object is initially sized for.  "
+      "Caches grow as needed when the client has to rewind further.\n"
+      "@ingroup Networking\n" );
 }
 
 //----------------------------------------------------------------------------
 
 TickCache::~TickCache()
 {
-   if (mTickCacheHead)
+   if (mEntries)
    {
       setCacheSize(0);
-      freeHead(mTickCacheHead);
-      mTickCacheHead = NULL;
+      freeRing(mEntries, mCapacity);
+      mEntries = NULL;
    }
 }
 
@@ -72,103 +94,103 @@ Move * TickCacheEntry::allocateMove()
    return allocMove();
 }
 
+void TickCache::_grow()
+{
+   U32 newCapacity = mCapacity ? mCapacity * 2 : getNextPow2(getMax(smHorizon, 2));
+   TickCacheEntry * newEntries = allocRing(newCapacity);
+
+   // unwrap the entries so the oldest is first again
+   for (U32 i = 0; i < mNumEntry; i++)
+      newEntries[i] = _getEntry(i);
+
+   if (mEntries)
+      freeRing(mEntries, mCapacity);
+
+   mEntries = newEntries;
+   mCapacity = newCapacity;
+   mOldest = 0;
+}
+
 TickCacheEntry * TickCache::addCacheEntry()
 {
-   // Add a new entry, creating head if needed
-   if (!mTickCacheHead)
-   {
-      mTickCacheHead = allocHead();
-      mTickCacheHead->newest = mTickCacheHead->oldest = mTickCacheHead->next = NULL;
-      mTickCacheHead->numEntry = 0;
-   }
-   if (!mTickCacheHead->newest)
-   {
-      mTickCacheHead->newest = mTickCacheHead->oldest = allocEntry();
-   }
-   else
-   {
-      mTickCacheHead->newest->next = allocEntry();
-      mTickCacheHead->newest = mTickCacheHead->newest->next;
-   }
-   mTickCacheHead->newest->next = NULL;
-   mTickCacheHead->newest->move = NULL;
-   mTickCacheHead->numEntry++;
-   return mTickCacheHead->newest;
+   // Add a new entry, growing the ring if needed
+   if (mNumEntry == mCapacity)
+      _grow();
+
+   TickCacheEntry * entry = &_getEntry(mNumEntry);
+   entry->move = NULL;
+   mNumEntry++;
+   return entry;
 }
 
 void TickCache::setCacheSize(S32 len)
 {
    // grow cache to len size, adding to newest side of the list
-   while (!mTickCacheHead || mTickCacheHead->numEntry < len)
+   while (mNumEntry < len)
       addCacheEntry();
    // shrink tick cache down to given size, popping off oldest entries first
-   while (mTickCacheHead && mTickCacheHead->numEntry > len)
+   while (mNumEntry > len)
       dropOldest();
 }
 
 void TickCache::dropOldest()
 {
-   AssertFatal(mTickCacheHead->oldest,"Popping off too many tick cache entries");
-   TickCacheEntry * oldest = mTickCacheHead->oldest;
-   mTickCacheHead->oldest = oldest->next;
-   if (oldest->move)
-      freeMove(oldest->move);
-   freeEntry(oldest);
-   mTickCacheHead->numEntry--;
-   if (mTickCacheHead->numEntry < 2)
-      mTickCacheHead->newest = mTickCacheHead->oldest;
+   AssertFatal(mNumEntry,"Popping off too many tick cache entries");
+   TickCacheEntry & oldest = _getEntry(0);
+   if (oldest.move)
+      freeMove(oldest.move);
+   mOldest = (mOldest + 1) & (mCapacity - 1);
+   mNumEntry--;
+   if (mNext)
+      mNext--;
 }
 
 void TickCache::dropNextOldest()
 {
-   AssertFatal(mTickCacheHead->oldest && mTickCacheHead->numEntry>1,"Popping off too many tick cache entries");
-   TickCacheEntry * oldest = mTickCacheHead->oldest;
-   TickCacheEntry * nextoldest = mTickCacheHead->oldest->next;
-   oldest->next = nextoldest->next;
-   if (nextoldest->move)
-      freeMove(nextoldest->move);
-   freeEntry(nextoldest);
-   mTickCacheHead->numEntry--;
-   if (mTickCacheHead->numEntry==1)
-      mTickCacheHead->newest = mTickCacheHead->oldest;
+   AssertFatal(mNumEntry>1,"Popping off too many tick cache entries");
+   TickCacheEntry & nextOldest = _getEntry(1);
+   if (nextOldest.move)
+      freeMove(nextOldest.move);
+
+   // move the oldest entry into the next oldest's slot
+   nextOldest = _getEntry(0);
+   mOldest = (mOldest + 1) & (mCapacity - 1);
+   mNumEntry--;
+   if (mNext > 1)
+      mNext--;
 }
 
 void TickCache::ageCache(S32 numToAge, S32 len)
 {
-   AssertFatal(mTickCacheHead,"No tick cache head");
-   AssertFatal(mTickCacheHead->numEntry>=numToAge,"Too few entries!");
-   AssertFatal(mTickCacheHead->numEntry>numToAge,"Too few entries!");
+   AssertFatal(mEntries,"No tick cache entries");
+   AssertFatal(mNumEntry>=numToAge,"Too few entries!");
+   AssertFatal(mNumEntry>numToAge,"Too few entries!");
 
    while (numToAge--)
       dropOldest();
-   while (mTickCacheHead->numEntry>len)
+   while (mNumEntry>len)
       dropNextOldest();
-   while (mTickCacheHead->numEntry<len)
+   while (mNumEntry<len)
       addCacheEntry();
 }
 
 void TickCache::beginCacheList()
 {
    // get ready iterate from oldest to newest entry
-   if (mTickCacheHead)
-      mTickCacheHead->next = mTickCacheHead->oldest;
-   // if no head, that's ok, we'll just add entries as we go
+   mNext = 0;
 }
 
 TickCacheEntry * TickCache::incCacheList(bool addIfNeeded)
 {
    // continue iterating through cache, returning current entry
    // we'll add new entries if need be
-   TickCacheEntry * ret = NULL;
-   if (mTickCacheHead && mTickCacheHead->next)
-   {
-      ret = mTickCacheHead->next;
-      mTickCacheHead->next = mTickCacheHead->next->next;
-   }
-   else if (addIfNeeded)
-   {
-      addCacheEntry();
-      ret = mTickCacheHead->newest;
-   }
+   if (mNext < mNumEntry)
+      return &_getEntry(mNext++);
+
+   if (!addIfNeeded)
+      return NULL;
+
+   TickCacheEntry * ret = addCacheEntry();
+   mNext = mNumEntry;
    return ret;
-}
\ No newline at end of file
+}
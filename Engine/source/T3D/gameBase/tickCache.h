@@ -34,15 +34,22 @@ struct TickCacheEntry
    enum { MaxPacketSize=140 };
 
    U8 packetData[MaxPacketSize];
-   TickCacheEntry * next;
    Move * move;
 
    // If you want to assign moves to tick cache for later playback, allocate them here
    Move * allocateMove();
 };
 
-struct TickCacheHead;
-
+/// Per object history of packet data for the last few ticks, used by the
+/// hifi client to rewind and replay objects when a server update arrives.
+///
+/// Entries are stored oldest to newest in a contiguous ring whose capacity
+/// is a power of two.  Rings are allocated when the first entry is added,
+/// sized to cover smHorizon ticks, and are recycled through per size free
+/// lists, so adding, aging and dropping entries never touch the general
+/// allocator once the cache is warm.
+///
+/// @note Entry pointers are only valid until the cache is next modified.
 class TickCache
 {
 public:
@@ -57,13 +64,29 @@ public:
    void beginCacheList();
    TickCacheEntry * incCacheList(bool addIfNeeded=true);
 
+   /// Number of ticks of history rings are initially sized for.
+   static S32 smHorizon;
+
 private:
-   TickCacheHead * mTickCacheHead;
+   TickCacheEntry & _getEntry(U32 i) { return mEntries[(mOldest + i) & (mCapacity - 1)]; }
+   void _grow();
+
+   TickCacheEntry * mEntries;
+   U32 mCapacity;
+   U32 mOldest;
+   U32 mNumEntry;
+
+   /// Offset from the oldest entry of the entry incCacheList() returns next.
+   U32 mNext;
 };
 
 inline TickCache::TickCache()
 {
-   mTickCacheHead = NULL;
+   mEntries = NULL;
+   mCapacity = 0;
+   mOldest = 0;
+   mNumEntry = 0;
+   mNext = 0;
 }
 
 #endif // _TICKCACHE_H_
\ No newline at end of file
@@ -0,0 +1,283 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "T3D/lagCompensation.h"
+
+#include "T3D/shapeBase.h"
+#include "T3D/gameBase/gameConnection.h"
+#include "T3D/gameBase/gameProcess.h"
+#include "scene/sceneContainer.h"
+#include "collision/collision.h"
+#include "console/consoleTypes.h"
+#include "console/engineAPI.h"
+#include "core/module.h"
+#include "platform/profiler.h"
+
+
+bool LagCompensation::smEnabled = true;
+S32 LagCompensation::smObjectMask = PlayerObjectType | VehicleObjectType;
+S32 LagCompensation::smMaxRewindMs = 500;
+S32 LagCompensation::smInterpolationMs = TickMs;
+Vector< LagCompensationHistory* > LagCompensation::smHistories;
+U32 LagCompensation::smLastTick = 0;
+F32 LagCompensation::smQueryTick = 0.0f;
+const SceneObject* LagCompensation::smQueryPresent = NULL;
+
+
+AFTER_MODULE_INIT( Sim )
+{
+   Con::addVariable( "$LagCompensation::enabled", TypeBool, &LagCompensation::smEnabled,
+      "If false, the server keeps no collision history and lag compensated ray casts "
+      "test objects at their present position.\n"
+      "@ingroup Game\n" );
+   Con::addVariable( "$LagCompensation::objectMask", TypeS32, &LagCompensation::smObjectMask,
+      "Type mask of the ShapeBase objects whose collision history the server tracks.  "
+      "Only affects objects added after it is changed.\n"
+      "@ingroup Game\n" );
+   Con::addVariable( "$LagCompensation::maxRewindMs", TypeS32, &LagCompensation::smMaxRewindMs,
+      "Longest time in milliseconds a lag compensated ray cast may rewind.  Limited by "
+      "the length of the kept history.\n"
+      "@ingroup Game\n" );
+   Con::addVariable( "$LagCompensation::interpolationMs", TypeS32, &LagCompensation::smInterpolationMs,
+      "Client interpolation delay in milliseconds added to the round trip time when "
+      "computing the view time of a client.\n"
+      "@ingroup Game\n" );
+}
+
+//-----------------------------------------------------------------------------
+
+void LagCompensation::addObject( ShapeBase* object )
+{
+   AssertFatal( object->isServerObject(), "LagCompensation::addObject - Only server objects have a history" );
+   AssertFatal( !object->mLagHistory, "LagCompensation::addObject - Object is already tracked" );
+
+   if ( !smEnabled || !( object->getTypeMask() & smObjectMask ) )
+      return;
+
+   LagCompensationHistory* history = new LagCompensationHistory;
+   history->object = object;
+   history->index = smHistories.size();
+   for ( U32 i = 0; i < LagCompensationHistory::HistorySize; i++ )
+      history->samples[i].tick = U32_MAX;
+
+   smHistories.push_back( history );
+   object->mLagHistory = history;
+}
+
+void LagCompensation::removeObject( ShapeBase* object )
+{
+   LagCompensationHistory* history = object->mLagHistory;
+   if ( !history )
+      return;
+
+   // Swap the last history into the removed slot.
+   LagCompensationHistory* last = smHistories.last();
+   smHistories[ history->index ] = last;
+   last->index = history->index;
+   smHistories.pop_back();
+
+   object->mLagHistory = NULL;
+   delete history;
+}
+
+void LagCompensation::recordTick( U32 tick )
+{
+   PROFILE_SCOPE( LagCompensation_RecordTick );
+
+   const U32 slot = tick % LagCompensationHistory::HistorySize;
+   smLastTick = tick;
+
+   for ( U32 i = 0; i < smHistories.size(); i++ )
+   {
+      LagCompensationHistory* history = smHistories[i];
+      const MatrixF& mat = history->object->getTransform();
+
+      LagCompensationSample& sample = history->samples[ slot ];
+      sample.tick = tick;
+      mat.getColumn( 3, &sample.position );
+      sample.rotation.set( mat );
+      sample.worldBox = history->object->getWorldBox();
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+bool LagCompensation::getSample( const ShapeBase* object, F32 tick, LagCompensationSample* outSample )
+{
+   const LagCompensationHistory* history = object->mLagHistory;
+   if ( !history || tick < 0.0f )
+      return false;
+
+   const U32 tick0 = (U32)tick;
+   const LagCompensationSample& sample0 = history->samples[ tick0 % LagCompensationHistory::HistorySize ];
+   if ( sample0.tick != tick0 )
+      return false;
+
+   *outSample = sample0;
+
+   // Blend toward the next tick if we have it.
+   const F32 frac = tick - F32( tick0 );
+   const LagCompensationSample& sample1 = history->samples[ ( tick0 + 1 ) % LagCompensationHistory::HistorySize ];
+   if ( frac > 0.0f && sample1.tick == tick0 + 1 )
+   {
+      outSample->position.interpolate( sample0.position, sample1.position, frac );
+      outSample->rotation.interpolate( sample0.rotation, sample1.rotation, frac );
+      outSample->worldBox.minExtents.interpolate( sample0.worldBox.minExtents, sample1.worldBox.minExtents, frac );
+      outSample->worldBox.maxExtents.interpolate( sample0.worldBox.maxExtents, sample1.worldBox.maxExtents, frac );
+   }
+
+   return true;
+}
+
+F32 LagCompensation::getViewTick( GameConnection* client )
+{
+   const F32 currentTick = F32( ServerProcessList::get()->getTotalTicks() );
+   if ( !client )
+      return currentTick;
+
+   const S32 maxRewindMs = getMin( smMaxRewindMs, S32( ( LagCompensationHistory::HistorySize - 1 ) * TickMs ) );
+   const F32 rewindMs = mClampF( client->getRoundTripTime() + smInterpolationMs, 0.0f, F32( maxRewindMs ) );
+
+   return currentTick - rewindMs / F32( TickMs );
+}
+
+//-----------------------------------------------------------------------------
+
+bool LagCompensation::_isPresentHit( RayInfo* info )
+{
+   if ( !( info->object->getTypeMask() & ShapeBaseObjectType ) || info->object == smQueryPresent )
+      return true;
+
+   LagCompensationSample sample;
+   return !getSample( static_cast< ShapeBase* >( info->object ), smQueryTick, &sample );
+}
+
+bool LagCompensation::castRayAtTime( SceneContainer* container, const Point3F& start, const Point3F& end, U32 mask, RayInfo* info, F32 tick, const SceneObject* present )
+{
+   if ( !smEnabled || smHistories.empty() || tick >= F32( smLastTick ) )
+      return container->castRay( start, end, mask, info );
+
+   PROFILE_SCOPE( LagCompensation_CastRayAtTime );
+
+   // Everything that is not rewound is tested in its present state.
+   smQueryTick = tick;
+   smQueryPresent = present;
+   bool hit = container->castRay( start, end, mask, info, &_isPresentHit );
+   smQueryPresent = NULL;
+   F32 currentT = hit ? info->t : 2.0f;
+
+   // Then test the rewound objects against their historic transforms.
+   for ( U32 i = 0; i < smHistories.size(); i++ )
+   {
+      ShapeBase* object = smHistories[i]->object;
+      if ( object == present || !( object->getTypeMask() & mask ) || !object->isCollisionEnabled() )
+         continue;
+
+      LagCompensationSample sample;
+      if ( !getSample( object, tick, &sample ) || !sample.worldBox.collideLine( start, end ) )
+         continue;
+
+      MatrixF objToWorld;
+      sample.rotation.setMatrix( &objToWorld );
+      objToWorld.setPosition( sample.position );
+
+      MatrixF worldToObj( objToWorld );
+      worldToObj.affineInverse();
+
+      const Point3F& scale = object->getScale();
+      Point3F xformedStart, xformedEnd;
+      worldToObj.mulP( start, &xformedStart );
+      worldToObj.mulP( end, &xformedEnd );
+      xformedStart.convolveInverse( scale );
+      xformedEnd.convolveInverse( scale );
+
+      RayInfo ri;
+      ri.generateTexCoord = info->generateTexCoord;
+      if ( !object->castRay( xformedStart, xformedEnd, &ri ) || ri.t >= currentT )
+         continue;
+
+      *info = ri;
+      info->point.interpolate( start, end, ri.t );
+      info->distance = ( start - info->point ).len();
+
+      PlaneF plane( info->normal.x, info->normal.y, info->normal.z, 0.0f );
+      PlaneF result;
+      mTransformPlane( objToWorld, scale, plane, &result );
+      info->normal = result;
+
+      currentT = ri.t;
+      hit = true;
+   }
+
+   return hit;
+}
+
+//-----------------------------------------------------------------------------
+
+DefineEngineFunction( containerRayCastAtTime, const char*,
+   ( Point3F start, Point3F end, U32 mask, GameConnection* client, SceneObject* pExempt ), ( NULL ),
+   "@brief Cast a ray against the server container as seen by a client.\n\n"
+
+   "Works like containerRayCast() on the server container but tests lag compensated objects "
+   "(see $LagCompensation::objectMask) where they were at the client's view time, which is "
+   "estimated from its round trip time.\n"
+
+   "@param start An XYZ vector containing the tail position of the ray.\n"
+   "@param end An XYZ vector containing the head position of the ray\n"
+   "@param mask A bitmask corresponding to the type of objects to check for\n"
+   "@param client The connection whose view time to rewind to.\n"
+   "@param pExempt An optional ID for a single object that ignored for this raycast\n"
+
+   "@returns A string containing either null, if nothing was struck, or the same fields "
+   "as containerRayCast().\n"
+
+   "@see containerRayCast\n"
+   "@ingroup Game")
+{
+   if ( pExempt )
+      pExempt->disableCollision();
+
+   RayInfo rinfo;
+   S32 ret = 0;
+   if ( LagCompensation::castRayAtTime( &gServerContainer, start, end, mask, &rinfo, LagCompensation::getViewTick( client ) ) )
+      ret = rinfo.object->getId();
+
+   if ( pExempt )
+      pExempt->enableCollision();
+
+   static const U32 bufSize = 256;
+   char *returnBuffer = Con::getReturnBuffer( bufSize );
+   if ( ret )
+   {
+      dSprintf( returnBuffer, bufSize, "%d %g %g %g %g %g %g %g",
+               ret, rinfo.point.x, rinfo.point.y, rinfo.point.z,
+               rinfo.normal.x, rinfo.normal.y, rinfo.normal.z, rinfo.distance );
+   }
+   else
+   {
+      returnBuffer[0] = '0';
+      returnBuffer[1] = '\0';
+   }
+
+   return returnBuffer;
+}
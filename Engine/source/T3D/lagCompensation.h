@@ -0,0 +1,150 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _LAGCOMPENSATION_H_
+#define _LAGCOMPENSATION_H_
+
+#ifndef _MPOINT3_H_
+#include "math/mPoint3.h"
+#endif
+#ifndef _MQUAT_H_
+#include "math/mQuat.h"
+#endif
+#ifndef _MBOX_H_
+#include "math/mBox.h"
+#endif
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+
+class ShapeBase;
+class SceneObject;
+class GameConnection;
+class SceneContainer;
+struct RayInfo;
+
+
+/// Collision state of a ShapeBase at the end of a server tick.
+struct LagCompensationSample
+{
+   /// Server tick this sample was taken at or U32_MAX if unused.
+   U32 tick;
+
+   Point3F position;
+   QuatF rotation;
+   Box3F worldBox;
+};
+
+/// Fixed size ring of the most recent collision samples of one object.
+/// Samples are stored at their tick modulo the ring size, so a lookup is
+/// a single index and a tick compare.
+struct LagCompensationHistory
+{
+   enum { HistorySize = 64 };
+
+   ShapeBase* object;
+
+   /// Index of this history in the list of tracked objects.
+   U32 index;
+
+   LagCompensationSample samples[ HistorySize ];
+};
+
+
+/// Server-side rewind of ShapeBase collision for hit tests.
+///
+/// Clients see other objects as they were roughly one round trip ago.
+/// To register hits against what the shooter actually saw, the server
+/// keeps a short per-object history of transforms and world boxes and
+/// casts rays against the objects as they were at the shooter's view
+/// time.  Everything not tracked (terrain, interiors, static shapes) is
+/// tested in its present state.
+///
+/// Memory is bounded: each tracked object owns one fixed ring of
+/// LagCompensationHistory::HistorySize samples (640ms at the default
+/// tick rate) and nothing is allocated per query.
+class LagCompensation
+{
+public:
+
+   /// If false, no history is recorded and castRayAtTime() tests
+   /// the present.
+   static bool smEnabled;
+
+   /// Type mask of the ShapeBase objects whose history is tracked.
+   static S32 smObjectMask;
+
+   /// Longest rewind in milliseconds that castRayAtTime() will honor.
+   static S32 smMaxRewindMs;
+
+   /// Delay in milliseconds of client interpolation added to the round
+   /// trip time when computing a client's view time.
+   static S32 smInterpolationMs;
+
+   /// Start tracking @a object if it matches #smObjectMask.
+   static void addObject( ShapeBase* object );
+
+   /// Stop tracking @a object.
+   static void removeObject( ShapeBase* object );
+
+   /// Record the state of all tracked objects at the end of @a tick.
+   static void recordTick( U32 tick );
+
+   /// Return the number of tracked objects.
+   static U32 getNumObjects() { return smHistories.size(); }
+
+   /// Return the state of @a object at the possibly fractional server
+   /// @a tick, interpolating between neighbouring samples.  Returns false
+   /// if the object has no history covering @a tick.
+   static bool getSample( const ShapeBase* object, F32 tick, LagCompensationSample* outSample );
+
+   /// Return the server tick the view of @a client corresponds to.  This
+   /// is the current tick minus the client's round trip time and its
+   /// interpolation delay, clamped to #smMaxRewindMs.
+   static F32 getViewTick( GameConnection* client );
+
+   /// Like SceneContainer::castRay() but tests tracked objects as they
+   /// were at server @a tick.  Ticks at or after the last recorded one
+   /// test the present.
+   ///
+   /// @param present Optional object that is always tested in its present
+   ///   state, usually the shooter.
+   static bool castRayAtTime( SceneContainer* container, const Point3F& start, const Point3F& end, U32 mask, RayInfo* info, F32 tick, const SceneObject* present = NULL );
+
+protected:
+
+   static Vector< LagCompensationHistory* > smHistories;
+
+   /// The tick of the last recordTick() call.
+   static U32 smLastTick;
+
+   /// Tick of the castRayAtTime() query in progress.
+   static F32 smQueryTick;
+
+   /// Object tested in its present state by the query in progress.
+   static const SceneObject* smQueryPresent;
+
+   /// Ray cast filter rejecting hits on objects that are rewound.
+   static bool _isPresentHit( RayInfo* info );
+};
+
+#endif // _LAGCOMPENSATION_H_
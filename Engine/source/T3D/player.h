@@ -754,6 +754,7 @@ public:
    void interpolateTick(F32 delta);
    void advanceTime(F32 dt);
    bool castRay(const Point3F &start, const Point3F &end, RayInfo* info);
+   bool isCastRayThreadSafe() const { return true; }
    bool buildPolyList(PolyListContext context, AbstractPolyList* polyList, const Box3F &box, const SphereF &sphere);
    void buildConvex(const Box3F& box, Convex* convex);
    bool isControlObject();
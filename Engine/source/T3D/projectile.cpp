@@ -47,6 +47,7 @@
 #include "T3D/physics/physicsWorld.h"
 #include "gfx/gfxTransformSaver.h"
 #include "T3D/containerQuery.h"
+#include "T3D/lagCompensation.h"
 #include "T3D/decal/decalManager.h"
 #include "T3D/decal/decalData.h"
 #include "T3D/lightDescription.h"
@@ -162,6 +163,7 @@ ProjectileData::ProjectileData()
 	velInheritFactor = 1.0f;
 	muzzleVelocity = 50;
    impactForce = 0.0f;
+   lagCompensated = false;
 
 	armingDelay = 0;
    fadeDelay = 20000 / 32;
@@ -246,6 +248,13 @@ void ProjectileData::initPersistFields()
    
    addField("impactForce", TypeF32, Offset(impactForce, ProjectileData));
 
+   addField("lagCompensated", TypeBool, Offset(lagCompensated, ProjectileData),
+      "@brief If true, the server tests hits against players and vehicles where the "
+      "client that fired the projectile saw them.\n\n"
+      "Only projectiles whose source object is controlled by a client are compensated.\n"
+      "@note This value is not transmitted between the server and the client.\n\n"
+      "@see containerRayCastAtTime");
+
    addProtectedField("lifetime", TypeS32, Offset(lifetime, ProjectileData), &setLifetime, &getScaledValue, 
       "@brief Amount of time, in milliseconds, before the projectile is removed from the simulation.\n\n"
       "Used with fadeDelay to determine the transparency of the projectile at a given time. "
@@ -1104,6 +1113,13 @@ void Projectile::simulate( F32 dt )
 
    if ( mPhysicsWorld )
       hit = mPhysicsWorld->castRay( oldPosition, newPosition, &rInfo, Point3F( newPosition - oldPosition) * mDataBlock->impactForce );            
+   else if ( isServerObject() && mDataBlock->lagCompensated && mSourceObject.isValid() && mSourceObject->getControllingClient() )
+   {
+      // Test targets where the shooter saw them.  The shooter itself is
+      // where it is now.
+      const F32 viewTick = LagCompensation::getViewTick( mSourceObject->getControllingClient() );
+      hit = LagCompensation::castRayAtTime( getContainer(), oldPosition, newPosition, csmDynamicCollisionMask | csmStaticCollisionMask, &rInfo, viewTick, mSourceObject );
+   }
    else 
       hit = getContainer()->castRay(oldPosition, newPosition, csmDynamicCollisionMask | csmStaticCollisionMask, &rInfo);
 
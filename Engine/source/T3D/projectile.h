@@ -81,6 +81,9 @@ public:
    /// Force imparted on a hit object.
    F32 impactForce;
 
+   /// Should the server test hits against targets as the shooter saw them?
+   bool lagCompensated;
+
    /// Should it arc?
    bool isBallistic;
 
@@ -35,6 +35,7 @@
 #include "core/stream/bitStream.h"
 #include "ts/tsPartInstance.h"
 #include "ts/tsShapeInstance.h"
+#include "ts/tsAnimBatch.h"
 #include "ts/tsMaterialList.h"
 #include "scene/sceneManager.h"
 #include "scene/sceneRenderState.h"
@@ -46,6 +47,8 @@
 #include "T3D/debris.h"
 #include "T3D/physicalZone.h"
 #include "T3D/containerQuery.h"
+#include "T3D/lagCompensation.h"
+#include "gui/3d/guiTSControl.h"
 #include "math/mathUtils.h"
 #include "math/mMatrix.h"
 #include "math/mTransform.h"
@@ -173,6 +176,7 @@ ShapeBaseData::ShapeBaseData()
    cameraMaxFov( 120.f ),
    cameraCanBank( false ),
    mountedImagesBank( false ),
+   animateUsedNodesOnly( false ),
    isInvincible( false ),
    renderWhenDestroyed( true ),
    debris( NULL ),
@@ -483,6 +487,23 @@ void ShapeBaseData::initPersistFields()
 
    endGroup( "Render" );
 
+   addGroup( "Animation LOD", "Reduce the cost of animating shapes that are small on screen." );
+
+      addField( "animFullRatePixels", TypeF32, Offset(animThrottle.fullRatePixels, ShapeBaseData),
+         "Projected radius in pixels at or above which the shape animates every frame.\n"
+         "Smaller shapes animate less often and interpolate the frames in between. "
+         "0 disables throttling." );
+      addField( "animFrozenPixels", TypeF32, Offset(animThrottle.frozenPixels, ShapeBaseData),
+         "Projected radius in pixels below which the shape stops animating and keeps its "
+         "last pose. 0 never freezes the shape." );
+      addField( "animMaxUpdateInterval", TypeS32, Offset(animThrottle.maxUpdateInterval, ShapeBaseData),
+         "Most frames between two animation updates, reached just above animFrozenPixels." );
+      addField( "animateUsedNodesOnly", TypeBool, Offset(animateUsedNodesOnly, ShapeBaseData),
+         "Only animate the nodes used by the meshes of the current detail level.\n"
+         "The eye, ear, camera and mount point nodes are always animated." );
+
+   endGroup( "Animation LOD" );
+
    addGroup( "Destruction", "Parameters related to the destruction effects of this object." );
 
       addField( "explosion", TYPEID< ExplosionData >(), Offset(explosion, ShapeBaseData),
@@ -700,6 +721,11 @@ void ShapeBaseData::packData(BitStream* stream)
       stream->write(cameraMaxFov);
    stream->writeFlag(cameraCanBank);
    stream->writeFlag(mountedImagesBank);
+
+   stream->write(animThrottle.fullRatePixels);
+   stream->write(animThrottle.frozenPixels);
+   stream->write(animThrottle.maxUpdateInterval);
+   stream->writeFlag(animateUsedNodesOnly);
    stream->writeString( debrisShapeName );
 
    stream->writeFlag(observeThroughObject);
@@ -802,6 +828,11 @@ void ShapeBaseData::unpackData(BitStream* stream)
    cameraCanBank = stream->readFlag();
    mountedImagesBank = stream->readFlag();
 
+   stream->read(&animThrottle.fullRatePixels);
+   stream->read(&animThrottle.frozenPixels);
+   stream->read(&animThrottle.maxUpdateInterval);
+   animateUsedNodesOnly = stream->readFlag();
+
    debrisShapeName = stream->readSTString();
 
    observeThroughObject = stream->readFlag();
@@ -916,7 +947,8 @@ ShapeBase::ShapeBase()
    mMass( 1.0f ),
    mOneOverMass( 1.0f ),
    mMoveMotion( false ),
-   mIsAiControlled( false )
+   mIsAiControlled( false ),
+   mLagHistory( NULL )
 {
    mTypeMask |= ShapeBaseObjectType | LightObjectType;   
 
@@ -1047,6 +1079,9 @@ bool ShapeBase::onAdd()
         mCloakTexture = TextureHandle(mDataBlock->cloakTexName, MeshTexture, false);
 */         
 
+   if ( isServerObject() )
+      LagCompensation::addObject( this );
+
    return true;
 }
 
@@ -1054,6 +1089,8 @@ void ShapeBase::onRemove()
 {
    mConvexList->nukeList();
 
+   LagCompensation::removeObject( this );
+
    Parent::onRemove();
 
    // Stop any running sounds on the client
@@ -1107,6 +1144,23 @@ bool ShapeBase::onNewDataBlock( GameBaseData *dptr, bool reload )
       if (isClientObject())
          mShapeInstance->cloneMaterialList();
 
+      if (mDataBlock->animateUsedNodesOnly)
+      {
+         mShapeInstance->setAnimateUsedNodesOnly(true);
+
+         // Nodes the object looks up even if no mesh uses them.
+         if (mDataBlock->eyeNode != -1)
+            mShapeInstance->addAlwaysAnimatedNode(mDataBlock->eyeNode);
+         if (mDataBlock->earNode != -1)
+            mShapeInstance->addAlwaysAnimatedNode(mDataBlock->earNode);
+         if (mDataBlock->cameraNode != -1)
+            mShapeInstance->addAlwaysAnimatedNode(mDataBlock->cameraNode);
+         for (S32 i = 0; i < SceneObject::NumMountPoints; i++)
+            if (mDataBlock->mountPointNode[i] != -1)
+               mShapeInstance->addAlwaysAnimatedNode(mDataBlock->mountPointNode[i]);
+      }
+      mAnimThrottle.reset();
+
       mObjBox = mDataBlock->mShape->bounds;
       resetWorldBox();
 
@@ -2414,6 +2468,62 @@ void ShapeBase::prepRenderImage( SceneRenderState *state )
    _prepRenderImage( state, true, true );
 }
 
+bool ShapeBase::_isForcedHighestDetail()
+{
+   GameConnection *con = GameConnection::getConnectionToServer();
+   ShapeBase *co = NULL;
+   if(con && ( (co = dynamic_cast<ShapeBase*>(con->getControlObject())) != NULL) )
+   {
+      if(co == this || co->getObjectMount() == this)
+         return true;
+   }
+
+   return false;
+}
+
+F32 ShapeBase::_getRenderDistance( SceneRenderState *state )
+{
+   Point3F cameraOffset = getWorldBox().getClosestPoint( state->getDiffuseCameraPosition() ) - state->getDiffuseCameraPosition();
+   F32 dist = cameraOffset.len();
+   if (dist < 0.01f)
+      dist = 0.01f;
+
+   return dist;
+}
+
+void ShapeBase::prepBatchAnimation( SceneRenderState *state, TSAnimBatch *batch )
+{
+   if ( !mShapeInstance )
+      return;
+
+   if( ( getDamageState() == Destroyed ) && ( !mDataBlock->renderWhenDestroyed ) )
+      return;
+
+   if ( mMeshHidden.getSize() > 0 && mMeshHidden.testAll() )   
+      return;
+
+   if ( mCubeReflector.isRendering() )
+      return;
+
+   // The control object is animated at the highest detail
+   // level by _prepRenderImage().
+   if ( _isForcedHighestDetail() )
+      return;
+
+   // Select the same detail level _prepRenderImage() will.
+   const F32 dist = _getRenderDistance( state );
+   const F32 invScale = (1.0f/getMax(getMax(mObjScale.x,mObjScale.y),mObjScale.z));
+   mShapeInstance->setDetailFromDistance( state, dist * invScale );
+   if ( mShapeInstance->getCurrentDetail() < 0 )
+      return;
+
+   // Throttled shapes interpolate their pose in _prepRenderImage(),
+   // so only those animating every frame are batched.
+   const F32 pixelRadius = state->projectRadius( dist, getWorldSphere().radius );
+   if ( TSAnimThrottle::getUpdateInterval( mDataBlock->animThrottle, pixelRadius ) == 1 )
+      batch->add( mShapeInstance );
+}
+
 void ShapeBase::_prepRenderImage(   SceneRenderState *state, 
                                     bool renderSelf, 
                                     bool renderMountedImages )
@@ -2442,24 +2552,12 @@ void ShapeBase::_prepRenderImage(   SceneRenderState *state,
 
    // We force all the shapes to use the highest detail
    // if we're the control object or mounted.
-   bool forceHighestDetail = false;
-   {
-      GameConnection *con = GameConnection::getConnectionToServer();
-      ShapeBase *co = NULL;
-      if(con && ( (co = dynamic_cast<ShapeBase*>(con->getControlObject())) != NULL) )
-      {
-         if(co == this || co->getObjectMount() == this)
-            forceHighestDetail = true;
-      }
-   }
+   const bool forceHighestDetail = _isForcedHighestDetail();
 
    mLastRenderFrame = sLastRenderFrame;
 
    // get shape detail...we might not even need to be drawn
-   Point3F cameraOffset = getWorldBox().getClosestPoint( state->getDiffuseCameraPosition() ) - state->getDiffuseCameraPosition();
-   F32 dist = cameraOffset.len();
-   if (dist < 0.01f)
-      dist = 0.01f;
+   F32 dist = _getRenderDistance( state );
 
    F32 invScale = (1.0f/getMax(getMax(mObjScale.x,mObjScale.y),mObjScale.z));
 
@@ -2470,7 +2568,13 @@ void ShapeBase::_prepRenderImage(   SceneRenderState *state,
       else
          mShapeInstance->setDetailFromDistance( state, dist * invScale );
                               
-      mShapeInstance->animate();
+      if ( forceHighestDetail )
+         mShapeInstance->animate();
+      else
+      {
+         const F32 pixelRadius = state->projectRadius( dist, getWorldSphere().radius );
+         mAnimThrottle.animate( mShapeInstance, mDataBlock->animThrottle, pixelRadius, GuiTSCtrl::getFrameCount() );
+      }
    }
    
    if (  ( mShapeInstance && mShapeInstance->getCurrentDetail() < 0 ) ||
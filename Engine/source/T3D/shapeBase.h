@@ -62,6 +62,9 @@
 #ifndef _DYNAMIC_CONSOLETYPES_H_
    #include "console/dynamicTypes.h"
 #endif
+#ifndef _TSANIMTHROTTLE_H_
+   #include "ts/tsAnimThrottle.h"
+#endif
 
 
 class GFXCubemap;
@@ -76,6 +79,7 @@ class ProjectileData;
 class ExplosionData;
 struct DebrisData;
 class ShapeBase;
+struct LagCompensationHistory;
 class SFXSource;
 class SFXTrack;
 class SFXProfile;
@@ -584,6 +588,12 @@ public:
    bool mountedImagesBank;          ///< Do mounted images bank along with the camera?
    /// @}
 
+   /// @name Animation Level of Detail
+   /// @{
+   TSAnimThrottle::Settings animThrottle; ///< Animation update rate by projected size
+   bool animateUsedNodesOnly;       ///< Only animate nodes used by the current detail level
+   /// @}
+
    /// @name Data initialized on preload
    /// @{
 
@@ -671,6 +681,7 @@ class ShapeBase : public GameBase, public ISceneLight
    friend struct ShapeBaseImageData;
    friend void waterFind(SceneObject*, void*);
    friend void physicalZoneFind(SceneObject*, void*);
+   friend class LagCompensation;
 
 public:
    typedef GameBase Parent;
@@ -747,6 +758,11 @@ protected:
    bool mMoveMotion;    ///< Indicates that a Move has come in requesting x, y or z motion
    /// @}
 
+   /// Collision history kept for server-side lag compensation or NULL
+   /// if the object is not tracked.
+   /// @see LagCompensation
+   LagCompensationHistory* mLagHistory;
+
 protected:
 
    // ShapeBase pointer to our mount object if it is ShapeBase, else it is NULL.
@@ -990,6 +1006,9 @@ protected:
    U32 mLastRenderFrame;
    F32 mLastRenderDistance;
 
+   /// Throttles the animation of distant shapes.
+   TSAnimThrottle mAnimThrottle;
+
    /// Do a reskin if necessary.
    virtual void reSkin();
 
@@ -1116,6 +1135,15 @@ protected:
                            bool renderSelf, 
                            bool renderMountedImages );
 
+   /// Returns true if this is the control object or the control
+   /// object is mounted to it, in which case it renders at the
+   /// highest detail level.
+   bool _isForcedHighestDetail();
+
+   /// Returns the distance from the camera to the world box used
+   /// for detail selection.
+   F32 _getRenderDistance( SceneRenderState* state );
+
    /// Renders the shape bounds as well as the 
    /// bounds of all mounted shape images.
    void _renderBoundingBox( ObjectRenderInst *ri, SceneRenderState *state, BaseMatInstance* );
@@ -1765,6 +1793,9 @@ public:
    /// @see SceneObject
    virtual void prepRenderImage( SceneRenderState* state );
 
+   /// @see SceneObject
+   virtual void prepBatchAnimation( SceneRenderState* state, TSAnimBatch* batch );
+
    /// Used from ShapeBase::_prepRenderImage() to submit render 
    /// instances for the main shape or its mounted elements.
    virtual void prepBatchRender( SceneRenderState *state, S32 mountedImageIndex );
@@ -0,0 +1,158 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "T3D/lagCompensation.h"
+#include "T3D/shapeBase.h"
+#include "scene/sceneContainer.h"
+#include "collision/collision.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+/// Unregistered player stand-in that collides rays with its object box.
+class LagCompensationTestObject : public ShapeBase
+{
+public:
+
+   LagCompensationTestObject()
+   {
+      mTypeMask = ShapeBaseObjectType | PlayerObjectType;
+      mObjBox.minExtents.set( -0.5f, -0.5f, 0.0f );
+      mObjBox.maxExtents.set( 0.5f, 0.5f, 2.0f );
+      setPosition( Point3F::Zero );
+   }
+
+   void setPosition( const Point3F& pos )
+   {
+      MatrixF mat( true );
+      mat.setPosition( pos );
+      setTransform( mat );
+   }
+
+   virtual bool castRay( const Point3F& start, const Point3F& end, RayInfo* info )
+   {
+      if( !mObjBox.collideLine( start, end, &info->t, &info->normal ) )
+         return false;
+
+      info->object = this;
+      return true;
+   }
+};
+
+// Moves a tracked object along X over several ticks and checks that
+// casts at an earlier tick hit it where it was then.
+
+CreateUnitTest( TestLagCompensation, "T3D/LagCompensation" )
+{
+   enum
+   {
+      FIRST_TICK = 1000,
+      NUM_TICKS = 10,
+   };
+
+   /// Position of the test object at @a tick.
+   static Point3F getPosition( U32 tick )
+   {
+      return Point3F( F32( tick - FIRST_TICK ) * 2.0f, 0.0f, 0.0f );
+   }
+
+   /// Cast a ray along Y through @a x at tick @a tick.
+   static bool castAt( SceneContainer& container, F32 x, F32 tick, RayInfo* info, const SceneObject* present = NULL )
+   {
+      return LagCompensation::castRayAtTime( &container,
+         Point3F( x, -10.0f, 1.0f ), Point3F( x, 10.0f, 1.0f ), PlayerObjectType, info, tick, present );
+   }
+
+   void run()
+   {
+      const bool wasEnabled = LagCompensation::smEnabled;
+      const S32 oldMask = LagCompensation::smObjectMask;
+      LagCompensation::smEnabled = true;
+      LagCompensation::smObjectMask = PlayerObjectType;
+
+      SceneContainer container;
+      LagCompensationTestObject* object = new LagCompensationTestObject;
+      container.addObject( object );
+      LagCompensation::addObject( object );
+
+      for( U32 tick = FIRST_TICK; tick < FIRST_TICK + NUM_TICKS; ++ tick )
+      {
+         object->setPosition( getPosition( tick ) );
+         LagCompensation::recordTick( tick );
+      }
+
+      const U32 lastTick = FIRST_TICK + NUM_TICKS - 1;
+      const F32 pastX = getPosition( FIRST_TICK + 2 ).x;
+      const F32 presentX = getPosition( lastTick ).x;
+
+      // The rewound cast hits the old position and misses the present one.
+      RayInfo info;
+      TEST( castAt( container, pastX, FIRST_TICK + 2, &info ) && info.object == object );
+      TEST( !castAt( container, presentX, FIRST_TICK + 2, &info ) );
+
+      // At the last recorded tick the object is where it is now.
+      TEST( castAt( container, presentX, lastTick, &info ) && info.object == object );
+      TEST( !castAt( container, pastX, lastTick, &info ) );
+
+      // An exempt object is tested in its present state.
+      TEST( !castAt( container, pastX, FIRST_TICK + 2, &info, object ) );
+      TEST( castAt( container, presentX, FIRST_TICK + 2, &info, object ) && info.object == object );
+
+      // Samples blend between neighbouring ticks.
+      LagCompensationSample sample;
+      TEST( LagCompensation::getSample( object, FIRST_TICK + 2.25f, &sample ) );
+      TEST( mFabs( sample.position.x - ( pastX + 0.5f ) ) < 0.001f );
+      TEST( mFabs( sample.worldBox.minExtents.x - pastX ) < 0.001f );
+      TEST( !LagCompensation::getSample( object, FIRST_TICK - 1, &sample ) );
+
+      // The ring keeps the last HistorySize ticks and drops older ones.
+      const U32 wrapTick = FIRST_TICK + LagCompensationHistory::HistorySize + 4;
+      for( U32 tick = FIRST_TICK + NUM_TICKS; tick <= wrapTick; ++ tick )
+      {
+         object->setPosition( getPosition( tick ) );
+         LagCompensation::recordTick( tick );
+      }
+
+      const U32 oldestTick = wrapTick - LagCompensationHistory::HistorySize + 1;
+      TEST( !LagCompensation::getSample( object, FIRST_TICK + 2, &sample ) );
+      TEST( !LagCompensation::getSample( object, oldestTick - 1, &sample ) );
+      TEST( LagCompensation::getSample( object, oldestTick, &sample ) &&
+            mFabs( sample.position.x - getPosition( oldestTick ).x ) < 0.001f );
+
+      // Older than the history, the object is tested where it is now.
+      TEST( !castAt( container, pastX, FIRST_TICK + 2, &info ) );
+      TEST( castAt( container, getPosition( wrapTick ).x, FIRST_TICK + 2, &info ) && info.object == object );
+
+      LagCompensation::removeObject( object );
+      container.removeObject( object );
+      delete object;
+
+      LagCompensation::smEnabled = wasEnabled;
+      LagCompensation::smObjectMask = oldMask;
+   }
+};
+
+#endif // !TORQUE_SHIPPING
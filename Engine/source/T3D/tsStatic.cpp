@@ -32,6 +32,7 @@
 #include "math/mathIO.h"
 #include "ts/tsShapeInstance.h"
 #include "ts/tsMaterialList.h"
+#include "ts/tsAnimBatch.h"
 #include "console/consoleTypes.h"
 #include "T3D/shapeBase.h"
 #include "sim/netConnection.h"
@@ -48,6 +49,7 @@
 #include "materials/materialFeatureData.h"
 #include "materials/materialFeatureTypes.h"
 #include "console/engineAPI.h"
+#include "gui/3d/guiTSControl.h"
 
 // andrewmac: Cloth Addon
 #include "T3D/physics/physicsCloth.h"
@@ -103,6 +105,7 @@ TSStatic::TSStatic()
 
    mPlayAmbient      = true;
    mAmbientThread    = NULL;
+   mAnimateUsedNodesOnly = false;
 
    mAllowPlayerStep = true;
 
@@ -186,6 +189,17 @@ void TSStatic::initPersistFields()
          "with large complex shapes like buildings which contain many submeshes." );
       addField( "originSort",    TypeBool,   Offset( mUseOriginSort, TSStatic ), 
          "Enables translucent sorting of the TSStatic by its origin instead of the bounds." );
+      addField( "animFullRatePixels", TypeF32, Offset( mAnimThrottleSettings.fullRatePixels, TSStatic ),
+         "Projected radius in pixels at or above which the shape animates every frame.\n"
+         "Smaller shapes animate less often and interpolate the frames in between. "
+         "0 disables throttling." );
+      addField( "animFrozenPixels", TypeF32, Offset( mAnimThrottleSettings.frozenPixels, TSStatic ),
+         "Projected radius in pixels below which the shape stops animating and keeps its "
+         "last pose. 0 never freezes the shape." );
+      addField( "animMaxUpdateInterval", TypeS32, Offset( mAnimThrottleSettings.maxUpdateInterval, TSStatic ),
+         "Most frames between two animation updates, reached just above animFrozenPixels." );
+      addField( "animateUsedNodesOnly", TypeBool, Offset( mAnimateUsedNodesOnly, TSStatic ),
+         "Only animate the nodes used by the meshes of the current detail level." );
 
    endGroup("Rendering");
 
@@ -337,6 +351,8 @@ bool TSStatic::_createShape()
     resetWorldBox();
 
     mShapeInstance = new TSShapeInstance( mShape, isClientObject() );
+    mShapeInstance->setAnimateUsedNodesOnly( mAnimateUsedNodesOnly );
+    mAnimThrottle.reset();
 
     if( isGhost() )
     {
@@ -528,11 +544,8 @@ void TSStatic::_updateShouldTick()
         setProcessTick(true);
 }
 
-void TSStatic::prepRenderImage( SceneRenderState* state )
+F32 TSStatic::_getRenderDistance( SceneRenderState *state )
 {
-   if( !mShapeInstance )
-      return;
-
    Point3F cameraOffset;
    getRenderTransform().getColumn(3,&cameraOffset);
    cameraOffset -= state->getDiffuseCameraPosition();
@@ -540,6 +553,34 @@ void TSStatic::prepRenderImage( SceneRenderState* state )
    if (dist < 0.01f)
       dist = 0.01f;
 
+   return dist;
+}
+
+void TSStatic::prepBatchAnimation( SceneRenderState* state, TSAnimBatch* batch )
+{
+   // Only shapes playing their ambient animation at the distance
+   // based detail level are batched.
+   if( !mShapeInstance || !mAmbientThread || mForceDetail != -1 )
+      return;
+
+   const F32 dist = _getRenderDistance( state );
+   F32 invScale = (1.0f/getMax(getMax(mObjScale.x,mObjScale.y),mObjScale.z));   
+   mShapeInstance->setDetailFromDistance( state, dist * invScale );
+   if ( mShapeInstance->getCurrentDetail() < 0 )
+      return;
+
+   const F32 pixelRadius = state->projectRadius( dist, getWorldSphere().radius );
+   if ( TSAnimThrottle::getUpdateInterval( mAnimThrottleSettings, pixelRadius ) == 1 )
+      batch->add( mShapeInstance );
+}
+
+void TSStatic::prepRenderImage( SceneRenderState* state )
+{
+   if( !mShapeInstance )
+      return;
+
+   F32 dist = _getRenderDistance( state );
+
    F32 invScale = (1.0f/getMax(getMax(mObjScale.x,mObjScale.y),mObjScale.z));   
 
    if ( mForceDetail == -1 )
@@ -582,7 +623,14 @@ void TSStatic::prepRenderImage( SceneRenderState* state )
    mat.scale( mObjScale );
    GFX->setWorldMatrix( mat );
 
-   mShapeInstance->animate();
+   if ( mForceDetail == -1 )
+   {
+      const F32 pixelRadius = state->projectRadius( dist, getWorldSphere().radius );
+      mAnimThrottle.animate( mShapeInstance, mAnimThrottleSettings, pixelRadius, GuiTSCtrl::getFrameCount() );
+   }
+   else
+      mShapeInstance->animate();
+
    mShapeInstance->render( rdata );
 
    if ( mRenderNormalScalar > 0 )
@@ -663,6 +711,11 @@ U32 TSStatic::packUpdate(NetConnection *con, U32 mask, BitStream *stream)
 
    stream->writeFlag( mPlayAmbient );
 
+   stream->write( mAnimThrottleSettings.fullRatePixels );
+   stream->write( mAnimThrottleSettings.frozenPixels );
+   stream->write( mAnimThrottleSettings.maxUpdateInterval );
+   stream->writeFlag( mAnimateUsedNodesOnly );
+
    if ( mLightPlugin )
       retMask |= mLightPlugin->packUpdate(this, AdvancedStaticOptionsMask, con, mask, stream);
 
@@ -726,6 +779,13 @@ void TSStatic::unpackUpdate(NetConnection *con, BitStream *stream)
 
    mPlayAmbient = stream->readFlag();
 
+   stream->read( &mAnimThrottleSettings.fullRatePixels );
+   stream->read( &mAnimThrottleSettings.frozenPixels );
+   stream->read( &mAnimThrottleSettings.maxUpdateInterval );
+   mAnimateUsedNodesOnly = stream->readFlag();
+   if ( mShapeInstance )
+      mShapeInstance->setAnimateUsedNodesOnly( mAnimateUsedNodesOnly );
+
    if ( mLightPlugin )
    {
       mLightPlugin->unpackUpdate(this, con, stream);
@@ -38,6 +38,9 @@
 #ifndef _TSSHAPE_H_
     #include "ts/tsShape.h"
 #endif
+#ifndef _TSANIMTHROTTLE_H_
+    #include "ts/tsAnimThrottle.h"
+#endif
 
 class TSShapeInstance;
 class TSThread;
@@ -116,6 +119,7 @@ protected:
    // Collision
    void prepCollision();
    bool castRay(const Point3F &start, const Point3F &end, RayInfo* info);
+   bool isCastRayThreadSafe() const { return mCollisionType == None || mCollisionType == Bounds; }
    bool castRayRendered(const Point3F &start, const Point3F &end, RayInfo* info);
    bool buildPolyList(PolyListContext context, AbstractPolyList* polyList, const Box3F &box, const SphereF& sphere);
    void buildConvex(const Box3F& box, Convex* convex);
@@ -126,6 +130,9 @@ protected:
 
    void _renderNormals( ObjectRenderInst *ri, SceneRenderState *state, BaseMatInstance *overrideMat );
 
+   /// Returns the camera distance used for detail selection.
+   F32 _getRenderDistance( SceneRenderState *state );
+
    void _onResourceChanged( const Torque::Path &path );
 
    // ProcessObject
@@ -153,6 +160,13 @@ protected:
    bool              mPlayAmbient;
    TSThread*         mAmbientThread;
 
+   /// Animation update rate by projected size.
+   TSAnimThrottle::Settings mAnimThrottleSettings;
+   TSAnimThrottle    mAnimThrottle;
+
+   /// Only animate the nodes used by the current detail level.
+   bool              mAnimateUsedNodesOnly;
+
    // andrewmac: PhysX3 Cloth Add-on
    bool              mEnablePhysicsRep;
    bool              mClothEnabled;
@@ -204,6 +218,7 @@ public:
    void setTransform( const MatrixF &mat );
    void onScaleChanged();
    void prepRenderImage( SceneRenderState *state );
+   void prepBatchAnimation( SceneRenderState *state, TSAnimBatch *batch );
    void inspectPostApply();
 
    /// The type of mesh data use for collision queries.
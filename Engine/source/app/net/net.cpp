@@ -31,8 +31,85 @@
 #include "sim/netObject.h"
 #include "app/net/serverQuery.h"
 #include "console/engineAPI.h"
+#include "core/module.h"
+#include "platform/profiler.h"
 #include <vector>
 #include "net.h"
+
+//----------------------------------------------------------------
+// shared remote command arguments
+//----------------------------------------------------------------
+
+   RemoteCommandPayload::RemoteCommandPayload(S32 argc, const char **argv)
+   {
+      static InfiniteBitStream sScratch;
+      sScratch.reset();
+
+      mArgc = argc;
+
+      for(S32 i = 0; i < argc; i++)
+      {
+         if(U8(argv[i][0]) == StringTagPrefixByte)
+         {
+            mSegments.increment();
+            Segment &seg = mSegments.last();
+            seg.isTag = true;
+            seg.tag = NetStringHandle(dAtoi(argv[i] + 1));
+            seg.offset = 0;
+            seg.bitCount = 0;
+            continue;
+         }
+
+         // start a new run after a tag, or for the first argument.
+         if(!mSegments.size() || mSegments.last().isTag)
+         {
+            // runs are byte aligned so they can be copied with writeBits.
+            sScratch.setCurPos((sScratch.getCurPos() + 7) & ~7);
+
+            mSegments.increment();
+            Segment &seg = mSegments.last();
+            seg.isTag = false;
+            seg.offset = sScratch.getCurPos() >> 3;
+            seg.bitCount = 0;
+         }
+
+         Segment &run = mSegments.last();
+         NetConnection::packString(&sScratch, argv[i]);
+         run.bitCount = sScratch.getCurPos() - (run.offset << 3);
+      }
+
+      mDataSize = sScratch.getPosition();
+      mData = (U8 *) dMalloc(getMax(mDataSize, U32(1)));
+      dMemcpy(mData, sScratch.getBuffer(), mDataSize);
+   }
+
+   RemoteCommandPayload::~RemoteCommandPayload()
+   {
+      dFree(mData);
+   }
+
+   void RemoteCommandPayload::validate(NetConnection *conn, U16 *outIds)
+   {
+      for(S32 i = 0; i < mSegments.size(); i++)
+      {
+         if(mSegments[i].isTag)
+            *outIds++ = conn->checkString(mSegments[i].tag);
+      }
+   }
+
+   void RemoteCommandPayload::pack(BitStream *bstream, const U16 *ids) const
+   {
+      bstream->writeInt(mArgc, RemoteCommandEvent::CommandArgsBits);
+      for(S32 i = 0; i < mSegments.size(); i++)
+      {
+         const Segment &seg = mSegments[i];
+         if(seg.isTag)
+            NetConnection::packTagString(bstream, *ids++);
+         else
+            bstream->writeBits(seg.bitCount, mData + seg.offset);
+      }
+   }
+
 //----------------------------------------------------------------
 // remote procedure call console functions
 //----------------------------------------------------------------
@@ -59,11 +136,19 @@
       }
    }
 
+   RemoteCommandEvent::RemoteCommandEvent(RemoteCommandPayload *payload, NetConnection *conn)
+   {
+      mArgc = 0;
+      mPayload = payload;
+      payload->validate(conn, mPayloadTagIds);
+   }
+
 #ifdef TORQUE_DEBUG_NET
    const char *RemoteCommandEvent::getDebugName()
    {
       static char buffer[256];
-      dSprintf(buffer, sizeof(buffer), "%s [%s]", getClassName(), mTagv[1].isValidString() ? mTagv[1].getString() : "--unknown--" );
+      NetStringHandle &tag = mPayload ? mPayload->getCommand() : mTagv[1];
+      dSprintf(buffer, sizeof(buffer), "%s [%s]", getClassName(), tag.isValidString() ? tag.getString() : "--unknown--" );
       return buffer;
    }
 #endif
@@ -76,6 +161,12 @@
 
    void RemoteCommandEvent::pack(NetConnection* conn, BitStream *bstream)
    {
+      if(mPayload)
+      {
+         mPayload->pack(bstream, mPayloadTagIds);
+         return;
+      }
+
       bstream->writeInt(mArgc, CommandArgsBits);
       // write it out reversed... why?
       // automatic string substitution with later arguments -
@@ -134,8 +225,16 @@
          char *temp = mArgv[1];
          mArgv[1] = mBuf;
 
+         // if this isn't the connection to the server (i.e. a simulated
+         // client), make it so while the command runs, so that any
+         // commandToServer() replies go back the way the command came.
+         SimObjectPtr<NetConnection> serverConnection = NetConnection::getConnectionToServer();
+         NetConnection::setConnectionToServer(conn);
+
          Con::execute(mArgc, (const char **) mArgv+1);
          mArgv[1] = temp;
+
+         NetConnection::setConnectionToServer(serverConnection);
       }
       else
       {
@@ -172,6 +271,42 @@
 	   conn->postNetEvent(cevt);
 	   }
 
+   void RemoteCommandEvent::broadcastRemoteCommand(S32 argc, const char **argv)
+	   {
+	   PROFILE_SCOPE(RemoteCommandEvent_broadcastRemoteCommand);
+
+	   if(U8(argv[0][0]) != StringTagPrefixByte)
+		   {
+		   Con::errorf(ConsoleLogEntry::Script, "Remote Command Error - command must be a tag.");
+		   return;
+		   }
+	   S32 i;
+	   for(i = argc - 1; i >= 0; i--)
+		   {
+		   if(argv[i][0] != 0)
+			   break;
+		   argc = i;
+		   }
+
+	   SimGroup *clients = Sim::getClientGroup();
+	   if(!clients->size())
+		   return;
+
+	   StrongRefPtr<RemoteCommandPayload> payload = new RemoteCommandPayload(argc, argv);
+	   smBroadcastCount++;
+	   smBroadcastPackedBytes += payload->getDataSize();
+
+	   for(SimGroup::iterator itr = clients->begin(); itr != clients->end(); itr++)
+		   {
+		   NetConnection *conn = dynamic_cast<NetConnection *>(*itr);
+		   if(!conn || !conn->isEstablished())
+			   continue;
+		   conn->postNetEvent(new RemoteCommandEvent(payload, conn));
+		   smBroadcastRecipients++;
+		   smBroadcastSharedBytes += payload->getDataSize();
+		   }
+	   }
+
    const char* RemoteCommandEvent::getTaggedString(const char* tag)
 	{
 	const char *indexPtr = tag;
@@ -200,6 +335,27 @@
 
 char RemoteCommandEvent::mBuf[1024];
 
+S32 RemoteCommandEvent::smBroadcastCount = 0;
+S32 RemoteCommandEvent::smBroadcastRecipients = 0;
+S32 RemoteCommandEvent::smBroadcastPackedBytes = 0;
+S32 RemoteCommandEvent::smBroadcastSharedBytes = 0;
+
+AFTER_MODULE_INIT( Sim )
+{
+   Con::addVariable( "$Stats::netBroadcasts", TypeS32, &RemoteCommandEvent::smBroadcastCount,
+      "Number of commands sent with commandToAllClients().\n"
+      "@ingroup Networking\n" );
+   Con::addVariable( "$Stats::netBroadcastRecipients", TypeS32, &RemoteCommandEvent::smBroadcastRecipients,
+      "Total number of clients that commands sent with commandToAllClients() were posted to.\n"
+      "@ingroup Networking\n" );
+   Con::addVariable( "$Stats::netBroadcastPackedBytes", TypeS32, &RemoteCommandEvent::smBroadcastPackedBytes,
+      "Bytes of command arguments packed by commandToAllClients().  Each command is only packed once.\n"
+      "@ingroup Networking\n" );
+   Con::addVariable( "$Stats::netBroadcastSharedBytes", TypeS32, &RemoteCommandEvent::smBroadcastSharedBytes,
+      "Bytes of packed command arguments sent by commandToAllClients(), summed over all recipients.\n"
+      "@ingroup Networking\n" );
+}
+
 IMPLEMENT_CO_NETEVENT_V1(RemoteCommandEvent);
 
 ConsoleDocClass( RemoteCommandEvent,
@@ -295,6 +451,30 @@ ConsoleFunction( commandToClient, void, 3, RemoteCommandEvent::MaxRemoteCommandA
 
 
 
+ConsoleFunction( commandToAllClients, void, 2, RemoteCommandEvent::MaxRemoteCommandArgs + 1, "(string func, ...)"
+   "@brief Send a command from the server to every client in the ClientGroup.\n\n"
+
+   "This has the same effect as calling commandToClient() for each client, but the arguments "
+   "are only packed once and the packed data is shared by all of the clients.  Use it for "
+   "messages that go to everybody, such as chat or HUD updates.  The $Stats::netBroadcast* "
+   "variables count the commands, recipients and bytes sent this way.\n\n"
+
+   "@param func Name of the client function being called\n"
+   "@param ... Various parameters being passed to client command\n\n"
+
+   "@tsexample\n"
+      "function messageAll(%msgType, %msgString, %a1, %a2)\n"
+      "{\n"
+      "   commandToAllClients('ServerMessage', %msgType, %msgString, %a1, %a2);\n"
+      "}\n"
+   "@endtsexample\n\n"
+
+   "@see commandToClient()\n"
+   "@ingroup Networking\n")
+{
+   RemoteCommandEvent::broadcastRemoteCommand(argc - 1, argv + 1);
+}
+
 DefineEngineFunction(removeTaggedString, void, (S32 tag), (-1),
    "@brief Remove a tagged string from the Net String Table\n\n"
 
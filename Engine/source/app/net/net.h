@@ -12,6 +12,54 @@
 #include "sim/netObject.h"
 #include "app/net/serverQuery.h"
 #include "console/engineAPI.h"
+#include "core/util/refBase.h"
+
+/// The arguments of a remote command, packed once so that the same command
+/// can be sent to any number of connections.
+///
+/// Only tagged string arguments depend on the connection, as each one has
+/// its own string table.  The payload keeps a reference to every tagged
+/// string, and stores all other runs of arguments as pre-packed, byte
+/// aligned bit ranges that are copied verbatim into each packet.
+class RemoteCommandPayload : public StrongRefBase
+{
+public:
+   struct Segment
+   {
+      /// True for a tagged string, false for a packed run.
+      bool isTag;
+      NetStringHandle tag;
+
+      /// Byte offset and bit count of a packed run in #mData.
+      U32 offset;
+      U32 bitCount;
+   };
+
+private:
+   S32 mArgc;
+   Vector<Segment> mSegments;
+   U8 *mData;
+   U32 mDataSize;
+
+public:
+   RemoteCommandPayload(S32 argc, const char **argv);
+   ~RemoteCommandPayload();
+
+   S32 getArgCount() const { return mArgc; }
+
+   /// Size of the pre-packed argument data in bytes.
+   U32 getDataSize() const { return mDataSize; }
+
+   /// The tagged command name.
+   NetStringHandle &getCommand() { return mSegments[0].tag; }
+
+   /// Make sure all tagged strings are known on @a conn and return
+   /// their send ids in @a outIds.
+   void validate(NetConnection *conn, U16 *outIds);
+
+   /// Write the command using the tag send ids from validate().
+   void pack(BitStream *bstream, const U16 *ids) const;
+};
 
 class RemoteCommandEvent : public NetEvent
 {
@@ -28,8 +76,15 @@ private:
    NetStringHandle mTagv[MaxRemoteCommandArgs + 1];
    static char mBuf[1024];
 
+   /// Shared arguments when the command is broadcast.
+   StrongRefPtr<RemoteCommandPayload> mPayload;
+
+   /// Send ids of the payload's tagged strings on the connection.
+   U16 mPayloadTagIds[MaxRemoteCommandArgs + 1];
+
 public:
    RemoteCommandEvent(S32 argc=0, const char **argv=NULL, NetConnection *conn = NULL);
+   RemoteCommandEvent(RemoteCommandPayload *payload, NetConnection *conn);
 
 #ifdef TORQUE_DEBUG_NET
    const char *getDebugName();
@@ -46,6 +101,28 @@ public:
    virtual void process(NetConnection *conn);
 
    static void sendRemoteCommand(NetConnection *conn, S32 argc, const char **argv);
+
+   /// Send a command to all clients in the ClientGroup, packing the
+   /// arguments only once.
+   static void broadcastRemoteCommand(S32 argc, const char **argv);
+
+   /// @name Broadcast Statistics
+   /// @{
+
+   /// Number of broadcast commands.
+   static S32 smBroadcastCount;
+
+   /// Number of events posted by broadcast commands.
+   static S32 smBroadcastRecipients;
+
+   /// Bytes of argument data packed by broadcast commands.
+   static S32 smBroadcastPackedBytes;
+
+   /// Bytes of argument data sent by broadcast commands without packing
+   /// them again for every recipient.
+   static S32 smBroadcastSharedBytes;
+
+   /// @}
 	 
    static void removeTaggedString(S32);
 
@@ -72,6 +72,26 @@ using namespace Compiler;
 
 //-----------------------------------------------------------------------------
 
+/// Return the type a value that is handed across a call boundary (function
+/// argument or return value) should be compiled to.  Numeric expressions stay
+/// numeric so the string stack can pass them on without a format/parse round
+/// trip; literals are formatted at compile time already so they're cheaper to
+/// pass as strings.  Variables are loaded as strings, which keeps numeric
+/// variables numeric at runtime (see OP_LOADVAR_STR).
+static TypeReq getCallValueType( ExprNode* expr )
+{
+   if( dynamic_cast< IntNode* >( expr ) || dynamic_cast< FloatNode* >( expr ) )
+      return TypeReqString;
+
+   const TypeReq type = expr->getPreferredType();
+   if( type == TypeReqUInt || type == TypeReqFloat )
+      return type;
+
+   return TypeReqString;
+}
+
+//-----------------------------------------------------------------------------
+
 void StmtNode::addBreakCount()
 {
    CodeBlock::smBreakLineCount++;
@@ -235,7 +255,7 @@ U32 ExprNode::compileStmt(U32 *codeStream, U32 ip, U32, U32)
 U32 ReturnStmtNode::precompileStmt(U32)
 {
    addBreakCount();
-   return 1 + (expr ? expr->precompile(TypeReqString) : 0);
+   return 1 + (expr ? expr->precompile(getCallValueType(expr)) : 0);
 }
 
 U32 ReturnStmtNode::compileStmt(U32 *codeStream, U32 ip, U32, U32)
@@ -245,8 +265,14 @@ U32 ReturnStmtNode::compileStmt(U32 *codeStream, U32 ip, U32, U32)
       codeStream[ip++] = OP_RETURN_VOID;
    else
    {
-      ip = expr->compile(codeStream, ip, TypeReqString);
-      codeStream[ip++] = OP_RETURN;
+      const TypeReq type = getCallValueType(expr);
+      ip = expr->compile(codeStream, ip, type);
+      if(type == TypeReqUInt)
+         codeStream[ip++] = OP_RETURN_UINT;
+      else if(type == TypeReqFloat)
+         codeStream[ip++] = OP_RETURN_FLT;
+      else
+         codeStream[ip++] = OP_RETURN;
    }
    return ip;
 }
@@ -1340,6 +1366,7 @@ U32 FuncCallExprNode::precompile(TypeReq type)
    // function
    // namespace
    // isDot
+   // call site cache index
 
    U32 size = 0;
    if(type != TypeReqString)
@@ -1347,8 +1374,8 @@ U32 FuncCallExprNode::precompile(TypeReq type)
    precompileIdent(funcName);
    precompileIdent(nameSpace);
    for(ExprNode *walk = args; walk; walk = (ExprNode *) walk->getNext())
-      size += walk->precompile(TypeReqString) + 1;
-   return size + 5;
+      size += walk->precompile(getCallValueType(walk)) + 1;
+   return size + 6;
 }
 
 U32 FuncCallExprNode::compile(U32 *codeStream, U32 ip, TypeReq type)
@@ -1356,8 +1383,14 @@ U32 FuncCallExprNode::compile(U32 *codeStream, U32 ip, TypeReq type)
    codeStream[ip++] = OP_PUSH_FRAME;
    for(ExprNode *walk = args; walk; walk = (ExprNode *) walk->getNext())
    {
-      ip = walk->compile(codeStream, ip, TypeReqString);
-      codeStream[ip++] = OP_PUSH;
+      const TypeReq argType = getCallValueType(walk);
+      ip = walk->compile(codeStream, ip, argType);
+      if(argType == TypeReqUInt)
+         codeStream[ip++] = OP_PUSH_UINT;
+      else if(argType == TypeReqFloat)
+         codeStream[ip++] = OP_PUSH_FLT;
+      else
+         codeStream[ip++] = OP_PUSH;
    }
    if(callType == MethodCall || callType == ParentCall)
       codeStream[ip++] = OP_CALLFUNC;
@@ -1369,6 +1402,7 @@ U32 FuncCallExprNode::compile(U32 *codeStream, U32 ip, TypeReq type)
    codeStream[ip] = STEtoU32(nameSpace, ip);
    ip++;
    codeStream[ip++] = callType;
+   codeStream[ip++] = CodeBlock::smCallSiteCount++;
    if(type != TypeReqString)
       codeStream[ip++] = conversionOp(TypeReqString, type);
    return ip;
@@ -1434,8 +1468,8 @@ U32 SlotAccessNode::precompile(TypeReq type)
       // total add of 4 + array precomp
       size += 3 + arrayExpr->precompile(TypeReqString);
    }
-   // eval object expression sub + 3 (op_setCurField + OP_SETCUROBJECT)
-   size += objectExpr->precompile(TypeReqString) + 3;
+   // eval object expression sub + 4 (op_setCurField + OP_SETCUROBJECT)
+   size += objectExpr->precompile(TypeReqString) + 4;
 
    // get field in desired type:
    return size + 1;
@@ -1458,6 +1492,7 @@ U32 SlotAccessNode::compile(U32 *codeStream, U32 ip, TypeReq type)
    
    codeStream[ip] = STEtoU32(slotName, ip);
    ip++;
+   codeStream[ip++] = CodeBlock::smFieldSiteCount++;
 
    if(arrayExpr)
    {
@@ -1546,6 +1581,7 @@ U32 SlotAssignNode::precompile(TypeReq type)
    // OP_SETCUROBJECT 1
    // OP_SETCURFIELD 1
    // fieldName 1
+   // field site cache index 1
    // OP_TERMINATE_REWIND_STR 1
 
    // OP_SETCURFIELDARRAY 1
@@ -1557,6 +1593,7 @@ U32 SlotAssignNode::precompile(TypeReq type)
    // OP_SETCUROBJECT
    // OP_SETCURFIELD
    // fieldName
+   // field site cache index
    // OP_TERMINATE_REWIND_STR
 
    // OP_SAVEFIELD
@@ -1571,9 +1608,9 @@ U32 SlotAssignNode::precompile(TypeReq type)
    size += valueExpr->precompile(TypeReqString);
 
    if(objectExpr)
-      size += objectExpr->precompile(TypeReqString) + 5;
+      size += objectExpr->precompile(TypeReqString) + 6;
    else
-      size += 5;
+      size += 6;
 
    if(arrayExpr)
       size += arrayExpr->precompile(TypeReqString) + 3;
@@ -1603,6 +1640,7 @@ U32 SlotAssignNode::compile(U32 *codeStream, U32 ip, TypeReq type)
    codeStream[ip++] = OP_SETCURFIELD;
    codeStream[ip] = STEtoU32(slotName, ip);
    ip++;
+   codeStream[ip++] = CodeBlock::smFieldSiteCount++;
    if(arrayExpr)
    {
       codeStream[ip++] = OP_TERMINATE_REWIND_STR;
@@ -1641,6 +1679,7 @@ U32 SlotAssignOpNode::precompile(TypeReq type)
    // OP_SETCUROBJECT
    // OP_SETCURFIELD
    // fieldName
+   // field site cache index
    // OP_TERMINATE_REWIND_STR
    // OP_SETCURFIELDARRAY
 
@@ -1649,6 +1688,7 @@ U32 SlotAssignOpNode::precompile(TypeReq type)
    // OP_SETCUROBJECT
    // OP_SETCURFIELD
    // fieldName
+   // field site cache index
 
    // OP_LOADFIELD of appropriate type
    // operand
@@ -1661,9 +1701,9 @@ U32 SlotAssignOpNode::precompile(TypeReq type)
    if(type != subType)
       size++;
    if(arrayExpr)
-      return size + 9 + arrayExpr->precompile(TypeReqString) + objectExpr->precompile(TypeReqString);
+      return size + 10 + arrayExpr->precompile(TypeReqString) + objectExpr->precompile(TypeReqString);
    else
-      return size + 6 + objectExpr->precompile(TypeReqString);
+      return size + 7 + objectExpr->precompile(TypeReqString);
 }
 
 U32 SlotAssignOpNode::compile(U32 *codeStream, U32 ip, TypeReq type)
@@ -1679,6 +1719,7 @@ U32 SlotAssignOpNode::compile(U32 *codeStream, U32 ip, TypeReq type)
    codeStream[ip++] = OP_SETCURFIELD;
    codeStream[ip] = STEtoU32(slotName, ip);
    ip++;
+   codeStream[ip++] = CodeBlock::smFieldSiteCount++;
    if(arrayExpr)
    {
       codeStream[ip++] = OP_TERMINATE_REWIND_STR;
@@ -29,15 +29,53 @@
 #include "core/strings/stringFunctions.h"
 #include "core/stringTable.h"
 #include "core/stream/fileStream.h"
+#include "core/util/endian.h"
 
 using namespace Compiler;
 
 bool           CodeBlock::smInFunction = false;
 U32            CodeBlock::smBreakLineCount = 0;
+U32            CodeBlock::smCallSiteCount = 0;
+U32            CodeBlock::smFieldSiteCount = 0;
+bool           CodeBlock::smUseInlineCaches = true;
 CodeBlock *    CodeBlock::smCodeBlockList = NULL;
 CodeBlock *    CodeBlock::smCurrentCodeBlock = NULL;
 ConsoleParser *CodeBlock::smCurrentParser = NULL;
 
+namespace {
+
+/// Header of a compiled script.
+///
+/// The sections that follow the header are stored raw and little endian in
+/// the order global floats, function floats, code and line break pairs,
+/// identifier fixups, global strings, function strings.  The header is a
+/// multiple of eight bytes so the float tables can be used in place.
+struct DSOHeader
+{
+   U32 version;
+   U32 globalStringsSize;
+   U32 functionStringsSize;
+   U32 globalFloatCount;
+   U32 functionFloatCount;
+   U32 codeSize;
+   U32 lineBreakPairCount;
+   U32 callSiteCount;
+   U32 fieldSiteCount;
+   U32 identCount;
+   U32 identDataSize;      ///< Size of the identifier fixups in U32s.
+   U32 imageSize;          ///< Size of the whole file in bytes.
+};
+
+#ifdef TORQUE_BIG_ENDIAN
+void swizzleWords(U32 *words, U32 count)
+{
+   for(U32 i = 0; i < count; i++)
+      words[i] = convertLEndianToHost(words[i]);
+}
+#endif
+
+} // namespace {}
+
 //-------------------------------------------------------------------------
 
 CodeBlock::CodeBlock()
@@ -54,6 +92,11 @@ CodeBlock::CodeBlock()
 
    refCount = 0;
    code = NULL;
+   callSiteCount = 0;
+   callSiteCaches = NULL;
+   fieldSiteCount = 0;
+   fieldSiteCaches = NULL;
+   image = NULL;
    name = NULL;
    fullPath = NULL;
    modPath = NULL;
@@ -66,16 +109,24 @@ CodeBlock::~CodeBlock()
 
    if(name)
       removeFromCodeList();
-   delete[] const_cast<char*>(globalStrings);
-   delete[] const_cast<char*>(functionStrings);
+
+   if(image)
+      freeImage();
+   else
+   {
+      delete[] const_cast<char*>(globalStrings);
+      delete[] const_cast<char*>(functionStrings);
+      delete[] globalFloats;
+      delete[] functionFloats;
+      delete[] code;
+   }
    
    functionStringsMaxLen = 0;
    globalStringsMaxLen = 0;
 
-   delete[] globalFloats;
-   delete[] functionFloats;
-   delete[] code;
    delete[] breakList;
+   delete[] callSiteCaches;
+   delete[] fieldSiteCaches;
 }
 
 //-------------------------------------------------------------------------
@@ -343,6 +394,47 @@ void CodeBlock::calcBreakList()
 }
 
 bool CodeBlock::read(StringTableEntry fileName, Stream &st)
+{
+   // Pull the rest of the stream in with a single read, putting the version
+   // that the caller already consumed back in front.
+   const U32 size = st.getStreamSize() - st.getPosition();
+   U8 *data = (U8 *) dMalloc_aligned(size + sizeof(U32), 8);
+   image = data;
+
+   *((U32 *) data) = convertHostToLEndian(U32(Con::DSOVersion));
+   if(!st.read(size, data + sizeof(U32)))
+      return false;
+
+   return loadImage(fileName, data, size + sizeof(U32));
+}
+
+bool CodeBlock::read(StringTableEntry fileName, const Torque::FS::FileRef &file)
+{
+   const U32 size = file->getSize();
+
+   void *data = file->map();
+   if(data)
+   {
+      // The mapping outlives the handle, so don't hold the file open for
+      // the lifetime of the block.
+      file->close();
+      image = data;
+      imageFile = file;
+   }
+   else
+   {
+      data = dMalloc_aligned(size, 8);
+      image = data;
+
+      file->setPosition(0, Torque::FS::File::Begin);
+      if(file->read(data, size) != size)
+         return false;
+   }
+
+   return loadImage(fileName, data, size);
+}
+
+bool CodeBlock::loadImage(StringTableEntry fileName, void *data, U32 size)
 {
    const StringTableEntry exePath = Platform::getMainDotCsDir();
    const StringTableEntry cwd = Platform::getCurrentDirectory();
@@ -373,86 +465,130 @@ bool CodeBlock::read(StringTableEntry fileName, Stream &st)
    //
    addToCodeList();
 
-   U32 globalSize,size,i;
-   st.read(&size);
-   if(size)
-   {
-      globalStrings = new char[size];
-      globalStringsMaxLen = size;
-      st.read(size, globalStrings);
-   }
-   globalSize = size;
-   st.read(&size);
-   if(size)
-   {
-      functionStrings = new char[size];
-      functionStringsMaxLen = size;
-      st.read(size, functionStrings);
-   }
-   st.read(&size);
-   if(size)
+   if(size < sizeof(DSOHeader))
    {
-      globalFloats = new F64[size];
-      for(U32 i = 0; i < size; i++)
-         st.read(&globalFloats[i]);
+      Con::errorf(ConsoleLogEntry::Script, "CodeBlock::read - truncated compiled script %s.", fileName);
+      return false;
    }
-   st.read(&size);
-   if(size)
+
+   U8 *base = (U8 *) data;
+   DSOHeader *header = (DSOHeader *) base;
+
+#ifdef TORQUE_BIG_ENDIAN
+   swizzleWords((U32 *) header, sizeof(DSOHeader) / sizeof(U32));
+#endif
+
+   // Work out where each section lives, making sure a damaged file can't
+   // send us outside the image.
+   const U64 totCodeSize = U64(header->codeSize) + U64(header->lineBreakPairCount) * 2;
+   const U64 floatsOffset = sizeof(DSOHeader);
+   const U64 codeOffset = floatsOffset + (U64(header->globalFloatCount) + header->functionFloatCount) * sizeof(F64);
+   const U64 identOffset = codeOffset + totCodeSize * sizeof(U32);
+   const U64 stringsOffset = identOffset + U64(header->identDataSize) * sizeof(U32);
+   const U64 imageSize = stringsOffset + header->globalStringsSize + header->functionStringsSize;
+
+   if(header->imageSize != size || imageSize != size)
    {
-      functionFloats = new F64[size];
-      for(U32 i = 0; i < size; i++)
-         st.read(&functionFloats[i]);
+      Con::errorf(ConsoleLogEntry::Script, "CodeBlock::read - corrupt compiled script %s.", fileName);
+      return false;
    }
-   U32 codeLength;
-   st.read(&codeLength);
-   st.read(&lineBreakPairCount);
 
-   U32 totSize = codeLength + lineBreakPairCount * 2;
-   code = new U32[totSize];
+   globalStringsMaxLen = header->globalStringsSize;
+   functionStringsMaxLen = header->functionStringsSize;
+   globalStrings = globalStringsMaxLen ? (char *) (base + stringsOffset) : NULL;
+   functionStrings = functionStringsMaxLen ? (char *) (base + stringsOffset + globalStringsMaxLen) : NULL;
+
+   globalFloats = header->globalFloatCount ? (F64 *) (base + floatsOffset) : NULL;
+   functionFloats = header->functionFloatCount ? (F64 *) (base + floatsOffset) + header->globalFloatCount : NULL;
+
+   codeSize = header->codeSize;
+   lineBreakPairCount = header->lineBreakPairCount;
+   callSiteCount = header->callSiteCount;
+   fieldSiteCount = header->fieldSiteCount;
+   code = (U32 *) (base + codeOffset);
+   lineBreakPairs = code + codeSize;
 
-   for(i = 0; i < codeLength; i++)
+   U32 *identData = (U32 *) (base + identOffset);
+   U32 *identEnd = identData + header->identDataSize;
+
+#ifdef TORQUE_BIG_ENDIAN
+   for(U32 i = 0; i < header->globalFloatCount + header->functionFloatCount; i++)
+      globalFloats[i] = convertLEndianToHost(globalFloats[i]);
+   swizzleWords(code, totCodeSize);
+   swizzleWords(identData, header->identDataSize);
+#endif
+
+   // StringTable-ize our identifiers.  Gather the names first so they can be
+   // interned as one batch, then patch the code.
+   const U32 identCount = header->identCount;
+   Vector<const char *> identNames(identCount);
+   Vector<StringTableEntry> idents(identCount);
+   identNames.setSize(identCount);
+   idents.setSize(identCount);
+
+   U32 *walk = identData;
+   for(U32 i = 0; i < identCount; i++)
    {
-      U8 b;
-      st.read(&b);
-      if(b == 0xFF)
-         st.read(&code[i]);
-      else
-         code[i] = b;
-   }
+      if(walk + 2 > identEnd || walk + 2 + walk[1] > identEnd)
+      {
+         Con::errorf(ConsoleLogEntry::Script, "CodeBlock::read - corrupt identifier table in %s.", fileName);
+         return false;
+      }
 
-   for(i = codeLength; i < totSize; i++)
-      st.read(&code[i]);
+      const U32 offset = walk[0];
+      identNames[i] = offset < globalStringsMaxLen ? globalStrings + offset : "";
+      walk += 2 + walk[1];
+   }
 
-   lineBreakPairs = code + codeLength;
+   StringTable->insertBatch(identNames.address(), identCount, idents.address());
 
-   // StringTable-ize our identifiers.
-   U32 identCount;
-   st.read(&identCount);
-   while(identCount--)
+   walk = identData;
+   for(U32 i = 0; i < identCount; i++)
    {
-      U32 offset;
-      st.read(&offset);
-      StringTableEntry ste;
-      if(offset < globalSize)
-         ste = StringTable->insert(globalStrings + offset);
-      else
-         ste = StringTable->insert("");
-      U32 count;
-      st.read(&count);
-      while(count--)
+      const U32 count = walk[1];
+      walk += 2;
+      for(U32 j = 0; j < count; j++, walk++)
       {
-         U32 ip;
-         st.read(&ip);
-         code[ip] = *((U32 *) &ste);
+         if(*walk < codeSize)
+            code[*walk] = *((U32 *) &idents[i]);
       }
    }
 
    if(lineBreakPairCount)
       calcBreakList();
 
+   allocInlineCaches();
+
    return true;
 }
 
+void CodeBlock::freeImage()
+{
+   if(imageFile)
+   {
+      imageFile->unmap();
+      imageFile = NULL;
+   }
+   else
+      dFree_aligned(image);
+
+   image = NULL;
+}
+
+void CodeBlock::freeGlobalTables()
+{
+   // Tables that live in the image go away with it.
+   if(!image)
+   {
+      delete[] globalStrings;
+      delete[] globalFloats;
+   }
+
+   globalStrings = NULL;
+   globalStringsMaxLen = 0;
+   globalFloats = NULL;
+}
+
 
 bool CodeBlock::compile(const char *codeFileName, StringTableEntry fileName, const char *inScript, bool overrideNoDso)
 {
@@ -488,16 +624,21 @@ bool CodeBlock::compile(const char *codeFileName, StringTableEntry fileName, con
       return false;
 #endif // !TORQUE_NO_DSO_GENERATION
 
+   // Write to a temporary file and move it into place when done so that a
+   // block still mapped from the old DSO never sees it change underneath it.
+   const String tempFileName = String(codeFileName) + ".tmp";
+
    FileStream st;
-   if(!st.open(codeFileName, Torque::FS::File::Write)) 
+   if(!st.open(tempFileName, Torque::FS::File::Write)) 
       return false;
-   st.write(U32(Con::DSOVersion));
 
    // Reset all our value tables...
    resetTables();
 
    smInFunction = false;
    smBreakLineCount = 0;
+   smCallSiteCount = 0;
+   smFieldSiteCount = 0;
    setBreakCodeBlock(this);
 
    if(gStatementList)
@@ -509,14 +650,6 @@ bool CodeBlock::compile(const char *codeFileName, StringTableEntry fileName, con
    code = new U32[codeSize + smBreakLineCount * 2];
    lineBreakPairs = code + codeSize;
 
-   // Write string table data...
-   getGlobalStringTable().write(st);
-   getFunctionStringTable().write(st);
-
-   // Write float table data...
-   getGlobalFloatTable().write(st);
-   getFunctionFloatTable().write(st);
-
    smBreakLineCount = 0;
    U32 lastIp;
    if(gStatementList)
@@ -529,34 +662,69 @@ bool CodeBlock::compile(const char *codeFileName, StringTableEntry fileName, con
 
    code[lastIp++] = OP_RETURN;
    U32 totSize = codeSize + smBreakLineCount * 2;
-   st.write(codeSize);
-   st.write(lineBreakPairCount);
+   callSiteCount = smCallSiteCount;
+   fieldSiteCount = smFieldSiteCount;
+
+   // Fill in the header now that all the tables are complete.
+   DSOHeader header;
+   header.version = Con::DSOVersion;
+   header.globalStringsSize = getGlobalStringTable().totalLen;
+   header.functionStringsSize = getFunctionStringTable().totalLen;
+   header.globalFloatCount = getGlobalFloatTable().count;
+   header.functionFloatCount = getFunctionFloatTable().count;
+   header.codeSize = codeSize;
+   header.lineBreakPairCount = lineBreakPairCount;
+   header.callSiteCount = callSiteCount;
+   header.fieldSiteCount = fieldSiteCount;
+   getIdentTable().getSize(header.identCount, header.identDataSize);
+   header.imageSize = sizeof(DSOHeader)
+      + (header.globalFloatCount + header.functionFloatCount) * sizeof(F64)
+      + totSize * sizeof(U32)
+      + header.identDataSize * sizeof(U32)
+      + header.globalStringsSize + header.functionStringsSize;
 
-   // Write out our bytecode, doing a bit of compression for low numbers.
-   U32 i;   
-   for(i = 0; i < codeSize; i++)
-   {
-      if(code[i] < 0xFF)
-         st.write(U8(code[i]));
-      else
-      {
-         st.write(U8(0xFF));
-         st.write(code[i]);
-      }
-   }
+   U32 i;
+   const U32 *headerWords = (const U32 *) &header;
+   for(i = 0; i < sizeof(DSOHeader) / sizeof(U32); i++)
+      st.write(headerWords[i]);
 
-   // Write the break info...
-   for(i = codeSize; i < totSize; i++)
+   // Write float table data...
+   getGlobalFloatTable().write(st);
+   getFunctionFloatTable().write(st);
+
+   // Write out our bytecode and the break info...
+   for(i = 0; i < totSize; i++)
       st.write(code[i]);
 
    getIdentTable().write(st);
 
+   // Write string table data...
+   getGlobalStringTable().write(st);
+   getFunctionStringTable().write(st);
+
    consoleAllocReset();
+
+   const bool writeOk = st.getStatus() == Stream::Ok;
    st.close();
 
-   return true;
+   if(!writeOk)
+   {
+      Torque::FS::Remove(tempFileName);
+      return false;
+   }
 
+   // Not every file system will rename over an existing file.
+   if(!Torque::FS::Rename(tempFileName, codeFileName))
+   {
+      Torque::FS::Remove(codeFileName);
+      if(!Torque::FS::Rename(tempFileName, codeFileName))
+      {
+         Torque::FS::Remove(tempFileName);
+         return false;
+      }
+   }
 
+   return true;
 }
 
 const char *CodeBlock::compileExec(StringTableEntry fileName, const char *inString, bool noCalls, S32 setFrame)
@@ -618,6 +786,8 @@ const char *CodeBlock::compileExec(StringTableEntry fileName, const char *inStri
 
    smInFunction = false;
    smBreakLineCount = 0;
+   smCallSiteCount = 0;
+   smFieldSiteCount = 0;
    setBreakCodeBlock(this);
 
    codeSize = precompileBlock(gStatementList, 0) + 1;
@@ -639,6 +809,10 @@ const char *CodeBlock::compileExec(StringTableEntry fileName, const char *inStri
    smBreakLineCount = 0;
    U32 lastIp = compileBlock(gStatementList, code, 0, 0, 0);
    code[lastIp++] = OP_RETURN;
+
+   callSiteCount = smCallSiteCount;
+   fieldSiteCount = smFieldSiteCount;
+   allocInlineCaches();
    
    consoleAllocReset();
 
@@ -653,6 +827,17 @@ const char *CodeBlock::compileExec(StringTableEntry fileName, const char *inStri
 
 //-------------------------------------------------------------------------
 
+void CodeBlock::allocInlineCaches()
+{
+   delete[] callSiteCaches;
+   delete[] fieldSiteCaches;
+
+   callSiteCaches = callSiteCount ? new CallSiteCache[ callSiteCount ] : NULL;
+   fieldSiteCaches = fieldSiteCount ? new FieldSiteCache[ fieldSiteCount ] : NULL;
+}
+
+//-------------------------------------------------------------------------
+
 void CodeBlock::incRefCount()
 {
    refCount++;
@@ -823,6 +1008,26 @@ void CodeBlock::dumpInstructions( U32 startIp, bool upToReturn )
             break;
          }
 
+         case OP_RETURN_UINT:
+         {
+            Con::printf( "%i: OP_RETURN_UINT", ip - 1 );
+
+            if( upToReturn )
+               return;
+
+            break;
+         }
+
+         case OP_RETURN_FLT:
+         {
+            Con::printf( "%i: OP_RETURN_FLT", ip - 1 );
+
+            if( upToReturn )
+               return;
+
+            break;
+         }
+
          case OP_CMPEQ:
          {
             Con::printf( "%i: OP_CMPEQ", ip - 1 );
@@ -1043,8 +1248,8 @@ void CodeBlock::dumpInstructions( U32 startIp, bool upToReturn )
          case OP_SETCURFIELD:
          {
             StringTableEntry curField = U32toSTE(code[ip]);
-            Con::printf( "%i: OP_SETCURFIELD field=%s", ip - 1, curField );
-            ++ ip;
+            Con::printf( "%i: OP_SETCURFIELD field=%s cache=%i", ip - 1, curField, code[ ip + 1 ] );
+            ip += 2;
          }
          
          case OP_SETCURFIELD_ARRAY:
@@ -1205,11 +1410,12 @@ void CodeBlock::dumpInstructions( U32 startIp, bool upToReturn )
             StringTableEntry fnName      = U32toSTE(code[ip]);
             U32 callType = code[ip+2];
 
-            Con::printf( "%i: OP_CALLFUNC_RESOLVE name=%s nspace=%s callType=%s", ip - 1, fnName, fnNamespace,
+            Con::printf( "%i: OP_CALLFUNC_RESOLVE name=%s nspace=%s callType=%s cache=%i", ip - 1, fnName, fnNamespace,
                callType == FuncCallExprNode::FunctionCall ? "FunctionCall"
-                  : callType == FuncCallExprNode::MethodCall ? "MethodCall" : "ParentCall" );
+                  : callType == FuncCallExprNode::MethodCall ? "MethodCall" : "ParentCall",
+               code[ ip + 3 ] );
             
-            ip += 3;
+            ip += 4;
             break;
          }
          
@@ -1219,11 +1425,12 @@ void CodeBlock::dumpInstructions( U32 startIp, bool upToReturn )
             StringTableEntry fnName      = U32toSTE(code[ip]);
             U32 callType = code[ip+2];
 
-            Con::printf( "%i: OP_CALLFUNC name=%s nspace=%s callType=%s", ip - 1, fnName, fnNamespace,
+            Con::printf( "%i: OP_CALLFUNC name=%s nspace=%s callType=%s cache=%i", ip - 1, fnName, fnNamespace,
                callType == FuncCallExprNode::FunctionCall ? "FunctionCall"
-                  : callType == FuncCallExprNode::MethodCall ? "MethodCall" : "ParentCall" );
+                  : callType == FuncCallExprNode::MethodCall ? "MethodCall" : "ParentCall",
+               code[ ip + 3 ] );
             
-            ip += 3;
+            ip += 4;
             break;
          }
 
@@ -1277,6 +1484,18 @@ void CodeBlock::dumpInstructions( U32 startIp, bool upToReturn )
             break;
          }
 
+         case OP_PUSH_UINT:
+         {
+            Con::printf( "%i: OP_PUSH_UINT", ip - 1 );
+            break;
+         }
+
+         case OP_PUSH_FLT:
+         {
+            Con::printf( "%i: OP_PUSH_FLT", ip - 1 );
+            break;
+         }
+
          case OP_PUSH_FRAME:
          {
             Con::printf( "%i: OP_PUSH_FRAME", ip - 1 );
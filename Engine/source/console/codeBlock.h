@@ -25,6 +25,8 @@
 
 #include "console/compiler.h"
 #include "console/consoleParser.h"
+#include "console/consoleInternal.h"
+#include "core/volume.h"
 
 class Stream;
 
@@ -39,9 +41,109 @@ private:
    
 public:
    static U32                       smBreakLineCount;
+   static U32                       smCallSiteCount;
+   static U32                       smFieldSiteCount;
    static bool                      smInFunction;
    static Compiler::ConsoleParser * smCurrentParser;
 
+   /// If false, the interpreter ignores the call and field site caches.
+   static bool                      smUseInlineCaches;
+
+   /// Inline cache for the function lookup of an OP_CALLFUNC/OP_CALLFUNC_RESOLVE.
+   ///
+   /// Remembers the entry that a lookup of the call's function name resolved to
+   /// for the last few namespaces seen at the call site.  The cache is flushed
+   /// whenever Namespace::mCacheSequence changes, i.e. whenever a function is
+   /// defined, a package is (de)activated or the namespace hierarchy changes.
+   struct CallSiteCache
+   {
+      enum { MaxEntries = 4 };
+
+      U32 sequence;
+      U32 numEntries;
+      U32 nextEntry;
+
+      /// Namespace found by OP_CALLFUNC_RESOLVE.
+      Namespace* resolvedNamespace;
+
+      Namespace* namespaces[ MaxEntries ];
+      Namespace::Entry* entries[ MaxEntries ];
+
+      CallSiteCache()
+         : sequence( 0 ), numEntries( 0 ), nextEntry( 0 ), resolvedNamespace( NULL ) {}
+
+      /// Drop everything if the namespaces have changed since the cache was filled.
+      void validate()
+      {
+         if( sequence != Namespace::mCacheSequence )
+         {
+            sequence = Namespace::mCacheSequence;
+            numEntries = 0;
+            nextEntry = 0;
+            resolvedNamespace = NULL;
+         }
+      }
+
+      /// Return the result of @a ns->lookup( @a name ).
+      Namespace::Entry* lookup( Namespace* ns, StringTableEntry name )
+      {
+         validate();
+
+         for( U32 i = 0; i < numEntries; ++ i )
+            if( namespaces[ i ] == ns )
+               return entries[ i ];
+
+         Namespace::Entry* entry = ns->lookup( name );
+
+         namespaces[ nextEntry ] = ns;
+         entries[ nextEntry ] = entry;
+         nextEntry = ( nextEntry + 1 ) % MaxEntries;
+         if( numEntries < MaxEntries )
+            numEntries ++;
+
+         return entry;
+      }
+   };
+
+   /// Inline cache for the static field lookup of an OP_SETCURFIELD.
+   ///
+   /// Remembers the field that the slot name resolved to for the last few
+   /// classes seen at the access site.  Class field lists are fixed once
+   /// AbstractClassRep::initialize() has run so the entries never go stale.
+   struct FieldSiteCache
+   {
+      enum { MaxEntries = 4 };
+
+      U32 numEntries;
+      U32 nextEntry;
+
+      AbstractClassRep* classes[ MaxEntries ];
+      const AbstractClassRep::Field* fields[ MaxEntries ];
+
+      FieldSiteCache()
+         : numEntries( 0 ), nextEntry( 0 ) {}
+
+      /// Return the result of @a object->findField( @a name ).
+      const AbstractClassRep::Field* lookup( SimObject* object, StringTableEntry name )
+      {
+         AbstractClassRep* classRep = object->getClassRep();
+
+         for( U32 i = 0; i < numEntries; ++ i )
+            if( classes[ i ] == classRep )
+               return fields[ i ];
+
+         const AbstractClassRep::Field* field = classRep->findField( name );
+
+         classes[ nextEntry ] = classRep;
+         fields[ nextEntry ] = field;
+         nextEntry = ( nextEntry + 1 ) % MaxEntries;
+         if( numEntries < MaxEntries )
+            numEntries ++;
+
+         return field;
+      }
+   };
+
    static CodeBlock* getCurrentBlock()
    {
       return smCurrentCodeBlock;
@@ -76,6 +178,12 @@ public:
    U32 codeSize;
    U32 *code;
 
+   U32 callSiteCount;
+   CallSiteCache *callSiteCaches;
+
+   U32 fieldSiteCount;
+   FieldSiteCache *fieldSiteCaches;
+
    U32 refCount;
    U32 lineBreakPairCount;
    U32 *lineBreakPairs;
@@ -83,6 +191,14 @@ public:
    U32 *breakList;
    CodeBlock *nextFile;
 
+   /// Compiled script image that the string, float and code tables point
+   /// into when the block was read from a DSO, or NULL if each table was
+   /// allocated separately.
+   void *image;
+
+   /// The DSO the image is mapped from, or NULL if it was read into memory.
+   Torque::FS::FileRef imageFile;
+
    void addToCodeList();
    void removeFromCodeList();
    void calcBreakList();
@@ -90,6 +206,9 @@ public:
    void setAllBreaks();
    void dumpInstructions( U32 startIp = 0, bool upToReturn = false );
 
+   /// Allocate the call and field site caches for the compiled code.
+   void allocInlineCaches();
+
    /// Returns the first breakable line or 0 if none was found.
    /// @param lineNumber The one based line number.
    U32 findFirstBreakLine(U32 lineNumber);
@@ -108,6 +227,15 @@ public:
    String getFunctionArgs( U32 offset );
 
    bool read(StringTableEntry fileName, Stream &st);
+
+   /// Load a compiled script from an open DSO positioned just past its
+   /// version.  The file is mapped in place when the file system supports
+   /// it, otherwise it is read into a single block.
+   bool read(StringTableEntry fileName, const Torque::FS::FileRef &file);
+
+   /// Release the global string and float tables once the top-level code
+   /// of the block has run.
+   void freeGlobalTables();
    bool compile(const char *dsoName, StringTableEntry fileName, const char *script, bool overrideNoDso = false);
 
    void incRefCount();
@@ -146,9 +274,19 @@ public:
    /// -1 a new frame is created. If the index is out of range the
    /// top stack frame is used.
    /// @param packageName The code package name or null.
+   /// @param typedReturn If true, the caller reads numeric return values
+   /// off the string stack, so they are not formatted and an empty string
+   /// is returned for them.
    const char *exec(U32 offset, const char *fnName, Namespace *ns, U32 argc, 
       const char **argv, bool noCalls, StringTableEntry packageName, 
-      S32 setFrame = -1);
+      S32 setFrame = -1, bool typedReturn = false);
+
+private:
+   /// Point the tables of the block into a compiled script image of
+   /// @a size bytes, starting with the DSO version.
+   bool loadImage(StringTableEntry fileName, void *data, U32 size);
+
+   void freeImage();
 };
 
 #endif
\ No newline at end of file
@@ -130,6 +130,26 @@ namespace Con
 
 //------------------------------------------------------------
 
+/// Read a field, using the access site's cache for the static field lookup if given.
+static inline const char* getCachedDataField( SimObject* object, StringTableEntry slotName, const char* array, CodeBlock::FieldSiteCache* cache )
+{
+   if( !cache )
+      return object->getDataField( slotName, array );
+
+   return object->getDataField( slotName, array, cache->lookup( object, slotName ) );
+}
+
+/// Write a field, using the access site's cache for the static field lookup if given.
+static inline void setCachedDataField( SimObject* object, StringTableEntry slotName, const char* array, const char* value, CodeBlock::FieldSiteCache* cache )
+{
+   if( !cache )
+      object->setDataField( slotName, array, value );
+   else
+      object->setDataField( slotName, array, value, cache->lookup( object, slotName ) );
+}
+
+//------------------------------------------------------------
+
 F64 consoleStringToNumber(const char *str, StringTableEntry file, U32 line)
 {
    F64 val = dAtof(str);
@@ -401,7 +421,7 @@ static void setFieldComponent( SimObject* object, StringTableEntry field, const
    }
 }
 
-const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNamespace, U32 argc, const char **argv, bool noCalls, StringTableEntry packageName, S32 setFrame)
+const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNamespace, U32 argc, const char **argv, bool noCalls, StringTableEntry packageName, S32 setFrame, bool typedReturn)
 {
 #ifdef TORQUE_DEBUG
    U32 stackStart = STR.mStartStackSize;
@@ -447,6 +467,7 @@ const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNam
          }
          for(i = 0; i < argc; i++)
          {
+            STR.formatArg(i+1, argv[i+1]);
             dStrcat(traceBuffer, argv[i+1]);
             if(i != argc - 1)
                dStrcat(traceBuffer, ", ");
@@ -460,7 +481,21 @@ const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNam
       {
          StringTableEntry var = U32toSTE(code[ip + i + 6]);
          gEvalState.setCurVarNameCreate(var);
-         gEvalState.setStringVariable(argv[i+1]);
+
+         // Arguments that were pushed as numbers can skip the string parse.
+         F64 argNumber;
+         switch(STR.getArgType(i+1, argv[i+1], argNumber))
+         {
+            case StringStack::IntValue:
+               gEvalState.setIntVariable(S32(argNumber));
+               break;
+            case StringStack::FloatValue:
+               gEvalState.setFloatVariable(argNumber);
+               break;
+            default:
+               gEvalState.setStringVariable(argv[i+1]);
+               break;
+         }
       }
       ip = ip + fnArgc + 6;
       curFloatTable = functionFloats;
@@ -519,6 +554,8 @@ const char *CodeBlock::exec(U32 ip, const char *functionName, Namespace *thisNam
    U32 failJump = 0;
    StringTableEntry prevField = NULL;
    StringTableEntry curField = NULL;
+   CodeBlock::FieldSiteCache *curFieldCache = NULL;
+   CodeBlock::CallSiteCache *callCache = NULL;
    SimObject *prevObject = NULL;
    SimObject *curObject = NULL;
    SimObject *saveObject=NULL;
@@ -1031,12 +1068,21 @@ breakContinue:
             ip = code[ip];
             break;
             
+         case OP_RETURN_UINT:
+            STR.setIntValue(intStack[_UINT--]);
+            goto execReturn;
+
+         case OP_RETURN_FLT:
+            STR.setFloatValue(floatStack[_FLT--]);
+            goto execReturn;
+
          // This fixes a bug when not explicitly returning a value.
          case OP_RETURN_VOID:
       		STR.setStringValue("");
       		// We're falling thru here on purpose.
             
          case OP_RETURN:
+         execReturn:
          
             if( iterDepth > 0 )
             {
@@ -1047,9 +1093,20 @@ breakContinue:
                   -- iterDepth;
                }
                
-               const char* returnValue = STR.getStringValue();
-               STR.rewind();
-               STR.setStringValue( returnValue ); // Not nice but works.
+               const StringStack::ValueType returnType = STR.getValueType();
+               const F64 returnNumber = STR.getNumberValue();
+               if( returnType != StringStack::StringValue )
+               {
+                  STR.setLen( 0 );
+                  STR.rewind();
+                  STR.setTypedValue( returnType, returnNumber, NULL );
+               }
+               else
+               {
+                  const char* returnValue = STR.getStringValue();
+                  STR.rewind();
+                  STR.setStringValue( returnValue ); // Not nice but works.
+               }
             }
                
             goto execFinished;
@@ -1246,8 +1303,17 @@ breakContinue:
             break;
 
          case OP_LOADVAR_STR:
-            val = gEvalState.getStringVariable();
-            STR.setStringValue(val);
+            // Numeric variables stay numeric until something asks for the
+            // string, which is often never for function arguments.
+            if(gEvalState.currentVariable && gEvalState.currentVariable->type == Dictionary::Entry::TypeInternalInt)
+               STR.setIntValue(gEvalState.currentVariable->getIntValue());
+            else if(gEvalState.currentVariable && gEvalState.currentVariable->type == Dictionary::Entry::TypeInternalFloat)
+               STR.setFloatValue(gEvalState.currentVariable->getFloatValue());
+            else
+            {
+               val = gEvalState.getStringVariable();
+               STR.setStringValue(val);
+            }
             break;
 
          case OP_SAVEVAR_UINT:
@@ -1259,7 +1325,12 @@ breakContinue:
             break;
 
          case OP_SAVEVAR_STR:
-            gEvalState.setStringVariable(STR.getStringValue());
+            if(STR.getValueType() == StringStack::IntValue)
+               gEvalState.setIntVariable(S32(STR.getNumberValue()));
+            else if(STR.getValueType() == StringStack::FloatValue)
+               gEvalState.setFloatVariable(STR.getNumberValue());
+            else
+               gEvalState.setStringVariable(STR.getStringValue());
             break;
 
          case OP_SETCUROBJECT:
@@ -1311,8 +1382,9 @@ breakContinue:
             prevField = curField;
             dStrcpy( prevFieldArray, curFieldArray );
             curField = U32toSTE(code[ip]);
+            curFieldCache = smUseInlineCaches ? &fieldSiteCaches[code[ip+1]] : NULL;
             curFieldArray[0] = 0;
-            ip++;
+            ip += 2;
             break;
 
          case OP_SETCURFIELD_ARRAY:
@@ -1327,7 +1399,7 @@ breakContinue:
 
          case OP_LOADFIELD_UINT:
             if(curObject)
-               intStack[_UINT+1] = U32(dAtoi(curObject->getDataField(curField, curFieldArray)));
+               intStack[_UINT+1] = U32(dAtoi(getCachedDataField(curObject, curField, curFieldArray, curFieldCache)));
             else
             {
                // The field is not being retrieved from an object. Maybe it's
@@ -1340,7 +1412,7 @@ breakContinue:
 
          case OP_LOADFIELD_FLT:
             if(curObject)
-               floatStack[_FLT+1] = dAtof(curObject->getDataField(curField, curFieldArray));
+               floatStack[_FLT+1] = dAtof(getCachedDataField(curObject, curField, curFieldArray, curFieldCache));
             else
             {
                // The field is not being retrieved from an object. Maybe it's
@@ -1354,7 +1426,7 @@ breakContinue:
          case OP_LOADFIELD_STR:
             if(curObject)
             {
-               val = curObject->getDataField(curField, curFieldArray);
+               val = getCachedDataField(curObject, curField, curFieldArray, curFieldCache);
                STR.setStringValue( val );
             }
             else
@@ -1369,7 +1441,7 @@ breakContinue:
          case OP_SAVEFIELD_UINT:
             STR.setIntValue(intStack[_UINT]);
             if(curObject)
-               curObject->setDataField(curField, curFieldArray, STR.getStringValue());
+               setCachedDataField(curObject, curField, curFieldArray, STR.getStringValue(), curFieldCache);
             else
             {
                // The field is not being set on an object. Maybe it's
@@ -1382,7 +1454,7 @@ breakContinue:
          case OP_SAVEFIELD_FLT:
             STR.setFloatValue(floatStack[_FLT]);
             if(curObject)
-               curObject->setDataField(curField, curFieldArray, STR.getStringValue());
+               setCachedDataField(curObject, curField, curFieldArray, STR.getStringValue(), curFieldCache);
             else
             {
                // The field is not being set on an object. Maybe it's
@@ -1394,7 +1466,7 @@ breakContinue:
 
          case OP_SAVEFIELD_STR:
             if(curObject)
-               curObject->setDataField(curField, curFieldArray, STR.getStringValue());
+               setCachedDataField(curObject, curField, curFieldArray, STR.getStringValue(), curFieldCache);
             else
             {
                // The field is not being set on an object. Maybe it's
@@ -1513,14 +1585,26 @@ breakContinue:
             fnName      = U32toSTE(code[ip]);
 
             // Try to look it up.
-            ns = Namespace::find(fnNamespace);
-            nsEntry = ns->lookup(fnName);
+            if(smUseInlineCaches)
+            {
+               callCache = &callSiteCaches[code[ip+3]];
+               callCache->validate();
+               if(!callCache->resolvedNamespace)
+                  callCache->resolvedNamespace = Namespace::find(fnNamespace);
+               ns = callCache->resolvedNamespace;
+               nsEntry = callCache->lookup(ns, fnName);
+            }
+            else
+            {
+               ns = Namespace::find(fnNamespace);
+               nsEntry = ns->lookup(fnName);
+            }
             if(!nsEntry)
             {
-               ip+= 3;
+               ip+= 4;
                Con::warnf(ConsoleLogEntry::General,
                   "%s: Unable to find function %s%s%s",
-                  getFileLine(ip-4), fnNamespace ? fnNamespace : "",
+                  getFileLine(ip-5), fnNamespace ? fnNamespace : "",
                   fnNamespace ? "::" : "", fnName);
                STR.popFrame();
                break;
@@ -1545,9 +1629,13 @@ breakContinue:
             }
 
             U32 callType = code[ip+2];
+            callCache = smUseInlineCaches ? &callSiteCaches[code[ip+3]] : NULL;
+
+            ip += 4;
 
-            ip += 3;
-            STR.getArgcArgv(fnName, &callArgc, &callArgv);
+            // Numeric arguments are only formatted below if the callee
+            // isn't a script function.
+            STR.getArgcArgv(fnName, &callArgc, &callArgv, false, false);
 
             const char *componentReturnValue = "";
 
@@ -1557,20 +1645,31 @@ breakContinue:
                {
                   // We must not have come from OP_CALLFUNC_RESOLVE, so figure out
                   // our own entry.
-                  nsEntry = Namespace::global()->lookup( fnName );
+                  nsEntry = callCache ? callCache->lookup( Namespace::global(), fnName ) : Namespace::global()->lookup( fnName );
                }
                ns = NULL;
             }
             else if(callType == FuncCallExprNode::MethodCall)
             {
                saveObject = gEvalState.thisObject;
-               gEvalState.thisObject = Sim::findObject(callArgv[1]);
+
+               F64 objectId;
+               if(STR.getArgType(1, callArgv[1], objectId) == StringStack::IntValue)
+                  gEvalState.thisObject = Sim::findObject(SimObjectId(S32(objectId)));
+               else
+               {
+                  STR.formatArg(1, callArgv[1]);
+                  gEvalState.thisObject = Sim::findObject(callArgv[1]);
+               }
+
                if(!gEvalState.thisObject)
                {
+                  STR.formatArg(1, callArgv[1]);
+
                   // Go back to the previous saved object.
                   gEvalState.thisObject = saveObject;
 
-                  Con::warnf(ConsoleLogEntry::General,"%s: Unable to find object: '%s' attempting to call function '%s'", getFileLine(ip-4), callArgv[1], fnName);
+                  Con::warnf(ConsoleLogEntry::General,"%s: Unable to find object: '%s' attempting to call function '%s'", getFileLine(ip-5), callArgv[1], fnName);
                   STR.popFrame();
                   break;
                }
@@ -1580,12 +1679,15 @@ breakContinue:
                {
                   ICallMethod *pComponent = dynamic_cast<ICallMethod *>( gEvalState.thisObject );
                   if( pComponent )
+                  {
+                     STR.formatArgs();
                      componentReturnValue = pComponent->callMethodArgList( callArgc, callArgv, false );
+                  }
                }
                
                ns = gEvalState.thisObject->getNamespace();
                if(ns)
-                  nsEntry = ns->lookup(fnName);
+                  nsEntry = callCache ? callCache->lookup(ns, fnName) : ns->lookup(fnName);
                else
                   nsEntry = NULL;
             }
@@ -1595,7 +1697,7 @@ breakContinue:
                {
                   ns = thisNamespace->mParent;
                   if(ns)
-                     nsEntry = ns->lookup(fnName);
+                     nsEntry = callCache ? callCache->lookup(ns, fnName) : ns->lookup(fnName);
                   else
                      nsEntry = NULL;
                }
@@ -1618,7 +1720,7 @@ breakContinue:
             {
                if(!noCalls && !( routingId == MethodOnComponent ) )
                {
-                  Con::warnf(ConsoleLogEntry::General,"%s: Unknown command %s.", getFileLine(ip-4), fnName);
+                  Con::warnf(ConsoleLogEntry::General,"%s: Unknown command %s.", getFileLine(ip-5), fnName);
                   if(callType == FuncCallExprNode::MethodCall)
                   {
                      Con::warnf(ConsoleLogEntry::General, "  Object %s(%d) %s",
@@ -1638,30 +1740,42 @@ breakContinue:
             if(nsEntry->mType == Namespace::Entry::ConsoleFunctionType)
             {
                const char *ret = "";
+               StringStack::ValueType retType = StringStack::StringValue;
+               F64 retNumber = 0;
                if(nsEntry->mFunctionOffset)
-                  ret = nsEntry->mCode->exec(nsEntry->mFunctionOffset, fnName, nsEntry->mNamespace, callArgc, callArgv, false, nsEntry->mPackage);
+               {
+                  ret = nsEntry->mCode->exec(nsEntry->mFunctionOffset, fnName, nsEntry->mNamespace, callArgc, callArgv, false, nsEntry->mPackage, -1, true);
+
+                  // Keep numeric return values numeric so they are only
+                  // formatted if the caller needs the string.
+                  retType = STR.getValueType();
+                  retNumber = STR.getNumberValue();
+               }
                
                STR.popFrame();
-               STR.setStringValue(ret);
+               STR.setTypedValue(retType, retNumber, ret);
             }
             else
             {
+               // Native functions take all their arguments as strings.
+               STR.formatArgs();
+
                const char* nsName = ns? ns->mName: "";
 #ifndef TORQUE_DEBUG
                // [tom, 12/13/2006] This stops tools functions from working in the console,
                // which is useful behavior when debugging so I'm ifdefing this out for debug builds.
                if(nsEntry->mToolOnly && ! Con::isCurrentScriptToolScript())
                {
-                  Con::errorf(ConsoleLogEntry::Script, "%s: %s::%s - attempting to call tools only function from outside of tools.", getFileLine(ip-4), nsName, fnName);
+                  Con::errorf(ConsoleLogEntry::Script, "%s: %s::%s - attempting to call tools only function from outside of tools.", getFileLine(ip-5), nsName, fnName);
                }
                else
 #endif
                if((nsEntry->mMinArgs && S32(callArgc) < nsEntry->mMinArgs) || (nsEntry->mMaxArgs && S32(callArgc) > nsEntry->mMaxArgs))
                {
                   Con::warnf(ConsoleLogEntry::Script, "%s: %s::%s - wrong number of arguments (got %i, expected min %i and max %i).",
-                     getFileLine(ip-4), nsName, fnName,
+                     getFileLine(ip-5), nsName, fnName,
                      callArgc, nsEntry->mMinArgs, nsEntry->mMaxArgs);
-                  Con::warnf(ConsoleLogEntry::Script, "%s: usage: %s", getFileLine(ip-4), nsEntry->mUsage);
+                  Con::warnf(ConsoleLogEntry::Script, "%s: usage: %s", getFileLine(ip-5), nsEntry->mUsage);
                   STR.popFrame();
                }
                else
@@ -1725,7 +1839,7 @@ breakContinue:
                      case Namespace::Entry::VoidCallbackType:
                         nsEntry->cb.mVoidCallbackFunc(gEvalState.thisObject, callArgc, callArgv);
                         if( code[ ip ] != OP_STR_TO_NONE && Con::getBoolVariable( "$Con::warnVoidAssignment", true ) )
-                           Con::warnf(ConsoleLogEntry::General, "%s: Call to %s in %s uses result of void function call.", getFileLine(ip-4), fnName, functionName);
+                           Con::warnf(ConsoleLogEntry::General, "%s: Call to %s in %s uses result of void function call.", getFileLine(ip-5), fnName, functionName);
                         
                         STR.popFrame();
                         STR.setStringValue("");
@@ -1790,6 +1904,16 @@ breakContinue:
             STR.push();
             break;
 
+         case OP_PUSH_UINT:
+            STR.setIntValue(intStack[_UINT--]);
+            STR.push();
+            break;
+
+         case OP_PUSH_FLT:
+            STR.setFloatValue(floatStack[_FLT--]);
+            STR.push();
+            break;
+
          case OP_PUSH_FRAME:
             STR.pushFrame();
             break;
@@ -2000,14 +2124,8 @@ execFinished:
       }
    }
    else
-   {
-      delete[] globalStrings;
-      globalStringsMaxLen = 0;
+      freeGlobalTables();
 
-      delete[] globalFloats;
-      globalStrings = NULL;
-      globalFloats = NULL;
-   }
    smCurrentCodeBlock = saveCodeBlock;
    if(saveCodeBlock && saveCodeBlock->name)
    {
@@ -2021,6 +2139,11 @@ execFinished:
    AssertFatal(!(STR.mStartStackSize > stackStart), "String stack not popped enough in script exec");
    AssertFatal(!(STR.mStartStackSize < stackStart), "String stack popped too much in script exec");
 #endif
+   // A script caller reads a numeric return value off the string stack
+   // itself, so it's only formatted for native callers.
+   if(typedReturn && STR.getValueType() != StringStack::StringValue)
+      return "";
+
    return STR.getStringValue();
 }
 
@@ -198,7 +198,6 @@ char *CompilerStringTable::build()
 
 void CompilerStringTable::write(Stream &st)
 {
-   st.write(totalLen);
    for(Entry *walk = list; walk; walk = walk->next)
       st.write(walk->len, walk->string);
 }
@@ -235,7 +234,6 @@ F64 *CompilerFloatTable::build()
 
 void CompilerFloatTable::write(Stream &st)
 {
-   st.write(count);
    for(Entry *walk = list; walk; walk = walk->next)
       st.write(walk->val);
 }
@@ -267,13 +265,22 @@ void CompilerIdentTable::add(StringTableEntry ste, U32 ip)
    newEntry->nextIdent = NULL;
 }
 
+void CompilerIdentTable::getSize(U32 &count, U32 &dataSize)
+{
+   count = 0;
+   dataSize = 0;
+   for(Entry *walk = list; walk; walk = walk->next)
+   {
+      count++;
+      dataSize += 2;
+      for(Entry *el = walk; el; el = el->nextIdent)
+         dataSize++;
+   }
+}
+
 void CompilerIdentTable::write(Stream &st)
 {
-   U32 count = 0;
    Entry * walk;
-   for(walk = list; walk; walk = walk->next)
-      count++;
-   st.write(count);
    for(walk = list; walk; walk = walk->next)
    {
       U32 ec = 0;
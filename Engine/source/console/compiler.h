@@ -54,6 +54,8 @@ namespace Compiler
       OP_RETURN,
       // fixes a bug when not explicitly returning a value
       OP_RETURN_VOID,
+      OP_RETURN_UINT,      ///< Return a value from the int stack.
+      OP_RETURN_FLT,       ///< Return a value from the float stack.
       OP_CMPEQ,
       OP_CMPGR,
       OP_CMPGE,
@@ -137,6 +139,8 @@ namespace Compiler
       OP_COMPARE_STR,
 
       OP_PUSH,
+      OP_PUSH_UINT,        ///< Push an argument from the int stack.
+      OP_PUSH_FLT,         ///< Push an argument from the float stack.
       OP_PUSH_FRAME,
 
       OP_ASSERT,
@@ -170,6 +174,9 @@ namespace Compiler
       Entry *list;
       void add(StringTableEntry ste, U32 ip);
       void reset();
+
+      /// Number of identifiers and the size in U32s of their fixup records.
+      void getSize(U32 &count, U32 &dataSize);
       void write(Stream &st);
    };
 
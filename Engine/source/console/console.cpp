@@ -339,6 +339,14 @@ void init()
    addVariable( "instantGroup", TypeRealString, &gInstantGroup, "The group that objects will be added to when they are created.\n"
 	   "@ingroup Console\n");
 
+   addVariable("Con::typedValueStack", TypeBool, &StringStack::smTypedValues, "If true, numbers passed between script functions are kept "
+      "as numbers instead of being converted to strings and back.\n"
+	   "@ingroup Console\n");
+
+   addVariable("Con::useInlineCaches", TypeBool, &CodeBlock::smUseInlineCaches, "If true, script call and field access sites cache their "
+      "function and field lookups.\n"
+	   "@ingroup Console\n");
+
    addVariable("Con::objectCopyFailures", TypeS32, &gObjectCopyFailures, "If greater than zero then it counts the number of object creation "
       "failures based on a missing copy object and does not report an error..\n"
 	   "@ingroup Console\n");   
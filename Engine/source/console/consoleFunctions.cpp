@@ -1978,7 +1978,7 @@ DefineEngineFunction( exec, bool, ( const char* fileName, bool noCalls, bool jou
    char* script = NULL;
    U32 version;
 
-   Stream *compiledStream = NULL;
+   Torque::FS::FileRef compiledFile;
    Torque::Time scriptModifiedTime, dsoModifiedTime;
 
    // Check here for .edso
@@ -2034,16 +2034,17 @@ DefineEngineFunction( exec, bool, ( const char* fileName, bool noCalls, bool jou
    //Note: Using Nathan Martin's version from the forums since its easier to read and understand
    if(compiled && dsoFile != NULL && (scriptFile == NULL|| (dsoModifiedTime >= scriptModifiedTime)))
    { //MGT: end
-      compiledStream = FileStream::createAndOpen( nameBuffer, Torque::FS::File::Read );
-      if (compiledStream)
+      compiledFile = Torque::FS::OpenFile( nameBuffer, Torque::FS::File::Read );
+      if (compiledFile)
       {
          // Check the version!
-         compiledStream->read(&version);
+         if(compiledFile->read(&version, sizeof(version)) != sizeof(version))
+            version = 0;
+         version = convertLEndianToHost(version);
          if(version != Con::DSOVersion)
          {
             Con::warnf("exec: Found an old DSO (%s, ver %d < %d), ignoring.", nameBuffer, version, Con::DSOVersion);
-            delete compiledStream;
-            compiledStream = NULL;
+            compiledFile = NULL;
          }
       }
    }
@@ -2052,7 +2053,7 @@ DefineEngineFunction( exec, bool, ( const char* fileName, bool noCalls, bool jou
    if(journal && Journal::IsRecording())
       Journal::WriteString(scriptFileName);
 
-   if(scriptFile != NULL && !compiledStream)
+   if(scriptFile != NULL && !compiledFile)
    {
       // If we have source but no compiled version, then we need to compile
       // (and journal as we do so, if that's required).
@@ -2100,12 +2101,8 @@ DefineEngineFunction( exec, bool, ( const char* fileName, bool noCalls, bool jou
          delete code;
          code = NULL;
 
-         compiledStream = FileStream::createAndOpen( nameBuffer, Torque::FS::File::Read );
-         if(compiledStream)
-         {
-            compiledStream->read(&version);
-         }
-         else
+         compiledFile = Torque::FS::OpenFile( nameBuffer, Torque::FS::File::Read );
+         if(!compiledFile)
          {
             // We have to exit out here, as otherwise we get double error reports.
             delete [] script;
@@ -2121,7 +2118,7 @@ DefineEngineFunction( exec, bool, ( const char* fileName, bool noCalls, bool jou
          Journal::Write(bool(false));
    }
 
-   if(compiledStream)
+   if(compiledFile)
    {
       // Delete the script object first to limit memory used
       // during recursive execs.
@@ -2133,10 +2130,14 @@ DefineEngineFunction( exec, bool, ( const char* fileName, bool noCalls, bool jou
       Con::printf("Loading compiled script %s.", scriptFileName);
 #endif   
       CodeBlock *code = new CodeBlock;
-      code->read(scriptFileName, *compiledStream);
-      delete compiledStream;
-      code->exec(0, scriptFileName, NULL, 0, NULL, noCalls, NULL, 0);
-      ret = true;
+      if(code->read(scriptFileName, compiledFile))
+      {
+         code->exec(0, scriptFileName, NULL, 0, NULL, noCalls, NULL, 0);
+         ret = true;
+      }
+      else
+         delete code;
+      compiledFile = NULL;
    }
    else
       if(scriptFile)
@@ -178,6 +178,9 @@ namespace Sim
    U32  getTimeSinceStart(U32 eventId);
    U32  getScheduleDuration(U32 eventId);
 
+   /// Returns the number of events currently waiting in the event queue.
+   U32  getEventQueueSize();
+
    /// Appends numbers to inName until an unused SimObject name is created
    String getUniqueName( const char *inName );
    /// Appends numbers to inName until an internal name not taken in the inSet is found.
@@ -54,14 +54,14 @@ class Semaphore;
 class SimEvent
 {
 public:
-   SimEvent *nextEvent;     ///< Linked list details - pointer to next item in the list.
+   U32 queueIndex;          ///< Slot of this event in the sim event queue heap.
    SimTime startTime;       ///< When the event was posted.
    SimTime time;            ///< When the event is scheduled to occur.
    U32 sequenceCount;       ///< Unique ID. These are assigned sequentially based on order
    ///  of addition to the list.
    SimObject *destObject;   ///< Object on which this event will be applied.
 
-   SimEvent() { destObject = NULL; }
+   SimEvent() { destObject = NULL; queueIndex = 0; }
    virtual ~SimEvent() {}   ///< Destructor
    ///
    /// A dummy virtual destructor is required
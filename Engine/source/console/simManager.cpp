@@ -31,6 +31,7 @@
 #include "console/consoleInternal.h"
 #include "console/engineAPI.h"
 #include "core/idGenerator.h"
+#include "core/util/tDictionary.h"
 #include "core/util/safeDelete.h"
 #include "platform/platformIntrinsics.h"
 #include "platform/profiler.h"
@@ -53,14 +54,112 @@ namespace Sim
 
 //---------------------------------------------------------------------------
 // event queue variables:
+//
+// Pending events are kept in a binary min-heap ordered by (time, sequenceCount)
+// with each event caching its own heap slot in SimEvent::queueIndex.  A hash
+// table maps event sequence numbers back to events so that cancelEvent() and
+// the various pending queries don't need to scan the queue.  Ordering on the
+// sequence count keeps events with the same time in the order they were posted.
 
 SimTime gCurrentTime;
 SimTime gTargetTime;
 
 void *gEventQueueMutex;
-SimEvent *gEventQueue;
+Vector< SimEvent* > gEventQueue( __FILE__, __LINE__ );
+HashTable< U32, SimEvent* > gEventLookup;
 U32 gEventSequence;
 
+//---------------------------------------------------------------------------
+// event queue heap maintenance
+
+static inline bool isEventBefore( const SimEvent* a, const SimEvent* b )
+{
+   if( a->time != b->time )
+      return a->time < b->time;
+
+   // Wrap-safe sequence compare.
+   return S32( a->sequenceCount - b->sequenceCount ) < 0;
+}
+
+static inline void setEventSlot( U32 index, SimEvent* event )
+{
+   gEventQueue[ index ] = event;
+   event->queueIndex = index;
+}
+
+static void siftEventUp( U32 index )
+{
+   SimEvent* event = gEventQueue[ index ];
+   while( index > 0 )
+   {
+      const U32 parent = ( index - 1 ) >> 1;
+      if( !isEventBefore( event, gEventQueue[ parent ] ) )
+         break;
+
+      setEventSlot( index, gEventQueue[ parent ] );
+      index = parent;
+   }
+   setEventSlot( index, event );
+}
+
+static void siftEventDown( U32 index )
+{
+   const U32 count = gEventQueue.size();
+   SimEvent* event = gEventQueue[ index ];
+   for(;;)
+   {
+      U32 child = ( index << 1 ) + 1;
+      if( child >= count )
+         break;
+
+      if( child + 1 < count && isEventBefore( gEventQueue[ child + 1 ], gEventQueue[ child ] ) )
+         child ++;
+
+      if( !isEventBefore( gEventQueue[ child ], event ) )
+         break;
+
+      setEventSlot( index, gEventQueue[ child ] );
+      index = child;
+   }
+   setEventSlot( index, event );
+}
+
+static void insertQueuedEvent( SimEvent* event )
+{
+   gEventQueue.push_back( event );
+   siftEventUp( gEventQueue.size() - 1 );
+   gEventLookup.insertUnique( event->sequenceCount, event );
+}
+
+/// Unlink an event from the queue without deleting it.
+static void removeQueuedEvent( SimEvent* event )
+{
+   const U32 index = event->queueIndex;
+   AssertFatal( index < gEventQueue.size() && gEventQueue[ index ] == event,
+      "Sim::removeQueuedEvent() - Event is not in the queue." );
+
+   gEventLookup.erase( event->sequenceCount );
+
+   SimEvent* last = gEventQueue.last();
+   gEventQueue.pop_back();
+   if( last == event )
+      return;
+
+   setEventSlot( index, last );
+   if( index > 0 && isEventBefore( last, gEventQueue[ ( index - 1 ) >> 1 ] ) )
+      siftEventUp( index );
+   else
+      siftEventDown( index );
+}
+
+static inline SimEvent* findQueuedEvent( U32 eventSequence )
+{
+   HashTable< U32, SimEvent* >::Iterator iter = gEventLookup.find( eventSequence );
+   if( iter == gEventLookup.end() )
+      return NULL;
+   return iter->value;
+}
+
 //---------------------------------------------------------------------------
 // event queue init/shutdown
 
@@ -69,7 +168,8 @@ static void initEventQueue()
    gCurrentTime = 0;
    gTargetTime = 0;
    gEventSequence = 1;
-   gEventQueue = NULL;
+   gEventQueue.clear();
+   gEventLookup.clear();
    gEventQueueMutex = Mutex::createMutex();
 }
 
@@ -77,13 +177,10 @@ static void shutdownEventQueue()
 {
    // Delete all pending events
    Mutex::lockMutex(gEventQueueMutex);
-   SimEvent *walk = gEventQueue;
-   while(walk)
-   {
-      SimEvent *temp = walk->nextEvent;
-      delete walk;
-      walk = temp;
-   }
+   for( U32 i = 0; i < gEventQueue.size(); i ++ )
+      delete gEventQueue[ i ];
+   gEventQueue.clear();
+   gEventLookup.clear();
    Mutex::unlockMutex(gEventQueueMutex);
    Mutex::destroyMutex(gEventQueueMutex);
 }
@@ -115,19 +212,15 @@ U32 postEvent(SimObject *destObject, SimEvent* event,U32 time)
       return InvalidEventId;
    }
    event->sequenceCount = gEventSequence++;
-   SimEvent **walk = &gEventQueue;
-   SimEvent *current;
-   
-   while((current = *walk) != NULL && (current->time < event->time))
-      walk = &(current->nextEvent);
-   
+
+   // Skip the invalid id if the sequence wraps around.
+   if( gEventSequence == InvalidEventId )
+      gEventSequence++;
+
    // [tom, 6/24/2005] This ensures that SimEvents are dispatched in the same order that they are posted.
    // This is needed to ensure Con::threadSafeExecute() executes script code in the correct order.
-   while((current = *walk) != NULL && (current->time == event->time))
-      walk = &(current->nextEvent);
-   
-   event->nextEvent = current;
-   *walk = event;
+   // The heap orders events with equal times by their sequence count.
+   insertQueuedEvent( event );
 
    U32 seqCount = event->sequenceCount;
 
@@ -143,20 +236,11 @@ void cancelEvent(U32 eventSequence)
 {
    Mutex::lockMutex(gEventQueueMutex);
 
-   SimEvent **walk = &gEventQueue;
-   SimEvent *current;
-   
-   while((current = *walk) != NULL)
+   SimEvent *event = findQueuedEvent( eventSequence );
+   if( event )
    {
-      if(current->sequenceCount == eventSequence)
-      {
-         *walk = current->nextEvent;
-         delete current;
-         Mutex::unlockMutex(gEventQueueMutex);
-         return;
-      }
-      else
-         walk = &(current->nextEvent);
+      removeQueuedEvent( event );
+      delete event;
    }
 
    Mutex::unlockMutex(gEventQueueMutex);
@@ -166,19 +250,28 @@ void cancelPendingEvents(SimObject *obj)
 {
    Mutex::lockMutex(gEventQueueMutex);
 
-   SimEvent **walk = &gEventQueue;
-   SimEvent *current;
-   
-   while((current = *walk) != NULL)
+   // Compact out the object's events and then rebuild the heap in one pass
+   // rather than sifting for each removal.
+   U32 count = 0;
+   for( U32 i = 0; i < gEventQueue.size(); i ++ )
    {
-      if(current->destObject == obj)
+      SimEvent *current = gEventQueue[ i ];
+      if( current->destObject == obj )
       {
-         *walk = current->nextEvent;
+         gEventLookup.erase( current->sequenceCount );
          delete current;
       }
       else
-         walk = &(current->nextEvent);
+         setEventSlot( count ++, current );
    }
+
+   if( count != gEventQueue.size() )
+   {
+      gEventQueue.setSize( count );
+      for( S32 i = S32( count / 2 ) - 1; i >= 0; i -- )
+         siftEventDown( i );
+   }
+
    Mutex::unlockMutex(gEventQueueMutex);
 }
 
@@ -189,47 +282,57 @@ bool isEventPending(U32 eventSequence)
 {
    Mutex::lockMutex(gEventQueueMutex);
 
-   for(SimEvent *walk = gEventQueue; walk; walk = walk->nextEvent)
-      if(walk->sequenceCount == eventSequence)
-      {
-         Mutex::unlockMutex(gEventQueueMutex);
-         return true;
-      }
+   bool pending = ( findQueuedEvent( eventSequence ) != NULL );
+
    Mutex::unlockMutex(gEventQueueMutex);
-   return false;
+   return pending;
 }
 
 U32 getEventTimeLeft(U32 eventSequence)
 {
    Mutex::lockMutex(gEventQueueMutex);
 
-   for(SimEvent *walk = gEventQueue; walk; walk = walk->nextEvent)
-      if(walk->sequenceCount == eventSequence)
-      {
-         SimTime t = walk->time - getCurrentTime();
-         Mutex::unlockMutex(gEventQueueMutex);
-         return t;
-      }
+   SimTime t = 0;
+   if( SimEvent *event = findQueuedEvent( eventSequence ) )
+      t = event->time - getCurrentTime();
 
    Mutex::unlockMutex(gEventQueueMutex);
 
-   return 0;   
+   return t;   
 }
 
 U32 getScheduleDuration(U32 eventSequence)
 {
-   for(SimEvent *walk = gEventQueue; walk; walk = walk->nextEvent)
-      if(walk->sequenceCount == eventSequence)
-         return (walk->time-walk->startTime);
-   return 0;
+   Mutex::lockMutex(gEventQueueMutex);
+
+   SimTime t = 0;
+   if( SimEvent *event = findQueuedEvent( eventSequence ) )
+      t = event->time - event->startTime;
+
+   Mutex::unlockMutex(gEventQueueMutex);
+
+   return t;
 }
 
 U32 getTimeSinceStart(U32 eventSequence)
 {
-   for(SimEvent *walk = gEventQueue; walk; walk = walk->nextEvent)
-      if(walk->sequenceCount == eventSequence)
-         return (getCurrentTime()-walk->startTime);
-   return 0;
+   Mutex::lockMutex(gEventQueueMutex);
+
+   SimTime t = 0;
+   if( SimEvent *event = findQueuedEvent( eventSequence ) )
+      t = getCurrentTime() - event->startTime;
+
+   Mutex::unlockMutex(gEventQueueMutex);
+
+   return t;
+}
+
+U32 getEventQueueSize()
+{
+   Mutex::lockMutex(gEventQueueMutex);
+   U32 size = gEventQueue.size();
+   Mutex::unlockMutex(gEventQueueMutex);
+   return size;
 }
 
 //---------------------------------------------------------------------------
@@ -243,10 +346,10 @@ void advanceToTime(SimTime targetTime)
    Mutex::lockMutex(gEventQueueMutex);
 
    gTargetTime = targetTime;
-   while(gEventQueue && gEventQueue->time <= targetTime)
+   while(gEventQueue.size() && gEventQueue.first()->time <= targetTime)
    {
-      SimEvent *event = gEventQueue;
-      gEventQueue = gEventQueue->nextEvent;
+      SimEvent *event = gEventQueue.first();
+      removeQueuedEvent( event );
       AssertFatal(event->time >= gCurrentTime,
          "Sim::advanceToTime() - Event time is less than current time.");
       gCurrentTime = event->time;
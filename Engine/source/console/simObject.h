@@ -451,6 +451,13 @@ class SimObject: public ConsoleObject
       ///                      (if field is an array); if NULL, it is ignored.
       const char *getDataField(StringTableEntry slotName, const char *array);
 
+      /// Get the value of a field on the object for which the static field
+      /// has already been looked up.
+      ///
+      /// @param   field       Result of findField( slotName ) or NULL if
+      ///                      there is no static field by that name.
+      const char *getDataField(StringTableEntry slotName, const char *array, const AbstractClassRep::Field *field);
+
       /// Set the value of a field on the object.
       ///
       /// See @ref simobject_console "here" for a detailed discussion of what this
@@ -461,6 +468,13 @@ class SimObject: public ConsoleObject
       /// @param   value       Value to store.
       void setDataField(StringTableEntry slotName, const char *array, const char *value);
 
+      /// Set the value of a field on the object for which the static field
+      /// has already been looked up.
+      ///
+      /// @param   field       Result of findField( slotName ) or NULL if
+      ///                      there is no static field by that name.
+      void setDataField(StringTableEntry slotName, const char *array, const char *value, const AbstractClassRep::Field *field);
+
       /// Get the type of a field on the object.
       ///
       /// @param   slotName    Field to access.
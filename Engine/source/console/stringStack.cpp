@@ -22,20 +22,35 @@
 
 #include "console/stringStack.h"
 
-void StringStack::getArgcArgv(StringTableEntry name, U32 *argc, const char ***in_argv, bool popStackFrame /* = false */)
+bool StringStack::smTypedValues = true;
+
+void StringStack::getArgcArgv(StringTableEntry name, U32 *argc, const char ***in_argv, bool popStackFrame /* = false */, bool format /* = true */)
 {
    U32 startStack = mFrameOffsets[mNumFrames-1] + 1;
    U32 argCount   = getMin(mStartStackSize - startStack, (U32)MaxArgs - 1);
 
    *in_argv = mArgV;
    mArgV[0] = name;
+   mArgCheckV[0] = NULL;
+   mArgPending[0] = false;
    
    for(U32 i = 0; i < argCount; i++)
+   {
       mArgV[i+1] = mBuffer + mStartOffsets[startStack + i];
+      mArgCheckV[i+1] = mArgV[i+1];
+      mArgTypes[i+1] = mStartTypes[startStack + i];
+      mArgNumbers[i+1] = mStartNumbers[startStack + i];
+      mArgPending[i+1] = mStartPending[startStack + i];
+   }
    argCount++;
+   mNumArgTypes = argCount;
    
    *argc = argCount;
 
+   // Popping the frame drops the argument types, so format them now.
+   if(format || popStackFrame)
+      formatArgs();
+
    if(popStackFrame)
       popFrame();
 }
\ No newline at end of file
@@ -40,13 +40,35 @@
 ///
 /// This class provides some powerful semantics for working with strings, and is
 /// used heavily by the console interpreter.
+///
+/// Every slot on the stack is tagged with the type of value it was set from.
+/// Numbers stored with setIntValue() or setFloatValue() are only formatted
+/// into the string buffer once someone actually asks for the string, and
+/// reading them back with getIntValue() or getFloatValue() skips the
+/// string parse altogether.  This includes numbers pushed as function
+/// arguments; they are only formatted if the callee is native or reads
+/// them as strings.
 struct StringStack
 {
    enum {
       MaxStackDepth = 1024,
       MaxArgs = 20,
-      ReturnBufferSpace = 512
+      ReturnBufferSpace = 512,
+      NumberBufferSpace = 32     ///< Space reserved for a number pushed without formatting it.
    };
+
+   /// Type of value held by a stack slot.
+   enum ValueType
+   {
+      StringValue,   ///< Only the string in the buffer is valid.
+      IntValue,      ///< Set from an integer.
+      FloatValue     ///< Set from a float.
+   };
+
+   /// If false, numbers are formatted right away and all slots are treated
+   /// as strings, which is how the interpreter used to work.
+   static bool smTypedValues;
+
    char *mBuffer;
    U32   mBufferSize;
    const char *mArgV[MaxArgs];
@@ -64,6 +86,30 @@ struct StringStack
    U32 mArgBufferSize;
    char *mArgBuffer;
 
+   /// Type and numeric value of the top of the stack.
+   ValueType mValueType;
+   F64 mNumberValue;
+
+   /// True if the top of the stack holds a number that has not been
+   /// formatted into the buffer yet.
+   bool mPendingFormat;
+
+   /// Types and numeric values of the slots in #mStartOffsets.
+   U8 mStartTypes[MaxStackDepth];
+   F64 mStartNumbers[MaxStackDepth];
+
+   /// True for slots pushed by push() that hold a number which has not
+   /// been formatted into their NumberBufferSpace bytes yet.
+   bool mStartPending[MaxStackDepth];
+
+   /// Types of the arguments returned by the last getArgcArgv().  Only
+   /// valid until the next frame is popped.
+   const char *mArgCheckV[MaxArgs];
+   U8 mArgTypes[MaxArgs];
+   F64 mArgNumbers[MaxArgs];
+   bool mArgPending[MaxArgs];
+   U32 mNumArgTypes;
+
    void validateBufferSize(U32 size)
    {
       if(size > mBufferSize)
@@ -91,6 +137,10 @@ struct StringStack
       mLen = 0;
       mStartStackSize = 0;
       mFunctionOffset = 0;
+      mValueType = StringValue;
+      mNumberValue = 0;
+      mPendingFormat = false;
+      mNumArgTypes = 0;
       validateBufferSize(8192);
       validateArgBufferSize(2048);
    }
@@ -102,20 +152,133 @@ struct StringStack
          dFree( mArgBuffer );
    }
 
+   /// Format a number the way the interpreter always has.
+   static void formatNumber(char *buffer, ValueType type, F64 number)
+   {
+      if(type == IntValue)
+         dSprintf(buffer, NumberBufferSpace, "%d", S32(number));
+      else
+         dSprintf(buffer, NumberBufferSpace, "%g", number);
+   }
+
+   /// Format a pending number on the top of the stack into the buffer.
+   void formatValue()
+   {
+      if(!mPendingFormat)
+         return;
+
+      validateBufferSize(mStart + NumberBufferSpace);
+      formatNumber(mBuffer + mStart, mValueType, mNumberValue);
+      mLen = dStrlen(mBuffer + mStart);
+      mPendingFormat = false;
+   }
+
+   /// Format a number pushed by push() into the space reserved for it.
+   void formatSlot(U32 slot)
+   {
+      if(!mStartPending[slot])
+         return;
+
+      formatNumber(mBuffer + mStartOffsets[slot], ValueType(mStartTypes[slot]), mStartNumbers[slot]);
+      mStartPending[slot] = false;
+   }
+
+   /// Format an argument returned by the last getArgcArgv() if it was
+   /// pushed as a number and hasn't been formatted yet.
+   ///
+   /// @param index Index of the argument in argv.
+   /// @param arg The argument string as handed to the callee; nothing is
+   ///    done if it doesn't match what getArgcArgv() returned.
+   void formatArg(U32 index, const char *arg)
+   {
+      if(index >= mNumArgTypes || !mArgPending[index] || mArgCheckV[index] != arg)
+         return;
+
+      formatNumber(const_cast<char*>(mArgCheckV[index]), ValueType(mArgTypes[index]), mArgNumbers[index]);
+      mArgPending[index] = false;
+   }
+
+   /// Format all arguments returned by the last getArgcArgv().  This must
+   /// be done before handing them to anything but a script function.
+   void formatArgs()
+   {
+      for(U32 i = 1; i < mNumArgTypes; i++)
+         formatArg(i, mArgCheckV[i]);
+   }
+
    /// Set the top of the stack to be an integer value.
    void setIntValue(U32 i)
    {
-      validateBufferSize(mStart + 32);
-      dSprintf(mBuffer + mStart, 32, "%d", i);
-      mLen = dStrlen(mBuffer + mStart);
+      if(!smTypedValues)
+      {
+         validateBufferSize(mStart + 32);
+         dSprintf(mBuffer + mStart, 32, "%d", i);
+         mLen = dStrlen(mBuffer + mStart);
+         mValueType = StringValue;
+         return;
+      }
+
+      mValueType = IntValue;
+      mNumberValue = S32(i);
+      mPendingFormat = true;
    }
 
    /// Set the top of the stack to be a float value.
    void setFloatValue(F64 v)
    {
-      validateBufferSize(mStart + 32);
-      dSprintf(mBuffer + mStart, 32, "%g", v);
-      mLen = dStrlen(mBuffer + mStart);
+      if(!smTypedValues)
+      {
+         validateBufferSize(mStart + 32);
+         dSprintf(mBuffer + mStart, 32, "%g", v);
+         mLen = dStrlen(mBuffer + mStart);
+         mValueType = StringValue;
+         return;
+      }
+
+      mValueType = FloatValue;
+      mNumberValue = v;
+      mPendingFormat = true;
+   }
+
+   /// Set the top of the stack to a value of the given type.  For numeric
+   /// types, @a str is ignored.
+   void setTypedValue(ValueType type, F64 number, const char *str)
+   {
+      if(type == IntValue)
+         setIntValue(U32(S32(number)));
+      else if(type == FloatValue)
+         setFloatValue(number);
+      else
+         setStringValue(str);
+   }
+
+   /// Get the type of the top of the stack.
+   inline ValueType getValueType() const
+   {
+      return mValueType;
+   }
+
+   /// Get the numeric value of the top of the stack.  Only meaningful if
+   /// getValueType() is not StringValue.
+   inline F64 getNumberValue() const
+   {
+      return mNumberValue;
+   }
+
+   /// Get the type an argument returned by the last getArgcArgv() had when
+   /// it was pushed.
+   ///
+   /// @param index Index of the argument in argv.
+   /// @param arg The argument string as handed to the callee; if it doesn't
+   ///    match what getArgcArgv() returned, the argument is treated as a string.
+   /// @param outNumber Receives the numeric value for numeric arguments.
+   ValueType getArgType(U32 index, const char *arg, F64 &outNumber) const
+   {
+      if(index >= mNumArgTypes || mArgCheckV[index] != arg)
+         return StringValue;
+
+      outNumber = mArgNumbers[index];
+      return ValueType(mArgTypes[index]);
    }
 
    /// Return a temporary buffer we can use to return data.
@@ -130,6 +293,7 @@ struct StringStack
    /// This updates the function offset.
    char *getArgBuffer(U32 size)
    {
+      formatValue();
       validateBufferSize(mStart + mFunctionOffset + size);
       char *ret = mBuffer + mStart + mFunctionOffset;
       mFunctionOffset += size;
@@ -145,6 +309,9 @@ struct StringStack
    /// Set a string value on the top of the stack.
    void setStringValue(const char *s)
    {
+      mValueType = StringValue;
+      mPendingFormat = false;
+
       if(!s)
       {
          mLen = 0;
@@ -162,18 +329,27 @@ struct StringStack
    /// @note Don't free this memory!
    inline StringTableEntry getSTValue()
    {
+      formatValue();
       return StringTable->insert(mBuffer + mStart);
    }
 
    /// Get an integer representation of the top of the stack.
    inline U32 getIntValue()
    {
+      if(mValueType == IntValue)
+         return U32(S32(mNumberValue));
+      else if(mValueType == FloatValue)
+         return U32(S64(mNumberValue));
+
       return dAtoi(mBuffer + mStart);
    }
 
    /// Get a float representation of the top of the stack.
    inline F64 getFloatValue()
    {
+      if(mValueType != StringValue)
+         return mNumberValue;
+
       return dAtof(mBuffer + mStart);
    }
 
@@ -182,6 +358,7 @@ struct StringStack
    /// @note This returns a pointer to the actual top of the stack, be careful!
    inline const char *getStringValue()
    {
+      formatValue();
       return mBuffer + mStart;
    }
 
@@ -191,9 +368,14 @@ struct StringStack
    ///       properly push the stack.
    void advance()
    {
+      formatValue();
+      mStartTypes[mStartStackSize] = mValueType;
+      mStartNumbers[mStartStackSize] = mNumberValue;
+      mStartPending[mStartStackSize] = false;
       mStartOffsets[mStartStackSize++] = mStart;
       mStart += mLen;
       mLen = 0;
+      mValueType = StringValue;
    }
 
    /// Advance the start stack, placing a single character, null-terminated strong
@@ -203,37 +385,70 @@ struct StringStack
    ///       properly push the stack.
    void advanceChar(char c)
    {
+      formatValue();
+      mStartTypes[mStartStackSize] = mValueType;
+      mStartNumbers[mStartStackSize] = mNumberValue;
+      mStartPending[mStartStackSize] = false;
       mStartOffsets[mStartStackSize++] = mStart;
       mStart += mLen;
       mBuffer[mStart] = c;
       mBuffer[mStart+1] = 0;
       mStart += 1;
       mLen = 0;
+      mValueType = StringValue;
    }
 
    /// Push the stack, placing a zero-length string on the top.
+   ///
+   /// A number that hasn't been formatted yet stays unformatted; room is
+   /// reserved for it so it can be formatted in place if the string is
+   /// ever needed.
    void push()
    {
-      advanceChar(0);
+      if(!mPendingFormat)
+      {
+         advanceChar(0);
+         return;
+      }
+
+      validateBufferSize(mStart + NumberBufferSpace + 1);
+      mStartTypes[mStartStackSize] = mValueType;
+      mStartNumbers[mStartStackSize] = mNumberValue;
+      mStartPending[mStartStackSize] = true;
+      mStartOffsets[mStartStackSize++] = mStart;
+      mBuffer[mStart] = 0;
+      mStart += NumberBufferSpace;
+      mBuffer[mStart] = 0;
+      mLen = 0;
+      mValueType = StringValue;
+      mPendingFormat = false;
    }
 
    inline void setLen(U32 newlen)
    {
       mLen = newlen;
+      mValueType = StringValue;
+      mPendingFormat = false;
    }
 
    /// Pop the start stack.
    void rewind()
    {
-      mStart = mStartOffsets[--mStartStackSize];
+      formatValue();
+      mValueType = StringValue;
+      formatSlot(--mStartStackSize);
+      mStart = mStartOffsets[mStartStackSize];
       mLen = dStrlen(mBuffer + mStart);
    }
 
    // Terminate the current string, and pop the start stack.
    void rewindTerminate()
    {
+      mValueType = StringValue;
+      mPendingFormat = false;
       mBuffer[mStart] = 0;
-      mStart = mStartOffsets[--mStartStackSize];
+      formatSlot(--mStartStackSize);
+      mStart = mStartOffsets[mStartStackSize];
       mLen   = dStrlen(mBuffer + mStart);
    }
 
@@ -241,9 +456,13 @@ struct StringStack
    /// and returning true if they matched, false if they didn't.
    U32 compare()
    {
+      formatValue();
+      mValueType = StringValue;
+
       // Figure out the 1st and 2nd item offsets.
       U32 oldStart = mStart;
-      mStart = mStartOffsets[--mStartStackSize];
+      formatSlot(--mStartStackSize);
+      mStart = mStartOffsets[mStartStackSize];
 
       // Compare current and previous strings.
       U32 ret = !dStricmp(mBuffer + mStart, mBuffer + oldStart);
@@ -258,7 +477,13 @@ struct StringStack
    
    void pushFrame()
    {
+      // Whatever is on the top is dropped when the frame is popped, so
+      // there's no need to format it.
+      mValueType = StringValue;
+      mPendingFormat = false;
       mFrameOffsets[mNumFrames++] = mStartStackSize;
+      mStartTypes[mStartStackSize] = StringValue;
+      mStartPending[mStartStackSize] = false;
       mStartOffsets[mStartStackSize++] = mStart;
       mStart += ReturnBufferSpace;
       validateBufferSize(0);
@@ -269,10 +494,17 @@ struct StringStack
       mStartStackSize = mFrameOffsets[--mNumFrames];
       mStart = mStartOffsets[mStartStackSize];
       mLen = 0;
+      mValueType = StringValue;
+      mPendingFormat = false;
+      mNumArgTypes = 0;
    }
 
    /// Get the arguments for a function call from the stack.
-   void getArgcArgv(StringTableEntry name, U32 *argc, const char ***in_argv, bool popStackFrame = false);
+   ///
+   /// @param format If false, arguments pushed as numbers are left
+   ///    unformatted and formatArgs() must be called before the arguments
+   ///    are read as strings.
+   void getArgcArgv(StringTableEntry name, U32 *argc, const char ***in_argv, bool popStackFrame = false, bool format = true);
 };
 
 #endif
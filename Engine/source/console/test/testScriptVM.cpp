@@ -0,0 +1,341 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "console/console.h"
+#include "console/stringStack.h"
+#include "console/compiler.h"
+#include "core/util/str.h"
+#include "core/stream/fileStream.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Script functions shared by the benchmarks below.
+
+static void defineScriptVMBenchmarks()
+{
+   Con::evaluate(
+      "function testVMAdd( %a, %b ) { return %a + %b; }\n"
+      "function testVMArith( %n )\n"
+      "{\n"
+      "   %sum = 0;\n"
+      "   for( %i = 0; %i < %n; %i ++ )\n"
+      "      %sum = testVMAdd( %sum, ( %i % 7 ) * 0.5 );\n"
+      "   return %sum;\n"
+      "}\n"
+      "function testVMFields( %n )\n"
+      "{\n"
+      "   %obj = new ScriptObject() { value = 0; };\n"
+      "   for( %i = 0; %i < %n; %i ++ )\n"
+      "      %obj.value = %obj.value + ( %i & 3 ) + %obj.getId() * 0;\n"
+      "   %result = %obj.value SPC %obj.class SPC %obj.internalName;\n"
+      "   %obj.delete();\n"
+      "   return %result;\n"
+      "}\n"
+      "function TestVMObject::step( %this, %x ) { return %x * 2 + 1; }\n"
+      "function testVMMethods( %n )\n"
+      "{\n"
+      "   %obj = new ScriptObject() { class = TestVMObject; };\n"
+      "   %sum = 0;\n"
+      "   for( %i = 0; %i < %n; %i ++ )\n"
+      "      %sum = ( %sum + %obj.step( %i & 15 ) ) % 100000;\n"
+      "   %obj.delete();\n"
+      "   return %sum;\n"
+      "}\n"
+      "function testVMMixed( %n )\n"
+      "{\n"
+      "   %obj = new ScriptObject() { class = TestVMObject; };\n"
+      "   %id = %obj.getId();\n"
+      "   %half = %n / 2;\n"
+      "   %result = strlen( %n * 1000 ) SPC %id.step( %n ) SPC testVMAdd( %half, %n ) SPC %half @ \"x\";\n"
+      "   %obj.delete();\n"
+      "   return %result;\n"
+      "}\n",
+      false, "testScriptVM.cs" );
+}
+
+struct ScriptVMBenchmark
+{
+   const char* name;
+   const char* script;
+};
+
+static const ScriptVMBenchmark sScriptVMBenchmarks[] =
+{
+   { "arithmetic", "testVMArith" },
+   { "fields", "testVMFields" },
+   { "methods", "testVMMethods" },
+};
+
+// Run a couple of numeric-heavy scripts with the typed value stack both
+// enabled and disabled, check that they agree, and report the timings.
+
+CreateUnitTest( TestScriptVMTypedStack, "Console/ScriptVM/TypedStack" )
+{
+   enum
+   {
+      DEFAULT_NUM_ITERATIONS = 100000,
+   };
+
+   void run()
+   {
+      const U32 numIterations = Con::getIntVariable( "$testScriptVM::numIterations", DEFAULT_NUM_ITERATIONS );
+      const bool oldTypedValues = StringStack::smTypedValues;
+
+      defineScriptVMBenchmarks();
+
+      Con::printf( "Script VM typed stack: %d iterations", numIterations );
+      for( U32 i = 0; i < sizeof( sScriptVMBenchmarks ) / sizeof( sScriptVMBenchmarks[ 0 ] ); ++ i )
+      {
+         const String call = String::ToString( "%s( %d );", sScriptVMBenchmarks[ i ].script, numIterations );
+
+         StringStack::smTypedValues = false;
+         U32 start = Platform::getRealMilliseconds();
+         const String stringResult = Con::evaluate( call.c_str() );
+         const U32 stringTime = Platform::getRealMilliseconds() - start;
+
+         StringStack::smTypedValues = true;
+         start = Platform::getRealMilliseconds();
+         const String typedResult = Con::evaluate( call.c_str() );
+         const U32 typedTime = Platform::getRealMilliseconds() - start;
+
+         TEST( stringResult == typedResult );
+
+         Con::printf( "   %-12s string %5dms, typed %5dms (%s)", sScriptVMBenchmarks[ i ].name, stringTime, typedTime, typedResult.c_str() );
+      }
+
+      // Numbers pushed without formatting them have to read the same in
+      // native functions, method lookups, script callees and concatenation.
+      StringStack::smTypedValues = false;
+      TEST( dStrcmp( Con::evaluate( "testVMMixed( 5 );" ), "4 11 7.5 2.5x" ) == 0 );
+      StringStack::smTypedValues = true;
+      TEST( dStrcmp( Con::evaluate( "testVMMixed( 5 );" ), "4 11 7.5 2.5x" ) == 0 );
+
+      StringStack::smTypedValues = oldTypedValues;
+   }
+};
+
+// Same scripts with the call and field site caches on and off.
+
+CreateUnitTest( TestScriptVMInlineCaches, "Console/ScriptVM/InlineCaches" )
+{
+   enum
+   {
+      DEFAULT_NUM_ITERATIONS = 100000,
+   };
+
+   void run()
+   {
+      const U32 numIterations = Con::getIntVariable( "$testScriptVM::numIterations", DEFAULT_NUM_ITERATIONS );
+      const bool oldUseInlineCaches = CodeBlock::smUseInlineCaches;
+
+      defineScriptVMBenchmarks();
+
+      Con::printf( "Script VM inline caches: %d iterations", numIterations );
+      for( U32 i = 0; i < sizeof( sScriptVMBenchmarks ) / sizeof( sScriptVMBenchmarks[ 0 ] ); ++ i )
+      {
+         const String call = String::ToString( "%s( %d );", sScriptVMBenchmarks[ i ].script, numIterations );
+
+         CodeBlock::smUseInlineCaches = false;
+         U32 start = Platform::getRealMilliseconds();
+         const String uncachedResult = Con::evaluate( call.c_str() );
+         const U32 uncachedTime = Platform::getRealMilliseconds() - start;
+
+         CodeBlock::smUseInlineCaches = true;
+         start = Platform::getRealMilliseconds();
+         const String cachedResult = Con::evaluate( call.c_str() );
+         const U32 cachedTime = Platform::getRealMilliseconds() - start;
+
+         TEST( uncachedResult == cachedResult );
+
+         Con::printf( "   %-12s uncached %5dms, cached %5dms", sScriptVMBenchmarks[ i ].name, uncachedTime, cachedTime );
+      }
+
+      // Redefining a method has to invalidate the call site caches.
+      Con::evaluate( "function TestVMObject::step( %this, %x ) { return 1; }", false, "testScriptVM.cs" );
+      TEST( dAtoi( Con::evaluate( "testVMMethods( 10 );" ) ) == 10 );
+
+      CodeBlock::smUseInlineCaches = oldUseInlineCaches;
+   }
+};
+
+// Loading compiled scripts compared to compiling them from source.  The
+// timings use the real scripts under $testScriptVM::scriptDir ("scripts" of
+// the running game by default) and fall back to a generated script if there
+// are none.
+
+CreateUnitTest( TestScriptVMCompiledScripts, "Console/ScriptVM/CompiledScripts" )
+{
+   enum
+   {
+      DEFAULT_NUM_FUNCTIONS = 500,
+      DEFAULT_NUM_LOADS = 10,
+   };
+
+   struct Script
+   {
+      StringTableEntry name;
+      String dsoName;
+      String source;
+   };
+
+   Vector< Script > mScripts;
+
+   void addScript( const char* name, const String& source )
+   {
+      Script script;
+      script.name = StringTable->insert( name );
+      script.dsoName = String::ToString( "testScriptVMCompiled%d.cs.dso", mScripts.size() );
+      script.source = source;
+      mScripts.push_back( script );
+   }
+
+   /// Add all the scripts found under @a dir.
+   void findScripts( const char* dir )
+   {
+      const Torque::Path path = Torque::Path::Join( Torque::FS::GetCwd(), '/', dir );
+      if( !Torque::FS::IsDirectory( path ) )
+         return;
+
+      Vector< String > files;
+      Torque::FS::FindByPattern( path, "*.cs", true, files );
+
+      for( U32 i = 0; i < files.size(); ++ i )
+      {
+         void* data = NULL;
+         U32 size = 0;
+         if( !Torque::FS::ReadFile( files[ i ], data, size, true ) )
+            continue;
+
+         addScript( files[ i ].c_str(), String( ( const char* ) data ) );
+         delete [] ( char* ) data;
+      }
+   }
+
+   /// Add a script with plenty of identifiers, strings and floats.
+   void generateScript( U32 numFunctions )
+   {
+      String script;
+      for( U32 i = 0; i < numFunctions; ++ i )
+         script += String::ToString(
+            "function testDSOFunc%d( %%a ) { $testDSO::value%d = %%a * %d.5 SPC \"str%d\"; return testDSOHelper( %%a, %d ); }\n",
+            i, i, i, i, i );
+      script += "function testDSOHelper( %a, %b ) { return %a + %b; }\n";
+
+      addScript( "testScriptVMCompiled.cs", script );
+   }
+
+   void run()
+   {
+      const U32 numLoads = Con::getIntVariable( "$testScriptVM::numLoads", DEFAULT_NUM_LOADS );
+      const char* scriptDir = Con::getVariable( "$testScriptVM::scriptDir" );
+
+      findScripts( scriptDir[ 0 ] ? scriptDir : "scripts" );
+      const bool realScripts = !mScripts.empty();
+      if( !realScripts )
+         generateScript( Con::getIntVariable( "$testScriptVM::numFunctions", DEFAULT_NUM_FUNCTIONS ) );
+
+      U32 numBytes = 0;
+      for( U32 i = 0; i < mScripts.size(); ++ i )
+         numBytes += mScripts[ i ].source.length();
+
+      // Compiling is what every exec pays without a DSO.
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 n = 0; n < numLoads; ++ n )
+         for( U32 i = 0; i < mScripts.size(); ++ i )
+         {
+            CodeBlock* code = new CodeBlock;
+            TEST( code->compile( mScripts[ i ].dsoName, mScripts[ i ].name, mScripts[ i ].source.c_str(), true ) );
+            delete code;
+         }
+      const U32 compileTime = Platform::getRealMilliseconds() - start;
+
+      // Load through the file, mapped where supported.
+      start = Platform::getRealMilliseconds();
+      for( U32 n = 0; n < numLoads; ++ n )
+         for( U32 i = 0; i < mScripts.size(); ++ i )
+         {
+            Torque::FS::FileRef file = Torque::FS::OpenFile( mScripts[ i ].dsoName, Torque::FS::File::Read );
+            TEST( file != NULL );
+            if( !file )
+               continue;
+
+            CodeBlock* code = new CodeBlock;
+            TEST( code->read( mScripts[ i ].name, file ) );
+            delete code;
+         }
+      const U32 mappedTime = Platform::getRealMilliseconds() - start;
+
+      // Load through a stream as a single read.
+      start = Platform::getRealMilliseconds();
+      for( U32 n = 0; n < numLoads; ++ n )
+         for( U32 i = 0; i < mScripts.size(); ++ i )
+         {
+            FileStream* stream = FileStream::createAndOpen( mScripts[ i ].dsoName, Torque::FS::File::Read );
+            TEST( stream != NULL );
+            if( !stream )
+               continue;
+
+            U32 version;
+            stream->read( &version );
+            TEST( version == Con::DSOVersion );
+
+            CodeBlock* code = new CodeBlock;
+            TEST( code->read( mScripts[ i ].name, *stream ) );
+            delete stream;
+            delete code;
+         }
+      const U32 streamTime = Platform::getRealMilliseconds() - start;
+
+      for( U32 i = 0; i < mScripts.size(); ++ i )
+         Torque::FS::Remove( mScripts[ i ].dsoName );
+
+      Con::printf( "Compiled scripts: %d %s scripts (%d bytes), %d loads",
+         mScripts.size(), realScripts ? "game" : "generated", numBytes, numLoads );
+      Con::printf( "   compile %5dms, mapped %5dms, streamed %5dms", compileTime, mappedTime, streamTime );
+
+      // Make sure loaded code still runs.
+      mScripts.clear();
+      generateScript( 10 );
+
+      CodeBlock* code = new CodeBlock;
+      TEST( code->compile( mScripts[ 0 ].dsoName, mScripts[ 0 ].name, mScripts[ 0 ].source.c_str(), true ) );
+      delete code;
+
+      Torque::FS::FileRef file = Torque::FS::OpenFile( mScripts[ 0 ].dsoName, Torque::FS::File::Read );
+      code = new CodeBlock;
+      TEST( file != NULL && code->read( mScripts[ 0 ].name, file ) );
+      code->exec( 0, mScripts[ 0 ].name, NULL, 0, NULL, false, NULL, 0 );
+
+      TEST( dAtoi( Con::evaluate( "testDSOFunc3( 4 );" ) ) == 7 );
+      TEST( dStrcmp( Con::getVariable( "$testDSO::value3" ), "14 str3" ) == 0 );
+
+      file = NULL;
+      Torque::FS::Remove( mScripts[ 0 ].dsoName );
+   }
+};
+
+#endif // !TORQUE_SHIPPING
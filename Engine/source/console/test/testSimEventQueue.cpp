@@ -0,0 +1,166 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "console/simBase.h"
+#include "console/console.h"
+#include "core/util/tVector.h"
+#include "math/mRandom.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Event that records the order in which it was processed.
+
+struct TestSimEventQueueEvent : public SimEvent
+{
+   Vector< U32 >* mLog;
+   U32 mValue;
+
+   TestSimEventQueueEvent( Vector< U32 >* log, U32 value )
+      : mLog( log ), mValue( value ) {}
+
+   virtual void process( SimObject* object )
+   {
+      if( mLog )
+         mLog->push_back( mValue );
+   }
+};
+
+// Verify dispatch order, cancellation and pending queries.
+
+CreateUnitTest( TestSimEventQueueOrdering, "Console/SimEventQueue/Ordering" )
+{
+   void run()
+   {
+      SimObject* object = new SimObject;
+      object->registerObject();
+
+      Vector< U32 > log;
+      const SimTime now = Sim::getCurrentTime();
+      const U32 startSize = Sim::getEventQueueSize();
+
+      // Post out of order, with several events sharing a time.
+      U32 ids[ 8 ];
+      ids[ 0 ] = Sim::postEvent( object, new TestSimEventQueueEvent( &log, 4 ), now + 30 );
+      ids[ 1 ] = Sim::postEvent( object, new TestSimEventQueueEvent( &log, 0 ), now + 10 );
+      ids[ 2 ] = Sim::postEvent( object, new TestSimEventQueueEvent( &log, 5 ), now + 30 );
+      ids[ 3 ] = Sim::postEvent( object, new TestSimEventQueueEvent( &log, 1 ), now + 10 );
+      ids[ 4 ] = Sim::postEvent( object, new TestSimEventQueueEvent( &log, 99 ), now + 20 );
+      ids[ 5 ] = Sim::postEvent( object, new TestSimEventQueueEvent( &log, 2 ), now + 20 );
+      ids[ 6 ] = Sim::postEvent( object, new TestSimEventQueueEvent( &log, 3 ), now + 20 );
+      ids[ 7 ] = Sim::postEvent( object, new TestSimEventQueueEvent( &log, 6 ), now + 40 );
+
+      TEST( Sim::getEventQueueSize() == startSize + 8 );
+      for( U32 i = 0; i < 8; ++ i )
+         TEST( Sim::isEventPending( ids[ i ] ) );
+
+      TEST( Sim::getEventTimeLeft( ids[ 7 ] ) == 40 );
+      TEST( Sim::getScheduleDuration( ids[ 0 ] ) == 30 );
+
+      Sim::cancelEvent( ids[ 4 ] );
+      TEST( !Sim::isEventPending( ids[ 4 ] ) );
+      TEST( Sim::getEventTimeLeft( ids[ 4 ] ) == 0 );
+
+      Sim::advanceToTime( now + 40 );
+
+      TEST( log.size() == 7 );
+      for( U32 i = 0; i < log.size(); ++ i )
+         TEST( log[ i ] == i );
+      for( U32 i = 0; i < 8; ++ i )
+         TEST( !Sim::isEventPending( ids[ i ] ) );
+
+      // Deleting the object must drop everything still queued for it.
+      U32 id = Sim::postEvent( object, new TestSimEventQueueEvent( &log, 7 ), now + 100 );
+      Sim::postEvent( object, new TestSimEventQueueEvent( &log, 8 ), now + 50 );
+      object->deleteObject();
+
+      TEST( !Sim::isEventPending( id ) );
+      TEST( Sim::getEventQueueSize() == startSize );
+   }
+};
+
+// Post/cancel throughput benchmark.
+
+CreateUnitTest( TestSimEventQueuePerformance, "Console/SimEventQueue/Performance" )
+{
+   enum { DEFAULT_NUM_EVENTS = 100000 };
+
+   void run()
+   {
+      const U32 numEvents = Con::getIntVariable( "$testSimEventQueue::numEvents", DEFAULT_NUM_EVENTS );
+
+      SimObject* object = new SimObject;
+      object->registerObject();
+
+      MRandomLCG rand( 1376312589 );
+      const SimTime now = Sim::getCurrentTime();
+
+      Vector< U32 > ids;
+      ids.setSize( numEvents );
+
+      // Post with random delays, as a busy server's schedule() calls would.
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < numEvents; ++ i )
+         ids[ i ] = Sim::postEvent( object, new TestSimEventQueueEvent( NULL, i ), now + 1 + rand.randI( 0, 60000 ) );
+      const U32 postTime = Platform::getRealMilliseconds() - start;
+
+      start = Platform::getRealMilliseconds();
+      U32 numPending = 0;
+      for( U32 i = 0; i < numEvents; ++ i )
+         if( Sim::isEventPending( ids[ i ] ) )
+            numPending ++;
+      const U32 pendingTime = Platform::getRealMilliseconds() - start;
+
+      TEST( numPending == numEvents );
+
+      // Cancel in random order.
+      for( U32 i = numEvents - 1; i > 0; -- i )
+      {
+         U32 j = rand.randI( 0, i );
+         U32 temp = ids[ i ];
+         ids[ i ] = ids[ j ];
+         ids[ j ] = temp;
+      }
+
+      start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < numEvents; ++ i )
+         Sim::cancelEvent( ids[ i ] );
+      const U32 cancelTime = Platform::getRealMilliseconds() - start;
+
+      for( U32 i = 0; i < numEvents; i += 997 )
+         TEST( !Sim::isEventPending( ids[ i ] ) );
+
+      object->deleteObject();
+
+      Con::printf( "SimEventQueue: %d events - post %dms (%.0f/s), pending %dms, cancel %dms (%.0f/s)",
+         numEvents,
+         postTime, F32( numEvents ) * 1000.f / F32( getMax( postTime, 1U ) ),
+         pendingTime,
+         cancelTime, F32( numEvents ) * 1000.f / F32( getMax( cancelTime, 1U ) ) );
+   }
+};
+
+#endif // !TORQUE_SHIPPING
@@ -169,6 +169,7 @@ public:
 
    void clearCompressionPoint();
    void setCompressionPoint(const Point3F& p);
+   const Point3F& getCompressionPoint() const { return mCompressPoint; }
 
    // Matching calls to these compression methods must, of course,
    // have matching scale values.
@@ -0,0 +1,247 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "core/stream/packetCoder.h"
+
+
+// The coder follows the binary range coder used by LZMA: a 32 bit range is
+// split according to the probability of the next bit, and the low end is kept
+// in 33 bits so that carries can be propagated into output that is held back
+// in a pending byte plus a run of 0xFF bytes.
+
+namespace {
+
+enum
+{
+   TopValue = 1 << 24,
+};
+
+static PacketCoder::Model gDefaultModel;
+
+inline U32 getBit(const U8 *data, U32 bit)
+{
+   return (data[bit >> 3] >> (bit & 0x7)) & 1;
+}
+
+inline void adapt(U16 &probability, U32 bit)
+{
+   if(bit)
+      probability -= probability >> PacketCoder::AdaptShift;
+   else
+      probability += (PacketCoder::ProbabilityOne - probability) >> PacketCoder::AdaptShift;
+}
+
+class RangeEncoder
+{
+   U64 mLow;
+   U32 mRange;
+   U8 mCache;
+   U32 mCacheSize;
+   bool mFirstByte;
+
+   U8 *mDst;
+   U32 mDstSize;
+   U32 mPos;
+
+   void writeByte(U8 value)
+   {
+      // the very first byte is always zero, so it is never stored
+      if(mFirstByte)
+      {
+         mFirstByte = false;
+         return;
+      }
+      if(mPos < mDstSize)
+         mDst[mPos] = value;
+      mPos++;
+   }
+
+   void shiftLow()
+   {
+      if(U32(mLow) < 0xFF000000 || (mLow >> 32) != 0)
+      {
+         U8 carry = U8(mLow >> 32);
+         U8 temp = mCache;
+         do
+         {
+            writeByte(temp + carry);
+            temp = 0xFF;
+         }
+         while(--mCacheSize != 0);
+         mCache = U8(mLow >> 24);
+      }
+      mCacheSize++;
+      mLow = (mLow & 0x00FFFFFF) << 8;
+   }
+
+public:
+
+   RangeEncoder(U8 *dst, U32 dstSize)
+      : mLow(0), mRange(0xFFFFFFFF), mCache(0), mCacheSize(1), mFirstByte(true),
+        mDst(dst), mDstSize(dstSize), mPos(0)
+   {
+   }
+
+   void encode(U16 &probability, U32 bit)
+   {
+      U32 bound = (mRange >> PacketCoder::ProbabilityBits) * probability;
+      if(bit)
+      {
+         mLow += bound;
+         mRange -= bound;
+      }
+      else
+         mRange = bound;
+      adapt(probability, bit);
+
+      while(mRange < TopValue)
+      {
+         mRange <<= 8;
+         shiftLow();
+      }
+   }
+
+   /// Flush the pending bytes and return the size, or 0 on overflow.
+   U32 finish()
+   {
+      for(U32 i = 0; i < 5; i++)
+         shiftLow();
+      return mPos <= mDstSize ? mPos : 0;
+   }
+
+   bool isFull() const { return mPos > mDstSize; }
+};
+
+class RangeDecoder
+{
+   U32 mRange;
+   U32 mCode;
+
+   const U8 *mSrc;
+   U32 mSrcSize;
+   U32 mPos;
+
+   U8 readByte()
+   {
+      // reading past the end yields zeros, like the flushed tail of the encoder
+      return mPos < mSrcSize ? mSrc[mPos++] : 0;
+   }
+
+public:
+
+   RangeDecoder(const U8 *src, U32 srcSize)
+      : mRange(0xFFFFFFFF), mCode(0), mSrc(src), mSrcSize(srcSize), mPos(0)
+   {
+      for(U32 i = 0; i < 4; i++)
+         mCode = (mCode << 8) | readByte();
+   }
+
+   U32 decode(U16 &probability)
+   {
+      U32 bound = (mRange >> PacketCoder::ProbabilityBits) * probability;
+      U32 bit;
+      if(mCode < bound)
+      {
+         mRange = bound;
+         bit = 0;
+      }
+      else
+      {
+         mCode -= bound;
+         mRange -= bound;
+         bit = 1;
+      }
+      adapt(probability, bit);
+
+      while(mRange < TopValue)
+      {
+         mRange <<= 8;
+         mCode = (mCode << 8) | readByte();
+      }
+      return bit;
+   }
+};
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+
+void PacketCoder::Model::reset()
+{
+   for(U32 i = 0; i < NumContexts; i++)
+      probabilities[i] = ProbabilityOne / 2;
+}
+
+void PacketCoder::Model::train(const U8 *data, U32 bitCount)
+{
+   U32 context = 0;
+   for(U32 i = 0; i < bitCount; i++)
+   {
+      U32 bit = getBit(data, i);
+      adapt(probabilities[context], bit);
+      context = ((context << 1) | bit) & (NumContexts - 1);
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+U32 PacketCoder::encode(const U8 *src, U32 bitCount, U8 *dst, U32 dstSize, const Model &model)
+{
+   Model state = model;
+   RangeEncoder encoder(dst, dstSize);
+
+   U32 context = 0;
+   for(U32 i = 0; i < bitCount && !encoder.isFull(); i++)
+   {
+      U32 bit = getBit(src, i);
+      encoder.encode(state.probabilities[context], bit);
+      context = ((context << 1) | bit) & (NumContexts - 1);
+   }
+   return encoder.finish();
+}
+
+void PacketCoder::decode(const U8 *src, U32 srcSize, U8 *dst, U32 bitCount, const Model &model)
+{
+   Model state = model;
+   RangeDecoder decoder(src, srcSize);
+
+   dMemset(dst, 0, (bitCount + 7) >> 3);
+
+   U32 context = 0;
+   for(U32 i = 0; i < bitCount; i++)
+   {
+      U32 bit = decoder.decode(state.probabilities[context]);
+      dst[i >> 3] |= bit << (i & 0x7);
+      context = ((context << 1) | bit) & (NumContexts - 1);
+   }
+}
+
+const PacketCoder::Model &PacketCoder::getDefaultModel()
+{
+   return gDefaultModel;
+}
+
+void PacketCoder::setDefaultModel(const Model &model)
+{
+   gDefaultModel = model;
+}
@@ -0,0 +1,87 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _PACKETCODER_H_
+#define _PACKETCODER_H_
+
+#ifndef _PLATFORM_H_
+#include "platform/platform.h"
+#endif
+
+
+/// Adaptive binary range coder for bit-packed network payloads.
+///
+/// Every bit is coded with a probability taken from a context made of the
+/// bits preceding it.  BitStream data is not byte aligned, so a bit context
+/// picks up the recurring flag runs, class ids and small integers that a byte
+/// oriented coder would miss.
+///
+/// Packets can be lost, so the probabilities are reset to a Model at the start
+/// of every packet and only adapt within it.  Both ends must use the same
+/// Model.  A Model can be trained on recorded traffic to start each packet
+/// from better estimates than the uniform default.
+class PacketCoder
+{
+public:
+
+   enum Constants
+   {
+      ContextBits = 12,                   ///< Number of preceding bits forming the context.
+      NumContexts = 1 << ContextBits,
+      ProbabilityBits = 11,               ///< Precision of the bit probabilities.
+      ProbabilityOne = 1 << ProbabilityBits,
+      AdaptShift = 4,                     ///< Adaptation rate; lower adapts faster.
+   };
+
+   /// Probability of a zero bit for every context.
+   struct Model
+   {
+      U16 probabilities[NumContexts];
+
+      Model() { reset(); }
+
+      /// Reset to even odds for all contexts.
+      void reset();
+
+      /// Adapt the model to @a bitCount bits of sample data.
+      void train(const U8 *data, U32 bitCount);
+   };
+
+   /// Code @a bitCount bits from @a src into @a dst.
+   ///
+   /// @return The number of bytes written, or 0 if the result did not fit
+   ///   into @a dstSize bytes.
+   static U32 encode(const U8 *src, U32 bitCount, U8 *dst, U32 dstSize, const Model &model);
+
+   /// Decode @a bitCount bits from the @a srcSize bytes at @a src into
+   /// @a dst, which must hold at least (bitCount + 7) / 8 bytes.
+   static void decode(const U8 *src, U32 srcSize, U8 *dst, U32 bitCount, const Model &model);
+
+   /// The model used for network packets.
+   static const Model &getDefaultModel();
+
+   /// Replace the model used for network packets.  Has to match on the
+   /// client and the server.
+   static void setDefaultModel(const Model &model);
+};
+
+#endif // _PACKETCODER_H_
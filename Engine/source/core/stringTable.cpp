@@ -22,6 +22,8 @@
 
 #include "core/strings/stringFunctions.h"
 #include "core/stringTable.h"
+#include "platform/platformIntrinsics.h"
+#include "console/engineAPI.h"
 
 _StringTable *_gStringTable = NULL;
 const U32 _StringTable::csm_stInitSize = 29;
@@ -33,67 +35,112 @@ const U32 _StringTable::csm_stInitSize = 29;
 //---------------------------------------------------------------
 
 namespace {
-bool sgInitTable = true;
-U8   sgHashTable[256];
 
-void initTolowerTable()
+/// Lower-case the ASCII letters in the four characters packed into @a w.
+///
+/// Each byte is tested for 'A'-'Z' on its low seven bits with the results
+/// landing in the byte's high bit, so no carries cross byte boundaries.
+/// Bytes with the high bit set are left alone, as dTolower() does.
+inline U32 foldCase(U32 w)
 {
-   for (U32 i = 0; i < 256; i++) {
-      U8 c = dTolower(i);
-      sgHashTable[i] = c * c;
+   const U32 low = w & 0x7F7F7F7F;
+   const U32 geA = low + 0x3F3F3F3F;   // 0x80 - 'A'
+   const U32 gtZ = low + 0x25252525;   // 0x80 - 'Z' - 1
+   const U32 upper = geA & ~gtZ & ~w & 0x80808080;
+   return w | (upper >> 2);
+}
+
+inline U32 loadWord(const char *str)
+{
+#if defined(TORQUE_CPU_X86)
+   return *((const U32 *) str);
+#else
+   U32 w;
+   dMemcpy(&w, str, sizeof(w));
+   return w;
+#endif
+}
+
+inline U32 mixWord(U32 h, U32 w)
+{
+   w *= 0xCC9E2D51;
+   w = (w << 15) | (w >> 17);
+   w *= 0x1B873593;
+   h ^= w;
+   h = (h << 13) | (h >> 19);
+   return h * 5 + 0xE6546B64;
+}
+
+U32 hashChars(const char *str, U32 len)
+{
+   U32 h = len;
+
+   for(; len >= 4; len -= 4, str += 4)
+      h = mixWord(h, foldCase(loadWord(str)));
+
+   if(len)
+   {
+      U32 w = 0;
+      for(U32 i = 0; i < len; i++)
+         w |= U32(U8(str[i])) << (i * 8);
+      h = mixWord(h, foldCase(w));
    }
 
-   sgInitTable = false;
+   // Finalize so that both the stripe (high bits) and the bucket (low
+   // bits) selection see a well distributed value.
+   h ^= h >> 16;
+   h *= 0x85EBCA6B;
+   h ^= h >> 13;
+   h *= 0xC2B2AE35;
+   h ^= h >> 16;
+   return h;
 }
 
 } // namespace {}
 
 U32 _StringTable::hashString(const char* str)
 {
-   if (sgInitTable)
-      initTolowerTable();
-
    if(!str) return -1;
 
-   U32 ret = 0;
-   char c;
-   while((c = *str++) != 0) {
-      ret <<= 1;
-      ret ^= sgHashTable[static_cast<U32>(c)];
-   }
-   return ret;
+   return hashChars(str, dStrlen(str));
 }
 
 U32 _StringTable::hashStringn(const char* str, S32 len)
 {
-   if (sgInitTable)
-      initTolowerTable();
+   // Stop at the terminator like hashString() so that lookupn() finds the
+   // entries that insert() created.
+   U32 n = 0;
+   while((len < 0 || n < len) && str[n])
+      n++;
 
-   U32 ret = 0;
-   char c;
-   while((c = *str++) != 0 && len--) {
-      ret <<= 1;
-      ret ^= sgHashTable[static_cast<U32>(c)];
-   }
-   return ret;
+   return hashChars(str, n);
 }
 
 //--------------------------------------
 _StringTable::_StringTable()
 {
-   buckets = (Node **) dMalloc(csm_stInitSize * sizeof(Node *));
-   for(U32 i = 0; i < csm_stInitSize; i++) {
-      buckets[i] = 0;
+   for(U32 i = 0; i < NumStripes; i++)
+   {
+      stripes[i].table = NULL;
+      stripes[i].itemCount = 0;
+      stripes[i].bytesAllocated = 0;
+      _resize(stripes[i], csm_stInitSize);
    }
-
-   numBuckets = csm_stInitSize;
-   itemCount = 0;
 }
 
 //--------------------------------------
 _StringTable::~_StringTable()
 {
-   dFree(buckets);
+   for(U32 i = 0; i < NumStripes; i++)
+   {
+      BucketArray *walk = stripes[i].table;
+      while(walk)
+      {
+         BucketArray *retired = walk->retired;
+         dFree(walk);
+         walk = retired;
+      }
+   }
 }
 
 
@@ -118,6 +165,69 @@ void _StringTable::destroy()
 }
 
 
+//--------------------------------------
+StringTableEntry _StringTable::_find(const BucketArray *table, U32 key, const char *val, bool caseSens)
+{
+   for(Node *walk = table->buckets[key % table->numBuckets]; walk; walk = walk->next)
+   {
+      if(walk->key != key)
+         continue;
+      if(caseSens && !dStrcmp(walk->val, val))
+         return walk->val;
+      else if(!caseSens && !dStricmp(walk->val, val))
+         return walk->val;
+   }
+   return NULL;
+}
+
+//--------------------------------------
+StringTableEntry _StringTable::_insert(const char *val, U32 key, bool caseSens)
+{
+   Stripe &stripe = _getStripe(key);
+
+   // Most strings are already in the table so look without the lock first.
+   StringTableEntry ret = _find(stripe.table, key, val, caseSens);
+   if(ret)
+      return ret;
+
+   MutexHandle handle;
+   handle.lock(&stripe.mutex, true);
+
+   // Look again now that nobody else can add it.  New strings go at the end
+   // of the chain so that case sens strings are always after their
+   // corresponding case insens strings.
+   BucketArray *table = stripe.table;
+   Node * volatile *walk = &table->buckets[key % table->numBuckets];
+   while(Node *temp = *walk)
+   {
+      if(temp->key == key)
+      {
+         if(caseSens && !dStrcmp(temp->val, val))
+            return temp->val;
+         else if(!caseSens && !dStricmp(temp->val, val))
+            return temp->val;
+      }
+      walk = &(temp->next);
+   }
+
+   const U32 len = dStrlen(val) + 1;
+   Node *node = (Node *) stripe.mempool.alloc(sizeof(Node));
+   node->next = NULL;
+   node->key = key;
+   node->val = (char *) stripe.mempool.alloc(len);
+   dMemcpy(node->val, val, len);
+   stripe.bytesAllocated += sizeof(Node) + len;
+
+   // Publish the fully constructed node to lock-free readers.
+   dCompareAndSwap(*const_cast<Node **>(walk), (Node *) NULL, node);
+   stripe.itemCount ++;
+
+   if(stripe.itemCount > 2 * table->numBuckets)
+      _resize(stripe, 4 * table->numBuckets - 1);
+
+   return node->val;
+}
+
 //--------------------------------------
 StringTableEntry _StringTable::insert(const char* _val, const bool caseSens)
 {
@@ -127,29 +237,7 @@ StringTableEntry _StringTable::insert(const char* _val, const bool caseSens)
       val = "";
    //-
 
-   Node **walk, *temp;
-   U32 key = hashString(val);
-   walk = &buckets[key % numBuckets];
-   while((temp = *walk) != NULL)   {
-      if(caseSens && !dStrcmp(temp->val, val))
-         return temp->val;
-      else if(!caseSens && !dStricmp(temp->val, val))
-         return temp->val;
-      walk = &(temp->next);
-   }
-   char *ret = 0;
-   if(!*walk) {
-      *walk = (Node *) mempool.alloc(sizeof(Node));
-      (*walk)->next = 0;
-      (*walk)->val = (char *) mempool.alloc(dStrlen(val) + 1);
-      dStrcpy((*walk)->val, val);
-      ret = (*walk)->val;
-      itemCount ++;
-   }
-   if(itemCount > 2 * numBuckets) {
-      resize(4 * numBuckets - 1);
-   }
-   return ret;
+   return _insert(val, hashString(val), caseSens);
 }
 
 //--------------------------------------
@@ -163,74 +251,175 @@ StringTableEntry _StringTable::insertn(const char* src, S32 len, const bool  cas
 }
 
 //--------------------------------------
-StringTableEntry _StringTable::lookup(const char* val, const bool  caseSens)
+void _StringTable::insertBatch(const char * const *strings, U32 count, StringTableEntry *outEntries, const bool caseSens)
 {
-   Node **walk, *temp;
-   U32 key = hashString(val);
-   walk = &buckets[key % numBuckets];
-   while((temp = *walk) != NULL)   {
-      if(caseSens && !dStrcmp(temp->val, val))
-            return temp->val;
-      else if(!caseSens && !dStricmp(temp->val, val))
-         return temp->val;
-      walk = &(temp->next);
+   // Hash everything up front and count how many strings each stripe may
+   // receive.
+   U32 *keys = new U32[count];
+   U32 stripeCounts[NumStripes];
+   dMemset(stripeCounts, 0, sizeof(stripeCounts));
+
+   for(U32 i = 0; i < count; i++)
+   {
+      keys[i] = hashString(strings[i] ? strings[i] : "");
+      stripeCounts[keys[i] >> (32 - NumStripeBits)] ++;
    }
-   return NULL;
+
+   // Grow each stripe once for the worst case where every string is new,
+   // using the same growth policy as insert() so it ends up the same shape.
+   for(U32 i = 0; i < NumStripes; i++)
+   {
+      if(!stripeCounts[i])
+         continue;
+
+      Stripe &stripe = stripes[i];
+      MutexHandle handle;
+      handle.lock(&stripe.mutex, true);
+
+      U32 newSize = stripe.table->numBuckets;
+      while(stripe.itemCount + stripeCounts[i] > 2 * newSize)
+         newSize = 4 * newSize - 1;
+      if(newSize != stripe.table->numBuckets)
+         _resize(stripe, newSize);
+   }
+
+   for(U32 i = 0; i < count; i++)
+      outEntries[i] = _insert(strings[i] ? strings[i] : "", keys[i], caseSens);
+
+   delete [] keys;
+}
+
+//--------------------------------------
+StringTableEntry _StringTable::lookup(const char* val, const bool  caseSens)
+{
+   // A miss is only ever a miss against the table as it was when we started,
+   // which is all a lookup racing with an insert can promise anyway.
+   const U32 key = hashString(val);
+   return _find(_getStripe(key).table, key, val, caseSens);
 }
 
 //--------------------------------------
 StringTableEntry _StringTable::lookupn(const char* val, S32 len, const bool  caseSens)
 {
-   Node **walk, *temp;
-   U32 key = hashStringn(val, len);
-   walk = &buckets[key % numBuckets];
-   while((temp = *walk) != NULL) {
-      if(caseSens && !dStrncmp(temp->val, val, len) && temp->val[len] == 0)
-         return temp->val;
-      else if(!caseSens && !dStrnicmp(temp->val, val, len) && temp->val[len] == 0)
-         return temp->val;
-      walk = &(temp->next);
+   const U32 key = hashStringn(val, len);
+   const BucketArray *table = _getStripe(key).table;
+   for(Node *walk = table->buckets[key % table->numBuckets]; walk; walk = walk->next)
+   {
+      if(walk->key != key)
+         continue;
+      if(caseSens && !dStrncmp(walk->val, val, len) && walk->val[len] == 0)
+         return walk->val;
+      else if(!caseSens && !dStrnicmp(walk->val, val, len) && walk->val[len] == 0)
+         return walk->val;
    }
    return NULL;
 }
 
 //--------------------------------------
 void _StringTable::resize(const U32 _newSize)
+{
+   // Spread the requested size over the stripes.
+   const U32 stripeSize = _newSize / NumStripes;
+
+   for(U32 i = 0; i < NumStripes; i++)
+   {
+      MutexHandle handle;
+      handle.lock(&stripes[i].mutex, true);
+      _resize(stripes[i], stripeSize);
+   }
+}
+
+//--------------------------------------
+void _StringTable::_resize(Stripe &stripe, const U32 _newSize)
 {
    /// avoid a possible 0 division
    const U32 newSize = _newSize ? _newSize : 1;
 
-   Node *head = NULL, *walk, *temp;
-   U32 i;
-   // reverse individual bucket lists
-   // we do this because new strings are added at the end of bucket
-   // lists so that case sens strings are always after their
-   // corresponding case insens strings
+   BucketArray *oldTable = stripe.table;
+   if(oldTable && oldTable->numBuckets == newSize)
+      return;
 
-   for(i = 0; i < numBuckets; i++) {
-      walk = buckets[i];
-      while(walk)
+   const U32 tableSize = sizeof(BucketArray) + (newSize - 1) * sizeof(Node *);
+   BucketArray *newTable = (BucketArray *) dMalloc(tableSize);
+   newTable->numBuckets = newSize;
+   newTable->retired = oldTable;
+   for(U32 i = 0; i < newSize; i++)
+      newTable->buckets[i] = NULL;
+   stripe.bytesAllocated += tableSize;
+
+   // The old chains may still be walked by lock-free readers so rather than
+   // relinking them the nodes are copied into the new array.  Walking each
+   // old chain front to back and appending keeps case sens strings after
+   // their corresponding case insens strings.
+   if(oldTable)
+   {
+      for(U32 i = 0; i < oldTable->numBuckets; i++)
       {
-         temp = walk->next;
-         walk->next = head;
-         head = walk;
-         walk = temp;
+         for(Node *walk = oldTable->buckets[i]; walk; walk = walk->next)
+         {
+            Node * volatile *tail = &newTable->buckets[walk->key % newSize];
+            while(*tail)
+               tail = &((*tail)->next);
+
+            Node *node = (Node *) stripe.mempool.alloc(sizeof(Node));
+            node->val = walk->val;
+            node->key = walk->key;
+            node->next = NULL;
+            *tail = node;
+            stripe.bytesAllocated += sizeof(Node);
+         }
       }
    }
-   buckets = (Node **) dRealloc(buckets, newSize * sizeof(Node));
-   for(i = 0; i < newSize; i++) {
-      buckets[i] = 0;
-   }
-   numBuckets = newSize;
-   walk = head;
-   while(walk) {
-      U32 key;
-      Node *temp = walk;
-
-      walk = walk->next;
-      key = hashString(temp->val);
-      temp->next = buckets[key % newSize];
-      buckets[key % newSize] = temp;
+
+   // Swap in the complete array.
+   dCompareAndSwap(*const_cast<BucketArray **>(&stripe.table), oldTable, newTable);
+}
+
+//--------------------------------------
+void _StringTable::getStats(Stats &stats)
+{
+   dMemset(&stats, 0, sizeof(stats));
+
+   for(U32 i = 0; i < NumStripes; i++)
+   {
+      Stripe &stripe = stripes[i];
+      MutexHandle handle;
+      handle.lock(&stripe.mutex, true);
+
+      const BucketArray *table = stripe.table;
+      stats.numEntries += stripe.itemCount;
+      stats.numBuckets += table->numBuckets;
+      stats.bytesAllocated += stripe.bytesAllocated;
+
+      for(U32 j = 0; j < table->numBuckets; j++)
+      {
+         U32 length = 0;
+         for(Node *walk = table->buckets[j]; walk; walk = walk->next)
+            length++;
+
+         if(length)
+            stats.numUsedBuckets++;
+         stats.maxChainLength = getMax(stats.maxChainLength, length);
+      }
    }
+
+   stats.loadFactor = stats.numBuckets ? F32(stats.numEntries) / F32(stats.numBuckets) : 0.0f;
+   stats.averageChainLength = stats.numUsedBuckets ? F32(stats.numEntries) / F32(stats.numUsedBuckets) : 0.0f;
 }
 
+//--------------------------------------
+DefineEngineFunction( dumpStringTableStats, void, (),,
+   "@brief Print occupancy information for the global string table to the console.\n\n"
+   "@ingroup Debugging\n"
+   "@internal")
+{
+   _StringTable::Stats stats;
+   StringTable->getStats(stats);
+
+   Con::printf("StringTable:");
+   Con::printf("   entries:        %d", stats.numEntries);
+   Con::printf("   buckets:        %d (%d used)", stats.numBuckets, stats.numUsedBuckets);
+   Con::printf("   load factor:    %.2f", stats.loadFactor);
+   Con::printf("   chain length:   %.2f average, %d max", stats.averageChainLength, stats.maxChainLength);
+   Con::printf("   bytes:          %d", stats.bytesAllocated);
+}
@@ -29,6 +29,9 @@
 #ifndef _DATACHUNKER_H_
 #include "core/dataChunker.h"
 #endif
+#ifndef _PLATFORM_THREADS_MUTEX_H_
+#include "platform/threads/mutex.h"
+#endif
 
 
 //--------------------------------------
@@ -73,6 +76,12 @@
 /// @note Be aware that the StringTable NEVER DEALLOCATES memory, so be careful when you
 ///       add strings to it. If you carelessly add many strings, you will end up wasting
 ///       space.
+///
+/// The table is safe to use from multiple threads.  It is split into stripes
+/// selected by the hash of a string, each with its own lock, bucket array and
+/// memory pool.  Chains are only ever appended to and a stripe is grown by
+/// building a new bucket array next to the old one, so lookups of strings that
+/// are already in the table never take a lock.
 class _StringTable
 {
 private:
@@ -83,16 +92,44 @@ private:
    struct Node
    {
       char *val;
-      Node *next;
+      U32 key;
+      Node * volatile next;
+   };
+
+   /// Bucket array of a stripe.  Arrays that have been replaced by a resize
+   /// are kept around until the table is destroyed since lock-free readers
+   /// may still be walking them.
+   struct BucketArray
+   {
+      U32 numBuckets;
+      BucketArray *retired;
+      Node * volatile buckets[1];
+   };
+
+   struct Stripe
+   {
+      Mutex mutex;
+      BucketArray * volatile table;
+      U32 itemCount;
+      U32 bytesAllocated;
+      DataChunker mempool;
+   };
+
+   enum
+   {
+      NumStripeBits = 4,
+      NumStripes = 1 << NumStripeBits,
    };
 
-   Node**      buckets;
-   U32         numBuckets;
-   U32         itemCount;
-   DataChunker mempool;
+   Stripe      stripes[NumStripes];
 
    StringTableEntry _EmptyString;
 
+   Stripe& _getStripe(U32 key) { return stripes[key >> (32 - NumStripeBits)]; }
+   static StringTableEntry _find(const BucketArray *table, U32 key, const char *val, bool caseSens);
+   StringTableEntry _insert(const char *val, U32 key, bool caseSens);
+   void _resize(Stripe &stripe, U32 newSize);
+
   protected:
    static const U32 csm_stInitSize;
 
@@ -127,6 +164,17 @@ private:
    /// @param  caseSens Determines whether case matters.
    StringTableEntry insertn(const char *string, S32 len, bool caseSens = false);
 
+   /// Insert a batch of strings at once, writing the resulting entries to
+   /// @a outEntries.  Each stripe of the table is grown at most once up front,
+   /// which avoids repeated rehashing when interning many strings, such as
+   /// when loading a compiled script.
+   ///
+   /// @param  strings     Array of @a count strings to insert.
+   /// @param  count       Number of strings.
+   /// @param  outEntries  Receives @a count entries, in the same order.
+   /// @param  caseSens    Determines whether case matters.
+   void insertBatch(const char * const *strings, U32 count, StringTableEntry *outEntries, bool caseSens = false);
+
    /// Get a pointer from the string table, NOT adding the string to the table
    /// if it was not already present.
    ///
@@ -150,7 +198,23 @@ private:
    /// @param newSize   Number of new items to allocate space for.
    void             resize(const U32 newSize);
 
-   /// Hash a string into a U32.
+   /// Occupancy information for the table.
+   struct Stats
+   {
+      U32 numEntries;         ///< Number of strings in the table.
+      U32 numBuckets;         ///< Total number of buckets over all stripes.
+      U32 numUsedBuckets;     ///< Number of buckets holding at least one string.
+      U32 maxChainLength;     ///< Length of the longest bucket chain.
+      U32 bytesAllocated;     ///< Memory used by strings, nodes and bucket arrays.
+      F32 loadFactor;         ///< Entries per bucket.
+      F32 averageChainLength; ///< Entries per used bucket.
+   };
+
+   /// Gather occupancy information for the table.
+   void getStats(Stats &stats);
+
+   /// Hash a string into a U32.  The hash is case-insensitive and folds
+   /// four characters at a time.
    static U32 hashString(const char* in_pString);
 
    /// Hash a string of given length into a U32.
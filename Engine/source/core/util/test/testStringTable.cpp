@@ -0,0 +1,161 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "console/console.h"
+#include "core/stringTable.h"
+#include "core/util/str.h"
+#include "core/util/tVector.h"
+#include "core/strings/stringFunctions.h"
+#include "platform/threads/thread.h"
+
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+CreateUnitTest( TestStringTable, "Util/StringTable" )
+{
+   void run()
+   {
+      // Hashing is case-insensitive, also across the word and tail paths.
+      TEST( _StringTable::hashString( "testStringTable" ) == _StringTable::hashString( "TESTSTRINGTABLE" ) );
+      TEST( _StringTable::hashString( "abc[]" ) != _StringTable::hashString( "ABC{}" ) );
+      TEST( _StringTable::hashStringn( "testStringTableXYZ", 15 ) == _StringTable::hashString( "teststringtable" ) );
+      TEST( _StringTable::hashStringn( "short", 100 ) == _StringTable::hashString( "short" ) );
+
+      StringTableEntry a = StringTable->insert( "testStringTableEntry" );
+      TEST( StringTable->insert( "TESTSTRINGTABLEENTRY" ) == a );
+      TEST( StringTable->lookup( "TestStringTableEntry" ) == a );
+      TEST( StringTable->lookupn( "testStringTableEntry and more", 20 ) == a );
+      TEST( StringTable->lookup( "testStringTableNotThere" ) == NULL );
+
+      // Case sensitive inserts get their own entry but still find the
+      // case insensitive one when it matches exactly.
+      StringTableEntry b = StringTable->insert( "TestStringTableEntry", true );
+      TEST( b != a );
+      TEST( dStrcmp( b, "TestStringTableEntry" ) == 0 );
+      TEST( StringTable->insert( "testStringTableEntry", true ) == a );
+      TEST( StringTable->insert( "TestStringTableEntry" ) == a );
+
+      const char* names[] = { "testStringTableBatch0", "TESTSTRINGTABLEBATCH0", "testStringTableBatch1", NULL };
+      StringTableEntry entries[ 4 ];
+      StringTable->insertBatch( names, 4, entries );
+      TEST( entries[ 0 ] == entries[ 1 ] );
+      TEST( entries[ 2 ] == StringTable->insert( "testStringTableBatch1" ) );
+      TEST( entries[ 3 ] == StringTable->EmptyString() );
+
+      _StringTable::Stats stats;
+      StringTable->getStats( stats );
+      TEST( stats.numEntries > 0 );
+      TEST( stats.numUsedBuckets <= stats.numBuckets );
+      TEST( stats.maxChainLength >= 1 );
+   }
+};
+
+// Many threads interning the same strings in different orders must all get
+// the same entries back.
+
+CreateUnitTest( TestStringTableConcurrent, "Util/StringTable/Concurrent" )
+{
+public:
+   typedef TestStringTableConcurrent TestType;
+
+   enum
+   {
+      DEFAULT_NUM_STRINGS = 20000,
+      DEFAULT_NUM_THREADS = 8,
+   };
+
+   Vector< String > mStrings;
+
+   struct InsertThread : public Thread
+   {
+      TestType* mTest;
+      U32 mIndex;
+      Vector< StringTableEntry > mEntries;
+
+      InsertThread( TestType* test, U32 index )
+         : Thread( 0, NULL, false ), mTest( test ), mIndex( index ) {}
+
+      virtual void run( void* arg )
+      {
+         const U32 numStrings = mTest->mStrings.size();
+         mEntries.setSize( numStrings );
+
+         // Walk the strings starting from a different place in each thread
+         // so that they race on inserting the same new strings.
+         for( U32 i = 0; i < numStrings; ++ i )
+         {
+            const U32 index = ( i + mIndex * 7919 ) % numStrings;
+            mEntries[ index ] = StringTable->insert( mTest->mStrings[ index ].c_str() );
+         }
+      }
+   };
+
+   void run()
+   {
+      const U32 numStrings = Con::getIntVariable( "$testStringTable::numStrings", DEFAULT_NUM_STRINGS );
+      const U32 numThreads = Con::getIntVariable( "$testStringTable::numThreads", DEFAULT_NUM_THREADS );
+
+      // Unique per run so every insert starts out as a miss.
+      const U32 seed = Platform::getRealMilliseconds();
+      mStrings.setSize( numStrings );
+      for( U32 i = 0; i < numStrings; ++ i )
+         mStrings[ i ] = String::ToString( "testStringTable_%d_%d", seed, i );
+
+      Vector< InsertThread* > threads;
+      for( U32 i = 0; i < numThreads; ++ i )
+         threads.push_back( new InsertThread( this, i ) );
+
+      const U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < numThreads; ++ i )
+         threads[ i ]->start();
+      for( U32 i = 0; i < numThreads; ++ i )
+         threads[ i ]->join();
+      const U32 time = Platform::getRealMilliseconds() - start;
+
+      for( U32 i = 0; i < numStrings; ++ i )
+      {
+         const StringTableEntry entry = threads[ 0 ]->mEntries[ i ];
+         TEST( entry != NULL && dStrcmp( entry, mStrings[ i ].c_str() ) == 0 );
+         for( U32 n = 1; n < numThreads; ++ n )
+            TEST( threads[ n ]->mEntries[ i ] == entry );
+      }
+
+      for( U32 i = 0; i < numThreads; ++ i )
+         delete threads[ i ];
+      mStrings.clear();
+
+      _StringTable::Stats stats;
+      StringTable->getStats( stats );
+
+      Con::printf( "StringTable: %d threads inserted %d strings in %dms", numThreads, numStrings, time );
+      Con::printf( "   %d entries, %d buckets, load %.2f, avg chain %.2f, max chain %d, %d bytes",
+         stats.numEntries, stats.numBuckets, stats.loadFactor, stats.averageChainLength,
+         stats.maxChainLength, stats.bytesAllocated );
+   }
+};
+
+#endif // !TORQUE_SHIPPING
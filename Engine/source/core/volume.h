@@ -180,6 +180,18 @@ public:
 
    virtual U32 read(void* dst, U32 size) = 0;
    virtual U32 write(const void* src, U32 size) = 0;
+
+   /// Map the entire contents of an open file into memory.
+   ///
+   /// The mapping is private copy-on-write: callers may modify the returned
+   /// memory but the changes are never written back to the file.  The mapping
+   /// does not need the file to stay open and is valid until unmap() is called
+   /// or the file object is destroyed.  File systems that do not support
+   /// mapping return NULL and callers should fall back to read().
+   virtual void* map() { return NULL; }
+
+   /// Release a mapping obtained through map().
+   virtual void unmap() {}
 };
 
 typedef WeakRefPtr<File> FilePtr;
@@ -22,6 +22,7 @@
 
 #include "platform/platformNet.h"
 #include "core/strings/stringFunctions.h"
+#include "core/util/tDictionary.h"
 
 #if defined (TORQUE_OS_WIN)
 #define TORQUE_USE_WINSOCK
@@ -80,6 +81,15 @@ typedef in_addr IN_ADDR;
 
 #define closesocket close
 
+// recvmmsg() and sendmmsg() move several datagrams per system call.
+#if defined( __GLIBC__ ) && ( __GLIBC__ > 2 || ( __GLIBC__ == 2 && __GLIBC_MINOR__ >= 14 ) )
+#define TORQUE_NET_MMSG
+#endif
+
+// epoll lets Net::process() visit only the polled sockets that are ready.
+#include <sys/epoll.h>
+#define TORQUE_NET_EPOLL
+
 #elif defined( TORQUE_OS_XENON )
 
 #include <Xtl.h>
@@ -137,6 +147,10 @@ static const char* strerror_wsa( S32 code )
 #include "console/console.h"
 #include "core/util/journal/process.h"
 #include "core/util/journal/journal.h"
+#include "core/module.h"
+#include "console/consoleTypes.h"
+#include "platform/threads/thread.h"
+#include "platform/platformIntrinsics.h"
 
 static Net::Error getLastError();
 static S32 defaultPort = 28000;
@@ -148,6 +162,21 @@ ConnectionAcceptedEvent Net::smConnectionAccept;
 ConnectionReceiveEvent  Net::smConnectionReceive;
 PacketReceiveEvent      Net::smPacketReceive;
 
+bool Net::smUseReceiveThread = false;
+bool Net::smBatchSends = false;
+
+AFTER_MODULE_INIT( Sim )
+{
+   Con::addVariable( "$pref::Net::ReceiveThread", TypeBool, &Net::smUseReceiveThread,
+      "@brief If true, UDP packets are received in batches on a separate thread.\n\n"
+      "The packets are queued and handed to the game on the main thread.  Takes effect "
+      "the next time the port is opened.\n\n"
+      "@ingroup Networking" );
+   Con::addVariable( "$pref::Net::BatchSends", TypeBool, &Net::smBatchSends,
+      "@brief If true, outgoing UDP packets are queued and sent in batches at the end of each frame.\n\n"
+      "@ingroup Networking" );
+}
+
 // local enum for socket states for polled sockets
 enum SocketState
 {
@@ -168,17 +197,96 @@ struct Socket
       state = InvalidState;
       remoteAddr[0] = 0;
       remotePort = -1;
+      pollEvents = 0;
    }
 
    NetSocket fd;
    S32 state;
    char remoteAddr[256];
    S32 remotePort;
+   U32 pollEvents;   ///< Events currently registered with epoll.
 };
 
 // list of polled sockets
 static Vector<Socket*> gPolledSockets( __FILE__, __LINE__ );
 
+#ifdef TORQUE_NET_EPOLL
+
+enum
+{
+   MaxReadyEvents = 256,
+};
+
+static S32 gEpollFd = -1;
+
+/// Maps a polled socket handle to its Socket so ready events can be
+/// dispatched without walking gPolledSockets.
+static HashTable< U32, Socket* > gPolledSocketMap;
+
+/// Sockets waiting for a DNS lookup; these have no readiness to wait on
+/// and are checked every frame.
+static Vector< NetSocket > gNameLookupSockets( __FILE__, __LINE__ );
+
+static Socket* findPolledSocket(NetSocket fd)
+{
+   HashTable< U32, Socket* >::Iterator iter = gPolledSocketMap.find(U32(fd));
+   return iter != gPolledSocketMap.end() ? iter->value : NULL;
+}
+
+/// Bring the epoll interest set in line with the socket's state.
+static void updatePolledSocket(Socket *sock)
+{
+   U32 events = 0;
+   switch (sock->state)
+   {
+   case Connected:
+   case Listening:
+      events = EPOLLIN;
+      break;
+   case ConnectionPending:
+      events = EPOLLOUT;
+      break;
+   }
+
+   bool lookup = (sock->state == NameLookupRequired);
+   S32 lookupIndex = -1;
+   for (S32 i = 0; i < gNameLookupSockets.size(); i++)
+   {
+      if (gNameLookupSockets[i] == sock->fd)
+      {
+         lookupIndex = i;
+         break;
+      }
+   }
+   if (lookup && lookupIndex == -1)
+      gNameLookupSockets.push_back(sock->fd);
+   else if (!lookup && lookupIndex != -1)
+      gNameLookupSockets.erase_fast(lookupIndex);
+
+   if (events == sock->pollEvents)
+      return;
+
+   epoll_event ev;
+   dMemset(&ev, 0, sizeof(ev));
+   ev.events = events;
+   ev.data.fd = sock->fd;
+
+   S32 op;
+   if (!sock->pollEvents)
+      op = EPOLL_CTL_ADD;
+   else if (!events)
+      op = EPOLL_CTL_DEL;
+   else
+      op = EPOLL_CTL_MOD;
+
+   if (epoll_ctl(gEpollFd, op, sock->fd, &ev) == -1)
+      Con::errorf("Net - epoll_ctl failed on socket %d: %s", sock->fd, strerror(errno));
+
+   sock->pollEvents = events;
+}
+
+#endif
+
 static Socket* addPolledSocket(NetSocket& fd, S32 state,
                                char* remoteAddr = NULL, S32 port = -1)
 {
@@ -190,6 +298,10 @@ static Socket* addPolledSocket(NetSocket& fd, S32 state,
    if (port != -1)
       sock->remotePort = port;
    gPolledSockets.push_back(sock);
+#ifdef TORQUE_NET_EPOLL
+   gPolledSocketMap.insertUnique(U32(fd), sock);
+   updatePolledSocket(sock);
+#endif
    return sock;
 }
 
@@ -244,7 +356,16 @@ bool Net::init()
 #endif
    initCount++;
 
+#ifdef TORQUE_NET_EPOLL
+   if (gEpollFd == -1)
+   {
+      gEpollFd = epoll_create(MaxConnections);
+      AssertISV(gEpollFd != -1, "Net::init - failed to create epoll instance!");
+   }
+#endif
+
    Process::notify(&Net::process, PROCESS_NET_ORDER);
+   Process::notify(&Net::flushSends, PROCESS_LAST_ORDER);
 
    return(true);
 }
@@ -252,6 +373,7 @@ bool Net::init()
 void Net::shutdown()
 {
    Process::remove(&Net::process);
+   Process::remove(&Net::flushSends);
 
    while (gPolledSockets.size() > 0)
       closeConnectTo(gPolledSockets[0]->fd);
@@ -259,6 +381,14 @@ void Net::shutdown()
    closePort();
    initCount--;
 
+#ifdef TORQUE_NET_EPOLL
+   if (!initCount && gEpollFd != -1)
+   {
+      ::close(gEpollFd);
+      gEpollFd = -1;
+   }
+#endif
+
 #if defined(TORQUE_USE_WINSOCK)
    if(!initCount)
    {
@@ -309,19 +439,9 @@ static void IPSocketToNetAddress(const struct sockaddr_in *sockAddr,  NetAddress
    address->type = NetAddress::IPAddress;
    address->port = htons(sockAddr->sin_port);
 #ifndef TORQUE_OS_XENON
-   char *tAddr;
-   tAddr = inet_ntoa(sockAddr->sin_addr);
-   //fprintf(stdout,"IPSocketToNetAddress(): %s\n",tAddr);fflush(NULL);
-   U8 nets[4];
-   nets[0] = atoi(strtok(tAddr, "."));
-   nets[1] = atoi(strtok(NULL, "."));
-   nets[2] = atoi(strtok(NULL, "."));
-   nets[3] = atoi(strtok(NULL, "."));
-   //fprintf(stdout,"0 = %d, 1 = %d, 2 = %d, 3 = %d\n", nets[0], nets[1],  nets[2], nets[3]);
-   address->netNum[0] = nets[0];
-   address->netNum[1] = nets[1];
-   address->netNum[2] = nets[2];
-   address->netNum[3] = nets[3];
+   // sin_addr is stored in network order, i.e. the bytes are already in
+   // dotted-quad order.
+   dMemcpy(address->netNum, &sockAddr->sin_addr, 4);
 #else
    address->netNum[0] = sockAddr->sin_addr.s_net;
    address->netNum[1] = sockAddr->sin_addr.s_host;
@@ -449,6 +569,13 @@ void Net::closeConnectTo(NetSocket sock)
    {
       if (gPolledSockets[i]->fd == sock)
       {
+#ifdef TORQUE_NET_EPOLL
+         // Closing the descriptor would drop it from the epoll set as well,
+         // but only if no other handle refers to it; be explicit.
+         gPolledSockets[i]->state = InvalidState;
+         updatePolledSocket(gPolledSockets[i]);
+         gPolledSocketMap.erase(U32(sock));
+#endif
          delete gPolledSockets[i];
          gPolledSockets.erase(i);
          break;
@@ -478,8 +605,7 @@ Net::Error Net::sendtoSocket(NetSocket socket, const U8 *buffer, S32  bufferSize
 
 bool Net::openPort(S32 port, bool doBind)
 {
-   if(udpSocket != InvalidSocket)
-      ::closesocket(udpSocket);
+   closePort();
 
    // we turn off VDP in non-release builds because VDP does not support broadcast packets
    // which are required for LAN queries (PC->Xbox connectivity).  The wire protocol still
@@ -512,7 +638,12 @@ bool Net::openPort(S32 port, bool doBind)
          error = setBlocking(udpSocket, false);
 
       if(error == NoError)
+      {
          Con::printf("UDP initialized on port %d", port);
+
+         if(smUseReceiveThread)
+            startReceiveThread();
+      }
       else
       {
          ::closesocket(udpSocket);
@@ -533,10 +664,19 @@ NetSocket Net::getPort()
 }
 
 
+// The first error hit by flushSends(), returned by the next Net::sendto().
+static Net::Error gSendError = Net::NoError;
+
 void Net::closePort()
 {
-   if(udpSocket != InvalidSocket)
-      ::closesocket(udpSocket);
+   if(udpSocket == InvalidSocket)
+      return;
+
+   flushSends();
+   stopReceiveThread();
+
+   ::closesocket(udpSocket);
+   udpSocket = InvalidSocket;
 }
 
 Net::Error Net::sendto(const NetAddress *address, const U8 *buffer, S32  bufferSize)
@@ -544,6 +684,17 @@ Net::Error Net::sendto(const NetAddress *address, const U8 *buffer, S32  bufferS
    if(Journal::IsPlaying())
       return NoError;
 
+   if(smBatchSends && udpSocket != InvalidSocket)
+   {
+      queueSend(address, buffer, bufferSize);
+
+      // Report a failure from the last flush of the queue, so errors
+      // are not lost even though the packets are sent later.
+      const Error error = gSendError;
+      gSendError = NoError;
+      return error;
+   }
+
    if(address->type == NetAddress::IPAddress)
    {
       sockaddr_in ipAddr;
@@ -566,226 +717,591 @@ Net::Error Net::sendto(const NetAddress *address, const U8 *buffer, S32  bufferS
    }
 }
 
-void Net::process()
+//-----------------------------------------------------------------------------
+// Batched UDP receive and send
+//-----------------------------------------------------------------------------
+
+namespace {
+
+enum
 {
-   sockaddr sa;
-   sa.sa_family = AF_UNSPEC;
-   NetAddress srcAddress;
-   RawData tmpBuffer;
-   tmpBuffer.alloc(MaxPacketDataSize);
+   /// Number of packets in the receive ring.  Must be a power of two.
+   ReceiveRingSize = 1024,
 
-   for(;;)
-   {
-      socklen_t addrLen = sizeof(sa);
-      S32 bytesRead = -1;
+   /// Maximum number of datagrams moved with a single system call.
+   MaxBatchSize = 64,
 
-      if(udpSocket != InvalidSocket)
-         bytesRead = recvfrom(udpSocket, (char *) tmpBuffer.data, MaxPacketDataSize, 0, &sa, &addrLen);
+   /// Number of queued sends at which the send queue is flushed right away.
+   MaxQueuedSends = 256,
 
-      if(bytesRead == -1)
-         break;
+   /// Time the receive thread waits for the socket to become readable before
+   /// checking whether it should stop.
+   ReceiveWaitMs = 50,
+};
 
-      if(sa.sa_family == AF_INET)
-         IPSocketToNetAddress((sockaddr_in *) &sa,  &srcAddress);
-      else
-         continue;
+/// A datagram as it came off the socket.
+struct UDPPacket
+{
+   sockaddr_in address;
+   U32 size;
+   U8 data[ Net::MaxPacketDataSize ];
+};
+
+/// Thread that receives datagrams from the UDP port into a ring of packets.
+///
+/// The ring has a single producer (this thread) and a single consumer (the
+/// main thread in Net::process()), so the read and write positions only
+/// ever get advanced by one side each.
+class UDPReceiveThread : public Thread
+{
+   public:
 
-      if(bytesRead <= 0)
+      typedef Thread Parent;
+
+      UDPReceiveThread( NetSocket socket )
+         : mSocket( socket ),
+           mWriteIndex( 0 ),
+           mReadIndex( 0 )
+      {
+         mPackets = new UDPPacket[ ReceiveRingSize ];
+      }
+
+      ~UDPReceiveThread()
+      {
+         delete [] mPackets;
+      }
+
+      virtual void run( void* arg );
+
+      /// Return the number of packets ready for the main thread and the
+      /// first of them.
+      U32 getReadable( U32& outIndex )
+      {
+         outIndex = mReadIndex;
+         return dAtomicRead( mWriteIndex ) - outIndex;
+      }
+
+      UDPPacket& getPacket( U32 index ) { return mPackets[ index & ( ReceiveRingSize - 1 ) ]; }
+
+      /// Hand @a count packets back to the receive thread.
+      void release( U32 count )
+      {
+         const U32 index = mReadIndex;
+         dCompareAndSwap( mReadIndex, index, index + count );
+      }
+
+   protected:
+
+      NetSocket mSocket;
+      UDPPacket* mPackets;
+
+      /// Position of the next packet the receive thread writes.
+      volatile U32 mWriteIndex;
+
+      /// Position of the next packet the main thread reads.
+      volatile U32 mReadIndex;
+
+      /// Receive up to @a count datagrams into the ring starting at @a index.
+      U32 _receive( U32 index, U32 count );
+};
+
+void UDPReceiveThread::run( void* arg )
+{
+   while( !checkForStop() )
+   {
+      fd_set readfds;
+      FD_ZERO( &readfds );
+      FD_SET( mSocket, &readfds );
+
+      timeval timeout;
+      timeout.tv_sec = 0;
+      timeout.tv_usec = ReceiveWaitMs * 1000;
+
+      if( select( mSocket + 1, &readfds, NULL, NULL, &timeout ) <= 0 )
          continue;
 
-      if(srcAddress.type == NetAddress::IPAddress &&
-         srcAddress.netNum[0] == 127 &&
-         srcAddress.netNum[1] == 0 &&
-         srcAddress.netNum[2] == 0 &&
-         srcAddress.netNum[3] == 1 &&
-         srcAddress.port == netPort)
+      const U32 index = mWriteIndex;
+      const U32 free = ReceiveRingSize - ( index - dAtomicRead( mReadIndex ) );
+      if( !free )
+      {
+         // The main thread is behind; leave the packets in the socket buffer.
+         Platform::sleep( 1 );
          continue;
+      }
 
-      tmpBuffer.size = bytesRead;
+      const U32 count = _receive( index, getMin( free, U32( MaxBatchSize ) ) );
+      if( count )
+         dCompareAndSwap( mWriteIndex, index, index + count );
+   }
+}
 
-      Net::smPacketReceive.trigger(srcAddress, tmpBuffer);
+U32 UDPReceiveThread::_receive( U32 index, U32 count )
+{
+#ifdef TORQUE_NET_MMSG
+
+   mmsghdr messages[ MaxBatchSize ];
+   iovec buffers[ MaxBatchSize ];
+
+   dMemset( messages, 0, sizeof( mmsghdr ) * count );
+   for( U32 i = 0; i < count; ++ i )
+   {
+      UDPPacket& packet = getPacket( index + i );
+
+      buffers[ i ].iov_base = packet.data;
+      buffers[ i ].iov_len = Net::MaxPacketDataSize;
+
+      messages[ i ].msg_hdr.msg_name = &packet.address;
+      messages[ i ].msg_hdr.msg_namelen = sizeof( packet.address );
+      messages[ i ].msg_hdr.msg_iov = &buffers[ i ];
+      messages[ i ].msg_hdr.msg_iovlen = 1;
    }
 
-   // process the polled sockets.  This blob of code performs functions
-   // similar to WinsockProc in winNet.cc
+   const S32 numReceived = recvmmsg( mSocket, messages, count, MSG_DONTWAIT, NULL );
+   if( numReceived <= 0 )
+      return 0;
 
-   if (gPolledSockets.size() == 0)
+   for( U32 i = 0; i < numReceived; ++ i )
+      getPacket( index + i ).size = messages[ i ].msg_len;
+
+   return numReceived;
+
+#else
+
+   U32 numReceived = 0;
+   while( numReceived < count )
+   {
+      UDPPacket& packet = getPacket( index + numReceived );
+
+      socklen_t addrLen = sizeof( packet.address );
+      const S32 bytesRead = recvfrom( mSocket, ( char* ) packet.data, Net::MaxPacketDataSize, 0,
+                                      ( sockaddr* ) &packet.address, &addrLen );
+      if( bytesRead == -1 )
+         break;
+
+      packet.size = bytesRead;
+      numReceived ++;
+   }
+
+   return numReceived;
+
+#endif
+}
+
+}
+
+static UDPReceiveThread* gReceiveThread;
+
+// The receive thread whose ring Net::process() is draining.  If a packet
+// handler closes the port, the thread is stopped but deleted only once
+// the drain has finished.
+static UDPReceiveThread* gDrainingThread;
+
+// Packets queued by Net::sendto() while batching sends.  The packets are
+// pooled and only the first gNumQueuedSends are in use.
+static Vector< UDPPacket* > gSendQueue( __FILE__, __LINE__ );
+static U32 gNumQueuedSends;
+
+void Net::startReceiveThread()
+{
+   if( gReceiveThread || udpSocket == InvalidSocket )
+      return;
+
+   gReceiveThread = new UDPReceiveThread( udpSocket );
+   gReceiveThread->start();
+}
+
+void Net::stopReceiveThread()
+{
+   if( !gReceiveThread )
+      return;
+
+   gReceiveThread->stop();
+   gReceiveThread->join();
+
+   if( gReceiveThread == gDrainingThread )
+      gReceiveThread = NULL;
+   else
+      SAFE_DELETE( gReceiveThread );
+}
+
+void Net::queueSend( const NetAddress* address, const U8* buffer, S32 bufferSize )
+{
+   if( gNumQueuedSends == gSendQueue.size() )
+      gSendQueue.push_back( new UDPPacket );
+
+   UDPPacket* packet = gSendQueue[ gNumQueuedSends ++ ];
+
+   netToIPSocketAddress( address, &packet->address );
+   packet->size = getMin( bufferSize, MaxPacketDataSize );
+   dMemcpy( packet->data, buffer, packet->size );
+
+   if( gNumQueuedSends >= MaxQueuedSends )
+      flushSends();
+}
+
+void Net::flushSends()
+{
+   if( !gNumQueuedSends )
       return;
 
+   if( udpSocket == InvalidSocket )
+   {
+      gNumQueuedSends = 0;
+      return;
+   }
+
+#ifdef TORQUE_NET_MMSG
+
+   mmsghdr messages[ MaxBatchSize ];
+   iovec buffers[ MaxBatchSize ];
+
+   for( U32 first = 0; first < gNumQueuedSends; )
+   {
+      const U32 count = getMin( gNumQueuedSends - first, U32( MaxBatchSize ) );
+
+      dMemset( messages, 0, sizeof( mmsghdr ) * count );
+      for( U32 i = 0; i < count; ++ i )
+      {
+         UDPPacket* packet = gSendQueue[ first + i ];
+
+         buffers[ i ].iov_base = packet->data;
+         buffers[ i ].iov_len = packet->size;
+
+         messages[ i ].msg_hdr.msg_name = &packet->address;
+         messages[ i ].msg_hdr.msg_namelen = sizeof( packet->address );
+         messages[ i ].msg_hdr.msg_iov = &buffers[ i ];
+         messages[ i ].msg_hdr.msg_iovlen = 1;
+      }
+
+      const S32 numSent = sendmmsg( udpSocket, messages, count, 0 );
+      if( numSent <= 0 )
+      {
+         // Drop the datagram that failed like a failed sendto() would.
+         if( gSendError == NoError )
+            gSendError = getLastError();
+         first ++;
+         continue;
+      }
+
+      first += numSent;
+   }
+
+#else
+
+   for( U32 i = 0; i < gNumQueuedSends; ++ i )
+   {
+      UDPPacket* packet = gSendQueue[ i ];
+      if( ::sendto( udpSocket, ( const char* ) packet->data, packet->size, 0,
+                    ( sockaddr* ) &packet->address, sizeof( packet->address ) ) == SOCKET_ERROR
+          && gSendError == NoError )
+         gSendError = getLastError();
+   }
+
+#endif
+
+   gNumQueuedSends = 0;
+}
+
+/// Check a polled socket for state changes and incoming data.
+/// Returns true if the socket should be closed.
+static bool processPolledSocket(Socket *currentSock)
+{
    S32 optval;
    socklen_t optlen = sizeof(S32);
    S32 bytesRead;
    Net::Error err;
    bool removeSock = false;
-   Socket *currentSock = NULL;
    sockaddr_in ipAddr;
    NetSocket incoming = InvalidSocket;
+   NetSocket listenSocket;
    char out_h_addr[1024];
    S32 out_h_length = 0;
    RawData readBuff;
 
-   for (S32 i = 0; i < gPolledSockets.size();
-      /* no increment, this is done at end of loop body */)
+   switch (currentSock->state)
    {
-      removeSock = false;
-      currentSock = gPolledSockets[i];
-      switch (currentSock->state)
-      {
-      case ::InvalidState:
-         Con::errorf("Error, InvalidState socket in polled sockets  list");
-         break;
-      case ::ConnectionPending:
-         // see if it is now connected
+   case ::InvalidState:
+      Con::errorf("Error, InvalidState socket in polled sockets  list");
+      break;
+   case ::ConnectionPending:
+      // see if it is now connected
 #ifdef TORQUE_OS_XENON
-         // WSASetLastError has no return value, however part of the SO_ERROR behavior
-         // is to clear the last error, so this needs to be done here.
-         if( ( optval = _getLastErrorAndClear() ) == -1 ) 
+      // WSASetLastError has no return value, however part of the SO_ERROR behavior
+      // is to clear the last error, so this needs to be done here.
+      if( ( optval = _getLastErrorAndClear() ) == -1 ) 
 #else
-         if (getsockopt(currentSock->fd, SOL_SOCKET, SO_ERROR,
-            (char*)&optval, &optlen) == -1)
+      if (getsockopt(currentSock->fd, SOL_SOCKET, SO_ERROR,
+         (char*)&optval, &optlen) == -1)
 #endif
+      {
+         Con::errorf("Error getting socket options: %s",  strerror(errno));
+
+         Net::smConnectionNotify.trigger(currentSock->fd, Net::ConnectFailed);
+         removeSock = true;
+      }
+      else
+      {
+         if (optval == EINPROGRESS)
+            // still connecting...
+            break;
+
+         if (optval == 0)
          {
-            Con::errorf("Error getting socket options: %s",  strerror(errno));
+            // poll for writable status to be sure we're connected.
+            bool ready = netSocketWaitForWritable(currentSock->fd,0);
+            if(!ready)
+               break;
 
+            currentSock->state = ::Connected;
+            Net::smConnectionNotify.trigger(currentSock->fd, Net::Connected);
+         }
+         else
+         {
+            // some kind of error
+            Con::errorf("Error connecting: %s", strerror(errno));
             Net::smConnectionNotify.trigger(currentSock->fd, Net::ConnectFailed);
             removeSock = true;
          }
+      }
+      break;
+   case ::Connected:
+
+      // try to get some data
+      bytesRead = 0;
+      readBuff.alloc(Net::MaxPacketDataSize);
+      err = Net::recv(currentSock->fd, (U8*)readBuff.data, Net::MaxPacketDataSize, &bytesRead);
+      if(err == Net::NoError)
+      {
+         if (bytesRead > 0)
+         {
+            // got some data, post it
+            readBuff.size = bytesRead;
+            Net::smConnectionReceive.trigger(currentSock->fd, readBuff);
+         }
          else
          {
-            if (optval == EINPROGRESS)
-               // still connecting...
-               break;
+            // ack! this shouldn't happen
+            if (bytesRead < 0)
+               Con::errorf("Unexpected error on socket: %s", strerror(errno));
 
-            if (optval == 0)
-            {
-               // poll for writable status to be sure we're connected.
-               bool ready = netSocketWaitForWritable(currentSock->fd,0);
-               if(!ready)
-                  break;
+            // zero bytes read means EOF
+            Net::smConnectionNotify.trigger(currentSock->fd, Net::Disconnected);
 
-               currentSock->state = ::Connected;
-               Net::smConnectionNotify.trigger(currentSock->fd, Net::Connected);
-            }
-            else
-            {
-               // some kind of error
-               Con::errorf("Error connecting: %s", strerror(errno));
-               Net::smConnectionNotify.trigger(currentSock->fd, Net::ConnectFailed);
-               removeSock = true;
-            }
+            removeSock = true;
          }
+      }
+      else if (err != Net::NoError && err != Net::WouldBlock)
+      {
+         Con::errorf("Error reading from socket: %s",  strerror(errno));
+         Net::smConnectionNotify.trigger(currentSock->fd, Net::Disconnected);
+         removeSock = true;
+      }
+      break;
+   case ::NameLookupRequired:
+      // is the lookup complete?
+      if (!gNetAsync.checkLookup(
+         currentSock->fd, out_h_addr, &out_h_length,
+         sizeof(out_h_addr)))
          break;
-      case ::Connected:
 
-         // try to get some data
-         bytesRead = 0;
-         readBuff.alloc(MaxPacketDataSize);
-         err = Net::recv(currentSock->fd, (U8*)readBuff.data, MaxPacketDataSize, &bytesRead);
-         if(err == Net::NoError)
+      U32 newState;
+      if (out_h_length == -1)
+      {
+         Con::errorf("DNS lookup failed: %s",  currentSock->remoteAddr);
+         newState = Net::DNSFailed;
+         removeSock = true;
+      }
+      else
+      {
+         // try to connect
+         dMemcpy(&(ipAddr.sin_addr.s_addr), out_h_addr,  out_h_length);
+         ipAddr.sin_port = currentSock->remotePort;
+         ipAddr.sin_family = AF_INET;
+         if(::connect(currentSock->fd, (struct sockaddr *)&ipAddr,
+            sizeof(ipAddr)) == -1)
          {
-            if (bytesRead > 0)
+            S32 errorCode;
+#if defined(TORQUE_USE_WINSOCK)
+            errorCode = WSAGetLastError();
+            if( errorCode == WSAEINPROGRESS || errorCode == WSAEWOULDBLOCK )
+#else
+            errorCode = errno;
+            if (errno == EINPROGRESS)
+#endif
             {
-               // got some data, post it
-               readBuff.size = bytesRead;
-               Net::smConnectionReceive.trigger(currentSock->fd, readBuff);
+               newState = Net::DNSResolved;
+               currentSock->state = ::ConnectionPending;
             }
             else
             {
-               // ack! this shouldn't happen
-               if (bytesRead < 0)
-                  Con::errorf("Unexpected error on socket: %s", strerror(errno));
-
-               // zero bytes read means EOF
-               Net::smConnectionNotify.trigger(currentSock->fd, Net::Disconnected);
-
+               const char* errorString;
+#if defined(TORQUE_USE_WINSOCK)
+               errorString = strerror_wsa( errorCode );
+#else
+               errorString = strerror( errorCode );
+#endif
+               Con::errorf("Error connecting to %s: %s (%i)",
+                  currentSock->remoteAddr,  errorString, errorCode);
+               newState = Net::ConnectFailed;
                removeSock = true;
             }
          }
-         else if (err != Net::NoError && err != Net::WouldBlock)
+         else
          {
-            Con::errorf("Error reading from socket: %s",  strerror(errno));
-            Net::smConnectionNotify.trigger(currentSock->fd, Net::Disconnected);
-            removeSock = true;
+            newState = Net::Connected;
+            currentSock->state = Net::Connected;
          }
-         break;
-      case ::NameLookupRequired:
-         // is the lookup complete?
-         if (!gNetAsync.checkLookup(
-            currentSock->fd, out_h_addr, &out_h_length,
-            sizeof(out_h_addr)))
+      }
+
+      Net::smConnectionNotify.trigger(currentSock->fd, newState);
+      break;
+   case ::Listening:
+      NetAddress incomingAddy;
+
+      // drain the backlog; the listen queue is short and readiness is
+      // only reported once per frame
+      listenSocket = currentSock->fd;
+      for (;;)
+      {
+         // the accept callback may close the listen socket, so don't
+         // touch currentSock in here
+         incoming = Net::accept(listenSocket, &incomingAddy);
+         if(incoming == InvalidSocket)
             break;
 
-         U32 newState;
-         if (out_h_length == -1)
-         {
-            Con::errorf("DNS lookup failed: %s",  currentSock->remoteAddr);
-            newState = Net::DNSFailed;
-            removeSock = true;
-         }
-         else
-         {
-            // try to connect
-            dMemcpy(&(ipAddr.sin_addr.s_addr), out_h_addr,  out_h_length);
-            ipAddr.sin_port = currentSock->remotePort;
-            ipAddr.sin_family = AF_INET;
-            if(::connect(currentSock->fd, (struct sockaddr *)&ipAddr,
-               sizeof(ipAddr)) == -1)
-            {
-               S32 errorCode;
-#if defined(TORQUE_USE_WINSOCK)
-               errorCode = WSAGetLastError();
-               if( errorCode == WSAEINPROGRESS || errorCode == WSAEWOULDBLOCK )
-#else
-               errorCode = errno;
-               if (errno == EINPROGRESS)
-#endif
-               {
-                  newState = Net::DNSResolved;
-                  currentSock->state = ::ConnectionPending;
-               }
-               else
-               {
-                  const char* errorString;
-#if defined(TORQUE_USE_WINSOCK)
-                  errorString = strerror_wsa( errorCode );
-#else
-                  errorString = strerror( errorCode );
-#endif
-                  Con::errorf("Error connecting to %s: %s (%i)",
-                     currentSock->remoteAddr,  errorString, errorCode);
-                  newState = Net::ConnectFailed;
-                  removeSock = true;
-               }
-            }
-            else
-            {
-               newState = Net::Connected;
-               currentSock->state = Net::Connected;
-            }
-         }
+         Net::setBlocking(incoming, false);
+         addPolledSocket(incoming, Connected);
+         Net::smConnectionAccept.trigger(listenSocket, incoming, incomingAddy);
+      }
+      break;
+   }
 
-         Net::smConnectionNotify.trigger(currentSock->fd, newState);
-         break;
-      case ::Listening:
-         NetAddress incomingAddy;
+   return removeSock;
+}
 
-         incoming = Net::accept(currentSock->fd, &incomingAddy);
-         if(incoming != InvalidSocket)
-         {
-            setBlocking(incoming, false);
-            addPolledSocket(incoming, Connected);
-            Net::smConnectionAccept.trigger(currentSock->fd, incoming, incomingAddy);
-         }
-         break;
+/// Hand a received datagram to Net::smPacketReceive unless it is one of our
+/// own broadcasts.
+static void triggerPacketReceive( const sockaddr* sa, RawData& data )
+{
+   if( sa->sa_family != AF_INET || !data.size )
+      return;
+
+   NetAddress srcAddress;
+   IPSocketToNetAddress( ( const sockaddr_in* ) sa, &srcAddress );
+
+   if(srcAddress.type == NetAddress::IPAddress &&
+      srcAddress.netNum[0] == 127 &&
+      srcAddress.netNum[1] == 0 &&
+      srcAddress.netNum[2] == 0 &&
+      srcAddress.netNum[3] == 1 &&
+      srcAddress.port == netPort)
+      return;
+
+   Net::smPacketReceive.trigger(srcAddress, data);
+}
+
+void Net::process()
+{
+   if(gReceiveThread)
+   {
+      // Drain the packets queued by the receive thread.  The packet data
+      // is passed on without copying it out of the ring.
+      // A handler may close the port, so stop as soon as the thread we
+      // are draining is no longer the active one.
+      UDPReceiveThread* thread = gReceiveThread;
+      gDrainingThread = thread;
+
+      U32 index;
+      const U32 count = thread->getReadable(index);
+      for(U32 i = 0; i < count && gReceiveThread == thread; i++)
+      {
+         UDPPacket& packet = thread->getPacket(index + i);
+         RawData data((S8*) packet.data, packet.size);
+         triggerPacketReceive((const sockaddr*) &packet.address, data);
       }
 
+      gDrainingThread = NULL;
+      if(gReceiveThread == thread)
+         thread->release(count);
+      else
+         delete thread;
+   }
+   else
+   {
+      sockaddr sa;
+      sa.sa_family = AF_UNSPEC;
+      RawData tmpBuffer;
+      tmpBuffer.alloc(MaxPacketDataSize);
+
+      for(;;)
+      {
+         socklen_t addrLen = sizeof(sa);
+         S32 bytesRead = -1;
+
+         if(udpSocket != InvalidSocket)
+            bytesRead = recvfrom(udpSocket, (char *) tmpBuffer.data, MaxPacketDataSize, 0, &sa, &addrLen);
+
+         if(bytesRead == -1)
+            break;
+
+         if(bytesRead <= 0)
+            continue;
+
+         tmpBuffer.size = bytesRead;
+         triggerPacketReceive(&sa, tmpBuffer);
+      }
+   }
+
+   // process the polled sockets.  This blob of code performs functions
+   // similar to WinsockProc in winNet.cc
+
+   if (gPolledSockets.size() == 0)
+      return;
+
+#ifdef TORQUE_NET_EPOLL
+
+   // Only visit the sockets epoll reports as ready plus the ones that
+   // are waiting for a DNS lookup, which has no socket readiness.
+   epoll_event events[MaxReadyEvents];
+   S32 numEvents = epoll_wait(gEpollFd, events, MaxReadyEvents, 0);
+
+   static Vector<NetSocket> readySockets(__FILE__, __LINE__);
+   readySockets.clear();
+   for (S32 i = 0; i < numEvents; i++)
+      readySockets.push_back(events[i].data.fd);
+   for (S32 i = 0; i < gNameLookupSockets.size(); i++)
+      readySockets.push_back(gNameLookupSockets[i]);
+
+   for (S32 i = 0; i < readySockets.size(); i++)
+   {
+      // The socket may have been closed by a callback in the meantime.
+      const NetSocket fd = readySockets[i];
+      Socket *currentSock = findPolledSocket(fd);
+      if (!currentSock)
+         continue;
+
+      if (processPolledSocket(currentSock))
+         closeConnectTo(fd);
+      else if ((currentSock = findPolledSocket(fd)) != NULL)
+         updatePolledSocket(currentSock);
+   }
+
+#else
+
+   for (S32 i = 0; i < gPolledSockets.size();
+      /* no increment, this is done at end of loop body */)
+   {
+      Socket *currentSock = gPolledSockets[i];
+
       // only increment index if we're not removing the connection,  since
       // the removal will shift the indices down by one
-      if (removeSock)
+      if (processPolledSocket(currentSock))
          closeConnectTo(currentSock->fd);
       else
          i++;
    }
+
+#endif
 }
 
 NetSocket Net::openSocket()
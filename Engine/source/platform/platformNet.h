@@ -100,6 +100,14 @@ struct Net
    static ConnectionReceiveEvent  smConnectionReceive;
    static PacketReceiveEvent      smPacketReceive;
 
+   /// If true, openPort() starts a thread that receives UDP packets in batches.
+   /// The packets are still handed to smPacketReceive on the main thread.
+   static bool smUseReceiveThread;
+
+   /// If true, sendto() queues UDP packets until flushSends() is called.
+   /// A send that fails during a flush is reported by the next sendto().
+   static bool smBatchSends;
+
    static bool init();
    static void shutdown();
 
@@ -114,6 +122,10 @@ struct Net
    static void closePort();
    static Error sendto(const NetAddress *address, const U8 *buffer, S32 bufferSize);
 
+   /// Send all UDP packets queued by sendto().  This is done automatically
+   /// at the end of every frame.
+   static void flushSends();
+
    // Reliable net functions (TCP)
    // all incoming messages come in on the Connected* events
    static NetSocket openListenPort(U16 port);
@@ -145,6 +157,10 @@ struct Net
 private:
    static void process();
 
+   static void startReceiveThread();
+   static void stopReceiveThread();
+   static void queueSend(const NetAddress *address, const U8 *buffer, S32 bufferSize);
+
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "platform/threads/jobSystem.h"
+#include "console/console.h"
+#include "core/util/tVector.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Jobs, counters and dependencies.
+
+CreateUnitTest( TestJobSystem, "Platform/JobSystem/Simple" )
+{
+   enum { DEFAULT_NUM_ITEMS = 4000 };
+
+   static Vector< U32 > results;
+   static volatile U32 sequence;
+
+   static void setResult( void* data )
+   {
+      const U32 index = ( U32 ) ( dsize_t ) data;
+      results[ index ] = index;
+   }
+
+   static void recordStage( void* data )
+   {
+      // Each stage records how many stages ran before it.
+      U32* slot = ( U32* ) data;
+      U32 order;
+      do
+         order = sequence;
+      while( !dCompareAndSwap( sequence, order, order + 1 ) );
+      *slot = order;
+   }
+
+   static void spawnChildren( void* data )
+   {
+      // Jobs may submit and wait on jobs of their own.
+      JobSystem::Counter counter;
+      const U32 base = ( U32 ) ( dsize_t ) data;
+      for( U32 i = 0; i < 10; ++ i )
+         JobSystem::GLOBAL().run( setResult, ( void* ) ( dsize_t ) ( base + i ), &counter );
+      JobSystem::GLOBAL().wait( counter );
+   }
+
+   void run()
+   {
+      const U32 numItems = Con::getIntVariable( "$testJobSystem::numValues", DEFAULT_NUM_ITEMS );
+      JobSystem& jobs = JobSystem::GLOBAL();
+
+      results.setSize( numItems );
+      for( U32 i = 0; i < numItems; ++ i )
+         results[ i ] = U32( -1 );
+
+      JobSystem::Counter counter;
+      for( U32 i = 0; i < numItems; ++ i )
+         jobs.run( setResult, ( void* ) ( dsize_t ) i, &counter );
+      jobs.wait( counter );
+
+      TEST( counter.isDone() );
+      for( U32 i = 0; i < numItems; ++ i )
+         test( results[ i ] == i, "result mismatch" );
+
+      // Nested submission and waiting.
+      for( U32 i = 0; i < numItems; ++ i )
+         results[ i ] = U32( -1 );
+      for( U32 i = 0; i + 10 <= numItems; i += 10 )
+         jobs.run( spawnChildren, ( void* ) ( dsize_t ) i, &counter );
+      jobs.wait( counter );
+      for( U32 i = 0; i + 10 <= numItems; ++ i )
+         test( results[ i ] == i, "nested result mismatch" );
+
+      // A chain of three stages; each one only starts when the previous
+      // one has finished.
+      U32 stages[ 3 ];
+      JobSystem::Counter first, second, third;
+      sequence = 0;
+      jobs.runAfter( second, recordStage, &stages[ 2 ], &third );
+      jobs.runAfter( first, recordStage, &stages[ 1 ], &second );
+      jobs.run( recordStage, &stages[ 0 ], &first );
+      jobs.wait( third );
+
+      TEST( second.isDone() && first.isDone() );
+      TEST( stages[ 0 ] == 0 );
+      TEST( stages[ 1 ] == 1 );
+      TEST( stages[ 2 ] == 2 );
+
+      results.clear();
+   }
+};
+
+Vector< U32 > TestJobSystem::results( __FILE__, __LINE__ );
+volatile U32 TestJobSystem::sequence;
+
+// parallelFor covering every index exactly once.
+
+CreateUnitTest( TestJobSystemParallelFor, "Platform/JobSystem/ParallelFor" )
+{
+   enum { DEFAULT_NUM_ITEMS = 100000 };
+
+   static void increment( void* data, U32 begin, U32 end )
+   {
+      U32* values = ( U32* ) data;
+      for( U32 i = begin; i < end; ++ i )
+         values[ i ] ++;
+   }
+
+   void run()
+   {
+      const U32 numItems = Con::getIntVariable( "$testJobSystem::numValues", DEFAULT_NUM_ITEMS );
+
+      Vector< U32 > values;
+      values.setSize( numItems );
+      dMemset( values.address(), 0, numItems * sizeof( U32 ) );
+
+      JobSystem::GLOBAL().parallelFor( numItems, increment, values.address() );
+      JobSystem::GLOBAL().parallelFor( numItems, increment, values.address(), 7 );
+      JobSystem::GLOBAL().parallelFor( 1, increment, values.address() );
+
+      bool allTwo = true;
+      for( U32 i = 1; i < numItems; ++ i )
+         allTwo &= ( values[ i ] == 2 );
+      TEST( allTwo );
+      TEST( values[ 0 ] == 3 );
+   }
+};
+
+#endif // !TORQUE_SHIPPING
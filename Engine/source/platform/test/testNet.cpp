@@ -23,6 +23,8 @@
 #include "platform/platformNet.h"
 #include "unit/test.h"
 #include "core/util/journal/process.h"
+#include "console/console.h"
+#include "core/strings/stringFunctions.h"
 
 using namespace UnitTesting;
 
@@ -197,4 +199,353 @@ CreateUnitTest( TestTCPRequestJournal, "Platform/Net/JournalTCPRequest")
       test(bytesRead == mDataRecved, "Didn't get same data back from journal playback.");
 
    }
-};
\ No newline at end of file
+};
+#if defined( TORQUE_OS_LINUX ) || defined( TORQUE_OS_MAC )
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+// Floods the UDP port over loopback from a plain socket and back, with and
+// without the receive thread and batched sends, and reports packets/sec.
+
+CreateUnitTest( TestUDPBatching, "Platform/Net/UDPBatching" )
+{
+   enum
+   {
+      DEFAULT_NUM_PACKETS = 50000,
+      DEFAULT_PORT = 28123,
+      PACKET_SIZE = 200,
+      BURST_SIZE = 64,
+      TIMEOUT_MS = 5000,
+      IDLE_TIMEOUT_MS = 200,  ///< Give up on packets dropped by the kernel after this long.
+   };
+
+   U32 mNumReceived;
+
+   void handlePacket( NetAddress address, RawData data )
+   {
+      mNumReceived ++;
+   }
+
+   /// Open a non-blocking UDP socket bound to an ephemeral loopback port.
+   S32 openPeer( sockaddr_in& outAddress )
+   {
+      S32 peer = socket( AF_INET, SOCK_DGRAM, 0 );
+      if( peer == -1 )
+         return -1;
+
+      dMemset( &outAddress, 0, sizeof( outAddress ) );
+      outAddress.sin_family = AF_INET;
+      outAddress.sin_addr.s_addr = inet_addr( "127.0.0.1" );
+      outAddress.sin_port = 0;
+
+      socklen_t addressLength = sizeof( outAddress );
+      if( ::bind( peer, ( sockaddr* ) &outAddress, sizeof( outAddress ) ) == -1 ||
+          getsockname( peer, ( sockaddr* ) &outAddress, &addressLength ) == -1 )
+      {
+         close( peer );
+         return -1;
+      }
+
+      fcntl( peer, F_SETFL, O_NONBLOCK );
+      return peer;
+   }
+
+   /// Send packets from @a peer to the UDP port and count how many
+   /// make it through Net::smPacketReceive.
+   F32 measureReceive( bool useThread, S32 peer, U16 port, U32 numPackets )
+   {
+      Net::smUseReceiveThread = useThread;
+      if( !Net::openPort( port ) )
+      {
+         test( false, "Failed to open the UDP port" );
+         return 0.0f;
+      }
+
+      sockaddr_in target;
+      dMemset( &target, 0, sizeof( target ) );
+      target.sin_family = AF_INET;
+      target.sin_addr.s_addr = inet_addr( "127.0.0.1" );
+      target.sin_port = htons( port );
+
+      // Protocol packets from unknown addresses are ignored by the game.
+      U8 buffer[ PACKET_SIZE ];
+      dMemset( buffer, 0, sizeof( buffer ) );
+      buffer[ 0 ] = 0x01;
+
+      mNumReceived = 0;
+      Net::smPacketReceive.notify( this, &TestUDPBatching::handlePacket );
+
+      const U32 start = Platform::getRealMilliseconds();
+      U32 lastProgress = start;
+      U32 numSent = 0;
+      while( mNumReceived < numSent || numSent < numPackets )
+      {
+         const U32 numReceived = mNumReceived;
+
+         for( U32 i = 0; i < BURST_SIZE && numSent < numPackets; ++ i, ++ numSent )
+            if( ::sendto( peer, buffer, sizeof( buffer ), 0, ( sockaddr* ) &target, sizeof( target ) ) == -1 )
+               break;
+
+         if( !Process::processEvents() )
+            break;
+
+         const U32 now = Platform::getRealMilliseconds();
+         if( mNumReceived != numReceived )
+            lastProgress = now;
+         if( now - start > TIMEOUT_MS || ( numSent == numPackets && now - lastProgress > IDLE_TIMEOUT_MS ) )
+            break;
+      }
+      const U32 time = getMax( lastProgress - start, U32( 1 ) );
+
+      Net::smPacketReceive.remove( this, &TestUDPBatching::handlePacket );
+      Net::closePort();
+
+      test( mNumReceived > 0, "No packets received" );
+      return F32( mNumReceived ) * 1000.0f / F32( time );
+   }
+
+   /// Send packets from the UDP port to @a peer.
+   F32 measureSend( bool batch, S32 peer, const sockaddr_in& peerAddress, U16 port, U32 numPackets )
+   {
+      Net::smUseReceiveThread = false;
+      Net::smBatchSends = batch;
+      if( !Net::openPort( port ) )
+      {
+         test( false, "Failed to open the UDP port" );
+         return 0.0f;
+      }
+
+      NetAddress address;
+      address.type = NetAddress::IPAddress;
+      dMemcpy( address.netNum, &peerAddress.sin_addr, 4 );
+      address.port = ntohs( peerAddress.sin_port );
+
+      U8 buffer[ PACKET_SIZE ];
+      dMemset( buffer, 0, sizeof( buffer ) );
+
+      U32 numReceived = 0;
+      U32 numSent = 0;
+      const U32 start = Platform::getRealMilliseconds();
+      U32 lastProgress = start;
+      while( numReceived < numSent || numSent < numPackets )
+      {
+         for( U32 i = 0; i < BURST_SIZE && numSent < numPackets; ++ i, ++ numSent )
+            Net::sendto( &address, buffer, sizeof( buffer ) );
+         Net::flushSends();
+
+         const U32 now = Platform::getRealMilliseconds();
+
+         U8 receiveBuffer[ Net::MaxPacketDataSize ];
+         while( recv( peer, receiveBuffer, sizeof( receiveBuffer ), 0 ) > 0 )
+         {
+            numReceived ++;
+            lastProgress = now;
+         }
+
+         if( now - start > TIMEOUT_MS || ( numSent == numPackets && now - lastProgress > IDLE_TIMEOUT_MS ) )
+            break;
+      }
+      const U32 time = getMax( lastProgress - start, U32( 1 ) );
+
+      Net::closePort();
+
+      test( numReceived > 0, "No packets received" );
+      return F32( numReceived ) * 1000.0f / F32( time );
+   }
+
+   void run()
+   {
+      if( Net::getPort() != InvalidSocket )
+      {
+         UnitPrint( "Skipping UDP batching test; the UDP port is in use.\n" );
+         return;
+      }
+
+      const U32 numPackets = Con::getIntVariable( "$testUDPBatching::numPackets", DEFAULT_NUM_PACKETS );
+      const U16 port = Con::getIntVariable( "$testUDPBatching::port", DEFAULT_PORT );
+
+      sockaddr_in peerAddress;
+      const S32 peer = openPeer( peerAddress );
+      if( peer == -1 )
+      {
+         test( false, "Failed to open the peer socket" );
+         return;
+      }
+
+      const bool oldUseReceiveThread = Net::smUseReceiveThread;
+      const bool oldBatchSends = Net::smBatchSends;
+
+      const F32 receiveDirect = measureReceive( false, peer, port, numPackets );
+      const F32 receiveThreaded = measureReceive( true, peer, port, numPackets );
+      const F32 sendDirect = measureSend( false, peer, peerAddress, port, numPackets );
+      const F32 sendBatched = measureSend( true, peer, peerAddress, port, numPackets );
+
+      Net::smUseReceiveThread = oldUseReceiveThread;
+      Net::smBatchSends = oldBatchSends;
+
+      close( peer );
+
+      Con::printf( "UDP loopback with %i packets of %i bytes (packets/sec):", numPackets, PACKET_SIZE );
+      Con::printf( "   receive: %.0f direct, %.0f threaded", receiveDirect, receiveThreaded );
+      Con::printf( "   send:    %.0f direct, %.0f batched", sendDirect, sendBatched );
+   }
+};
+
+// Opens a local echo server and many idle TCP connections to it, then
+// reports what the idle connections cost per frame and the echo round trip
+// time for one active connection among them.
+
+CreateUnitTest( TestTCPPolling, "Platform/Net/TCPPolling" )
+{
+   enum
+   {
+      DEFAULT_NUM_CONNECTIONS = 1000,
+      DEFAULT_NUM_FRAMES = 1000,
+      DEFAULT_PORT = 28124,
+      CONNECTS_PER_FRAME = 4,    ///< Stay within the listen backlog.
+      TIMEOUT_MS = 10000,
+   };
+
+   NetSocket mListenSocket;
+   Vector< NetSocket > mServerSockets;
+   U32 mNumConnected;
+   U32 mNumFailed;
+   U32 mNumEchoed;
+
+   void handleAccept( NetSocket listenSocket, NetSocket incoming, NetAddress address )
+   {
+      if( listenSocket == mListenSocket )
+         mServerSockets.push_back( incoming );
+   }
+
+   void handleNotify( NetSocket sock, U32 state )
+   {
+      if( state == Net::Connected )
+         mNumConnected ++;
+      else if( state == Net::ConnectFailed || state == Net::DNSFailed || state == Net::Disconnected )
+         mNumFailed ++;
+   }
+
+   void handleReceive( NetSocket sock, RawData data )
+   {
+      for( U32 i = 0; i < mServerSockets.size(); ++ i )
+         if( mServerSockets[ i ] == sock )
+         {
+            Net::sendtoSocket( sock, ( const U8* ) data.data, data.size );
+            return;
+         }
+
+      mNumEchoed += data.size;
+   }
+
+   bool waitFor( U32& counter, U32 target )
+   {
+      const U32 start = Platform::getRealMilliseconds();
+      while( counter < target && mNumFailed == 0 )
+      {
+         if( !Process::processEvents() || Platform::getRealMilliseconds() - start > TIMEOUT_MS )
+            return false;
+      }
+      return counter >= target;
+   }
+
+   void run()
+   {
+      U32 numConnections = Con::getIntVariable( "$testTCPPolling::numConnections", DEFAULT_NUM_CONNECTIONS );
+      const U32 numFrames = Con::getIntVariable( "$testTCPPolling::numFrames", DEFAULT_NUM_FRAMES );
+      const U16 port = Con::getIntVariable( "$testTCPPolling::port", DEFAULT_PORT );
+
+      // Both ends of every connection live in this process.
+      rlimit limit;
+      if( getrlimit( RLIMIT_NOFILE, &limit ) == 0 && limit.rlim_cur != RLIM_INFINITY )
+      {
+         const U32 maxConnections = limit.rlim_cur > 128 ? U32( limit.rlim_cur - 128 ) / 2 : 0;
+         if( numConnections > maxConnections )
+         {
+            Con::warnf( "TCPPolling: file descriptor limit allows only %i connections", maxConnections );
+            numConnections = maxConnections;
+         }
+      }
+
+      mListenSocket = Net::openListenPort( port );
+      if( mListenSocket == InvalidSocket )
+      {
+         test( false, "Failed to open the listen port" );
+         return;
+      }
+
+      mNumConnected = 0;
+      mNumFailed = 0;
+      mNumEchoed = 0;
+
+      Net::smConnectionAccept.notify( this, &TestTCPPolling::handleAccept );
+      Net::smConnectionNotify.notify( this, &TestTCPPolling::handleNotify );
+      Net::smConnectionReceive.notify( this, &TestTCPPolling::handleReceive );
+
+      char address[ 64 ];
+      dSprintf( address, sizeof( address ), "ip:127.0.0.1:%i", port );
+
+      Vector< NetSocket > clientSockets;
+      for( U32 i = 0; i < numConnections; ++ i )
+      {
+         const NetSocket sock = Net::openConnectTo( address );
+         if( sock == InvalidSocket )
+            break;
+         clientSockets.push_back( sock );
+
+         if( ( i + 1 ) % CONNECTS_PER_FRAME == 0 )
+            Process::processEvents();
+      }
+
+      U32 numAccepted = mServerSockets.size();
+      bool connected = waitFor( mNumConnected, clientSockets.size() );
+      while( connected && numAccepted < clientSockets.size() && Process::processEvents() )
+         numAccepted = mServerSockets.size();
+      test( connected && clientSockets.size() == numConnections, "Failed to open all connections" );
+
+      if( connected )
+      {
+         // Everything is idle; this is the per-frame cost of polling.
+         U32 start = Platform::getRealMilliseconds();
+         for( U32 i = 0; i < numFrames; ++ i )
+            Process::processEvents();
+         const F32 idleTime = F32( Platform::getRealMilliseconds() - start ) / F32( numFrames );
+
+         // Bounce a message off the echo server with everything else idle.
+         const U8 message[] = "ping";
+         start = Platform::getRealMilliseconds();
+         U32 numRoundTrips = 0;
+         for( ; numRoundTrips < numFrames; ++ numRoundTrips )
+         {
+            Net::sendtoSocket( clientSockets.last(), message, sizeof( message ) );
+            if( !waitFor( mNumEchoed, ( numRoundTrips + 1 ) * sizeof( message ) ) )
+               break;
+         }
+         const F32 echoTime = F32( Platform::getRealMilliseconds() - start ) / F32( getMax( numRoundTrips, U32( 1 ) ) );
+         test( numRoundTrips == numFrames, "Echo round trips failed" );
+
+         Con::printf( "TCP polling with %i idle connections (%i sockets):", clientSockets.size(), clientSockets.size() + mServerSockets.size() + 1 );
+         Con::printf( "   idle frame: %.3f ms", idleTime );
+         Con::printf( "   echo round trip: %.3f ms", echoTime );
+      }
+
+      Net::smConnectionAccept.remove( this, &TestTCPPolling::handleAccept );
+      Net::smConnectionNotify.remove( this, &TestTCPPolling::handleNotify );
+      Net::smConnectionReceive.remove( this, &TestTCPPolling::handleReceive );
+
+      for( U32 i = 0; i < clientSockets.size(); ++ i )
+         Net::closeConnectTo( clientSockets[ i ] );
+      for( U32 i = 0; i < mServerSockets.size(); ++ i )
+         Net::closeConnectTo( mServerSockets[ i ] );
+      Net::closeConnectTo( mListenSocket );
+      mServerSockets.clear();
+   }
+};
+
+#endif
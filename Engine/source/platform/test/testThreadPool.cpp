@@ -22,6 +22,7 @@
 
 #include "unit/test.h"
 #include "platform/threads/threadPool.h"
+#include "platform/threads/jobSystem.h"
 #include "console/console.h"
 #include "core/util/tVector.h"
 
@@ -82,4 +83,138 @@ CreateUnitTest( TestThreadPool, "Platform/ThreadPool/Simple" )
 
 Vector< U32 > TestThreadPool::results( __FILE__, __LINE__ );
 
+// Throughput and latency of ThreadPool compared to JobSystem.
+//
+// Throughput is measured with many small items that each do a fixed amount
+// of busywork.  Latency is measured as the round trip time of a single item
+// submitted to an otherwise idle pool.
+
+CreateUnitTest( TestThreadPoolBenchmark, "Platform/ThreadPool/Benchmark" )
+{
+   enum
+   {
+      DEFAULT_NUM_ITEMS = 100000,
+      DEFAULT_NUM_ROUND_TRIPS = 2000,
+      DEFAULT_ITEM_WORK = 200,
+   };
+
+   static volatile U32 smNumDone;
+   static U32 smItemWork;
+   static volatile U32 smSink;
+
+   static void doWork( U32 seed )
+   {
+      U32 value = seed;
+      for( U32 i = 0; i < smItemWork; ++ i )
+         value = value * 1664525 + 1013904223;
+      smSink = value;
+   }
+
+   static void waitForItems( U32 count )
+   {
+      while( dAtomicRead( smNumDone ) < count )
+         Platform::sleep( 0 );
+   }
+
+   struct BenchmarkItem : public ThreadPool::WorkItem
+   {
+      U32 mIndex;
+
+      BenchmarkItem( U32 index )
+         : mIndex( index ) {}
+
+   protected:
+      virtual void execute()
+      {
+         doWork( mIndex );
+         dFetchAndAdd( smNumDone, 1 );
+      }
+   };
+
+   static void benchmarkJob( void* data )
+   {
+      doWork( ( U32 ) ( dsize_t ) data );
+      dFetchAndAdd( smNumDone, 1 );
+   }
+
+   static void benchmarkRange( void* data, U32 begin, U32 end )
+   {
+      for( U32 i = begin; i < end; ++ i )
+         doWork( i );
+      dFetchAndAdd( smNumDone, end - begin );
+   }
+
+   void run()
+   {
+      const U32 numItems = Con::getIntVariable( "$testThreadPool::numBenchmarkItems", DEFAULT_NUM_ITEMS );
+      const U32 numRoundTrips = Con::getIntVariable( "$testThreadPool::numRoundTrips", DEFAULT_NUM_ROUND_TRIPS );
+      smItemWork = Con::getIntVariable( "$testThreadPool::itemWork", DEFAULT_ITEM_WORK );
+
+      ThreadPool& pool = ThreadPool::GLOBAL();
+      JobSystem& jobs = JobSystem::GLOBAL();
+
+      Con::printf( "ThreadPool: %d threads, JobSystem: %d threads + caller", pool.getNumThreads(), jobs.getNumThreads() );
+
+      // Throughput.
+
+      smNumDone = 0;
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < numItems; ++ i )
+      {
+         ThreadSafeRef< BenchmarkItem > item( new BenchmarkItem( i ) );
+         pool.queueWorkItem( item );
+      }
+      waitForItems( numItems );
+      const U32 poolTime = Platform::getRealMilliseconds() - start;
+
+      smNumDone = 0;
+      start = Platform::getRealMilliseconds();
+      JobSystem::Counter counter;
+      for( U32 i = 0; i < numItems; ++ i )
+         jobs.run( benchmarkJob, ( void* ) ( dsize_t ) i, &counter );
+      jobs.wait( counter );
+      const U32 jobTime = Platform::getRealMilliseconds() - start;
+      TEST( smNumDone == numItems );
+
+      smNumDone = 0;
+      start = Platform::getRealMilliseconds();
+      jobs.parallelFor( numItems, benchmarkRange, NULL );
+      const U32 parallelForTime = Platform::getRealMilliseconds() - start;
+      TEST( smNumDone == numItems );
+
+      Con::printf( "   throughput (%d items): ThreadPool %dms, JobSystem %dms, parallelFor %dms",
+         numItems, poolTime, jobTime, parallelForTime );
+
+      // Latency.  Don't let the job system run the item on our own thread.
+
+      smItemWork = 0;
+      smNumDone = 0;
+      start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < numRoundTrips; ++ i )
+      {
+         ThreadSafeRef< BenchmarkItem > item( new BenchmarkItem( i ) );
+         pool.queueWorkItem( item );
+         waitForItems( i + 1 );
+      }
+      const U32 poolLatency = Platform::getRealMilliseconds() - start;
+
+      smNumDone = 0;
+      start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < numRoundTrips; ++ i )
+      {
+         jobs.run( benchmarkJob, ( void* ) ( dsize_t ) i, &counter );
+         waitForItems( i + 1 );
+      }
+      const U32 jobLatency = Platform::getRealMilliseconds() - start;
+      jobs.wait( counter );
+
+      Con::printf( "   latency (%d round trips): ThreadPool %.1fus, JobSystem %.1fus",
+         numRoundTrips, F32( poolLatency ) * 1000.0f / numRoundTrips, F32( jobLatency ) * 1000.0f / numRoundTrips );
+   }
+};
+
+volatile U32 TestThreadPoolBenchmark::smNumDone;
+U32 TestThreadPoolBenchmark::smItemWork;
+volatile U32 TestThreadPoolBenchmark::smSink;
+
 #endif // !TORQUE_SHIPPING
@@ -0,0 +1,584 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/threads/jobSystem.h"
+#include "platform/threads/thread.h"
+#include "platform/threads/threadPool.h"
+#include "platform/platformCPUCount.h"
+#include "core/strings/stringFunctions.h"
+
+
+//#define DEBUG_SPEW
+
+
+namespace {
+
+   /// Minimal lock for the short critical sections of the job deques.
+   struct SpinLockScope
+   {
+      volatile U32& mLock;
+
+      SpinLockScope( volatile U32& lock )
+         : mLock( lock )
+      {
+         while( !dCompareAndSwap( mLock, 0, 1 ) )
+            ;
+      }
+      ~SpinLockScope()
+      {
+         dCompareAndSwap( mLock, 1, 0 );
+      }
+   };
+}
+
+//=============================================================================
+//    JobSystem::Job.
+//=============================================================================
+
+struct JobSystem::Job
+{
+   JobFunction    mFunction;
+   RangeFunction  mRangeFunction;
+   void*          mData;
+   U32            mBegin;
+   U32            mEnd;
+   Counter*       mCounter;
+
+   Job() {}
+   Job( JobFunction function, void* data, Counter* counter )
+      : mFunction( function ), mRangeFunction( NULL ), mData( data ), mBegin( 0 ), mEnd( 0 ), mCounter( counter ) {}
+   Job( RangeFunction function, void* data, U32 begin, U32 end, Counter* counter )
+      : mFunction( NULL ), mRangeFunction( function ), mData( data ), mBegin( begin ), mEnd( end ), mCounter( counter ) {}
+};
+
+//=============================================================================
+//    JobSystem::Counter.
+//=============================================================================
+
+struct JobSystem::Counter::Continuation
+{
+   JobSystem*     mSystem;
+   Job            mJob;
+   Continuation*  mNext;
+};
+
+//--------------------------------------------------------------------------
+
+JobSystem::Counter::Counter()
+   : mCount( 0 ),
+     mLock( 0 ),
+     mContinuations( NULL )
+{
+}
+
+//--------------------------------------------------------------------------
+
+JobSystem::Counter::~Counter()
+{
+   AssertFatal( isDone(), "JobSystem::Counter::~Counter - counter destroyed with jobs outstanding" );
+
+   // The worker that finished the last job may still be releasing the lock.
+   SpinLockScope lock( mLock );
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::Counter::increment( U32 count )
+{
+   dFetchAndAdd( mCount, count );
+}
+
+//--------------------------------------------------------------------------
+
+bool JobSystem::Counter::decrement()
+{
+   U32 count;
+   do
+   {
+      count = mCount;
+      AssertFatal( count > 0, "JobSystem::Counter::decrement - counter underflow" );
+   }
+   while( !dCompareAndSwap( mCount, count, count - 1 ) );
+
+   return ( count == 1 );
+}
+
+//=============================================================================
+//    JobSystem::Deque.
+//=============================================================================
+
+/// Fixed-size job deque of a single worker.
+///
+/// The owning worker pushes and pops at the bottom, other threads steal from
+/// the top.  Critical sections are a handful of instructions, so a spin
+/// lock per deque is cheaper here than a lock-free scheme that needs full
+/// fences on every pop.
+struct JobSystem::Deque
+{
+   enum { Capacity = 4096 };
+
+   volatile U32 mLock;
+   U32 mTop;
+   U32 mBottom;
+   Job mJobs[ Capacity ];
+
+   Deque()
+      : mLock( 0 ), mTop( 0 ), mBottom( 0 ) {}
+
+   bool isEmpty()
+   {
+      return ( dAtomicRead( *reinterpret_cast< volatile U32* >( &mTop ) )
+               == dAtomicRead( *reinterpret_cast< volatile U32* >( &mBottom ) ) );
+   }
+
+   bool push( const Job& job )
+   {
+      SpinLockScope lock( mLock );
+      if( mBottom - mTop >= Capacity )
+         return false;
+
+      mJobs[ mBottom % Capacity ] = job;
+      mBottom ++;
+      return true;
+   }
+
+   bool pop( Job& outJob )
+   {
+      if( isEmpty() )
+         return false;
+
+      SpinLockScope lock( mLock );
+      if( mBottom == mTop )
+         return false;
+
+      mBottom --;
+      outJob = mJobs[ mBottom % Capacity ];
+      return true;
+   }
+
+   bool steal( Job& outJob )
+   {
+      if( isEmpty() )
+         return false;
+
+      SpinLockScope lock( mLock );
+      if( mBottom == mTop )
+         return false;
+
+      outJob = mJobs[ mTop % Capacity ];
+      mTop ++;
+      return true;
+   }
+};
+
+//=============================================================================
+//    JobSystem::WorkerThread.
+//=============================================================================
+
+struct JobSystem::WorkerThread : public Thread
+{
+   enum
+   {
+      /// Number of times a worker looks for work before going to sleep.
+      NumSpins = 64
+   };
+
+   WorkerThread( JobSystem* system, U32 index )
+      : mSystem( system ),
+        mIndex( index ),
+        mSleeping( 0 ),
+        mSemaphore( 0 ) {}
+
+   virtual void run( void* arg = 0 );
+
+   JobSystem*     mSystem;
+   U32            mIndex;
+
+   /// 1 while the worker is registered as sleeping.  Whoever flips this
+   /// back to 0 -- a waker or the worker itself -- owns the registration.
+   volatile U32   mSleeping;
+
+   /// Released by a waker that claimed mSleeping.
+   Semaphore      mSemaphore;
+};
+
+void JobSystem::WorkerThread::run( void* arg )
+{
+   #ifdef TORQUE_DEBUG
+   {
+      // Set the thread's name for debugging.
+      char buffer[ 2048 ];
+      dSprintf( buffer, sizeof( buffer ), "JobSystem(%s) WorkerThread %i", mSystem->mName.c_str(), mIndex );
+      _setName( buffer );
+   }
+   #endif
+
+   U32 numSpins = 0;
+   while( !checkForStop() )
+   {
+      Job job;
+      if( mSystem->_takeJob( mIndex, job ) )
+      {
+         mSystem->_execute( job );
+         numSpins = 0;
+      }
+      else if( numSpins < NumSpins )
+      {
+         numSpins ++;
+         Platform::sleep( 0 );
+      }
+      else
+      {
+         mSystem->_sleep( mIndex );
+         numSpins = 0;
+      }
+   }
+
+#ifdef DEBUG_SPEW
+   Platform::outputDebugString( "[JobSystem::WorkerThread] thread '%i' exits", getId() );
+#endif
+}
+
+//=============================================================================
+//    JobSystem.
+//=============================================================================
+
+JobSystem::JobSystem( const char* name, U32 numThreads )
+   : mName( name ),
+     mNumThreads( numThreads ),
+     mDeques( NULL ),
+     mThreads( NULL ),
+     mNumThreadsSleeping( 0 ),
+     mNextDeque( 0 )
+{
+   if( !mNumThreads )
+   {
+      // Use platformCPUInfo directly as in the case of the global system,
+      // Platform::SystemInfo will not yet have been initialized.
+
+      U32 numLogical;
+      U32 numPhysical;
+      U32 numCores;
+
+      CPUInfo::CPUCount( numLogical, numCores, numPhysical );
+
+      // Leave a core for the main thread, which joins in while waiting.
+      const U32 baseCount = getMax( numLogical, numCores );
+      mNumThreads = baseCount > 1 ? baseCount - 1 : 1;
+   }
+
+   #ifdef DEBUG_SPEW
+   Platform::outputDebugString( "[JobSystem] spawning %i threads", mNumThreads );
+   #endif
+
+   mDeques = new Deque[ mNumThreads ];
+   mThreads = new WorkerThread*[ mNumThreads ];
+   for( U32 i = 0; i < mNumThreads; ++ i )
+      mThreads[ i ] = new WorkerThread( this, i );
+   for( U32 i = 0; i < mNumThreads; ++ i )
+      mThreads[ i ]->start();
+}
+
+//--------------------------------------------------------------------------
+
+JobSystem::~JobSystem()
+{
+   shutdown();
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::shutdown()
+{
+   if( !mThreads )
+      return;
+
+   for( U32 i = 0; i < mNumThreads; ++ i )
+      mThreads[ i ]->stop();
+
+   // Wake everyone up so they see their stop flag.
+   for( U32 i = 0; i < mNumThreads; ++ i )
+      mThreads[ i ]->mSemaphore.release();
+
+   for( U32 i = 0; i < mNumThreads; ++ i )
+   {
+      mThreads[ i ]->join();
+      delete mThreads[ i ];
+   }
+
+   delete [] mThreads;
+   delete [] mDeques;
+
+   mThreads = NULL;
+   mDeques = NULL;
+   mNumThreads = 0;
+}
+
+//--------------------------------------------------------------------------
+
+S32 JobSystem::_getCurrentWorker() const
+{
+   const U32 threadId = ThreadManager::getCurrentThreadId();
+   for( U32 i = 0; i < mNumThreads; ++ i )
+      if( ThreadManager::compare( mThreads[ i ]->getId(), threadId ) )
+         return i;
+   return -1;
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::_push( const Job& job )
+{
+   // Workers feed their own deque; everyone else spreads their jobs out.
+
+   S32 worker = _getCurrentWorker();
+   if( worker == -1 )
+   {
+      U32 index;
+      do
+         index = mNextDeque;
+      while( !dCompareAndSwap( mNextDeque, index, index + 1 ) );
+      worker = index % mNumThreads;
+   }
+
+   if( !mDeques[ worker ].push( job ) )
+   {
+      // Deque is full; don't hold up the caller any longer than the job does.
+      _execute( job );
+   }
+}
+
+//--------------------------------------------------------------------------
+
+bool JobSystem::_takeJob( S32 worker, Job& outJob )
+{
+   if( worker != -1 && mDeques[ worker ].pop( outJob ) )
+      return true;
+
+   // Steal, starting with our neighbour so that thieves spread out.
+
+   const U32 start = worker != -1 ? worker + 1 : 0;
+   for( U32 i = 0; i < mNumThreads; ++ i )
+   {
+      const U32 victim = ( start + i ) % mNumThreads;
+      if( victim != worker && mDeques[ victim ].steal( outJob ) )
+         return true;
+   }
+
+   return false;
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::_execute( const Job& job )
+{
+   if( job.mRangeFunction )
+      job.mRangeFunction( job.mData, job.mBegin, job.mEnd );
+   else
+      job.mFunction( job.mData );
+
+   Counter* counter = job.mCounter;
+   if( !counter )
+      return;
+
+   // Decrement and detach the continuations in one go under the lock so
+   // runAfter() can't queue on a counter that has already been released.
+   // Once the count is zero, the counter may be destroyed as soon as the
+   // lock is dropped (wait() and ~Counter take it), so it must not be
+   // touched past this block.
+
+   Counter::Continuation* continuations = NULL;
+   {
+      SpinLockScope lock( counter->mLock );
+      if( counter->decrement() )
+      {
+         continuations = counter->mContinuations;
+         counter->mContinuations = NULL;
+      }
+   }
+
+   // Release the jobs that were waiting on the counter.
+
+   while( continuations )
+   {
+      Counter::Continuation* next = continuations->mNext;
+      continuations->mSystem->_push( continuations->mJob );
+      continuations->mSystem->_wake( 1 );
+      delete continuations;
+      continuations = next;
+   }
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::_wake( U32 count )
+{
+   for( U32 i = 0; i < mNumThreads && count; ++ i )
+   {
+      if( !dAtomicRead( mNumThreadsSleeping ) )
+         break;
+
+      WorkerThread* thread = mThreads[ i ];
+      if( dCompareAndSwap( thread->mSleeping, 1, 0 ) )
+      {
+         dFetchAndAdd( mNumThreadsSleeping, U32( -1 ) );
+         thread->mSemaphore.release();
+         count --;
+      }
+   }
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::_sleep( S32 worker )
+{
+   WorkerThread* thread = mThreads[ worker ];
+
+   dCompareAndSwap( thread->mSleeping, 0, 1 );
+   dFetchAndAdd( mNumThreadsSleeping, 1 );
+
+   // Look once more now that we are registered as sleeping so that a job
+   // pushed just before can't be missed.
+
+   Job job;
+   if( !_takeJob( worker, job ) )
+   {
+      thread->mSemaphore.acquire();
+      return;
+   }
+
+   // Unregister.  If a waker claimed us first, it has taken our share of
+   // mNumThreadsSleeping and owes us a release, so consume that instead.
+
+   if( dCompareAndSwap( thread->mSleeping, 1, 0 ) )
+      dFetchAndAdd( mNumThreadsSleeping, U32( -1 ) );
+   else
+      thread->mSemaphore.acquire();
+
+   _execute( job );
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::run( JobFunction function, void* data, Counter* counter )
+{
+   if( counter )
+      counter->increment();
+
+   const Job job( function, data, counter );
+   if( !mNumThreads || ThreadPool::getForceAllMainThread() )
+      _execute( job );
+   else
+   {
+      _push( job );
+      _wake( 1 );
+   }
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::runAfter( Counter& dependency, JobFunction function, void* data, Counter* counter )
+{
+   if( counter )
+      counter->increment();
+
+   {
+      SpinLockScope lock( dependency.mLock );
+      if( !dependency.isDone() )
+      {
+         // Queue behind the dependency; the job that brings its count down
+         // to zero will submit us.
+
+         Counter::Continuation* continuation = new Counter::Continuation;
+         continuation->mSystem = this;
+         continuation->mJob = Job( function, data, counter );
+         continuation->mNext = dependency.mContinuations;
+         dependency.mContinuations = continuation;
+         return;
+      }
+   }
+
+   const Job job( function, data, counter );
+   if( !mNumThreads || ThreadPool::getForceAllMainThread() )
+      _execute( job );
+   else
+   {
+      _push( job );
+      _wake( 1 );
+   }
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::wait( Counter& counter )
+{
+   const S32 worker = _getCurrentWorker();
+   while( !counter.isDone() )
+   {
+      Job job;
+      if( _takeJob( worker, job ) )
+         _execute( job );
+      else
+         Platform::sleep( 0 );
+   }
+
+   // Let the worker that finished the last job drop the counter's lock
+   // before the caller is free to destroy it.
+   SpinLockScope lock( counter.mLock );
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::parallelFor( U32 count, RangeFunction function, void* data, U32 grainSize )
+{
+   if( !count )
+      return;
+
+   if( !mNumThreads || ThreadPool::getForceAllMainThread() )
+   {
+      function( data, 0, count );
+      return;
+   }
+
+   // By default, aim for a few ranges per thread so stealing can even out
+   // uneven work.
+
+   if( !grainSize )
+      grainSize = getMax( count / ( ( mNumThreads + 1 ) * 4 ), U32( 1 ) );
+
+   const U32 numJobs = ( count + grainSize - 1 ) / grainSize;
+
+   Counter counter;
+   counter.increment( numJobs );
+
+   // Run the first range ourselves after handing out the rest.
+
+   for( U32 i = 1; i < numJobs; ++ i )
+   {
+      const U32 begin = i * grainSize;
+      _push( Job( function, data, begin, getMin( begin + grainSize, count ), &counter ) );
+   }
+   _wake( numJobs - 1 );
+
+   _execute( Job( function, data, 0, getMin( grainSize, count ), &counter ) );
+   wait( counter );
+}
@@ -0,0 +1,232 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JOBSYSTEM_H_
+#define _JOBSYSTEM_H_
+
+#ifndef _PLATFORM_THREAD_SEMAPHORE_H_
+   #include "platform/threads/semaphore.h"
+#endif
+#ifndef _PLATFORMINTRINSICS_H_
+   #include "platform/platformIntrinsics.h"
+#endif
+#ifndef _TSINGLETON_H_
+   #include "core/util/tSingleton.h"
+#endif
+#ifndef _TORQUE_STRING_H_
+   #include "core/util/str.h"
+#endif
+
+
+/// @file
+/// Work-stealing scheduler for fine-grained parallel work.
+
+
+/// Work-stealing job scheduler.
+///
+/// Where ThreadPool is meant for long-running, prioritized background work
+/// such as resource loading, the job system is meant for splitting up
+/// frame-critical work into many small pieces and waiting for them to
+/// finish.  Jobs are plain function pointers with a data argument, so
+/// submitting one does not allocate.
+///
+/// Each worker thread has its own job deque.  Workers push and pop at the
+/// bottom of their own deque and, when it runs empty, steal from the top of
+/// the other workers' deques.  Jobs submitted from threads outside the
+/// system are spread over the worker deques.
+///
+/// Jobs are tracked through Counters.  Any thread may wait() on a counter
+/// and will execute pending jobs itself while doing so rather than blocking,
+/// which also makes it safe to wait from within a job.  runAfter() holds
+/// back a job until another counter has completed, which allows expressing
+/// simple dependency chains without waiting on the submitting thread.
+///
+/// @code
+/// static void addOne( void* data, U32 begin, U32 end )
+/// {
+///    U32* values = ( U32* ) data;
+///    for( U32 i = begin; i < end; ++ i )
+///       values[ i ] ++;
+/// }
+///
+/// JobSystem::GLOBAL().parallelFor( values.size(), addOne, values.address() );
+/// @endcode
+///
+class JobSystem
+{
+   public:
+
+      /// Function executed by a job.
+      typedef void ( *JobFunction )( void* data );
+
+      /// Function executed for a range of indices by parallelFor().
+      typedef void ( *RangeFunction )( void* data, U32 begin, U32 end );
+
+      /// Tracks the number of jobs outstanding in a group.
+      ///
+      /// The count is incremented when a job is submitted with the counter
+      /// and decremented when the job has finished.  Counters must outlive
+      /// the jobs they track, so usually they are waited on before they go
+      /// out of scope.
+      class Counter
+      {
+         public:
+
+            Counter();
+            ~Counter();
+
+            /// Return true if all jobs tracked by this counter have finished.
+            bool isDone() const { return ( getCount() == 0 ); }
+
+            /// Return the number of jobs still outstanding.
+            U32 getCount() const { return dAtomicRead( const_cast< volatile U32& >( mCount ) ); }
+
+         protected:
+
+            friend class JobSystem;
+
+            struct Continuation;
+
+            /// Number of jobs outstanding.
+            volatile U32 mCount;
+
+            /// Spin lock guarding mContinuations.
+            volatile U32 mLock;
+
+            /// Jobs waiting for the counter to reach zero.
+            Continuation* mContinuations;
+
+            void increment( U32 count = 1 );
+
+            /// Decrement the count and return true if it reached zero.
+            bool decrement();
+      };
+
+   protected:
+
+      struct Job;
+      struct Deque;
+      struct WorkerThread;
+
+      friend struct WorkerThread;
+
+      /// Name of the job system.  Used to name worker threads.
+      String mName;
+
+      /// Number of worker threads.
+      U32 mNumThreads;
+
+      /// Job deques; one per worker thread.
+      Deque* mDeques;
+
+      /// Worker threads.
+      WorkerThread** mThreads;
+
+      /// Number of workers registered as sleeping.  Lets _wake() skip
+      /// scanning the workers when nobody is asleep.
+      volatile U32 mNumThreadsSleeping;
+
+      /// Round-robin index for jobs submitted from outside the workers.
+      volatile U32 mNextDeque;
+
+      /// Return the index of the worker running on the current thread or -1.
+      S32 _getCurrentWorker() const;
+
+      /// Put a job on a deque, executing it right away if the deque is full.
+      void _push( const Job& job );
+
+      /// Take a job from the given worker's deque or steal one from another.
+      bool _takeJob( S32 worker, Job& outJob );
+
+      void _execute( const Job& job );
+      void _wake( U32 count );
+
+      /// Called by workers to block until more work might be available.
+      void _sleep( S32 worker );
+
+   public:
+
+      /// Create a job system with the given number of worker threads.
+      ///
+      /// If numThreads is zero (the default), one worker is created for each
+      /// CPU core other than the one the main thread is running on.
+      ///
+      /// @param numThreads Number of threads to create or zero for default.
+      JobSystem( const char* name, U32 numThreads = 0 );
+
+      ~JobSystem();
+
+      /// Stop and delete the worker threads.  Pending jobs are discarded.
+      void shutdown();
+
+      /// Return the number of worker threads.
+      U32 getNumThreads() const { return mNumThreads; }
+
+      /// Submit a job.
+      ///
+      /// @param function Function to execute.
+      /// @param data Argument for @a function.
+      /// @param counter Optional counter to track the job with.
+      void run( JobFunction function, void* data, Counter* counter = NULL );
+
+      /// Submit a job that is only started once all jobs tracked by
+      /// @a dependency have finished.
+      ///
+      /// @a counter is incremented right away, so waiting on it also waits
+      /// for the dependency.
+      void runAfter( Counter& dependency, JobFunction function, void* data, Counter* counter = NULL );
+
+      /// Wait for all jobs tracked by @a counter to finish, executing pending
+      /// jobs on the calling thread in the meantime.
+      void wait( Counter& counter );
+
+      /// Call @a function for all indices in [0, @a count) split into ranges
+      /// of at most @a grainSize indices, and wait for it to finish.
+      ///
+      /// @param grainSize Number of indices per job or zero to pick one
+      ///   based on the number of worker threads.
+      void parallelFor( U32 count, RangeFunction function, void* data, U32 grainSize = 0 );
+
+      /// Return the global job system singleton.
+      static JobSystem& GLOBAL();
+
+      struct GlobalJobSystem;
+};
+
+
+struct JobSystem::GlobalJobSystem : public JobSystem, public ManagedSingleton< GlobalJobSystem >
+{
+   typedef JobSystem Parent;
+
+   GlobalJobSystem()
+      : Parent( "GLOBAL" ) {}
+
+   // For ManagedSingleton.
+   static const char* getSingletonName() { return "GlobalJobSystem"; }
+};
+
+inline JobSystem& JobSystem::GLOBAL()
+{
+   return *( GlobalJobSystem::instance() );
+}
+
+#endif // !_JOBSYSTEM_H_
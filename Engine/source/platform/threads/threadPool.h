@@ -292,6 +292,9 @@ class ThreadPool
       /// Manually shutdown threads outside of static destructors.
       void shutdown();
 
+      /// Return the number of worker threads in the pool.
+      U32 getNumThreads() const { return mNumThreads; }
+
       ///
       void queueWorkItem( WorkItem* item );
       
@@ -22,6 +22,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <sys/mman.h>
 
 #include "core/crc.h"
 #include "core/frameAllocator.h"
@@ -238,12 +239,16 @@ PosixFile::PosixFile(const Path& path,String name)
    _name = name;
    _status = Closed;
    _handle = 0;
+   _mapping = 0;
+   _mappingSize = 0;
 }
 
 PosixFile::~PosixFile()
 {
    if (_handle)
       close();
+
+   unmap();
 }
 
 Path PosixFile::getName() const
@@ -358,6 +363,40 @@ bool PosixFile::close()
    return true;
 }
 
+void* PosixFile::map()
+{
+   if (_mapping)
+      return _mapping;
+
+   if (_status != Open && _status != EndOfFile)
+      return 0;
+
+   // Make sure anything buffered by stdio is on disk before we map it.
+   fflush(_handle);
+
+   struct stat info;
+   if (fstat(fileno(_handle),&info) < 0 || info.st_size <= 0)
+      return 0;
+
+   void* mapping = mmap(0,info.st_size,PROT_READ | PROT_WRITE,MAP_PRIVATE,fileno(_handle),0);
+   if (mapping == MAP_FAILED)
+      return 0;
+
+   _mapping = mapping;
+   _mappingSize = info.st_size;
+   return _mapping;
+}
+
+void PosixFile::unmap()
+{
+   if (_mapping)
+   {
+      munmap(_mapping,_mappingSize);
+      _mapping = 0;
+      _mappingSize = 0;
+   }
+}
+
 U32 PosixFile::getPosition()
 {
    if (_status == Open || _status == EndOfFile)
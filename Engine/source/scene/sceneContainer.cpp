@@ -26,9 +26,15 @@
 #include "collision/extrudedPolyList.h"
 #include "collision/earlyOutPolyList.h"
 #include "scene/sceneObject.h"
+#include "scene/sceneSpatialIndex.h"
 #include "platform/profiler.h"
 #include "console/engineAPI.h"
 #include "math/util/frustum.h"
+#include "core/util/safeDelete.h"
+#include "core/module.h"
+#include "console/consoleTypes.h"
+#include "platform/threads/jobSystem.h"
+#include "platform/platformIntrinsics.h"
 
 
 // [rene, 02-Mar-11]
@@ -45,6 +51,23 @@ const U32 SceneContainer::csmNumBins = 16;
 const F32 SceneContainer::csmBinSize = 64;
 const F32 SceneContainer::csmTotalBinSize = SceneContainer::csmBinSize * SceneContainer::csmNumBins;
 const U32 SceneContainer::csmRefPoolBlockSize = 4096;
+const U32 SceneContainer::csmRayBatchSize = 32;
+const U32 SceneContainer::csmMinParallelRays = 64;
+
+bool SceneContainer::smParallelRayCasts = true;
+
+AFTER_MODULE_INIT( Sim )
+{
+   Con::addVariable( "$Container::parallelRayCasts", TypeBool, &SceneContainer::smParallelRayCasts,
+      "If true, batched ray casts on the server container are spread over the global thread pool.\n"
+      "@ingroup Game\n" );
+}
+
+// Used by findObjectList to collect results from spatial index queries.
+static void _findObjectListCallback( SceneObject* object, void* key )
+{
+   reinterpret_cast< Vector< SceneObject* >* >( key )->push_back( object );
+}
 
 // Statics used by buildPolyList methods
 static AbstractPolyList* sPolyList;
@@ -117,6 +140,9 @@ SceneContainer::SceneContainer()
    VECTOR_SET_ASSOCIATION( mSearchList );
    VECTOR_SET_ASSOCIATION( mWaterAndZones );
    VECTOR_SET_ASSOCIATION( mTerrains );
+   VECTOR_SET_ASSOCIATION( mIndexCandidates );
+
+   mSpatialIndex = NULL;
 
    mFreeRefPool = NULL;
    addRefPoolBlock();
@@ -129,6 +155,7 @@ SceneContainer::SceneContainer()
 SceneContainer::~SceneContainer()
 {
    delete[] mBinArray;
+   SAFE_DELETE( mSpatialIndex );
 
    for (U32 i = 0; i < mRefPoolBlocks.size(); i++)
    {
@@ -162,7 +189,10 @@ bool SceneContainer::addObject(SceneObject* obj)
    obj->mContainer = this;
    obj->linkAfter(&mStart);
 
-   insertIntoBins(obj);
+   if( mSpatialIndex )
+      mSpatialIndex->insertObject( obj );
+   else
+      insertIntoBins(obj);
 
    // Also insert water and physical zone types into the special vector.
    if ( obj->getTypeMask() & ( WaterObjectType | PhysicalZoneObjectType ) )
@@ -179,6 +209,8 @@ bool SceneContainer::removeObject(SceneObject* obj)
 {
    AssertFatal(obj->mContainer == this, "Trying to remove from wrong container.");
    removeFromBins(obj);
+   if( mSpatialIndex )
+      mSpatialIndex->removeObject( obj );
 
    // Remove water and physical zone types from the special vector.
    if ( obj->getTypeMask() & ( WaterObjectType | PhysicalZoneObjectType ) )
@@ -383,6 +415,12 @@ void SceneContainer::checkBins(SceneObject* obj)
 {
    AssertFatal(obj != NULL, "No object?");
 
+   if( mSpatialIndex )
+   {
+      mSpatialIndex->updateObject( obj );
+      return;
+   }
+
    PROFILE_START(CheckBins);
    if (obj->mBinRefHead == NULL)
    {
@@ -430,6 +468,12 @@ void SceneContainer::findObjects(const Box3F& box, U32 mask, FindCallback callba
       return;
    }
 
+   if( mSpatialIndex )
+   {
+      _findIndexedObjects( box, NULL, mask, callback, key );
+      return;
+   }
+
    AssertFatal( !mSearchInProgress, "SceneContainer::findObjects - Container queries are not re-entrant" );
    mSearchInProgress = true;
 
@@ -508,6 +552,12 @@ void SceneContainer::findObjects( const Frustum &frustum, U32 mask, FindCallback
       return;
    }
 
+   if( mSpatialIndex )
+   {
+      _findIndexedObjects( searchBox, &frustum, mask, callback, key );
+      return;
+   }
+
    AssertFatal( !mSearchInProgress, "SceneContainer::findObjects - Container queries are not re-entrant" );
    mSearchInProgress = true;
 
@@ -605,6 +655,12 @@ void SceneContainer::polyhedronFindObjects(const Polyhedron& polyhedron, U32 mas
       return;
    }
 
+   if( mSpatialIndex )
+   {
+      _findIndexedObjects( box, NULL, mask, callback, key );
+      return;
+   }
+
    AssertFatal( !mSearchInProgress, "SceneContainer::polyhedronFindObjects - Container queries are not re-entrant" );
    mSearchInProgress = true;
 
@@ -668,6 +724,12 @@ void SceneContainer::findObjectList( const Box3F& searchBox, U32 mask, Vector<Sc
 {
    PROFILE_SCOPE( Container_FindObjectList_Box );
 
+   if( mSpatialIndex )
+   {
+      _findIndexedObjects( searchBox, NULL, mask, _findObjectListCallback, outFound );
+      return;
+   }
+
    AssertFatal( !mSearchInProgress, "SceneContainer::findObjectList - Container queries are not re-entrant" );
    mSearchInProgress = true;
 
@@ -815,6 +877,82 @@ void SceneContainer::_findSpecialObjects( const Vector< SceneObject* >& vector,
 
 //-----------------------------------------------------------------------------
 
+void SceneContainer::_findIndexedObjects( const Box3F& box, const Frustum* frustum, U32 mask, FindCallback callback, void* key )
+{
+   PROFILE_SCOPE( SceneContainer_findIndexedObjects );
+
+   AssertFatal( !mSearchInProgress, "SceneContainer::_findIndexedObjects - Container queries are not re-entrant" );
+   mSearchInProgress = true;
+
+   mIndexCandidates.clear();
+   mSpatialIndex->findCandidates( box, mIndexCandidates );
+
+   for( U32 i = 0; i < mIndexCandidates.size(); ++ i )
+   {
+      SceneObject* object = mIndexCandidates[ i ];
+
+      if( ( object->getTypeMask() & mask ) == 0 || !object->isCollisionEnabled() )
+         continue;
+
+      const Box3F& worldBox = object->getWorldBox();
+      if( !object->isGlobalBounds() && !worldBox.isOverlapped( box ) )
+         continue;
+
+      if( frustum && frustum->isCulled( worldBox ) )
+         continue;
+
+      ( *callback )( object, key );
+   }
+
+   mSearchInProgress = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::setSpatialIndex( SceneSpatialIndex* index )
+{
+   AssertFatal( !mSearchInProgress, "SceneContainer::setSpatialIndex - Cannot change index during a query" );
+
+   if( index == mSpatialIndex )
+      return;
+
+   for( Link* itr = mStart.next; itr != &mEnd; itr = itr->next )
+   {
+      SceneObject* object = static_cast< SceneObject* >( itr );
+
+      if( mSpatialIndex )
+         mSpatialIndex->removeObject( object );
+      else
+         removeFromBins( object );
+
+      if( index )
+         index->insertObject( object );
+      else
+         insertIntoBins( object );
+   }
+
+   SAFE_DELETE( mSpatialIndex );
+   mSpatialIndex = index;
+}
+
+//-----------------------------------------------------------------------------
+
+Box3F SceneContainer::getObjectBounds() const
+{
+   Box3F bounds = Box3F::Invalid;
+
+   for( const Link* itr = mStart.next; itr != &mEnd; itr = itr->next )
+   {
+      const SceneObject* object = static_cast< const SceneObject* >( itr );
+      if( !object->isGlobalBounds() )
+         bounds.intersect( object->getWorldBox() );
+   }
+
+   return bounds;
+}
+
+//-----------------------------------------------------------------------------
+
 bool SceneContainer::castRay( const Point3F& start, const Point3F& end, U32 mask, RayInfo* info, CastRayCallback callback )
 {
    AssertFatal( info->userData == NULL, "SceneContainer::castRay - RayInfo->userData cannot be used here!" );
@@ -839,6 +977,63 @@ bool SceneContainer::castRayRendered( const Point3F& start, const Point3F& end,
 
 //-----------------------------------------------------------------------------
 
+// Bump the normal of a ray cast result into worldspace if appropriate.
+static bool _finishCastRay( RayInfo* info, F32 currentT )
+{
+   if(currentT != 2)
+   {
+      PlaneF fakePlane;
+      fakePlane.x = info->normal.x;
+      fakePlane.y = info->normal.y;
+      fakePlane.z = info->normal.z;
+      fakePlane.d = 0;
+
+      PlaneF result;
+      mTransformPlane(info->object->getTransform(), info->object->getScale(), fakePlane, &result);
+      info->normal = result;
+
+      return true;
+   }
+   else
+   {
+      // Do nothing and exit...
+      return false;
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+// Cast a ray against a single object and update the result if the hit
+// is closer than currentT.
+static void _castRayObject( SceneObject* ptr, bool rendered, const Point3F& start, const Point3F& end, RayInfo* info, SceneContainer::CastRayCallback callback, F32& currentT )
+{
+   Point3F xformedStart, xformedEnd;
+   ptr->getWorldTransform().mulP(start, &xformedStart);
+   ptr->getWorldTransform().mulP(end,   &xformedEnd);
+   xformedStart.convolveInverse(ptr->getScale());
+   xformedEnd.convolveInverse(ptr->getScale());
+
+   RayInfo ri;
+   ri.generateTexCoord  = info->generateTexCoord;
+   bool result = false;
+   if (!rendered)
+      result = ptr->castRay(xformedStart, xformedEnd, &ri);
+   else
+      result = ptr->castRayRendered(xformedStart, xformedEnd, &ri);
+   if (result)
+   {
+      if( ri.t < currentT && ( !callback || callback( &ri ) ) )
+      {
+         *info = ri;
+         info->point.interpolate(start, end, info->t);
+         currentT = ri.t;
+         info->distance = (start - info->point).len();
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+
 // DMMNOTE: There are still some optimizations to be done here.  In particular:
 //           - After checking the overflow bin, we can potentially shorten the line
 //             that we rasterize against the grid if there is a collision with say,
@@ -859,6 +1054,25 @@ bool SceneContainer::_castRay( U32 type, const Point3F& start, const Point3F& en
    F32 currentT = 2.0;
    mCurrSeqKey++;
 
+   if( mSpatialIndex )
+   {
+      mIndexCandidates.clear();
+      mSpatialIndex->findRayCandidates( start, end, mIndexCandidates );
+
+      for( U32 i = 0; i < mIndexCandidates.size(); ++ i )
+      {
+         SceneObject* ptr = mIndexCandidates[ i ];
+
+         if( ( ptr->getTypeMask() & mask ) != 0 &&
+             ptr->isCollisionEnabled() == true &&
+             ( ptr->isGlobalBounds() || ptr->getWorldBox().collideLine( start, end ) ) )
+            _castRayObject( ptr, type == RenderedGeometry, start, end, info, callback, currentT );
+      }
+
+      mSearchInProgress = false;
+      return _finishCastRay( info, currentT );
+   }
+
    SceneObjectRef* chain = mOverflowBin.nextInBin;
    while (chain)
    {
@@ -1103,26 +1317,291 @@ bool SceneContainer::_castRay( U32 type, const Point3F& start, const Point3F& en
 
    mSearchInProgress = false;
 
-   // Bump the normal into worldspace if appropriate.
-   if(currentT != 2)
+   return _finishCastRay( info, currentT );
+}
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+/// Shared state of a SceneContainer::castRays() call.
+struct RayCastBatchJob
+{
+   struct Batch
    {
-      PlaneF fakePlane;
-      fakePlane.x = info->normal.x;
-      fakePlane.y = info->normal.y;
-      fakePlane.z = info->normal.z;
-      fakePlane.d = 0;
+      /// Range in #rayOrder.
+      U32 firstRay;
+      U32 numRays;
 
-      PlaneF result;
-      mTransformPlane(info->object->getTransform(), info->object->getScale(), fakePlane, &result);
-      info->normal = result;
+      /// Range in #candidates.
+      U32 firstCandidate;
+      U32 numCandidates;
+
+      /// Range in #serialCandidates.
+      U32 firstSerialCandidate;
+      U32 numSerialCandidates;
+   };
+
+   const SceneContainer::RayQuery* queries;
+   RayInfo* outInfos;
+
+   /// Closest hit so far per ray.
+   Vector< F32 > currentT;
+
+   /// Results against #serialCandidates.  Kept apart from #outInfos
+   /// as workers may be writing those at the same time.
+   Vector< RayInfo > serialInfos;
+   Vector< F32 > serialT;
+
+   /// Ray indices sorted by cell.
+   Vector< U32 > rayOrder;
+
+   Vector< Batch > batches;
+
+   /// Objects that may be tested on any thread.
+   Vector< SceneObject* > candidates;
+
+   /// Objects that must be tested on the calling thread.
+   Vector< SceneObject* > serialCandidates;
+
+   U32 numBatches;
+   volatile U32 nextBatch;
+
+   RayCastBatchJob()
+      : numBatches( 0 ), nextBatch( 0 ) {}
+
+   static void castRay( SceneObject* const* objects, U32 numObjects, const SceneContainer::RayQuery& query, RayInfo* info, F32& currentT )
+   {
+      for( U32 i = 0; i < numObjects; ++ i )
+      {
+         SceneObject* ptr = objects[ i ];
+         if( ( ptr->getTypeMask() & query.mask ) != 0 &&
+             ptr->isCollisionEnabled() &&
+             ( ptr->isGlobalBounds() || ptr->getWorldBox().collideLine( query.start, query.end ) ) )
+            _castRayObject( ptr, false, query.start, query.end, info, NULL, currentT );
+      }
+   }
+
+   /// Claim the next batch and test it against #candidates.
+   /// @return False if there are no more batches left.
+   bool processNextBatch()
+   {
+      U32 index;
+      do
+      {
+         index = dAtomicRead( nextBatch );
+         if( index >= numBatches )
+            return false;
+      }
+      while( !dCompareAndSwap( nextBatch, index, index + 1 ) );
+
+      const Batch& batch = batches[ index ];
+      for( U32 i = 0; i < batch.numRays; ++ i )
+      {
+         const U32 ray = rayOrder[ batch.firstRay + i ];
+         castRay( candidates.address() + batch.firstCandidate, batch.numCandidates,
+            queries[ ray ], &outInfos[ ray ], currentT[ ray ] );
+      }
 
       return true;
    }
-   else
+
+   /// Test all batches against #serialCandidates.
+   void processSerialCandidates()
    {
-      // Do nothing and exit...
-      return false;
+      for( U32 n = 0; n < batches.size(); ++ n )
+      {
+         const Batch& batch = batches[ n ];
+         if( !batch.numSerialCandidates )
+            continue;
+
+         for( U32 i = 0; i < batch.numRays; ++ i )
+         {
+            const U32 ray = rayOrder[ batch.firstRay + i ];
+            castRay( serialCandidates.address() + batch.firstSerialCandidate, batch.numSerialCandidates,
+               queries[ ray ], &serialInfos[ ray ], serialT[ ray ] );
+         }
+      }
    }
+};
+
+/// JobSystem job that keeps processing batches of a RayCastBatchJob.
+static void processRayCastBatches( void* data )
+{
+   RayCastBatchJob* job = reinterpret_cast< RayCastBatchJob* >( data );
+   while( job->processNextBatch() );
+}
+
+struct RaySortKey
+{
+   U32 cell;
+   U32 index;
+};
+
+/// Spread the low 16 bits of @a x out to the even bits.
+static inline U32 spreadMortonBits( U32 x )
+{
+   x &= 0x0000FFFF;
+   x = ( x | ( x << 8 ) ) & 0x00FF00FF;
+   x = ( x | ( x << 4 ) ) & 0x0F0F0F0F;
+   x = ( x | ( x << 2 ) ) & 0x33333333;
+   x = ( x | ( x << 1 ) ) & 0x55555555;
+   return x;
+}
+
+/// Return the Morton code of the unwrapped bin cell containing @a x, @a y.
+/// Unlike the bin index, cells a multiple of csmTotalBinSize apart get
+/// different codes, and neighboring cells mostly get close ones.
+static U32 getRayCellKey( F32 x, F32 y, F32 binSize )
+{
+   const U32 cellX = U32( S32( mFloor( x / binSize ) ) + 0x8000 );
+   const U32 cellY = U32( S32( mFloor( y / binSize ) ) + 0x8000 );
+   return spreadMortonBits( cellX ) | ( spreadMortonBits( cellY ) << 1 );
+}
+
+static S32 QSORT_CALLBACK cmpRaySortKey( const void* a, const void* b )
+{
+   const RaySortKey* ka = reinterpret_cast< const RaySortKey* >( a );
+   const RaySortKey* kb = reinterpret_cast< const RaySortKey* >( b );
+
+   if( ka->cell != kb->cell )
+      return ka->cell < kb->cell ? -1 : 1;
+   return S32( ka->index ) - S32( kb->index );
+}
+
+} // namespace
+
+U32 SceneContainer::castRays( const RayQuery* queries, U32 count, RayInfo* outInfos )
+{
+   PROFILE_SCOPE( SceneContainer_castRays );
+
+   if( !count )
+      return 0;
+
+   bool parallel = smParallelRayCasts && this == &gServerContainer && count >= csmMinParallelRays;
+   #ifndef TORQUE_MULTITHREAD
+   parallel = false;
+   #endif
+
+   RayCastBatchJob job;
+   job.queries = queries;
+   job.outInfos = outInfos;
+   job.currentT.setSize( count );
+   job.rayOrder.reserve( count );
+
+   for( U32 i = 0; i < count; ++ i )
+   {
+      outInfos[ i ].object = NULL;
+      job.currentT[ i ] = 2.0f;
+   }
+
+   if( parallel )
+   {
+      job.serialInfos.setSize( count );
+      job.serialT.setSize( count );
+      for( U32 i = 0; i < count; ++ i )
+      {
+         job.serialInfos[ i ].object = NULL;
+         job.serialInfos[ i ].generateTexCoord = outInfos[ i ].generateTexCoord;
+         job.serialT[ i ] = 2.0f;
+      }
+   }
+
+   // Sort the rays along a Z-order curve by the cell their midpoint falls
+   // into so that rays close to each other can share their candidate list.
+
+   Vector< RaySortKey > keys;
+   keys.setSize( count );
+   for( U32 i = 0; i < count; ++ i )
+   {
+      const Point3F mid = ( queries[ i ].start + queries[ i ].end ) * 0.5f;
+
+      keys[ i ].cell = getRayCellKey( mid.x, mid.y, csmBinSize );
+      keys[ i ].index = i;
+   }
+   dQsort( keys.address(), count, sizeof( RaySortKey ), cmpRaySortKey );
+
+   // Build the batches and gather their candidates.
+
+   PROFILE_START( SceneContainer_castRays_gather );
+
+   Vector< SceneObject* > found;
+   for( U32 i = 0; i < count; )
+   {
+      RayCastBatchJob::Batch batch;
+      batch.firstRay = job.rayOrder.size();
+
+      Box3F box = Box3F::Invalid;
+      U32 mask = 0;
+
+      U32 j = i;
+      for( ; j < count && j - i < csmRayBatchSize && keys[ j ].cell == keys[ i ].cell; ++ j )
+      {
+         const RayQuery& query = queries[ keys[ j ].index ];
+         job.rayOrder.push_back( keys[ j ].index );
+         box.intersect( query.start );
+         box.intersect( query.end );
+         mask |= query.mask;
+      }
+      batch.numRays = j - i;
+
+      found.clear();
+      findObjectList( box, mask, &found );
+
+      batch.firstCandidate = job.candidates.size();
+      batch.firstSerialCandidate = job.serialCandidates.size();
+      for( U32 k = 0; k < found.size(); ++ k )
+      {
+         if( !parallel || found[ k ]->isCastRayThreadSafe() )
+            job.candidates.push_back( found[ k ] );
+         else
+            job.serialCandidates.push_back( found[ k ] );
+      }
+      batch.numCandidates = job.candidates.size() - batch.firstCandidate;
+      batch.numSerialCandidates = job.serialCandidates.size() - batch.firstSerialCandidate;
+
+      job.batches.push_back( batch );
+      i = j;
+   }
+   job.numBatches = job.batches.size();
+
+   PROFILE_END();
+
+   JobSystem& jobs = JobSystem::GLOBAL();
+   JobSystem::Counter counter;
+
+   if( parallel )
+   {
+      const U32 numItems = getMin( jobs.getNumThreads(), job.numBatches - 1 );
+      for( U32 i = 0; i < numItems; ++ i )
+         jobs.run( &processRayCastBatches, &job, &counter );
+
+      // Take care of the objects that can't leave this thread while the
+      // workers are busy.
+      job.processSerialCandidates();
+   }
+
+   // Help out with the batches and then wait for the jobs still working on
+   // the last ones.  Waiting runs other pending jobs rather than spinning.
+   while( job.processNextBatch() );
+   jobs.wait( counter );
+
+   U32 numHits = 0;
+   for( U32 i = 0; i < count; ++ i )
+   {
+      if( parallel && job.serialT[ i ] < job.currentT[ i ] )
+      {
+         outInfos[ i ] = job.serialInfos[ i ];
+         job.currentT[ i ] = job.serialT[ i ];
+      }
+
+      if( _finishCastRay( &outInfos[ i ], job.currentT[ i ] ) )
+         numHits ++;
+      else
+         outInfos[ i ].object = NULL;
+   }
+
+   return numHits;
 }
 
 //-----------------------------------------------------------------------------
@@ -1648,4 +2127,52 @@ DefineEngineFunction( containerRayCast, const char*,
    return(returnBuffer);
 }
 
+//-----------------------------------------------------------------------------
+
+DefineEngineFunction( containerSetSpatialIndex, bool,
+   ( const char* type, const char* bounds, U32 maxDepth, bool useClientContainer ), ( "", SceneLooseOctree::DefaultMaxDepth, false ),
+   "@brief Select the spatial database used by a container for its queries and ray casts.\n\n"
+
+   "The default bin grid wraps around every 1024 meters so large worlds end up with long "
+   "bin chains.  A loose octree sized to the world avoids this.\n"
+
+   "@param type Either \"grid\" for the default bin grid or \"octree\" for a loose octree.\n"
+   "@param bounds World space box (\"minX minY minZ maxX maxY maxZ\") covering the area the octree "
+   "should subdivide, e.g. the mission area.  If empty, the bounds of the objects currently in the "
+   "container are used.\n"
+   "@param maxDepth Maximum depth of the octree.\n"
+   "@param useClientContainer Optionally indicates the client container should be changed.\n"
+   "@return true if the index was installed.\n"
+
+   "@ingroup Game")
+{
+   SceneContainer* pContainer = useClientContainer ? &gClientContainer : &gServerContainer;
+
+   if( dStricmp( type, "grid" ) == 0 )
+   {
+      pContainer->setSpatialIndex( NULL );
+      return true;
+   }
+   else if( dStricmp( type, "octree" ) == 0 )
+   {
+      Box3F box = pContainer->getObjectBounds();
+      if( bounds && bounds[ 0 ] )
+         dSscanf( bounds, "%g %g %g %g %g %g",
+            &box.minExtents.x, &box.minExtents.y, &box.minExtents.z,
+            &box.maxExtents.x, &box.maxExtents.y, &box.maxExtents.z );
+
+      if( !box.isValidBox() )
+      {
+         Con::errorf( "containerSetSpatialIndex - No valid bounds for octree" );
+         return false;
+      }
+
+      pContainer->setSpatialIndex( new SceneLooseOctree( box, maxDepth ) );
+      return true;
+   }
+
+   Con::errorf( "containerSetSpatialIndex - Unknown index type '%s'", type );
+   return false;
+}
+
 ConsoleFunctionGroupEnd( Containers );
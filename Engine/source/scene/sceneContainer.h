@@ -53,6 +53,7 @@ class AbstractPolyList;
 class OptimizedPolyList;
 class Frustum;
 class Point3F;
+class SceneSpatialIndex;
 
 struct RayInfo;
 
@@ -134,6 +135,8 @@ class SimpleQueryList
 /// Database for SceneObjects.
 ///
 /// ScenceContainer implements a grid-based spatial subdivision for the contents of a scene.
+/// Alternatively, a SceneSpatialIndex can be installed on a container with setSpatialIndex()
+/// in which case all spatial queries run against that index instead of the bin grid.
 class SceneContainer
 {
       enum CastRayType
@@ -187,11 +190,23 @@ class SceneContainer
       /// Vector that contains just the terrain objects in the container.
       Vector< SceneObject* > mTerrains;
 
+      /// Spatial index used instead of the bin grid or NULL.
+      SceneSpatialIndex* mSpatialIndex;
+
+      /// Candidate list used by queries against #mSpatialIndex.
+      Vector< SceneObject* > mIndexCandidates;
+
       static const U32 csmNumBins;
       static const F32 csmBinSize;
       static const F32 csmTotalBinSize;
       static const U32 csmRefPoolBlockSize;
 
+      /// Maximum number of rays sharing a candidate list in castRays().
+      static const U32 csmRayBatchSize;
+
+      /// Minimum number of rays for castRays() to use worker threads.
+      static const U32 csmMinParallelRays;
+
    public:
 
       SceneContainer();
@@ -203,6 +218,24 @@ class SceneContainer
       /// Return a vector containing all terrain objects in this container.
       const Vector< SceneObject* >& getTerrains() const { return mTerrains; }
 
+      /// @name Spatial index
+      /// @{
+
+      /// Replace the bin grid with the given spatial index and move all objects over
+      /// to it.  The container takes ownership of the index.  Passing NULL restores the
+      /// default bin grid.
+      void setSpatialIndex( SceneSpatialIndex* index );
+
+      /// Return the spatial index used by this container or NULL if the container
+      /// uses its bin grid.
+      SceneSpatialIndex* getSpatialIndex() const { return mSpatialIndex; }
+
+      /// Return the combined world bounds of all objects in the container excluding
+      /// objects with global bounds.
+      Box3F getObjectBounds() const;
+
+      /// @}
+
       /// @name Basic database operations
       /// @{
 
@@ -239,6 +272,16 @@ class SceneContainer
 
       typedef bool ( *CastRayCallback )( RayInfo* ri );
 
+      /// A single ray for castRays().
+      struct RayQuery
+      {
+         Point3F start;
+         Point3F end;
+
+         /// Object type mask (@see SimObjectTypes).
+         U32 mask;
+      };
+
       /// Test against collision geometry -- fast.
       bool castRay( const Point3F &start, const Point3F &end, U32 mask, RayInfo* info, CastRayCallback callback = NULL );
 
@@ -247,6 +290,24 @@ class SceneContainer
 
       bool collideBox(const Point3F &start, const Point3F &end, U32 mask, RayInfo* info);
 
+      /// Test many rays against collision geometry at once.
+      ///
+      /// Rays are grouped by the bin cell they fall into and each group shares
+      /// a single candidate search.  On the server container, groups are spread
+      /// over the global JobSystem for all objects that report
+      /// SceneObject::isCastRayThreadSafe(); other objects are tested on the
+      /// calling thread.
+      ///
+      /// @param queries Rays to cast.
+      /// @param count Number of rays in @a queries.
+      /// @param outInfos Array receiving one result per ray.  The object of a
+      ///   result is NULL if the ray did not hit anything.
+      /// @return Number of rays that hit something.
+      U32 castRays( const RayQuery* queries, U32 count, RayInfo* outInfos );
+
+      /// If false, castRays() does all its work on the calling thread.
+      static bool smParallelRayCasts;
+
       /// @}
 
       /// @name Poly list
@@ -300,6 +361,9 @@ class SceneContainer
       /// Base cast ray code
       bool _castRay( U32 type, const Point3F &start, const Point3F &end, U32 mask, RayInfo* info, CastRayCallback callback );
 
+      /// Box and frustum queries against #mSpatialIndex.
+      void _findIndexedObjects( const Box3F& box, const Frustum* frustum, U32 mask, FindCallback callback, void* key );
+
       void _findSpecialObjects( const Vector< SceneObject* >& vector, U32 mask, FindCallback, void *key = NULL );
       void _findSpecialObjects( const Vector< SceneObject* >& vector, const Box3F &box, U32 mask, FindCallback callback, void *key = NULL );   
 
@@ -0,0 +1,203 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "scene/sceneInterestGrid.h"
+
+#include "scene/sceneObject.h"
+#include "platform/profiler.h"
+
+
+S32 QSORT_CALLBACK SceneInterestGrid::_compareEntries( const void* a, const void* b )
+{
+   const U32 keyA = reinterpret_cast< const Entry* >( a )->key;
+   const U32 keyB = reinterpret_cast< const Entry* >( b )->key;
+
+   if( keyA < keyB )
+      return -1;
+   else if( keyA > keyB )
+      return 1;
+   return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+SceneInterestGrid::SceneInterestGrid()
+   : mCellSize( 64.0f ),
+     mUpdateTime( 0 ),
+     mDirty( true ),
+     mQuerySequence( 0 )
+{
+   VECTOR_SET_ASSOCIATION( mObjects );
+   VECTOR_SET_ASSOCIATION( mEntries );
+   VECTOR_SET_ASSOCIATION( mOversized );
+   VECTOR_SET_ASSOCIATION( mQueryMarks );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneInterestGrid::setCellSize( F32 size )
+{
+   AssertFatal( size > 0.0f, "SceneInterestGrid::setCellSize - Invalid cell size" );
+
+   if( size != mCellSize )
+   {
+      mCellSize = size;
+      mDirty = true;
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+S32 SceneInterestGrid::_getCell( F32 value ) const
+{
+   return mClamp( S32( mFloor( value / mCellSize ) ), -0x8000, 0x7FFF );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneInterestGrid::_addObjectCallback( SceneObject* object, void* key )
+{
+   if( object->isScopeable() )
+      reinterpret_cast< SceneInterestGrid* >( key )->_addObject( object );
+}
+
+void SceneInterestGrid::_addObject( SceneObject* object )
+{
+   const U32 index = mObjects.size();
+   mObjects.push_back( object );
+
+   if( object->isGlobalBounds() )
+   {
+      mOversized.push_back( index );
+      return;
+   }
+
+   const Box3F& box = object->getWorldBox();
+   const S32 minX = _getCell( box.minExtents.x );
+   const S32 minY = _getCell( box.minExtents.y );
+   const S32 maxX = _getCell( box.maxExtents.x );
+   const S32 maxY = _getCell( box.maxExtents.y );
+
+   if( ( maxX - minX + 1 ) * ( maxY - minY + 1 ) > MaxCellsPerObject )
+   {
+      mOversized.push_back( index );
+      return;
+   }
+
+   for( S32 x = minX; x <= maxX; ++ x )
+      for( S32 y = minY; y <= maxY; ++ y )
+      {
+         Entry entry;
+         entry.key = _getCellKey( x, y );
+         entry.object = index;
+         mEntries.push_back( entry );
+      }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneInterestGrid::rebuild( SceneContainer* container, SimTime time )
+{
+   PROFILE_SCOPE( SceneInterestGrid_rebuild );
+
+   mObjects.clear();
+   mEntries.clear();
+   mOversized.clear();
+
+   container->findObjects( 0xFFFFFFFF, _addObjectCallback, this );
+
+   dQsort( mEntries.address(), mEntries.size(), sizeof( Entry ), _compareEntries );
+
+   mQueryMarks.setSize( mObjects.size() );
+   if( mQueryMarks.size() )
+      dMemset( mQueryMarks.address(), 0, mQueryMarks.memSize() );
+   mQuerySequence = 0;
+
+   mUpdateTime = time;
+   mDirty = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneInterestGrid::findObjects( const Box3F& box, SceneContainer::FindCallback callback, void* key )
+{
+   PROFILE_SCOPE( SceneInterestGrid_findObjects );
+
+   AssertFatal( !mDirty, "SceneInterestGrid::findObjects - Grid must be rebuilt first" );
+
+   // Objects are only reported once per query, so start a new sequence,
+   // and reset the marks in the unlikely case that it wraps.
+
+   if( ++ mQuerySequence == 0 )
+   {
+      if( mQueryMarks.size() )
+         dMemset( mQueryMarks.address(), 0, mQueryMarks.memSize() );
+      mQuerySequence = 1;
+   }
+
+   const S32 minX = _getCell( box.minExtents.x );
+   const S32 minY = _getCell( box.minExtents.y );
+   const S32 maxX = _getCell( box.maxExtents.x );
+   const S32 maxY = _getCell( box.maxExtents.y );
+
+   const Entry* entries = mEntries.address();
+   const U32 numEntries = mEntries.size();
+
+   for( S32 x = minX; x <= maxX; ++ x )
+   {
+      const U32 firstKey = _getCellKey( x, minY );
+      const U32 lastKey = _getCellKey( x, maxY );
+
+      // Find the first entry in this row of cells.
+
+      U32 lo = 0;
+      U32 hi = numEntries;
+      while( lo < hi )
+      {
+         const U32 mid = ( lo + hi ) / 2;
+         if( entries[ mid ].key < firstKey )
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+
+      for( ; lo < numEntries && entries[ lo ].key <= lastKey; ++ lo )
+      {
+         const U32 index = entries[ lo ].object;
+         if( mQueryMarks[ index ] == mQuerySequence )
+            continue;
+         mQueryMarks[ index ] = mQuerySequence;
+
+         SceneObject* object = mObjects[ index ];
+         if( box.isOverlapped( object->getWorldBox() ) )
+            callback( object, key );
+      }
+   }
+
+   for( U32 i = 0; i < mOversized.size(); ++ i )
+   {
+      SceneObject* object = mObjects[ mOversized[ i ] ];
+      if( object->isGlobalBounds() || box.isOverlapped( object->getWorldBox() ) )
+         callback( object, key );
+   }
+}
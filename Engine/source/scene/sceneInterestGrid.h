@@ -0,0 +1,132 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _SCENEINTERESTGRID_H_
+#define _SCENEINTERESTGRID_H_
+
+#ifndef _SCENECONTAINER_H_
+#include "scene/sceneContainer.h"
+#endif
+
+#ifndef _SIM_H_
+#include "console/sim.h"
+#endif
+
+
+/// A uniform 2D grid of the scopeable objects in a scene, shared by all
+/// connections when they determine which objects are in scope.
+///
+/// The grid is rebuilt at most once per server tick, from a single pass
+/// over the container, and then answers the box queries made by
+/// SceneManager::scopeScene() for every client.  Each cell is a contiguous
+/// run in a single sorted entry list, so a query only needs one binary search
+/// per row of cells it touches.
+///
+/// Objects that would cover too many cells, and objects with global bounds,
+/// are kept in a separate list that is tested by every query.
+///
+/// The grid only stores object pointers, so it must be marked dirty whenever
+/// objects are added to or removed from the scene.
+class SceneInterestGrid
+{
+   public:
+
+      enum
+      {
+         /// Objects covering more cells than this are kept in the
+         /// oversized list instead.
+         MaxCellsPerObject = 16,
+      };
+
+   protected:
+
+      struct Entry
+      {
+         /// Packed cell coordinates; see _getCellKey().
+         U32 key;
+
+         /// Index into #mObjects.
+         U32 object;
+      };
+
+      /// Edge length of a cell in world units.
+      F32 mCellSize;
+
+      /// Sim time of the last rebuild.
+      SimTime mUpdateTime;
+
+      /// True if the grid has to be rebuilt before the next query.
+      bool mDirty;
+
+      /// All objects in the grid.
+      Vector< SceneObject* > mObjects;
+
+      /// Cell entries sorted by key.
+      Vector< Entry > mEntries;
+
+      /// Objects in #mObjects that are tested by every query.
+      Vector< U32 > mOversized;
+
+      /// Per object query sequence number used to report objects that
+      /// span several cells only once.
+      Vector< U32 > mQueryMarks;
+      U32 mQuerySequence;
+
+      static S32 QSORT_CALLBACK _compareEntries( const void* a, const void* b );
+      static void _addObjectCallback( SceneObject* object, void* key );
+      void _addObject( SceneObject* object );
+
+      /// Return the cell coordinate of @a value along one axis.
+      S32 _getCell( F32 value ) const;
+
+      static U32 _getCellKey( S32 x, S32 y )
+      {
+         return ( U32( x + 0x8000 ) << 16 ) | U32( y + 0x8000 );
+      }
+
+   public:
+
+      SceneInterestGrid();
+
+      /// Set the edge length of the grid cells.
+      void setCellSize( F32 size );
+
+      F32 getCellSize() const { return mCellSize; }
+
+      /// Force a rebuild before the next query.
+      void markDirty() { mDirty = true; }
+
+      /// Return true if the grid is dirty or was last built before @a time.
+      bool needsUpdate( SimTime time ) const { return mDirty || time != mUpdateTime; }
+
+      /// Rebuild the grid from the scopeable objects in @a container.
+      void rebuild( SceneContainer* container, SimTime time );
+
+      /// Invoke @a callback for every object in the grid whose world box
+      /// overlaps @a box.
+      void findObjects( const Box3F& box, SceneContainer::FindCallback callback, void* key = NULL );
+
+      /// Return the number of objects in the grid.
+      U32 getObjectCount() const { return mObjects.size(); }
+};
+
+#endif // _SCENEINTERESTGRID_H_
@@ -24,6 +24,7 @@
 #include "scene/sceneManager.h"
 
 #include "scene/sceneObject.h"
+#include "scene/sceneInterestGrid.h"
 #include "scene/zones/sceneTraversalState.h"
 #include "scene/sceneRenderState.h"
 #include "scene/zones/sceneRootZone.h"
@@ -36,6 +37,7 @@
 #include "console/engineAPI.h"
 #include "sim/netConnection.h"
 #include "T3D/gameBase/gameConnection.h"
+#include "platform/threads/mutex.h"
 
 // For player object bounds workaround.
 #include "T3D/player.h"
@@ -73,6 +75,16 @@ MODULE_BEGIN( Scene )
          "If true, the bounding boxes of objects will be displayed.\n\n"
          "@ingroup Rendering" );
 
+      Con::addVariable( "$Scene::useInterestGrid", TypeBool, &SceneManager::smUseInterestGrid,
+         "If true, objects are scoped for all connections from a grid that is rebuilt once per tick "
+         "instead of querying the scene container for every connection.\n\n"
+         "@ingroup Networking" );
+
+      Con::addVariable( "$Scene::interestGridCellSize", TypeF32, &SceneManager::smInterestGridCellSize,
+         "Edge length in world units of the cells of the interest grid used for scoping.\n\n"
+         "@see $Scene::useInterestGrid\n"
+         "@ingroup Networking" );
+
       Con::addVariable( "$Scene::maxOccludersPerZone", TypeS32, &SceneCullingState::smMaxOccludersPerZone,
          "Maximum number of occluders that will be concurrently allowed into the scene culling state of any given zone.\n\n"
          "@ingroup Rendering" );
@@ -97,6 +109,9 @@ MODULE_END;
 
 bool SceneManager::smRenderBoundingBoxes;
 bool SceneManager::smLockDiffuseFrustum = false;
+bool SceneManager::smDeferUpdates = false;
+bool SceneManager::smUseInterestGrid = true;
+F32 SceneManager::smInterestGridCellSize = 64.0f;
 SceneCameraState SceneManager::smLockedDiffuseCamera = SceneCameraState( RectI(), Frustum(), MatrixF(), MatrixF() );
 
 SceneManager* gClientSceneGraph = NULL;
@@ -115,7 +130,8 @@ SceneManager::SceneManager( bool isClient )
      mVisibleDistance( 500.f ),
      mNearClip( 0.1f ),
      mAmbientLightColor( ColorF( 0.1f, 0.1f, 0.1f, 1.0f ) ),
-     mZoneManager( NULL )
+     mZoneManager( NULL ),
+     mInterestGrid( NULL )
 {
    VECTOR_SET_ASSOCIATION( mBatchQueryList );
 
@@ -136,6 +152,7 @@ SceneManager::SceneManager( bool isClient )
 SceneManager::~SceneManager()
 {   
    SAFE_DELETE( mZoneManager );
+   SAFE_DELETE( mInterestGrid );
 
    if( mLightManager )
       mLightManager->deactivate();   
@@ -569,7 +586,24 @@ void SceneManager::scopeScene( CameraScopeQuery* query, NetConnection* netConnec
    Box3F area( query->visibleDistance );
    area.setCenter( query->pos );
 
-   getContainer()->findObjects( area, 0xFFFFFFFF, _scopeCallback, &info );
+   if( smUseInterestGrid && smInterestGridCellSize > 0.0f )
+   {
+      // The grid is shared by all connections and only rebuilt
+      // on the first query of each tick.
+
+      if( !mInterestGrid )
+         mInterestGrid = new SceneInterestGrid;
+
+      mInterestGrid->setCellSize( smInterestGridCellSize );
+
+      const SimTime time = Sim::getCurrentTime();
+      if( mInterestGrid->needsUpdate( time ) )
+         mInterestGrid->rebuild( getContainer(), time );
+
+      mInterestGrid->findObjects( area, _scopeCallback, &info );
+   }
+   else
+      getContainer()->findObjects( area, 0xFFFFFFFF, _scopeCallback, &info );
 }
 
 //-----------------------------------------------------------------------------
@@ -596,6 +630,9 @@ bool SceneManager::addObjectToScene( SceneObject* object )
          getZoneManager()->registerObject( object );
    }
 
+   if( mInterestGrid )
+      mInterestGrid->markDirty();
+
    // Notify the object.
 
    return object->onSceneAdd();
@@ -612,6 +649,9 @@ void SceneManager::removeObjectFromScene( SceneObject* obj )
 
    obj->onSceneRemove();
 
+   if( mInterestGrid )
+      mInterestGrid->markDirty();
+
    // Remove the object from the container.
 
    if( getContainer() )
@@ -629,8 +669,29 @@ void SceneManager::removeObjectFromScene( SceneObject* obj )
 
 //-----------------------------------------------------------------------------
 
+// Objects recorded by notifyObjectDirty() while updates are deferred.
+static Mutex sDeferredObjectsMutex;
+static Vector< SceneObject* > sDeferredObjects;
+
+static S32 QSORT_CALLBACK _compareObjectIds( const void* a, const void* b )
+{
+   const SceneObject* objA = *( const SceneObject* const* ) a;
+   const SceneObject* objB = *( const SceneObject* const* ) b;
+
+   return S32( objA->getId() ) - S32( objB->getId() );
+}
+
 void SceneManager::notifyObjectDirty( SceneObject* object )
 {
+   if( smDeferUpdates )
+   {
+      MutexHandle handle;
+      handle.lock( &sDeferredObjectsMutex, true );
+
+      sDeferredObjects.push_back( object );
+      return;
+   }
+
    // Update container state.
 
    if( object->mContainer )
@@ -644,6 +705,46 @@ void SceneManager::notifyObjectDirty( SceneObject* object )
 
 //-----------------------------------------------------------------------------
 
+void SceneManager::beginDeferredUpdates()
+{
+   AssertFatal( !smDeferUpdates, "SceneManager::beginDeferredUpdates - already deferring updates" );
+   smDeferUpdates = true;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneManager::endDeferredUpdates()
+{
+   AssertFatal( smDeferUpdates, "SceneManager::endDeferredUpdates - not deferring updates" );
+   smDeferUpdates = false;
+
+   if( sDeferredObjects.empty() )
+      return;
+
+   PROFILE_SCOPE( SceneManager_endDeferredUpdates );
+
+   // Objects get recorded once for every change so sort them
+   // and only update each one once.
+
+   dQsort( sDeferredObjects.address(), sDeferredObjects.size(), sizeof( SceneObject* ), _compareObjectIds );
+
+   SceneObject* lastObject = NULL;
+   for( U32 i = 0; i < sDeferredObjects.size(); ++ i )
+   {
+      SceneObject* object = sDeferredObjects[ i ];
+      if( object == lastObject )
+         continue;
+
+      lastObject = object;
+      if( object->getSceneManager() )
+         object->getSceneManager()->notifyObjectDirty( object );
+   }
+
+   sDeferredObjects.clear();
+}
+
+//-----------------------------------------------------------------------------
+
 void SceneManager::setDisplayTargetResolution( const Point2I &size )
 {
    mDisplayTargetResolution = size;
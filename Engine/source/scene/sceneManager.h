@@ -66,6 +66,7 @@ class SceneRenderState;
 class SceneCameraState;
 class SceneZoneSpace;
 class NetConnection;
+class SceneInterestGrid;
 class RenderPassManager;
 
 
@@ -117,14 +118,29 @@ class SceneManager
       /// If true, render the AABBs of objects for debugging.
       static bool smRenderBoundingBoxes;
 
+      /// If true, scopeScene() queries the shared interest grid instead
+      /// of the container.
+      static bool smUseInterestGrid;
+
+      /// Edge length of the interest grid cells.
+      static F32 smInterestGridCellSize;
+
    protected:
 
+      /// If true, notifyObjectDirty() only records objects.
+      /// @see beginDeferredUpdates
+      static bool smDeferUpdates;
+
       /// Whether this is the client-side scene.
       bool mIsClient;
 
       /// Manager for the zones in this scene.
       SceneZoneSpaceManager* mZoneManager;
 
+      /// Grid used to scope objects for all connections, created on
+      /// the first call to scopeScene().
+      SceneInterestGrid* mInterestGrid;
+
       // NonClipProjection is the projection matrix without oblique frustum clipping
       // applied to it (in reflections)
       MatrixF mNonClipProj;
@@ -218,8 +234,24 @@ class SceneManager
 
       /// Let the scene manager know that the given object has changed its transform or
       /// sizing state.
+      ///
+      /// @note This may be called on any thread while updates are deferred.
       void notifyObjectDirty( SceneObject* object );
 
+      /// Start deferring the container and zoning updates done by notifyObjectDirty().
+      ///
+      /// This is used while objects are ticked on several threads.  Objects are only
+      /// recorded until endDeferredUpdates() is called.
+      static void beginDeferredUpdates();
+
+      /// Stop deferring and update all objects recorded since beginDeferredUpdates().
+      /// Objects are updated in the order of their IDs so that the resulting container
+      /// state does not depend on thread timing.
+      static void endDeferredUpdates();
+
+      /// Return true if object updates are currently being deferred.
+      static bool isDeferringUpdates() { return smDeferUpdates; }
+
       /// @}
 
       /// @name Rendering
@@ -127,6 +127,8 @@ SceneObject::SceneObject()
    mBinMaxX = 0xFFFFFFFF;
    mBinMinY = 0xFFFFFFFF;
    mBinMaxY = 0xFFFFFFFF;
+   mSpatialIndexNode = NULL;
+   mSpatialIndexSlot = 0;
    mLightPlugin = NULL;
 
    mMount.object = NULL;
@@ -146,7 +148,7 @@ SceneObject::SceneObject()
 
 SceneObject::~SceneObject()
 {
-   AssertFatal( mZoneRefHead == NULL && mBinRefHead == NULL,
+   AssertFatal( mZoneRefHead == NULL && mBinRefHead == NULL && mSpatialIndexNode == NULL,
       "SceneObject::~SceneObject - Object still linked in reference lists!");
    AssertFatal( !mSceneObjectLinks,
       "SceneObject::~SceneObject() - object is still linked to SceneTrackers" );
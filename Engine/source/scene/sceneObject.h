@@ -62,6 +62,7 @@ class SceneObjectLightingPlugin;
 class Convex;
 class LightInfo;
 class SFXAmbience;
+class TSAnimBatch;
 
 struct ObjectRenderInst;
 struct Move;
@@ -98,6 +99,7 @@ class SceneObject : public NetObject, private SceneContainer::Link, public Proce
 
       friend class SceneManager;
       friend class SceneContainer;
+      friend class SceneLooseOctree; // mSpatialIndexNode
       friend class SceneZoneSpaceManager;
       friend class SceneCullingState; // _getZoneRefHead
       friend class SceneObjectLink; // mSceneObjectLinks
@@ -345,6 +347,11 @@ class SceneObject : public NetObject, private SceneContainer::Link, public Proce
       U32 mBinMinY;
       U32 mBinMaxY;
 
+      /// Placement of the object in the container's SceneSpatialIndex if
+      /// the container uses one instead of its bin grid.
+      void* mSpatialIndexNode;
+      U32 mSpatialIndexSlot;
+
       /// Returns the container sequence key.
       U32 getContainerSeqKey() const { return mContainerSeqKey; }
 
@@ -544,6 +551,13 @@ class SceneObject : public NetObject, private SceneContainer::Link, public Proce
       /// @param   info   Collision information obtained (out)
       virtual bool castRay( const Point3F& start, const Point3F& end, RayInfo* info ) { return false; }
 
+      /// Returns true if castRay() only reads object state and may thus be called
+      /// from several threads at once.
+      ///
+      /// SceneContainer::castRays() only tests objects that return true here on
+      /// worker threads; everything else is tested on the calling thread.
+      virtual bool isCastRayThreadSafe() const { return false; }
+
       /// Casts a ray against rendered geometry, returns true if RayInfo is modified.
       ///
       /// @param   start   Start point of ray
@@ -692,6 +706,13 @@ class SceneObject : public NetObject, private SceneContainer::Link, public Proce
       /// @param state Rendering state.
       virtual void prepRenderImage( SceneRenderState* state ) {}
 
+      /// Called before prepRenderImage() on all the objects being rendered
+      /// to let animated shapes queue their shape instances in @a batch.
+      /// The batch is animated before any prepRenderImage() call.
+      /// @param state Rendering state.
+      /// @param batch Batch to add shape instances to.
+      virtual void prepBatchAnimation( SceneRenderState* state, TSAnimBatch* batch ) {}
+
       /// @}
 
       /// @name Lighting
@@ -25,6 +25,7 @@
 
 #include "renderInstance/renderPassManager.h"
 #include "math/util/matrixSet.h"
+#include "ts/tsAnimBatch.h"
 
 
 
@@ -94,16 +95,40 @@ const MatrixF& SceneRenderState::getProjectionMatrix() const
 
 //-----------------------------------------------------------------------------
 
+SceneRenderState::PrepRenderImagesSignal& SceneRenderState::getPrepRenderImagesSignal()
+{
+   static PrepRenderImagesSignal theSignal;
+   return theSignal;
+}
+
+//-----------------------------------------------------------------------------
+
 void SceneRenderState::renderObjects( SceneObject** objects, U32 numObjects )
 {
+   // Animate the shapes of the objects together.  The batch is always
+   // empty again before prepRenderImage() is called, so nested renders
+   // can share it.
+
+   if( TSAnimBatch::smEnabled )
+   {
+      PROFILE_SCOPE( SceneRenderState_batchAnimation );
+
+      static TSAnimBatch sAnimBatch;
+      for( U32 i = 0; i < numObjects; ++ i )
+         objects[ i ]->prepBatchAnimation( this, &sAnimBatch );
+      sAnimBatch.animate();
+   }
+
    // Let the objects batch their stuff.
 
    PROFILE_START( SceneRenderState_prepRenderImages );
+   getPrepRenderImagesSignal().trigger( this, true );
    for( U32 i = 0; i < numObjects; ++ i )
    {
       SceneObject* object = objects[ i ];
       object->prepRenderImage( this );
    }
+   getPrepRenderImagesSignal().trigger( this, false );
    PROFILE_END();
 
    // Render what the objects have batched.
@@ -61,6 +61,14 @@ class SceneRenderState
       /// @see getOverrideMaterial
       typedef Delegate< BaseMatInstance*( BaseMatInstance* ) > MatDelegate;
 
+      /// Signal triggered by renderObjects() before (@a begin is true) and
+      /// after the objects have batched their render instances.  Lets work
+      /// queued while batching be finished before the instances render.
+      typedef Signal< void( SceneRenderState* state, bool begin ) > PrepRenderImagesSignal;
+
+      /// @see PrepRenderImagesSignal
+      static PrepRenderImagesSignal& getPrepRenderImagesSignal();
+
    protected:
 
       /// SceneManager being rendered in this state.
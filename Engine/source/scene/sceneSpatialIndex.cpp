@@ -0,0 +1,335 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "scene/sceneSpatialIndex.h"
+
+#include "scene/sceneObject.h"
+#include "platform/profiler.h"
+
+
+//=============================================================================
+//    SceneLooseOctree.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+
+SceneLooseOctree::SceneLooseOctree( const Box3F& bounds, U32 maxDepth )
+   : mMaxDepth( getMin( maxDepth, U32( MaxDepth ) ) ),
+     mNumNodes( 0 ),
+     mNumObjects( 0 )
+{
+   AssertFatal( bounds.isValidBox(), "SceneLooseOctree - Invalid bounds!" );
+
+   const F32 halfSize = getMax( bounds.len_max() * 0.5f, 1.0f );
+
+   mRoot = _allocNode( NULL, 0, bounds.getCenter(), halfSize );
+   mOverflow = _allocNode( NULL, 0, bounds.getCenter(), halfSize );
+}
+
+//-----------------------------------------------------------------------------
+
+SceneLooseOctree::~SceneLooseOctree()
+{
+   AssertWarn( mNumObjects == 0, "SceneLooseOctree - Deleting tree that still has objects in it!" );
+
+   _freeNode( mRoot );
+   _freeNode( mOverflow );
+}
+
+//-----------------------------------------------------------------------------
+
+SceneLooseOctree::Node* SceneLooseOctree::_allocNode( Node* parent, U32 childIndex, const Point3F& center, F32 halfSize )
+{
+   Node* node = mNodeAllocator.alloc();
+
+   node->parent = parent;
+   node->childIndex = childIndex;
+   node->numChildren = 0;
+   node->depth = parent ? parent->depth + 1 : 0;
+   node->center = center;
+   node->halfSize = halfSize;
+
+   const F32 looseHalfSize = halfSize * 2.0f;
+   node->looseBox.minExtents = center - Point3F( looseHalfSize, looseHalfSize, looseHalfSize );
+   node->looseBox.maxExtents = center + Point3F( looseHalfSize, looseHalfSize, looseHalfSize );
+
+   for( U32 i = 0; i < 8; ++ i )
+      node->children[ i ] = NULL;
+
+   mNumNodes ++;
+   return node;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneLooseOctree::_freeNode( Node* node )
+{
+   for( U32 i = 0; i < 8; ++ i )
+      if( node->children[ i ] )
+         _freeNode( node->children[ i ] );
+
+   // Don't leave dangling references behind in objects that are still in here.
+   for( U32 i = 0; i < node->objects.size(); ++ i )
+      node->objects[ i ]->mSpatialIndexNode = NULL;
+
+   mNumObjects -= node->objects.size();
+   mNumNodes --;
+   mNodeAllocator.free( node );
+}
+
+//-----------------------------------------------------------------------------
+
+U32 SceneLooseOctree::_getTargetDepth( const Box3F& box ) const
+{
+   const F32 extent = box.len_max();
+
+   // Descend for as long as the object still fits into a child cell.
+   U32 depth = 0;
+   F32 childSize = mRoot->halfSize;
+   while( depth < mMaxDepth && extent <= childSize )
+   {
+      depth ++;
+      childSize *= 0.5f;
+   }
+
+   return depth;
+}
+
+//-----------------------------------------------------------------------------
+
+bool SceneLooseOctree::_isOverflowObject( SceneObject* object ) const
+{
+   if( object->isGlobalBounds() )
+      return true;
+
+   const Box3F& box = object->getWorldBox();
+   if( box.len_max() > mRoot->halfSize * 2.0f )
+      return true;
+
+   const Point3F center = box.getCenter();
+   const Point3F offset = center - mRoot->center;
+
+   return (    mFabs( offset.x ) > mRoot->halfSize
+            || mFabs( offset.y ) > mRoot->halfSize
+            || mFabs( offset.z ) > mRoot->halfSize );
+}
+
+//-----------------------------------------------------------------------------
+
+SceneLooseOctree::Node* SceneLooseOctree::_findTargetNode( SceneObject* object, bool create )
+{
+   if( _isOverflowObject( object ) )
+      return mOverflow;
+
+   const Box3F& box = object->getWorldBox();
+   const Point3F center = box.getCenter();
+   const U32 targetDepth = _getTargetDepth( box );
+
+   Node* node = mRoot;
+   while( node->depth < targetDepth )
+   {
+      U32 index = 0;
+      if( center.x >= node->center.x ) index |= 1;
+      if( center.y >= node->center.y ) index |= 2;
+      if( center.z >= node->center.z ) index |= 4;
+
+      Node* child = node->children[ index ];
+      if( !child )
+      {
+         if( !create )
+            return NULL;
+
+         const F32 childHalfSize = node->halfSize * 0.5f;
+         Point3F childCenter = node->center;
+         childCenter.x += ( index & 1 ) ? childHalfSize : -childHalfSize;
+         childCenter.y += ( index & 2 ) ? childHalfSize : -childHalfSize;
+         childCenter.z += ( index & 4 ) ? childHalfSize : -childHalfSize;
+
+         child = _allocNode( node, index, childCenter, childHalfSize );
+         node->children[ index ] = child;
+         node->numChildren ++;
+      }
+
+      node = child;
+   }
+
+   return node;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneLooseOctree::_addToNode( Node* node, SceneObject* object )
+{
+   object->mSpatialIndexNode = node;
+   object->mSpatialIndexSlot = node->objects.size();
+   node->objects.push_back( object );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneLooseOctree::_removeFromNode( SceneObject* object )
+{
+   Node* node = reinterpret_cast< Node* >( object->mSpatialIndexNode );
+   const U32 slot = object->mSpatialIndexSlot;
+
+   AssertFatal( slot < node->objects.size() && node->objects[ slot ] == object,
+      "SceneLooseOctree::_removeFromNode - Object is not in its node!" );
+
+   // Swap the last object into the vacated slot.
+   SceneObject* last = node->objects.last();
+   node->objects[ slot ] = last;
+   last->mSpatialIndexSlot = slot;
+   node->objects.pop_back();
+
+   object->mSpatialIndexNode = NULL;
+   object->mSpatialIndexSlot = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneLooseOctree::_pruneNode( Node* node )
+{
+   while( node != mRoot && node != mOverflow &&
+          node->objects.empty() && node->numChildren == 0 )
+   {
+      Node* parent = node->parent;
+      parent->children[ node->childIndex ] = NULL;
+      parent->numChildren --;
+
+      mNumNodes --;
+      mNodeAllocator.free( node );
+
+      node = parent;
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneLooseOctree::insertObject( SceneObject* object )
+{
+   AssertFatal( object->mSpatialIndexNode == NULL, "SceneLooseOctree::insertObject - Object already in an index!" );
+
+   _addToNode( _findTargetNode( object, true ), object );
+   mNumObjects ++;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneLooseOctree::removeObject( SceneObject* object )
+{
+   Node* node = reinterpret_cast< Node* >( object->mSpatialIndexNode );
+   if( !node )
+      return;
+
+   _removeFromNode( object );
+   _pruneNode( node );
+   mNumObjects --;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneLooseOctree::updateObject( SceneObject* object )
+{
+   PROFILE_SCOPE( SceneLooseOctree_updateObject );
+
+   Node* node = reinterpret_cast< Node* >( object->mSpatialIndexNode );
+   if( !node )
+   {
+      insertObject( object );
+      return;
+   }
+
+   // Most moves stay within the same cell so check that without
+   // touching the tree.
+   if( node == mOverflow )
+   {
+      if( _isOverflowObject( object ) )
+         return;
+   }
+   else if( !_isOverflowObject( object ) )
+   {
+      const Box3F& box = object->getWorldBox();
+      const Point3F offset = box.getCenter() - node->center;
+
+      if(    node->depth == _getTargetDepth( box )
+          && mFabs( offset.x ) <= node->halfSize
+          && mFabs( offset.y ) <= node->halfSize
+          && mFabs( offset.z ) <= node->halfSize )
+         return;
+   }
+
+   // Insert before pruning so we don't release nodes we are about to reuse.
+   _removeFromNode( object );
+   _addToNode( _findTargetNode( object, true ), object );
+   _pruneNode( node );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneLooseOctree::findCandidates( const Box3F& box, Vector< SceneObject* >& outCandidates )
+{
+   PROFILE_SCOPE( SceneLooseOctree_findCandidates );
+
+   outCandidates.merge( mOverflow->objects );
+   _findCandidates( mRoot, box, outCandidates );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneLooseOctree::_findCandidates( Node* node, const Box3F& box, Vector< SceneObject* >& outCandidates ) const
+{
+   if( !node->looseBox.isOverlapped( box ) )
+      return;
+
+   outCandidates.merge( node->objects );
+
+   if( node->numChildren )
+      for( U32 i = 0; i < 8; ++ i )
+         if( node->children[ i ] )
+            _findCandidates( node->children[ i ], box, outCandidates );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneLooseOctree::findRayCandidates( const Point3F& start, const Point3F& end, Vector< SceneObject* >& outCandidates )
+{
+   PROFILE_SCOPE( SceneLooseOctree_findRayCandidates );
+
+   outCandidates.merge( mOverflow->objects );
+   _findRayCandidates( mRoot, start, end, outCandidates );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneLooseOctree::_findRayCandidates( Node* node, const Point3F& start, const Point3F& end, Vector< SceneObject* >& outCandidates ) const
+{
+   if( !node->looseBox.collideLine( start, end ) )
+      return;
+
+   outCandidates.merge( node->objects );
+
+   if( node->numChildren )
+      for( U32 i = 0; i < 8; ++ i )
+         if( node->children[ i ] )
+            _findRayCandidates( node->children[ i ], start, end, outCandidates );
+}
@@ -0,0 +1,195 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _SCENESPATIALINDEX_H_
+#define _SCENESPATIALINDEX_H_
+
+#ifndef _MBOX_H_
+#include "math/mBox.h"
+#endif
+
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+
+#ifndef _DATACHUNKER_H_
+#include "core/dataChunker.h"
+#endif
+
+
+/// @file
+/// Alternative spatial backends for SceneContainer.
+
+
+class SceneObject;
+
+
+/// Interface for a spatial database that can replace the default bin grid
+/// of a SceneContainer.
+///
+/// A spatial index only needs to return conservative candidate sets; the
+/// container performs the exact type mask, collision and bounds tests itself.
+///
+/// Each object may store its index placement in SceneObject::mSpatialIndexNode
+/// and SceneObject::mSpatialIndexSlot.
+///
+/// @see SceneContainer::setSpatialIndex
+class SceneSpatialIndex
+{
+   public:
+
+      virtual ~SceneSpatialIndex() {}
+
+      /// Return the name of this index type as used by the console.
+      virtual const char* getTypeName() const = 0;
+
+      /// Add an object to the index.
+      virtual void insertObject( SceneObject* object ) = 0;
+
+      /// Remove an object from the index.
+      virtual void removeObject( SceneObject* object ) = 0;
+
+      /// Called when the world box of an object that is already
+      /// in the index has changed.
+      virtual void updateObject( SceneObject* object ) = 0;
+
+      /// Append all objects that may overlap @a box to @a outCandidates.
+      virtual void findCandidates( const Box3F& box, Vector< SceneObject* >& outCandidates ) = 0;
+
+      /// Append all objects that may intersect the line segment from @a start to @a end
+      /// to @a outCandidates.
+      virtual void findRayCandidates( const Point3F& start, const Point3F& end, Vector< SceneObject* >& outCandidates ) = 0;
+};
+
+
+//----------------------------------------------------------------------------
+
+/// A loose octree.
+///
+/// Every object lives in exactly one node: the deepest node whose cell is at
+/// least as large as the object's largest extent and that contains the object's
+/// center.  Node bounds are loosened to twice the cell size so that such an
+/// object always fits inside its node's loose bounds.  Nodes are created on demand
+/// and pruned again when they become empty.
+///
+/// Objects with global bounds or with their center outside of the root cell are
+/// kept in a separate overflow list that is returned for every query, so the
+/// root bounds should be sized to cover the playable area (e.g. the mission area).
+class SceneLooseOctree : public SceneSpatialIndex
+{
+   public:
+
+      enum
+      {
+         /// Default maximum depth of the tree.
+         DefaultMaxDepth = 8,
+
+         /// Hard limit on the depth of the tree.
+         MaxDepth = 16,
+      };
+
+   protected:
+
+      struct Node
+      {
+         Node* parent;
+         Node* children[ 8 ];
+
+         /// Index of this node in its parent's #children.
+         U32 childIndex;
+
+         /// Number of non-NULL #children.
+         U32 numChildren;
+
+         U32 depth;
+
+         /// Center of the node's cell.
+         Point3F center;
+
+         /// Half the edge length of the node's cell.
+         F32 halfSize;
+
+         /// Cell bounds enlarged by the loose factor.
+         Box3F looseBox;
+
+         /// Objects that are stored in this node.
+         Vector< SceneObject* > objects;
+      };
+
+      Node* mRoot;
+
+      /// Objects that don't fit into the tree.
+      Node* mOverflow;
+
+      U32 mMaxDepth;
+
+      U32 mNumNodes;
+      U32 mNumObjects;
+
+      ClassChunker< Node > mNodeAllocator;
+
+      Node* _allocNode( Node* parent, U32 childIndex, const Point3F& center, F32 halfSize );
+      void _freeNode( Node* node );
+
+      /// Return the node that @a object should be stored in.
+      Node* _findTargetNode( SceneObject* object, bool create );
+
+      /// Return the tree depth at which an object with the given extents belongs.
+      U32 _getTargetDepth( const Box3F& box ) const;
+
+      /// Returns true if an object should be stored in the overflow list.
+      bool _isOverflowObject( SceneObject* object ) const;
+
+      void _addToNode( Node* node, SceneObject* object );
+      void _removeFromNode( SceneObject* object );
+
+      /// Release empty nodes going up from @a node.
+      void _pruneNode( Node* node );
+
+      void _findCandidates( Node* node, const Box3F& box, Vector< SceneObject* >& outCandidates ) const;
+      void _findRayCandidates( Node* node, const Point3F& start, const Point3F& end, Vector< SceneObject* >& outCandidates ) const;
+
+   public:
+
+      /// Create a loose octree whose root cell is the cube enclosing @a bounds.
+      SceneLooseOctree( const Box3F& bounds, U32 maxDepth = DefaultMaxDepth );
+      virtual ~SceneLooseOctree();
+
+      /// Return the number of nodes currently allocated in the tree.
+      U32 getNumNodes() const { return mNumNodes; }
+
+      /// Return the number of objects in the tree including the overflow list.
+      U32 getNumObjects() const { return mNumObjects; }
+
+      /// Return the number of objects that did not fit into the tree.
+      U32 getNumOverflowObjects() const { return mOverflow->objects.size(); }
+
+      // SceneSpatialIndex.
+      virtual const char* getTypeName() const { return "octree"; }
+      virtual void insertObject( SceneObject* object );
+      virtual void removeObject( SceneObject* object );
+      virtual void updateObject( SceneObject* object );
+      virtual void findCandidates( const Box3F& box, Vector< SceneObject* >& outCandidates );
+      virtual void findRayCandidates( const Point3F& start, const Point3F& end, Vector< SceneObject* >& outCandidates );
+};
+
+#endif // !_SCENESPATIALINDEX_H_
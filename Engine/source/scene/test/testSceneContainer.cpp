@@ -0,0 +1,219 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "scene/sceneContainer.h"
+#include "scene/sceneObject.h"
+#include "scene/sceneSpatialIndex.h"
+#include "collision/collision.h"
+#include "console/console.h"
+#include "core/util/tVector.h"
+#include "math/mRandom.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Compares query results and throughput of the default bin grid and the
+// loose octree on a synthetic scene.
+
+CreateUnitTest( TestSceneContainerSpatialIndex, "Scene/SceneContainer/SpatialIndex" )
+{
+   enum
+   {
+      DEFAULT_NUM_OBJECTS = 50000,
+      DEFAULT_NUM_QUERIES = 2000,
+   };
+
+   /// Static box that collides rays against its object box.
+   struct TestObject : public SceneObject
+   {
+      TestObject( const Point3F& pos, F32 size )
+      {
+         mTypeMask = StaticObjectType;
+         mObjBox.minExtents.set( -size, -size, -size );
+         mObjBox.maxExtents.set( size, size, size );
+
+         MatrixF mat( true );
+         mat.setPosition( pos );
+         setTransform( mat );
+      }
+
+      virtual bool castRay( const Point3F& start, const Point3F& end, RayInfo* info )
+      {
+         if( !mObjBox.collideLine( start, end, &info->t, &info->normal ) )
+            return false;
+
+         info->object = this;
+         return true;
+      }
+   };
+
+   static void countCallback( SceneObject* object, void* key )
+   {
+      ( *reinterpret_cast< U32* >( key ) ) ++;
+   }
+
+   struct Results
+   {
+      U32 numFound;
+      U32 numHits;
+      U32 boxTime;
+      U32 rayTime;
+   };
+
+   Vector< Box3F > mBoxes;
+   Vector< Point3F > mRayStarts;
+   Vector< Point3F > mRayEnds;
+
+   void runQueries( SceneContainer& container, Results& results )
+   {
+      results.numFound = 0;
+      results.numHits = 0;
+
+      U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < mBoxes.size(); ++ i )
+         container.findObjects( mBoxes[ i ], StaticObjectType, countCallback, &results.numFound );
+      results.boxTime = Platform::getRealMilliseconds() - start;
+
+      start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < mRayStarts.size(); ++ i )
+      {
+         RayInfo info;
+         if( container.castRay( mRayStarts[ i ], mRayEnds[ i ], StaticObjectType, &info ) )
+            results.numHits ++;
+      }
+      results.rayTime = Platform::getRealMilliseconds() - start;
+   }
+
+   void run()
+   {
+      const U32 numObjects = Con::getIntVariable( "$testSceneContainer::numObjects", DEFAULT_NUM_OBJECTS );
+      const U32 numQueries = Con::getIntVariable( "$testSceneContainer::numQueries", DEFAULT_NUM_QUERIES );
+      const F32 worldSize = 8192.0f;
+
+      MRandomLCG rand( 1376312589 );
+
+      SceneContainer* container = new SceneContainer;
+      Vector< TestObject* > objects;
+
+      for( U32 i = 0; i < numObjects; ++ i )
+      {
+         Point3F pos( rand.randF( -worldSize, worldSize ) * 0.5f,
+                      rand.randF( -worldSize, worldSize ) * 0.5f,
+                      rand.randF( 0.0f, 200.0f ) );
+
+         TestObject* object = new TestObject( pos, rand.randF( 0.5f, 4.0f ) );
+         container->addObject( object );
+         objects.push_back( object );
+      }
+
+      for( U32 i = 0; i < numQueries; ++ i )
+      {
+         Point3F center( rand.randF( -worldSize, worldSize ) * 0.5f,
+                         rand.randF( -worldSize, worldSize ) * 0.5f,
+                         100.0f );
+         mBoxes.push_back( Box3F( center - Point3F( 32, 32, 100 ), center + Point3F( 32, 32, 100 ) ) );
+
+         Point3F dir( rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ), rand.randF( -0.2f, 0.2f ) );
+         dir.normalizeSafe();
+         mRayStarts.push_back( center );
+         mRayEnds.push_back( center + dir * 200.0f );
+      }
+
+      Results gridResults;
+      runQueries( *container, gridResults );
+
+      // The batched path must agree with individual casts.
+      Vector< SceneContainer::RayQuery > rays;
+      Vector< RayInfo > rayInfos;
+      rays.setSize( numQueries );
+      rayInfos.setSize( numQueries );
+      for( U32 i = 0; i < numQueries; ++ i )
+      {
+         rays[ i ].start = mRayStarts[ i ];
+         rays[ i ].end = mRayEnds[ i ];
+         rays[ i ].mask = StaticObjectType;
+      }
+
+      U32 start = Platform::getRealMilliseconds();
+      const U32 numBatchedHits = container->castRays( rays.address(), numQueries, rayInfos.address() );
+      const U32 batchedTime = Platform::getRealMilliseconds() - start;
+
+      TEST( numBatchedHits == gridResults.numHits );
+      for( U32 i = 0; i < numQueries; ++ i )
+      {
+         RayInfo info;
+         if( container->castRay( mRayStarts[ i ], mRayEnds[ i ], StaticObjectType, &info ) )
+            TEST( rayInfos[ i ].object == info.object && mFabs( rayInfos[ i ].t - info.t ) < 0.0001f );
+         else
+            TEST( rayInfos[ i ].object == NULL );
+      }
+
+      container->setSpatialIndex( new SceneLooseOctree( container->getObjectBounds() ) );
+      TEST( container->getSpatialIndex() != NULL );
+
+      Results octreeResults;
+      runQueries( *container, octreeResults );
+
+      // Both backends must find exactly the same objects.
+      TEST( gridResults.numFound == octreeResults.numFound );
+      TEST( gridResults.numHits == octreeResults.numHits );
+
+      // Move everything around and make sure the octree keeps up.
+      for( U32 i = 0; i < objects.size(); ++ i )
+      {
+         MatrixF mat( true );
+         mat.setPosition( objects[ i ]->getPosition() + Point3F( rand.randF( -50.0f, 50.0f ), rand.randF( -50.0f, 50.0f ), 0.0f ) );
+         objects[ i ]->setTransform( mat );
+         container->checkBins( objects[ i ] );
+      }
+
+      runQueries( *container, octreeResults );
+      container->setSpatialIndex( NULL );
+      runQueries( *container, gridResults );
+
+      TEST( gridResults.numFound == octreeResults.numFound );
+      TEST( gridResults.numHits == octreeResults.numHits );
+
+      Con::printf( "SceneContainer: %d objects, %d box queries, %d rays", numObjects, numQueries, numQueries );
+      Con::printf( "   grid:   boxes %dms, rays %dms", gridResults.boxTime, gridResults.rayTime );
+      Con::printf( "   octree: boxes %dms, rays %dms", octreeResults.boxTime, octreeResults.rayTime );
+      Con::printf( "   batched rays (grid): %dms", batchedTime );
+
+      for( U32 i = 0; i < objects.size(); ++ i )
+      {
+         container->removeObject( objects[ i ] );
+         delete objects[ i ];
+      }
+
+      delete container;
+
+      mBoxes.clear();
+      mRayStarts.clear();
+      mRayEnds.clear();
+   }
+};
+
+#endif // !TORQUE_SHIPPING
@@ -0,0 +1,175 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "scene/sceneInterestGrid.h"
+#include "scene/sceneObject.h"
+#include "console/console.h"
+#include "core/util/tVector.h"
+#include "math/mRandom.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Checks that the interest grid finds the same objects as the container
+// and compares the cost of scoping many clients against both.
+
+CreateUnitTest( TestSceneInterestGrid, "Scene/SceneInterestGrid" )
+{
+   enum
+   {
+      DEFAULT_NUM_OBJECTS = 20000,
+      DEFAULT_NUM_CLIENTS = 256,
+   };
+
+   struct TestObject : public SceneObject
+   {
+      U32 mIndex;
+
+      TestObject( U32 index, const Point3F& pos, F32 size )
+         : mIndex( index )
+      {
+         mTypeMask = StaticObjectType;
+         mNetFlags.set( Ghostable );
+         mObjBox.minExtents.set( -size, -size, -size );
+         mObjBox.maxExtents.set( size, size, size );
+
+         MatrixF mat( true );
+         mat.setPosition( pos );
+         setTransform( mat );
+      }
+   };
+
+   struct Results
+   {
+      U32 numFound;
+      U32 indexSum;
+   };
+
+   static void collectCallback( SceneObject* object, void* key )
+   {
+      Results* results = reinterpret_cast< Results* >( key );
+      results->numFound ++;
+      results->indexSum += static_cast< TestObject* >( object )->mIndex;
+   }
+
+   void run()
+   {
+      const U32 numObjects = Con::getIntVariable( "$testSceneInterestGrid::numObjects", DEFAULT_NUM_OBJECTS );
+      const U32 numClients = Con::getIntVariable( "$testSceneInterestGrid::numClients", DEFAULT_NUM_CLIENTS );
+      const F32 worldSize = 4096.0f;
+      const F32 visibleDistance = 500.0f;
+
+      MRandomLCG rand( 2147001325 );
+
+      SceneContainer* container = new SceneContainer;
+      Vector< TestObject* > objects;
+
+      for( U32 i = 0; i < numObjects; ++ i )
+      {
+         Point3F pos( rand.randF( -worldSize, worldSize ) * 0.5f,
+                      rand.randF( -worldSize, worldSize ) * 0.5f,
+                      rand.randF( 0.0f, 200.0f ) );
+
+         // Mostly small objects plus a few that end up in the oversized list.
+         const F32 size = ( i % 100 ) ? rand.randF( 0.5f, 40.0f ) : rand.randF( 100.0f, 400.0f );
+
+         TestObject* object = new TestObject( i, pos, size );
+         container->addObject( object );
+         objects.push_back( object );
+      }
+
+      // Clients are clustered around a few hot spots, as they tend to be.
+      Vector< Box3F > areas;
+      for( U32 i = 0; i < numClients; ++ i )
+      {
+         const F32 spot = F32( i % 4 ) * worldSize * 0.2f - worldSize * 0.3f;
+         Point3F pos( spot + rand.randF( -200.0f, 200.0f ), spot + rand.randF( -200.0f, 200.0f ), 100.0f );
+
+         Box3F area( visibleDistance );
+         area.setCenter( pos );
+         areas.push_back( area );
+      }
+
+      SceneInterestGrid grid;
+      grid.setCellSize( 64.0f );
+      TEST( grid.needsUpdate( 0 ) );
+
+      U32 start = Platform::getRealMilliseconds();
+      grid.rebuild( container, 0 );
+      const U32 rebuildTime = Platform::getRealMilliseconds() - start;
+
+      TEST( !grid.needsUpdate( 0 ) );
+      TEST( grid.needsUpdate( 32 ) );
+      TEST( grid.getObjectCount() == numObjects );
+
+      Vector< Results > containerResults;
+      containerResults.setSize( numClients );
+
+      start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < numClients; ++ i )
+      {
+         containerResults[ i ].numFound = 0;
+         containerResults[ i ].indexSum = 0;
+         container->findObjects( areas[ i ], 0xFFFFFFFF, collectCallback, &containerResults[ i ] );
+      }
+      const U32 containerTime = Platform::getRealMilliseconds() - start;
+
+      Vector< Results > gridResults;
+      gridResults.setSize( numClients );
+
+      start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < numClients; ++ i )
+      {
+         gridResults[ i ].numFound = 0;
+         gridResults[ i ].indexSum = 0;
+         grid.findObjects( areas[ i ], collectCallback, &gridResults[ i ] );
+      }
+      const U32 gridTime = Platform::getRealMilliseconds() - start;
+
+      for( U32 i = 0; i < numClients; ++ i )
+      {
+         TEST( gridResults[ i ].numFound == containerResults[ i ].numFound );
+         TEST( gridResults[ i ].indexSum == containerResults[ i ].indexSum );
+      }
+
+      grid.markDirty();
+      TEST( grid.needsUpdate( 0 ) );
+
+      Con::printf( "SceneInterestGrid: %d objects, %d clients", numObjects, numClients );
+      Con::printf( "   container: %dms", containerTime );
+      Con::printf( "   grid:      %dms (+%dms rebuild)", gridTime, rebuildTime );
+
+      for( U32 i = 0; i < objects.size(); ++ i )
+      {
+         container->removeObject( objects[ i ] );
+         delete objects[ i ];
+      }
+
+      delete container;
+   }
+};
+
+#endif // !TORQUE_SHIPPING
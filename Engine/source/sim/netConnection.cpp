@@ -26,6 +26,9 @@
 #include "sim/netConnection.h"
 #include "core/stream/bitStream.h"
 #include "core/stream/fileStream.h"
+#include "core/stream/packetCoder.h"
+#include "sim/netDemoStream.h"
+#include "platform/profiler.h"
 #ifndef TORQUE_TGB_ONLY
 #include "scene/pathManager.h"
 #endif
@@ -278,6 +281,51 @@ void NetConnection::consoleInit()
 
       "@ingroup Networking");
 
+   Con::addVariable("$Net::ghostPriorityRefresh", TypeS32, &smGhostPriorityRefresh,
+      "@brief Number of packets a ghost keeps its cached update priority.\n\n"
+
+      "Ghost update priorities are recomputed when a ghost gets dirty or has been sent.  Ghosts "
+      "that stay dirty without being sent reuse their priority for this many packets before it is "
+      "recomputed.  A value of 1 recomputes all priorities on every packet.  The default value is 4.\n\n"
+
+      "@ingroup Networking");
+
+   Con::addVariable("$Net::ghostSnapshotDeltas", TypeBool, &smGhostSnapshotDeltas,
+      "@brief If true, ghost updates are sent as deltas against the last acknowledged update.\n\n"
+
+      "The server keeps the last packed update each client acknowledged for every ghost and sends "
+      "new updates as a bitwise difference against it whenever that is smaller.  This saves bandwidth "
+      "for slowly changing objects at the cost of some memory and CPU time on both ends.  Only needs "
+      "to be set on the server.  The default value is false.\n\n"
+
+      "@ingroup Networking");
+
+   Con::addVariable("$Net::compressPackets", TypeBool, &smCompressPackets,
+      "@brief If true, new connections entropy code the packets they send.\n\n"
+
+      "The packet payload is run through an adaptive range coder and sent coded whenever that is "
+      "smaller.  Receivers handle both forms, so this only affects the sending side.  Use "
+      "NetConnection::setPacketCompression() to change it for a single connection.  The default "
+      "value is false.\n\n"
+
+      "@ingroup Networking");
+
+   Con::addVariable("$Net::demoKeyframeInterval", TypeS32, &smDemoKeyframeInterval,
+      "@brief Number of ticks between seek keyframes in recorded demos.\n\n"
+
+      "Every keyframe stores the full state of the connection, so that playback can jump to it "
+      "without replaying the demo from the start.  Smaller values make seeking cheaper and demo "
+      "files larger.  A value of 0 records no keyframes.  The default value is 1000.\n\n"
+
+      "@ingroup Networking");
+
+   Con::addVariable("$Net::demoCompression", TypeBool, &smDemoCompression,
+      "@brief If true, recorded demo data is compressed.\n\n"
+
+      "Compression happens on the thread writing the demo file.  The default value is true.\n\n"
+
+      "@ingroup Networking");
+
    Con::addVariable("$Stats::netBitsSent", TypeS32, &gNetBitsSent,
       "@brief The number of bytes sent during the last packet send operation.\n\n"
 
@@ -363,12 +411,15 @@ NetConnection::NetConnection()
 
    mSimulatedPing = 0;
    mSimulatedPacketLoss = 0;
+   mCompressPackets = smCompressPackets;
 #ifdef TORQUE_DEBUG_NET
    mLogging = false;
 #endif
    mEstablished = false;
    mLastUpdateTime = 0;
    mRoundTripTime = 0;
+   mBytesSent = 0;
+   mBytesReceived = 0;
    mPacketLoss = 0;
    mNextTableHash = NULL;
    mSendDelayCredit = 0;
@@ -414,12 +465,15 @@ NetConnection::NetConnection()
    mGhostRefs = NULL;
    mGhostLookupTable = NULL;
    mLocalGhosts = NULL;
+   mGhostSnapshots = NULL;
 
    mGhostsActive = 0;
 
    mMissionPathsSent = false;
    mDemoWriteStream = NULL;
    mDemoReadStream = NULL;
+   mDemoWriteTick = 0;
+   mDemoReadTick = 0;
 
    mPingSendCount = 0;
    mPingRetryCount = DefaultPingRetryCount;
@@ -444,6 +498,12 @@ NetConnection::~NetConnection()
    if(mCurrentDownloadingFile)
       delete mCurrentDownloadingFile;
 
+   if(mGhostSnapshots)
+   {
+      for(U32 i = 0; i < MaxGhostCount; i++)
+         clearGhostSnapshots(i);
+      delete[] mGhostSnapshots;
+   }
    delete[] mLocalGhosts;
    delete[] mGhostLookupTable;
    delete[] mGhostRefs;
@@ -586,6 +646,16 @@ DefineEngineMethod( NetConnection, setSimulatedNetParams, void, (F32 packetLoss,
    object->setSimulatedNetParams(packetLoss, delay);
 }
 
+DefineEngineMethod( NetConnection, setPacketCompression, void, (bool compress),,
+   "@brief Sets whether packets sent over this connection are entropy coded.\n\n"
+
+   "@param compress True to code the payload of each packet with an adaptive range coder whenever "
+   "that makes it smaller.\n"
+   "@see $Net::compressPackets\n")
+{
+   object->setPacketCompression(compress);
+}
+
 DefineEngineMethod( NetConnection, getPing, S32, (),,
    "@brief Returns the average round trip time (in ms) for the connection.\n\n"
 
@@ -669,6 +739,9 @@ void NetConnection::onRemove()
 }
 
 String NetConnection::mErrorBuffer;
+bool NetConnection::smCompressPackets = false;
+S32 NetConnection::smDemoKeyframeInterval = 1000;
+bool NetConnection::smDemoCompression = true;
 
 void NetConnection::setLastError(const char *fmt, ...)
 {
@@ -717,6 +790,7 @@ void NetConnection::processRawPacket(BitStream *bstream)
    if(mDemoWriteStream)
       recordBlock(BlockTypePacket, bstream->getReadByteSize(), bstream->getBuffer());
 
+   mBytesReceived += bstream->getStreamSize();
    ConnectionProtocol::processRawPacket(bstream);
 }
 
@@ -727,6 +801,18 @@ void NetConnection::handlePacket(BitStream *bstream)
 
    mErrorBuffer = String();
 
+   U8 payload[Net::MaxPacketDataSize];
+   BitStream payloadStream(payload, sizeof(payload));
+   if(bstream->readFlag())
+   {
+      if(!decompressPacket(bstream, &payloadStream))
+      {
+         connectionError("Invalid packet. (bad compressed payload)");
+         return;
+      }
+      bstream = &payloadStream;
+   }
+
    if(bstream->readFlag())
    {
       mCurRate.updateDelay = bstream->readInt(12);
@@ -810,6 +896,10 @@ void NetConnection::checkPacketSend(bool force)
    BitStream *stream = BitStream::getPacketStream(mCurRate.packetSize);
    buildSendPacketHeader(stream);
 
+   // set by compressPacket() below if the payload gets coded
+   const U32 compressFlagPos = stream->getBitPosition();
+   stream->writeFlag(false);
+
    mLastUpdateTime = curTime;
 
    PacketNotify *note = allocNotify();
@@ -843,6 +933,8 @@ void NetConnection::checkPacketSend(bool force)
    DEBUG_LOG(("PKLOG %d START", getId()) );
    writePacket(stream, note);
    DEBUG_LOG(("PKLOG %d END - %d", getId(), stream->getCurPos() - start) );
+   if(mCompressPackets)
+      compressPacket(stream, compressFlagPos);
    if(mSimulatedPacketLoss && Platform::getRandom() < mSimulatedPacketLoss)
    {
       //Con::printf("NET  %d: SENDDROP - %d", getId(), mLastSendSeq);
@@ -856,6 +948,65 @@ void NetConnection::checkPacketSend(bool force)
    sendPacket(stream);
 }
 
+/// Copy @a bitCount bits starting at bit @a srcBit of @a src to the start of @a dst.
+static void copyPacketBits(const U8 *src, U32 srcBit, U8 *dst, U32 bitCount)
+{
+   dMemset(dst, 0, (bitCount + 7) >> 3);
+   for(U32 i = 0; i < bitCount; i++)
+   {
+      U32 bit = srcBit + i;
+      if(src[bit >> 3] & (1 << (bit & 0x7)))
+         dst[i >> 3] |= 1 << (i & 0x7);
+   }
+}
+
+void NetConnection::compressPacket(BitStream *stream, U32 flagPos)
+{
+   PROFILE_SCOPE(NetConnection_compressPacket);
+
+   const U32 payloadStart = flagPos + 1;
+   const U32 payloadEnd = stream->getBitPosition();
+   const U32 payloadBits = payloadEnd - payloadStart;
+
+   U8 payload[Net::MaxPacketDataSize];
+   copyPacketBits(stream->getBuffer(), payloadStart, payload, payloadBits);
+
+   U8 coded[Net::MaxPacketDataSize];
+   U32 codedSize = PacketCoder::encode(payload, payloadBits, coded, sizeof(coded), PacketCoder::getDefaultModel());
+   if(!codedSize || PacketPayloadSizeBits + (codedSize << 3) >= payloadBits)
+      return;
+
+   stream->setBit(flagPos, true);
+   stream->setCurPos(payloadStart);
+   stream->writeInt(payloadBits, PacketPayloadSizeBits);
+   stream->writeBits(codedSize << 3, coded);
+}
+
+bool NetConnection::decompressPacket(BitStream *stream, BitStream *outStream)
+{
+   PROFILE_SCOPE(NetConnection_decompressPacket);
+
+   U32 payloadBits = stream->readInt(PacketPayloadSizeBits);
+   if(payloadBits > (Net::MaxPacketDataSize << 3))
+      return false;
+
+   // the coded bytes run to the end of the packet
+   const U32 codedStart = stream->getBitPosition();
+   const U32 streamEnd = stream->getStreamSize() << 3;
+   if(codedStart > streamEnd)
+      return false;
+   const U32 codedBits = streamEnd - codedStart;
+
+   U8 coded[Net::MaxPacketDataSize];
+   copyPacketBits(stream->getBuffer(), codedStart, coded, codedBits);
+   stream->setCurPos(streamEnd);
+
+   const U32 payloadSize = (payloadBits + 7) >> 3;
+   PacketCoder::decode(coded, (codedBits + 7) >> 3, outStream->getBuffer(), payloadBits, PacketCoder::getDefaultModel());
+   outStream->setBuffer(outStream->getBuffer(), payloadSize);
+   return true;
+}
+
 Net::Error NetConnection::sendPacket(BitStream *stream)
 {
    //Con::printf("NET  %d: SEND - %d", getId(), mLastSendSeq);
@@ -864,6 +1015,7 @@ Net::Error NetConnection::sendPacket(BitStream *stream)
       return Net::NoError;
 
    gNetBitsSent = stream->getPosition();
+   mBytesSent += stream->getPosition();
 
    if(isLocalConnection())
    {
@@ -914,6 +1066,26 @@ void NetConnection::packetDropped(PacketNotify *note)
 //--------------------------------------------------------------------
 
 void NetConnection::writeDemoStartBlock(ResizeBitStream* stream)
+{
+   writeDemoConnectionState(stream);
+}
+
+bool NetConnection::readDemoStartBlock(BitStream* stream)
+{
+   return readDemoConnectionState(stream);
+}
+
+void NetConnection::writeDemoKeyframe(ResizeBitStream* stream)
+{
+   writeDemoConnectionState(stream);
+}
+
+bool NetConnection::readDemoKeyframe(BitStream* stream)
+{
+   return readDemoConnectionState(stream);
+}
+
+void NetConnection::writeDemoConnectionState(ResizeBitStream* stream)
 {
    ConnectionProtocol::writeDemoStartBlock(stream);
 
@@ -939,7 +1111,7 @@ void NetConnection::writeDemoStartBlock(ResizeBitStream* stream)
    ghostWriteStartBlock(stream);
 }
 
-bool NetConnection::readDemoStartBlock(BitStream* stream)
+bool NetConnection::readDemoConnectionState(BitStream* stream)
 {
    ConnectionProtocol::readDemoStartBlock(stream);
 
@@ -969,22 +1141,55 @@ bool NetConnection::readDemoStartBlock(BitStream* stream)
    return true;
 }
 
+void NetConnection::resetDemoConnectionState()
+{
+   while(mNotifyQueueHead)
+      handleNotify(false);
+
+   while(mWaitSeqEvents)
+   {
+      NetEventNote *temp = mWaitSeqEvents;
+      mWaitSeqEvents = temp->mNextEvent;
+
+      temp->mEvent->decRef();
+      mEventNoteChunker.free(temp);
+   }
+
+   if(mLocalGhosts)
+   {
+      for(U32 i = 0; i < MaxGhostCount; i++)
+      {
+         if(mLocalGhosts[i])
+         {
+            mLocalGhosts[i]->deleteObject();
+            mLocalGhosts[i] = NULL;
+         }
+         clearGhostSnapshots(i);
+      }
+   }
+}
+
 bool NetConnection::startDemoRecord(const char *fileName)
 {
-   FileStream *fs = new FileStream;
+   FileStream *fs;
 
    if((fs = FileStream::createAndOpen( fileName, Torque::FS::File::Write )) == NULL)
       return false;
 
-   mDemoWriteStream = fs;
-   mDemoWriteStream->write(mProtocolVersion);
+   fs->write(U32(NetDemo::DemoMagic));
+   fs->write(U32(NetDemo::DemoVersion));
+   fs->write(mProtocolVersion);
    ResizeBitStream bs;
 
    // then write out the start block
    writeDemoStartBlock(&bs);
    U32 size = bs.getPosition() + 1;
-   mDemoWriteStream->write(size);
-   mDemoWriteStream->write(size, bs.getBuffer());
+   fs->write(size);
+   fs->write(size, bs.getBuffer());
+
+   // everything after the start block goes through the buffered writer
+   mDemoWriteStream = new NetDemoWriteStream(fs, smDemoCompression);
+   mDemoWriteTick = 0;
    return true;
 }
 
@@ -994,41 +1199,142 @@ bool NetConnection::replayDemoRecord(const char *fileName)
    if((fs = FileStream::createAndOpen( fileName, Torque::FS::File::Read )) == NULL)
       return false;
 
-   mDemoReadStream = fs;
-   mDemoReadStream->read(&mProtocolVersion);
+   // demos without the magic number start with the protocol version
+   U32 magic;
+   fs->read(&magic);
+   bool indexed = (magic == NetDemo::DemoMagic);
+   if(indexed)
+   {
+      U32 version;
+      fs->read(&version);
+      if(version != NetDemo::DemoVersion)
+      {
+         delete fs;
+         return false;
+      }
+      fs->read(&mProtocolVersion);
+   }
+   else
+      mProtocolVersion = magic;
+
    U32 size;
-   mDemoReadStream->read(&size);
+   fs->read(&size);
    U8 *block = new U8[size];
-   mDemoReadStream->read(size, block);
+   fs->read(size, block);
    BitStream bs(block, size);
 
+   mDemoReadStream = new NetDemoReadStream(fs, indexed);
+   mDemoReadTick = 0;
+
    bool res = readDemoStartBlock(&bs);
    delete[] block;
    if(!res)
       return false;
 
    // prep for first block read
+   return readNextBlockHeader();
+}
+
+bool NetConnection::readNextBlockHeader()
+{
    // type/size stored in U16: [type:4][size:12]
    U16 typeSize;
    mDemoReadStream->read(&typeSize);
 
+   // keyframes are only read when seeking
+   while((typeSize >> 12) == BlockTypeKeyframe && mDemoReadStream->getStatus() == Stream::Ok)
+   {
+      U32 size;
+      mDemoReadStream->read(&size);
+      mDemoReadStream->skip(size);
+      mDemoReadStream->read(&typeSize);
+   }
+
    mDemoNextBlockType = typeSize >> 12;
    mDemoNextBlockSize = typeSize & 0xFFF;
 
-   if(mDemoReadStream->getStatus() != Stream::Ok)
-      return false;
-   return true;
+   return mDemoReadStream->getStatus() == Stream::Ok;
 }
 
 void NetConnection::stopRecording()
 {
    if(mDemoWriteStream)
    {
+      // waits for the writer to finish and appends the seek index
       delete mDemoWriteStream;
       mDemoWriteStream = NULL;
    }
 }
 
+void NetConnection::recordDemoTick()
+{
+   if(!mDemoWriteStream)
+      return;
+
+   if(smDemoKeyframeInterval > 0 && (mDemoWriteTick % smDemoKeyframeInterval) == 0)
+      recordDemoKeyframe();
+
+   mDemoWriteTick++;
+   mDemoWriteStream->setTickCount(mDemoWriteTick);
+}
+
+void NetConnection::recordDemoKeyframe()
+{
+   PROFILE_SCOPE(NetConnection_RecordDemoKeyframe);
+
+   ResizeBitStream bs;
+   writeDemoKeyframe(&bs);
+   U32 size = bs.getPosition() + 1;
+
+   // keyframes don't fit the 12 bit block size, so the size follows the type
+   U16 typeSize = BlockTypeKeyframe << 12;
+   mDemoWriteStream->beginKeyframe(mDemoWriteTick);
+   mDemoWriteStream->write(typeSize);
+   mDemoWriteStream->write(size);
+   mDemoWriteStream->write(size, bs.getBuffer());
+}
+
+U32 NetConnection::getDemoTickCount() const
+{
+   return mDemoReadStream ? mDemoReadStream->getTickCount() : 0;
+}
+
+bool NetConnection::seekDemoKeyframe(U32 tick)
+{
+   PROFILE_SCOPE(NetConnection_SeekDemoKeyframe);
+
+   U32 keyframeTick;
+   if(!mDemoReadStream || !mDemoReadStream->canSeek() || !mDemoReadStream->seekKeyframe(tick, keyframeTick))
+      return false;
+
+   U16 typeSize;
+   U32 size;
+   mDemoReadStream->read(&typeSize);
+   mDemoReadStream->read(&size);
+   if((typeSize >> 12) != BlockTypeKeyframe || mDemoReadStream->getStatus() != Stream::Ok)
+   {
+      stopDemoPlayback();
+      return false;
+   }
+
+   U8 *block = new U8[size];
+   mDemoReadStream->read(size, block);
+   BitStream bs(block, size);
+
+   resetDemoConnectionState();
+   bool res = readDemoKeyframe(&bs);
+   delete[] block;
+
+   if(!res || !readNextBlockHeader())
+   {
+      stopDemoPlayback();
+      return false;
+   }
+
+   mDemoReadTick = keyframeTick;
+   return true;
+}
+
 void NetConnection::recordBlock(U32 type, U32 size, void *data)
 {
    AssertFatal(type < MaxNumBlockTypes, "NetConnection::recordBlock: invalid type");
@@ -1079,13 +1385,7 @@ bool NetConnection::processNextBlock()
    if(mDemoReadStream->read(mDemoNextBlockSize, buffer))
       handleRecordedBlock(mDemoNextBlockType, mDemoNextBlockSize, buffer);
 
-   U16 typeSize;
-   mDemoReadStream->read(&typeSize);
-
-   mDemoNextBlockType = typeSize >> 12;
-   mDemoNextBlockSize = typeSize & 0xFFF;
-
-   if(mDemoReadStream->getStatus() != Stream::Ok)
+   if(!readNextBlockHeader())
    {
       stopDemoPlayback();
       return false;
@@ -1123,8 +1423,7 @@ void NetConnection::packString(BitStream *stream, const char *str)
    }
    if(U8(str[0]) == StringTagPrefixByte)
    {
-      stream->writeInt(TagString, 2);
-      stream->writeInt(dAtoi(str + 1), ConnectionStringTable::EntryBitSize);
+      packTagString(stream, dAtoi(str + 1));
       return;
    }
    if(str[0] == '-' || (str[0] >= '0' && str[0] <= '9'))
@@ -1158,6 +1457,12 @@ void NetConnection::packString(BitStream *stream, const char *str)
    stream->writeString(str);
 }
 
+void NetConnection::packTagString(BitStream *stream, U32 netId)
+{
+   stream->writeInt(TagString, 2);
+   stream->writeInt(netId, ConnectionStringTable::EntryBitSize);
+}
+
 void NetConnection::unpackString(BitStream *stream, char readBuffer[1024])
 {
    U32 code = stream->readInt(2);
@@ -45,6 +45,8 @@ class NetObject;
 class BitStream;
 class ResizeBitStream;
 class Stream;
+class NetDemoWriteStream;
+class NetDemoReadStream;
 class Point3F;
 
 struct GhostInfo;
@@ -424,6 +426,16 @@ public:
       GhostInfo *ghost;          ///< Reference to the GhostInfo we're from.
       GhostRef *nextRef;         ///< Next GhostRef in this packet.
       GhostRef *nextUpdateChain; ///< Next update we sent for this ghost.
+
+      /// @name Snapshot Deltas
+      ///
+      /// With snapshot deltas enabled, the packed update is kept until the
+      /// packet is acknowledged and then becomes the ghost's new baseline.
+      /// @{
+      U8 *snapshot;              ///< Packed update bits, or NULL.
+      U32 snapshotBits;          ///< Number of bits in snapshot.
+      U32 snapshotSequence;      ///< Per-ghost sequence number of this update.
+      /// @}
    };
 
    enum Constants
@@ -490,6 +502,10 @@ private:
    U32 mSimulatedPing;
    F32 mSimulatedPacketLoss;
 
+   /// Total number of bytes sent and received on this connection.
+   U32 mBytesSent;
+   U32 mBytesReceived;
+
    /// @}
 
    /// @name State
@@ -503,6 +519,9 @@ private:
    bool mEstablished;
    bool mMissionPathsSent;
 
+   /// Entropy code the payload of outgoing packets when it saves space.
+   bool mCompressPackets;
+
    struct NetRate
    {
       U32 updateDelay;
@@ -554,6 +573,7 @@ protected:
 
 public:
    static NetConnection *getConnectionToServer() { return mServerConnection; }
+   static void setConnectionToServer(NetConnection *conn) { mServerConnection = conn; }
 
    static NetConnection *getLocalClientConnection() { return mLocalClientConnection; }
    static void setLocalClientConnection(NetConnection *conn) { mLocalClientConnection = conn; }
@@ -570,6 +590,36 @@ public:
    void setSimulatedNetParams(F32 packetLoss, U32 ping)
       { mSimulatedPacketLoss = packetLoss; mSimulatedPing = ping; }
 
+   /// @name Packet Compression
+   ///
+   /// The packet payload that follows the protocol header can be entropy
+   /// coded with PacketCoder.  A flag after the header tells the receiver,
+   /// so only the sending side has to enable it.
+   /// @{
+
+   /// Default for mCompressPackets of new connections.
+   static bool smCompressPackets;
+
+   void setPacketCompression(bool compress) { mCompressPackets = compress; }
+
+   enum PacketCompressionConstants
+   {
+      PacketPayloadSizeBits = 14,   ///< Enough for Net::MaxPacketDataSize bytes.
+   };
+
+   /// Code the payload that follows the compression flag at bit @a flagPos
+   /// of @a stream.  The stream is rewritten and the flag set only if the
+   /// result is smaller.
+   static void compressPacket(BitStream *stream, U32 flagPos);
+
+   /// Decode a payload written by compressPacket().  Reads from the current
+   /// position of @a stream, right after the compression flag.  @a outStream
+   /// must have a buffer of at least Net::MaxPacketDataSize bytes; it is set up
+   /// to read the decoded payload.
+   static bool decompressPacket(BitStream *stream, BitStream *outStream);
+
+   /// @}
+
    bool isConnectionToServer()           { return mTypeFlags.test(ConnectionToServer); }
    bool isLocalConnection()            { return !mRemoteConnection.isNull() ; }
    bool isNetworkConnection()          { return mTypeFlags.test(NetworkConnection); }
@@ -594,6 +644,8 @@ public:
    U32 getProtocolVersion()                     { return mProtocolVersion; }
    F32 getRoundTripTime()                       { return mRoundTripTime; }
    F32 getPacketLoss()                          { return( mPacketLoss ); }
+   U32 getBytesSent()                           { return mBytesSent; }
+   U32 getBytesReceived()                       { return mBytesReceived; }
 
    static String mErrorBuffer;
    static void setLastError(const char *fmt,...);
@@ -748,7 +800,14 @@ public:
    NetStringHandle translateRemoteStringId(U32 id) { return mStringTable->lookupString(id); }
    void         validateSendString(const char *str);
 
-   void   packString(BitStream *stream, const char *str);
+   /// Pack a remote command argument.  Tagged strings must already be
+   /// translated to this connection's send id.  Does not depend on the
+   /// connection, so the result may be shared between connections.
+   static void packString(BitStream *stream, const char *str);
+
+   /// Pack a tagged string argument by its send id on the connection.
+   static void packTagString(BitStream *stream, U32 netId);
+
    void unpackString(BitStream *stream, char readBuffer[1024]);
 
    void           packNetStringHandleU(BitStream *stream, NetStringHandle &h);
@@ -775,6 +834,14 @@ protected:
    U32 mGhostZeroUpdateIndex;  ///< Index in mGhostArray of first ghost with 0 update mask.
    U32 mGhostFreeIndex;        ///< Index in mGhostArray of first free ghost.
 
+   /// Number of packets a ghost that stays dirty without being sent keeps its
+   /// cached update priority before it is recomputed.
+   static U32 smGhostPriorityRefresh;
+
+   /// If true, ghost updates are sent as bitwise deltas against the last
+   /// update the client acknowledged for the ghost, whenever that is smaller.
+   static bool smGhostSnapshotDeltas;
+
    U32 mGhostsActive;			///- Track actve ghosts on client side
 
    bool mGhosting;             ///< Am I currently ghosting objects?
@@ -807,6 +874,24 @@ protected:
    void ghostWriteStartBlock(ResizeBitStream *stream);
    void ghostReadStartBlock(BitStream *stream);
 
+   /// Pack a ghost update as a snapshot, either verbatim or as a delta
+   /// against the ghost's acknowledged baseline.
+   U32 ghostPackSnapshot(GhostInfo *ghost, GhostRef *ref, U32 updateMask, BitStream *bstream);
+
+   /// Unpack an update written by ghostPackSnapshot() and record it in the
+   /// ghost's snapshot history.
+   void ghostUnpackSnapshot(U32 index, BitStream *bstream);
+
+   /// Free the snapshot history of the ghost at @a index.
+   void clearGhostSnapshots(U32 index);
+
+   /// Allocate a buffer for a snapshot of @a bitCount bits.  Buffers are
+   /// pooled by size and shared by all connections.
+   static U8 *allocSnapshot(U32 bitCount);
+
+   /// Return a buffer from allocSnapshot() to its pool.  NULL is ignored.
+   static void freeSnapshot(U8 *data, U32 bitCount);
+
    virtual void ghostWriteExtra(NetObject *,BitStream *) {}
    virtual void ghostReadExtra(NetObject *,BitStream *, bool newGhost) {}
    virtual void ghostPreRead(NetObject *, bool newGhost) {}
@@ -821,11 +906,40 @@ public:
       GhostIdBitSize = 12,
       MaxGhostCount = 1 << GhostIdBitSize, //4096,
       GhostLookupTableSize = 1 << GhostIdBitSize, //4096
-      GhostIndexBitSize = 4 // number of bits GhostIdBitSize-3 fits into
+      GhostIndexBitSize = 4, // number of bits GhostIdBitSize-3 fits into
+
+      GhostSnapshotHistorySize = 8,       ///< Updates per ghost the client keeps as delta baselines.
+      GhostSnapshotSequenceBits = 4,      ///< Must count at least twice GhostSnapshotHistorySize.
+      GhostSnapshotSequenceCount = 1 << GhostSnapshotSequenceBits,
+      GhostSnapshotSizeBits = 14,         ///< Bits in the size of a packed update.
    };
 
+protected:
+   /// A packed ghost update kept on the client as a delta baseline.
+   struct GhostSnapshot
+   {
+      U32 sequence;     ///< Sequence number modulo GhostSnapshotSequenceCount.
+      U32 bitCount;
+      U8 *data;
+   };
+
+   /// The most recent updates received for a ghost.
+   struct GhostSnapshotHistory
+   {
+      U32 next;         ///< Slot the next update is stored in.
+      GhostSnapshot snapshots[GhostSnapshotHistorySize];
+   };
+
+   /// Received update history per ghost index.  Only allocated on
+   /// the client once the server sends snapshot deltas.
+   GhostSnapshotHistory **mGhostSnapshots;
+
+public:
    U32 getGhostsActive() { return mGhostsActive;};
 
+   /// Number of ghosts currently resolved on the receiving end.
+   U32 getLocalGhostCount() const;
+
    /// Are we ghosting to someone?
    bool isGhostingTo() { return mLocalGhosts != NULL; };
 
@@ -995,8 +1109,8 @@ public:
 /// @{
 
 private:
-   Stream *mDemoWriteStream;
-   Stream *mDemoReadStream;
+   NetDemoWriteStream *mDemoWriteStream;
+   NetDemoReadStream *mDemoReadStream;
    U32 mDemoNextBlockType;
    U32 mDemoNextBlockSize;
 
@@ -1006,11 +1120,39 @@ private:
 
    U32 mDemoRealStartTime;
 
+   /// Number of ticks recorded into / played back from the current demo.
+   U32 mDemoWriteTick;
+   U32 mDemoReadTick;
+
+   /// Read the header of the next block, skipping over keyframes.
+   bool readNextBlockHeader();
+
+   /// Write a keyframe block for the current recording tick.
+   void recordDemoKeyframe();
+
+protected:
+   /// Number of ticks between seek keyframes in recorded demos.
+   static S32 smDemoKeyframeInterval;
+
+   /// If true, recorded demo blocks are compressed.
+   static bool smDemoCompression;
+
+   /// Write/read the connection state shared by the start block and keyframes.
+   void writeDemoConnectionState(ResizeBitStream *stream);
+   bool readDemoConnectionState(BitStream *stream);
+
+   /// Drop all ghosts, pending events and packet notifies before a keyframe is read.
+   void resetDemoConnectionState();
+
 public:
    enum DemoBlockTypes {
       BlockTypePacket,
       BlockTypeSendPacket,
-      NetConnectionBlockTypeCount
+      NetConnectionBlockTypeCount,
+
+      /// Seek keyframe holding the full connection state.  Uses the last
+      /// block type so the types of existing demos keep their values.
+      BlockTypeKeyframe = 0xF,
    };
 
    enum DemoConstants {
@@ -1028,6 +1170,27 @@ public:
    virtual void handleRecordedBlock(U32 type, U32 size, void *data);
    bool processNextBlock();
 
+   /// Called once per tick while recording, before the tick's move block is
+   /// recorded.  Writes a seek keyframe every $Net::demoKeyframeInterval ticks.
+   void recordDemoTick();
+
+   /// Called once per tick block played back.
+   void advanceDemoReadTick() { mDemoReadTick++; }
+
+   /// Return the number of ticks played back so far.
+   U32 getDemoReadTick() const { return mDemoReadTick; }
+
+   /// Return the number of ticks in the demo being played back, or 0 if
+   /// the demo has no seek index.
+   U32 getDemoTickCount() const;
+
+   /// Restore the state of the latest keyframe at or before @a tick and
+   /// continue playback from there.
+   ///
+   /// @return False if the demo has no seek index or the keyframe could not
+   ///   be read.  In the latter case playback is stopped.
+   bool seekDemoKeyframe(U32 tick);
+
    bool startDemoRecord(const char *fileName);
    bool replayDemoRecord(const char *fileName);
    void startDemoRead();
@@ -1036,6 +1199,8 @@ public:
 
    virtual void writeDemoStartBlock(ResizeBitStream *stream);
    virtual bool readDemoStartBlock(BitStream *stream);
+   virtual void writeDemoKeyframe(ResizeBitStream *stream);
+   virtual bool readDemoKeyframe(BitStream *stream);
    virtual void demoPlaybackComplete();
 /// @}
 };
@@ -1057,6 +1222,12 @@ public:  // required for MSVC
    U32 flags;                             ///< Flags from GhostInfo::Flags
    F32 priority;                          ///< A float value indicating the priority of this object for
                                           ///  updates.
+   U32 prioritySkipCount;                 ///< updateSkipCount at the time #priority was computed.
+
+   U8 *baseline;                          ///< Last packed update the client acknowledged, or NULL.
+   U32 baselineBits;                      ///< Number of bits in baseline.
+   U32 baselineSequence;                  ///< Sequence number of baseline.
+   U32 snapshotSequence;                  ///< Sequence number of the next update.
 
    /// @name References
    ///
@@ -1089,6 +1260,7 @@ public:  // required for MSVC
       KillingGhost      = BIT(6),
       ScopedEvent       = BIT(7),
       ScopeLocalAlways  = BIT(8),
+      PriorityDirty     = BIT(9),  ///< Priority must be recomputed before the next update.
    };
 };
 
@@ -1104,6 +1276,7 @@ inline void NetConnection::ghostPushNonZero(GhostInfo *info)
       info->arrayIndex = mGhostZeroUpdateIndex;
    }
    mGhostZeroUpdateIndex++;
+   info->flags |= GhostInfo::PriorityDirty;
    //AssertFatal(validateGhostArray(), "Invalid ghost array!");
 }
 
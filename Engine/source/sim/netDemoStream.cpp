@@ -0,0 +1,454 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "sim/netDemoStream.h"
+
+#include "platform/threads/thread.h"
+#include "platform/profiler.h"
+#include "zlib/zlib.h"
+
+
+using namespace NetDemo;
+
+//-----------------------------------------------------------------------------
+// NetDemoWriteThread.
+//-----------------------------------------------------------------------------
+
+/// Worker thread writing the chunks queued by a NetDemoWriteStream.
+class NetDemoWriteThread : public Thread
+{
+   public:
+
+      typedef Thread Parent;
+
+      NetDemoWriteThread( NetDemoWriteStream* stream )
+         : mStream( stream ) {}
+
+      virtual void run( void* arg );
+
+   protected:
+
+      NetDemoWriteStream* mStream;
+};
+
+void NetDemoWriteThread::run( void* arg )
+{
+   while( true )
+   {
+      mStream->mQueueSemaphore.acquire();
+
+      NetDemoWriteStream::Chunk chunk;
+      if( !mStream->mQueue.tryPopFront( chunk ) )
+         continue;
+
+      // A chunk without data tells us to finish.
+      if( !chunk.data )
+         break;
+
+      mStream->_writeChunk( chunk );
+      delete [] chunk.data;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// NetDemoWriteStream.
+//-----------------------------------------------------------------------------
+
+NetDemoWriteStream::NetDemoWriteStream( Stream* fileStream, bool compress )
+   : mFileStream( fileStream ),
+     mCompress( compress ),
+     mChunkSize( 0 ),
+     mChunkKeyframe( false ),
+     mChunkTick( 0 ),
+     mPosition( 0 ),
+     mTickCount( 0 ),
+     mQueueSemaphore( 0 )
+{
+   mChunkData = new U8[ ChunkSize ];
+   mCompressBuffer = mCompress ? new U8[ compressBound( ChunkSize ) ] : NULL;
+
+   mThread = new NetDemoWriteThread( this );
+   mThread->start();
+}
+
+NetDemoWriteStream::~NetDemoWriteStream()
+{
+   _flushChunk();
+
+   // Let the worker drain the queue and exit.
+   Chunk done;
+   done.data = NULL;
+   done.size = 0;
+   done.keyframe = false;
+   done.tick = 0;
+   mQueue.pushBack( done );
+   mQueueSemaphore.release();
+
+   mThread->join();
+   delete mThread;
+
+   // End chunk.
+   mFileStream->write( U32( 0 ) );
+   mFileStream->write( U32( 0 ) );
+
+   // Seek index and footer.
+   const U32 indexOffset = mFileStream->getPosition();
+   mFileStream->write( U32( mIndex.size() ) );
+   for( U32 i = 0; i < mIndex.size(); ++ i )
+   {
+      mFileStream->write( mIndex[ i ].tick );
+      mFileStream->write( mIndex[ i ].offset );
+   }
+
+   mFileStream->write( indexOffset );
+   mFileStream->write( mTickCount );
+   mFileStream->write( U32( IndexMagic ) );
+
+   delete mFileStream;
+   delete [] mChunkData;
+   delete [] mCompressBuffer;
+}
+
+void NetDemoWriteStream::beginKeyframe( U32 tick )
+{
+   _flushChunk();
+
+   mChunkKeyframe = true;
+   mChunkTick = tick;
+}
+
+bool NetDemoWriteStream::hasCapability( const Capability caps ) const
+{
+   return ( caps == StreamWrite );
+}
+
+bool NetDemoWriteStream::setPosition( const U32 in_newPosition )
+{
+   AssertFatal( false, "NetDemoWriteStream::setPosition - demo streams cannot be positioned" );
+   return false;
+}
+
+bool NetDemoWriteStream::_read( const U32 in_numBytes, void* out_pBuffer )
+{
+   AssertFatal( false, "NetDemoWriteStream::_read - demo write streams cannot be read" );
+   setStatus( IllegalCall );
+   return false;
+}
+
+bool NetDemoWriteStream::_write( const U32 in_numBytes, const void* in_pBuffer )
+{
+   const U8* src = ( const U8* ) in_pBuffer;
+   U32 remaining = in_numBytes;
+
+   while( remaining )
+   {
+      const U32 count = getMin( remaining, U32( ChunkSize ) - mChunkSize );
+      dMemcpy( mChunkData + mChunkSize, src, count );
+
+      mChunkSize += count;
+      src += count;
+      remaining -= count;
+
+      if( mChunkSize == ChunkSize )
+         _flushChunk();
+   }
+
+   mPosition += in_numBytes;
+   return true;
+}
+
+void NetDemoWriteStream::_flushChunk()
+{
+   if( !mChunkSize )
+      return;
+
+   // Hand our buffer over to the worker and start a new one.
+   Chunk chunk;
+   chunk.data = mChunkData;
+   chunk.size = mChunkSize;
+   chunk.keyframe = mChunkKeyframe;
+   chunk.tick = mChunkTick;
+
+   mQueue.pushBack( chunk );
+   mQueueSemaphore.release();
+
+   mChunkData = new U8[ ChunkSize ];
+   mChunkSize = 0;
+   mChunkKeyframe = false;
+}
+
+void NetDemoWriteStream::_writeChunk( const Chunk& chunk )
+{
+   PROFILE_SCOPE( NetDemoWriteStream_WriteChunk );
+
+   const U32 offset = mFileStream->getPosition();
+   if( chunk.keyframe )
+   {
+      KeyframeEntry entry;
+      entry.tick = chunk.tick;
+      entry.offset = offset;
+      mIndex.push_back( entry );
+   }
+
+   const U8* data = chunk.data;
+   U32 storedSize = chunk.size;
+
+   if( mCompress )
+   {
+      uLongf compressedSize = compressBound( chunk.size );
+      if( compress2( mCompressBuffer, &compressedSize, chunk.data, chunk.size, Z_BEST_SPEED ) == Z_OK
+          && compressedSize < chunk.size )
+      {
+         data = mCompressBuffer;
+         storedSize = compressedSize;
+      }
+   }
+
+   mFileStream->write( chunk.size );
+   mFileStream->write( storedSize );
+   mFileStream->write( storedSize, data );
+}
+
+//-----------------------------------------------------------------------------
+// NetDemoReadStream.
+//-----------------------------------------------------------------------------
+
+NetDemoReadStream::NetDemoReadStream( Stream* fileStream, bool indexed )
+   : mFileStream( fileStream ),
+     mIndexed( indexed ),
+     mChunkData( NULL ),
+     mChunkSize( 0 ),
+     mChunkPosition( 0 ),
+     mChunkCapacity( 0 ),
+     mCompressBuffer( NULL ),
+     mCompressCapacity( 0 ),
+     mTickCount( 0 )
+{
+   if( mIndexed )
+   {
+      const U32 start = mFileStream->getPosition();
+      _readIndex();
+      mFileStream->setPosition( start );
+   }
+}
+
+NetDemoReadStream::~NetDemoReadStream()
+{
+   delete mFileStream;
+   delete [] mChunkData;
+   delete [] mCompressBuffer;
+}
+
+void NetDemoReadStream::_readIndex()
+{
+   // The footer is missing if recording did not finish cleanly; the demo
+   // still plays, it just cannot seek.
+   const U32 size = mFileStream->getStreamSize();
+   if( size < FooterSize || !mFileStream->setPosition( size - FooterSize ) )
+      return;
+
+   U32 indexOffset, tickCount, magic;
+   mFileStream->read( &indexOffset );
+   mFileStream->read( &tickCount );
+   mFileStream->read( &magic );
+   if( magic != IndexMagic || indexOffset >= size - FooterSize )
+      return;
+
+   mFileStream->setPosition( indexOffset );
+
+   U32 count;
+   mFileStream->read( &count );
+   if( count > ( size - FooterSize - indexOffset ) / sizeof( KeyframeEntry ) )
+      return;
+
+   mIndex.setSize( count );
+   for( U32 i = 0; i < count; ++ i )
+   {
+      mFileStream->read( &mIndex[ i ].tick );
+      mFileStream->read( &mIndex[ i ].offset );
+   }
+
+   if( mFileStream->getStatus() != Ok )
+      mIndex.clear();
+   else
+      mTickCount = tickCount;
+}
+
+bool NetDemoReadStream::seekKeyframe( U32 tick, U32& outTick )
+{
+   if( mIndex.empty() )
+      return false;
+
+   // Binary search for the last keyframe at or before the tick.
+   U32 lo = 0;
+   U32 hi = mIndex.size();
+   while( hi - lo > 1 )
+   {
+      const U32 mid = ( lo + hi ) / 2;
+      if( mIndex[ mid ].tick <= tick )
+         lo = mid;
+      else
+         hi = mid;
+   }
+
+   if( !mFileStream->setPosition( mIndex[ lo ].offset ) )
+      return false;
+
+   mChunkSize = 0;
+   mChunkPosition = 0;
+   setStatus( Ok );
+
+   if( !_readChunk() )
+      return false;
+
+   outTick = mIndex[ lo ].tick;
+   return true;
+}
+
+bool NetDemoReadStream::skip( U32 numBytes )
+{
+   U8 buffer[ 1024 ];
+   while( numBytes )
+   {
+      const U32 count = getMin( numBytes, U32( sizeof( buffer ) ) );
+      if( !read( count, buffer ) )
+         return false;
+      numBytes -= count;
+   }
+   return true;
+}
+
+bool NetDemoReadStream::hasCapability( const Capability caps ) const
+{
+   return ( caps == StreamRead );
+}
+
+U32 NetDemoReadStream::getPosition() const
+{
+   return mFileStream->getPosition();
+}
+
+bool NetDemoReadStream::setPosition( const U32 in_newPosition )
+{
+   AssertFatal( false, "NetDemoReadStream::setPosition - use seekKeyframe() to position demo streams" );
+   return false;
+}
+
+U32 NetDemoReadStream::getStreamSize()
+{
+   return mFileStream->getStreamSize();
+}
+
+bool NetDemoReadStream::_write( const U32 in_numBytes, const void* in_pBuffer )
+{
+   AssertFatal( false, "NetDemoReadStream::_write - demo read streams cannot be written" );
+   setStatus( IllegalCall );
+   return false;
+}
+
+bool NetDemoReadStream::_read( const U32 in_numBytes, void* out_pBuffer )
+{
+   if( !mIndexed )
+   {
+      const bool result = mFileStream->read( in_numBytes, out_pBuffer );
+      setStatus( mFileStream->getStatus() );
+      return result;
+   }
+
+   U8* dst = ( U8* ) out_pBuffer;
+   U32 remaining = in_numBytes;
+
+   while( remaining )
+   {
+      if( mChunkPosition == mChunkSize && !_readChunk() )
+      {
+         if( getStatus() == Ok )
+            setStatus( EOS );
+         return false;
+      }
+
+      const U32 count = getMin( remaining, mChunkSize - mChunkPosition );
+      dMemcpy( dst, mChunkData + mChunkPosition, count );
+
+      mChunkPosition += count;
+      dst += count;
+      remaining -= count;
+   }
+
+   return true;
+}
+
+bool NetDemoReadStream::_readChunk()
+{
+   PROFILE_SCOPE( NetDemoReadStream_ReadChunk );
+
+   U32 rawSize, storedSize;
+   mFileStream->read( &rawSize );
+   mFileStream->read( &storedSize );
+
+   // A zero sized chunk ends the block data.
+   if( mFileStream->getStatus() != Ok || !rawSize )
+      return false;
+
+   if( rawSize > ChunkSize || storedSize > compressBound( rawSize ) )
+   {
+      setStatus( IOError );
+      return false;
+   }
+
+   if( rawSize > mChunkCapacity )
+   {
+      delete [] mChunkData;
+      mChunkData = new U8[ rawSize ];
+      mChunkCapacity = rawSize;
+   }
+
+   if( storedSize == rawSize )
+   {
+      if( !mFileStream->read( rawSize, mChunkData ) )
+         return false;
+   }
+   else
+   {
+      if( storedSize > mCompressCapacity )
+      {
+         delete [] mCompressBuffer;
+         mCompressBuffer = new U8[ storedSize ];
+         mCompressCapacity = storedSize;
+      }
+
+      if( !mFileStream->read( storedSize, mCompressBuffer ) )
+         return false;
+
+      uLongf size = rawSize;
+      if( uncompress( mChunkData, &size, mCompressBuffer, storedSize ) != Z_OK || size != rawSize )
+      {
+         setStatus( IOError );
+         return false;
+      }
+   }
+
+   mChunkSize = rawSize;
+   mChunkPosition = 0;
+   return true;
+}
@@ -0,0 +1,205 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _NETDEMOSTREAM_H_
+#define _NETDEMOSTREAM_H_
+
+#ifndef _STREAM_H_
+#include "core/stream/stream.h"
+#endif
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+#ifndef _THREADSAFEDEQUE_H_
+#include "platform/threads/threadSafeDeque.h"
+#endif
+#ifndef _PLATFORM_THREAD_SEMAPHORE_H_
+#include "platform/threads/semaphore.h"
+#endif
+
+class NetDemoWriteThread;
+
+
+/// Layout of an indexed demo file.
+///
+/// An indexed demo starts with DemoMagic and DemoVersion, followed by the
+/// protocol version and the start block as in a plain demo.  The recorded
+/// blocks are then stored in chunks of up to ChunkSize bytes, each prefixed
+/// with its raw and stored size; a chunk is zlib compressed if that makes it
+/// smaller.  A chunk with a raw size of zero ends the block data.
+///
+/// Every keyframe block starts a new chunk.  After the end chunk, the file
+/// holds the seek index (the tick and file offset of every keyframe chunk)
+/// and a footer pointing at it, so playback can jump to the chunk holding
+/// the nearest keyframe without decoding anything before it.
+///
+/// Demos without DemoMagic are plain demos and are read as before.
+namespace NetDemo
+{
+   enum Constants
+   {
+      DemoMagic = 0x4F4D4544,    ///< "DEMO"
+      IndexMagic = 0x58444E49,   ///< "INDX"
+      DemoVersion = 1,
+      ChunkSize = 0x10000,
+      FooterSize = 12,
+   };
+
+   /// Seek index entry.
+   struct KeyframeEntry
+   {
+      U32 tick;
+      U32 offset;
+   };
+}
+
+/// Buffered demo writer.
+///
+/// Collects written blocks into chunks and hands full chunks to a worker
+/// thread that compresses and writes them, so that recording does not stall
+/// the game on file I/O.  Takes ownership of the file stream; the seek
+/// index and footer are written when the stream is deleted.
+class NetDemoWriteStream : public Stream
+{
+   typedef Stream Parent;
+
+   friend class NetDemoWriteThread;
+
+public:
+
+   NetDemoWriteStream( Stream* fileStream, bool compress );
+   virtual ~NetDemoWriteStream();
+
+   /// Start a new chunk holding the keyframe for @a tick.  Must be called
+   /// before the keyframe block is written.
+   void beginKeyframe( U32 tick );
+
+   /// Set the total number of ticks stored in the footer.
+   void setTickCount( U32 ticks ) { mTickCount = ticks; }
+
+   // Stream.
+   virtual bool hasCapability( const Capability caps ) const;
+   virtual U32 getPosition() const { return mPosition; }
+   virtual bool setPosition( const U32 in_newPosition );
+   virtual U32 getStreamSize() { return mPosition; }
+
+protected:
+
+   /// A chunk waiting to be written by the worker thread.
+   struct Chunk
+   {
+      U8* data;
+      U32 size;
+      bool keyframe;
+      U32 tick;
+   };
+
+   virtual bool _read( const U32 in_numBytes, void* out_pBuffer );
+   virtual bool _write( const U32 in_numBytes, const void* in_pBuffer );
+
+   /// Hand the current chunk to the worker thread.
+   void _flushChunk();
+
+   /// Compress and write @a chunk to the file.  Called on the worker thread.
+   void _writeChunk( const Chunk& chunk );
+
+   Stream* mFileStream;
+   bool mCompress;
+
+   U8* mChunkData;
+   U32 mChunkSize;
+   bool mChunkKeyframe;
+   U32 mChunkTick;
+
+   /// Logical number of bytes written.
+   U32 mPosition;
+   U32 mTickCount;
+
+   ThreadSafeDeque< Chunk > mQueue;
+   Semaphore mQueueSemaphore;
+   NetDemoWriteThread* mThread;
+
+   /// Seek index, only touched by the worker thread while it runs.
+   Vector< NetDemo::KeyframeEntry > mIndex;
+   U8* mCompressBuffer;
+};
+
+/// Reader for plain and indexed demos.
+///
+/// Constructed on the file stream positioned right after the start block.
+/// Block data of indexed demos is decompressed a chunk at a time; plain
+/// demos are read straight from the file and cannot seek.  Takes ownership
+/// of the file stream.
+class NetDemoReadStream : public Stream
+{
+   typedef Stream Parent;
+
+public:
+
+   NetDemoReadStream( Stream* fileStream, bool indexed );
+   virtual ~NetDemoReadStream();
+
+   /// Return true if the demo has a seek index.
+   bool canSeek() const { return !mIndex.empty(); }
+
+   /// Total number of ticks in the demo, or 0 if unknown.
+   U32 getTickCount() const { return mTickCount; }
+
+   /// Position the stream at the keyframe closest to but not after @a tick.
+   /// @param outTick Set to the tick of the keyframe.
+   bool seekKeyframe( U32 tick, U32& outTick );
+
+   /// Discard the next @a numBytes bytes.
+   bool skip( U32 numBytes );
+
+   // Stream.
+   virtual bool hasCapability( const Capability caps ) const;
+   virtual U32 getPosition() const;
+   virtual bool setPosition( const U32 in_newPosition );
+   virtual U32 getStreamSize();
+
+protected:
+
+   virtual bool _read( const U32 in_numBytes, void* out_pBuffer );
+   virtual bool _write( const U32 in_numBytes, const void* in_pBuffer );
+
+   /// Load the chunk starting at the current file position.
+   bool _readChunk();
+
+   /// Load the seek index from the footer.
+   void _readIndex();
+
+   Stream* mFileStream;
+   bool mIndexed;
+
+   U8* mChunkData;
+   U32 mChunkSize;
+   U32 mChunkPosition;
+   U32 mChunkCapacity;
+   U8* mCompressBuffer;
+   U32 mCompressCapacity;
+
+   U32 mTickCount;
+   Vector< NetDemo::KeyframeEntry > mIndex;
+};
+
+#endif // _NETDEMOSTREAM_H_
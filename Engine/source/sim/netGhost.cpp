@@ -30,6 +30,7 @@
 #include "console/console.h"
 #include "console/consoleTypes.h"
 #include "console/engineAPI.h"
+#include "core/dataChunker.h"
 
 #define DebugChecksum 0xF00DBAAD
 
@@ -184,6 +185,8 @@ void NetConnection::setGhostFrom(bool ghostFrom)
          mGhostRefs[i].obj = NULL;
          mGhostRefs[i].index = i;
          mGhostRefs[i].updateMask = 0;
+         mGhostRefs[i].baseline = NULL;
+         mGhostRefs[i].snapshotSequence = 0;
       }
       mGhostLookupTable = new GhostInfo *[GhostLookupTableSize];
       for(i = 0; i < GhostLookupTableSize; i++)
@@ -254,6 +257,7 @@ void NetConnection::ghostPacketDropped(PacketNotify *notify)
          packRef->ghost->flags &= ~GhostInfo::KillingGhost;
       }
 
+      freeSnapshot(packRef->snapshot, packRef->snapshotBits);
       delete packRef;
       packRef = temp;
    }
@@ -280,6 +284,19 @@ void NetConnection::ghostPacketReceived(PacketNotify *notify)
 
       *walk = 0;
 
+      // the client has this update now, so it's the new delta baseline.
+      // notifies arrive in order, so it is newer than the current one.
+
+      if(packRef->snapshot)
+      {
+         GhostInfo *ghost = packRef->ghost;
+         freeSnapshot(ghost->baseline, ghost->baselineBits);
+         ghost->baseline = packRef->snapshot;
+         ghost->baselineBits = packRef->snapshotBits;
+         ghost->baselineSequence = packRef->snapshotSequence;
+         packRef->snapshot = NULL;
+      }
+
       // if this object was ghosting , it is now ghosted
 
       if(packRef->ghostInfoFlags & GhostInfo::Ghosting)
@@ -304,13 +321,30 @@ struct UpdateQueueEntry
       { priority = in_priority; obj = in_obj; }
 };
 
-static S32 QSORT_CALLBACK UQECompare(const void *a,const void *b)
+U32 NetConnection::smGhostPriorityRefresh = 4;
+bool NetConnection::smGhostSnapshotDeltas = false;
+
+/// Sift the ghost at @a index down the max-heap of @a count ghosts in @a heap,
+/// keeping the ghosts' array indices in sync.
+static void ghostHeapSiftDown(GhostInfo **heap, U32 index, U32 count)
 {
-   GhostInfo *ga = *((GhostInfo **) a);
-   GhostInfo *gb = *((GhostInfo **) b);
+   GhostInfo *ghost = heap[index];
+   for(;;)
+   {
+      U32 child = index * 2 + 1;
+      if(child >= count)
+         break;
+      if(child + 1 < count && heap[child + 1]->priority > heap[child]->priority)
+         child++;
+      if(heap[child]->priority <= ghost->priority)
+         break;
 
-   F32 ret = ga->priority - gb->priority;
-   return (ret < 0) ? -1 : ((ret > 0) ? 1 : 0);
+      heap[index] = heap[child];
+      heap[index]->arrayIndex = index;
+      index = child;
+   }
+   heap[index] = ghost;
+   ghost->arrayIndex = index;
 }
 
 void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
@@ -334,9 +368,11 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
    // 1. Scope query - find if any new objects have come into
    //    scope and if any have gone out.
    // 2. call scoped objects' priority functions if the flag set is nonzero
+   //    and the object got dirty or was sent since its priority was last
+   //    computed, or smGhostPriorityRefresh packets have passed.
    //    A removed ghost is assumed to have a high priority
-   // 3. call updates based on sorted priority until the packet is
-   //    full.  set flags to zero for all updated objects
+   // 3. call updates in priority order, popping them off a heap, until the
+   //    packet is full.  set flags to zero for all updated objects
 
    CameraScopeQuery camInfo;
 
@@ -396,18 +432,26 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
       {
          if(walk->flags & GhostInfo::KillGhost)
             walk->priority = 10000;
-         else
+         else if((walk->flags & GhostInfo::PriorityDirty) ||
+                 walk->updateSkipCount - walk->prioritySkipCount >= smGhostPriorityRefresh)
+         {
             walk->priority = walk->obj->getUpdatePriority(&camInfo, walk->updateMask, walk->updateSkipCount);
+            walk->prioritySkipCount = walk->updateSkipCount;
+            walk->flags &= ~GhostInfo::PriorityDirty;
+         }
       }
       else
+      {
          walk->priority = 0;
+         walk->flags |= GhostInfo::PriorityDirty;
+      }
    }
    GhostRef *updateList = NULL;
-   dQsort(mGhostArray, mGhostZeroUpdateIndex, sizeof(GhostInfo *), UQECompare);
 
-   // reset the array indices...
-   for(i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
-      mGhostArray[i]->arrayIndex = i;
+   // Heapify the dirty ghosts.  Only as many ghosts as fit into the
+   // packet are popped off, so there is no need to sort all of them.
+   for(i = S32(mGhostZeroUpdateIndex / 2) - 1; i >= 0; i--)
+      ghostHeapSiftDown(mGhostArray, i, mGhostZeroUpdateIndex);
 
    S32 sendSize = 1;
    while(maxIndex >>= 1)
@@ -417,12 +461,24 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
       sendSize = 3;
 
    bstream->writeInt(sendSize - 3, GhostIndexBitSize);
+   const bool snapshotDeltas = bstream->writeFlag(smGhostSnapshotDeltas);
 
    U32 count = 0;
    //
-   for(i = mGhostZeroUpdateIndex - 1; i >= 0 && !bstream->isFull(); i--)
+   for(U32 heapSize = mGhostZeroUpdateIndex; heapSize > 0 && !bstream->isFull(); )
    {
-      GhostInfo *walk = mGhostArray[i];
+      // Pop the ghost with the highest priority.  It is moved right
+      // behind the heap, so pushing it to zero below leaves the heap intact.
+      GhostInfo *walk = mGhostArray[0];
+      heapSize--;
+      if(heapSize > 0)
+      {
+         mGhostArray[0] = mGhostArray[heapSize];
+         mGhostArray[heapSize] = walk;
+         walk->arrayIndex = heapSize;
+         ghostHeapSiftDown(mGhostArray, 0, heapSize);
+      }
+
 		if(walk->flags & (GhostInfo::KillingGhost | GhostInfo::Ghosting))
 		   continue;
 		
@@ -440,6 +496,7 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
 
       upd->ghost = walk;
       upd->ghostInfoFlags = 0;
+      upd->snapshot = NULL;
 
       if(walk->flags & GhostInfo::KillGhost)
       {
@@ -468,6 +525,10 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
             walk->flags &= ~GhostInfo::NotYetGhosted;
             walk->flags |= GhostInfo::Ghosting;
             upd->ghostInfoFlags = GhostInfo::Ghosting;
+
+            // the client starts a fresh snapshot history for new ghosts
+            freeSnapshot(walk->baseline, walk->baselineBits);
+            walk->baseline = NULL;
          }
 #ifdef TORQUE_DEBUG_NET
          else {
@@ -480,7 +541,11 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
 #ifdef TORQUE_NET_STATS
          U32 beginSize = bstream->getBitPosition();
 #endif
-         U32 retMask = walk->obj->packUpdate(this, updateMask, bstream);
+         U32 retMask;
+         if(snapshotDeltas)
+            retMask = ghostPackSnapshot(walk, upd, updateMask, bstream);
+         else
+            retMask = walk->obj->packUpdate(this, updateMask, bstream);
 #ifdef TORQUE_NET_STATS
          walk->obj->getClassRep()->updateNetStatPack(updateMask, bstream->getBitPosition() - beginSize);
 #endif
@@ -502,6 +567,7 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
 #endif
       }
       walk->updateSkipCount = 0;
+      walk->flags |= GhostInfo::PriorityDirty;
       count++;
    }
    //Con::printf("Ghosts updated: %d (%d remain)", count, mGhostZeroUpdateIndex);
@@ -525,6 +591,7 @@ void NetConnection::ghostReadPacket(BitStream *bstream)
    S32 idSize;
    idSize = bstream->readInt( GhostIndexBitSize);
    idSize += 3;
+   const bool snapshotDeltas = bstream->readFlag();
 
    // while there's an object waiting...
    gGhostUpdates = 0;
@@ -543,6 +610,7 @@ void NetConnection::ghostReadPacket(BitStream *bstream)
          AssertFatal(mLocalGhosts[index] != NULL, "Error, NULL ghost encountered.");
          mLocalGhosts[index]->deleteObject();
          mLocalGhosts[index] = NULL;
+         clearGhostSnapshots(index);
       }
       else
       {
@@ -586,10 +654,16 @@ void NetConnection::ghostReadPacket(BitStream *bstream)
 #ifdef TORQUE_NET_STATS
             U32 beginSize = bstream->getBitPosition();
 #endif
-            mLocalGhosts[index]->unpackUpdate(this, bstream);
+            clearGhostSnapshots(index);
+            if(snapshotDeltas)
+               ghostUnpackSnapshot(index, bstream);
+            else
+               mLocalGhosts[index]->unpackUpdate(this, bstream);
 #ifdef TORQUE_NET_STATS
             mLocalGhosts[index]->getClassRep()->updateNetStatUnpack(bstream->getBitPosition() - beginSize);
 #endif
+            if(mErrorBuffer.isNotEmpty())
+               return;
             // Setup the remote object pointers before
             // we register so that it can be used from onAdd.
             if( mRemoteConnection )
@@ -635,10 +709,15 @@ void NetConnection::ghostReadPacket(BitStream *bstream)
 #ifdef TORQUE_NET_STATS
             U32 beginSize = bstream->getBitPosition();
 #endif
-            mLocalGhosts[index]->unpackUpdate(this, bstream);
+            if(snapshotDeltas)
+               ghostUnpackSnapshot(index, bstream);
+            else
+               mLocalGhosts[index]->unpackUpdate(this, bstream);
 #ifdef TORQUE_NET_STATS
             mLocalGhosts[index]->getClassRep()->updateNetStatUnpack(bstream->getBitPosition() - beginSize);
 #endif
+            if(mErrorBuffer.isNotEmpty())
+               return;
             ghostReadExtra(mLocalGhosts[index],bstream,false);
          }
          //PacketStream::getStats()->addBits(PacketStats::Receive, bstream->getCurPos() - startPos, ghostRefs[index].localGhost->getPersistTag());
@@ -657,6 +736,202 @@ void NetConnection::ghostReadPacket(BitStream *bstream)
 
 //-----------------------------------------------------------------------------
 
+U32 NetConnection::ghostPackSnapshot(GhostInfo *ghost, GhostRef *ref, U32 updateMask, BitStream *bstream)
+{
+   // pack into a scratch stream first, so the bits can be kept and
+   // compared against the baseline.  every bit written is set or cleared
+   // explicitly, so only the unused bits of the last byte need clearing.
+   U8 packBuffer[Net::MaxPacketDataSize];
+   BitStream packStream(packBuffer, sizeof(packBuffer));
+   packStream.setCompressionPoint(bstream->getCompressionPoint());
+
+   U32 retMask = ghost->obj->packUpdate(this, updateMask, &packStream);
+
+   // packUpdate may have moved the compression point for the ghosts that follow
+   bstream->setCompressionPoint(packStream.getCompressionPoint());
+
+   const U32 bitCount = packStream.getBitPosition();
+   const U32 byteCount = (bitCount + 7) >> 3;
+   AssertFatal(bitCount < (1 << GhostSnapshotSizeBits), "NetConnection::ghostPackSnapshot - update too large.");
+   if(bitCount & 0x7)
+      packBuffer[byteCount - 1] &= (1 << (bitCount & 0x7)) - 1;
+
+   ref->snapshotSequence = ghost->snapshotSequence++;
+   ref->snapshotBits = bitCount;
+   ref->snapshot = allocSnapshot(bitCount);
+   dMemcpy(ref->snapshot, packBuffer, byteCount);
+
+   bstream->writeInt(ref->snapshotSequence & (GhostSnapshotSequenceCount - 1), GhostSnapshotSequenceBits);
+
+   // the client only remembers the last few updates it received, so the
+   // baseline is only usable if not too many updates were sent since.
+   // every changed byte of the delta costs 9 bits, every unchanged one 1.
+   const U32 baselineBytes = ghost->baseline ? (ghost->baselineBits + 7) >> 3 : 0;
+   bool useDelta = false;
+   if(ghost->baseline && ref->snapshotSequence - ghost->baselineSequence <= GhostSnapshotHistorySize)
+   {
+      U32 deltaBits = GhostSnapshotSequenceBits + 1 + byteCount;
+      if(bitCount != ghost->baselineBits)
+         deltaBits += GhostSnapshotSizeBits;
+      for(U32 i = 0; i < byteCount && deltaBits < bitCount; i++)
+      {
+         if(packBuffer[i] != (i < baselineBytes ? ghost->baseline[i] : 0))
+            deltaBits += 8;
+      }
+      useDelta = deltaBits < bitCount;
+   }
+
+   if(bstream->writeFlag(useDelta))
+   {
+      bstream->writeInt(ghost->baselineSequence & (GhostSnapshotSequenceCount - 1), GhostSnapshotSequenceBits);
+      if(!bstream->writeFlag(bitCount == ghost->baselineBits))
+         bstream->writeInt(bitCount, GhostSnapshotSizeBits);
+
+      for(U32 i = 0; i < byteCount; i++)
+      {
+         U8 delta = packBuffer[i] ^ (i < baselineBytes ? ghost->baseline[i] : 0);
+         if(bstream->writeFlag(delta != 0))
+            bstream->writeInt(delta, 8);
+      }
+   }
+   else
+      bstream->writeBits(bitCount, packBuffer);
+
+   return retMask;
+}
+
+void NetConnection::ghostUnpackSnapshot(U32 index, BitStream *bstream)
+{
+   if(!mGhostSnapshots)
+   {
+      mGhostSnapshots = new GhostSnapshotHistory *[MaxGhostCount];
+      for(S32 i = 0; i < MaxGhostCount; i++)
+         mGhostSnapshots[i] = NULL;
+   }
+
+   GhostSnapshotHistory *history = mGhostSnapshots[index];
+   if(!history)
+   {
+      history = new GhostSnapshotHistory;
+      dMemset(history, 0, sizeof(GhostSnapshotHistory));
+      mGhostSnapshots[index] = history;
+   }
+
+   NetObject *obj = mLocalGhosts[index];
+   U32 sequence = bstream->readInt(GhostSnapshotSequenceBits);
+   U32 bitCount;
+   U8 *data;
+
+   if(bstream->readFlag())
+   {
+      // find the baseline, newest first; older updates may share its
+      // sequence number
+      U32 baselineSequence = bstream->readInt(GhostSnapshotSequenceBits);
+      GhostSnapshot *baseline = NULL;
+      for(U32 i = 1; i <= GhostSnapshotHistorySize && !baseline; i++)
+      {
+         GhostSnapshot &snapshot = history->snapshots[(history->next + GhostSnapshotHistorySize - i) % GhostSnapshotHistorySize];
+         if(snapshot.data && snapshot.sequence == baselineSequence)
+            baseline = &snapshot;
+      }
+      if(!baseline)
+      {
+         setLastError("Invalid packet. (missing ghost snapshot baseline)");
+         return;
+      }
+
+      bitCount = bstream->readFlag() ? baseline->bitCount : bstream->readInt(GhostSnapshotSizeBits);
+
+      const U32 byteCount = (bitCount + 7) >> 3;
+      const U32 baselineBytes = (baseline->bitCount + 7) >> 3;
+      data = allocSnapshot(bitCount);
+      for(U32 i = 0; i < byteCount; i++)
+      {
+         U8 delta = bstream->readFlag() ? U8(bstream->readInt(8)) : 0;
+         data[i] = delta ^ (i < baselineBytes ? baseline->data[i] : 0);
+      }
+      if(bitCount & 0x7)
+         data[byteCount - 1] &= (1 << (bitCount & 0x7)) - 1;
+
+      BitStream unpackStream(data, byteCount);
+      unpackStream.setCompressionPoint(bstream->getCompressionPoint());
+      obj->unpackUpdate(this, &unpackStream);
+      bstream->setCompressionPoint(unpackStream.getCompressionPoint());
+   }
+   else
+   {
+      // unpack in place, then go back and copy out the bits it consumed
+      U32 start = bstream->getBitPosition();
+      obj->unpackUpdate(this, bstream);
+      bitCount = bstream->getBitPosition() - start;
+
+      const U32 byteCount = (bitCount + 7) >> 3;
+      data = allocSnapshot(bitCount);
+      bstream->setCurPos(start);
+      bstream->readBits(bitCount, data);
+      if(bitCount & 0x7)
+         data[byteCount - 1] &= (1 << (bitCount & 0x7)) - 1;
+   }
+
+   GhostSnapshot &slot = history->snapshots[history->next];
+   freeSnapshot(slot.data, slot.bitCount);
+   slot.sequence = sequence;
+   slot.bitCount = bitCount;
+   slot.data = data;
+   history->next = (history->next + 1) % GhostSnapshotHistorySize;
+}
+
+void NetConnection::clearGhostSnapshots(U32 index)
+{
+   if(!mGhostSnapshots || !mGhostSnapshots[index])
+      return;
+
+   GhostSnapshotHistory *history = mGhostSnapshots[index];
+   for(U32 i = 0; i < GhostSnapshotHistorySize; i++)
+      freeSnapshot(history->snapshots[i].data, history->snapshots[i].bitCount);
+
+   delete history;
+   mGhostSnapshots[index] = NULL;
+}
+
+namespace {
+
+// snapshot buffers are pooled by power of two size, from SnapshotPoolMinBytes
+// up to the largest update GhostSnapshotSizeBits can describe.
+enum
+{
+   SnapshotPoolMinBytes = 16,
+   SnapshotPoolCount = 8,
+};
+
+FreeListChunkerUntyped *gSnapshotPools[SnapshotPoolCount];
+
+U32 getSnapshotPool(U32 bitCount)
+{
+   const U32 byteCount = (bitCount + 7) >> 3;
+   U32 pool = 0;
+   while((U32(SnapshotPoolMinBytes) << pool) < byteCount)
+      pool++;
+   return pool;
+}
+
+}
+
+U8 *NetConnection::allocSnapshot(U32 bitCount)
+{
+   const U32 pool = getSnapshotPool(bitCount);
+   AssertFatal(pool < SnapshotPoolCount, "NetConnection::allocSnapshot - update too large.");
+
+   if(!gSnapshotPools[pool])
+      gSnapshotPools[pool] = new FreeListChunkerUntyped(SnapshotPoolMinBytes << pool);
+   return reinterpret_cast<U8 *>(gSnapshotPools[pool]->alloc());
+}
+
+void NetConnection::freeSnapshot(U8 *data, U32 bitCount)
+{
+   if(data)
+      gSnapshotPools[getSnapshotPool(bitCount)]->free(data);
+}
 
 //-----------------------------------------------------------------------------
 
@@ -714,6 +989,9 @@ void NetConnection::freeGhostInfo(GhostInfo *ghost)
    }
    ghostPushZeroToFree(ghost);
    AssertFatal(ghost->updateChain == NULL, "Ack!");
+
+   freeSnapshot(ghost->baseline, ghost->baselineBits);
+   ghost->baseline = NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -804,7 +1082,7 @@ void NetConnection::objectInScope(NetObject *obj)
    giptr->updateMask = 0xFFFFFFFF;
    ghostPushNonZero(giptr);
 
-   giptr->flags = GhostInfo::NotYetGhosted | GhostInfo::InScope;
+   giptr->flags = GhostInfo::NotYetGhosted | GhostInfo::InScope | GhostInfo::PriorityDirty;
 
    if(obj->mNetFlags.test(NetObject::ScopeAlways))
       giptr->flags |= GhostInfo::ScopeAlways;
@@ -880,6 +1158,7 @@ void NetConnection::handleConnectionMessage(U32 message, U32 sequence, U32 ghost
                mLocalGhosts[i]->deleteObject();
                mLocalGhosts[i] = NULL;
             }
+            clearGhostSnapshots(i);
          }
          while(mGhostAlwaysSaveList.size())
          {
@@ -1171,6 +1450,7 @@ void NetConnection::loadNextGhostAlwaysObject(bool hadNewFiles)
 
       AssertFatal(mLocalGhosts[index] == NULL, "Ghost already in table!");
       mLocalGhosts[index] = object;
+      clearGhostSnapshots(index);
       hadNewFiles = true;
    }
 }
@@ -1182,6 +1462,18 @@ NetObject *NetConnection::resolveGhost(S32 id)
    return mLocalGhosts[id];
 }
 
+U32 NetConnection::getLocalGhostCount() const
+{
+   if(!mLocalGhosts)
+      return 0;
+
+   U32 count = 0;
+   for(U32 i = 0; i < MaxGhostCount; i++)
+      if(mLocalGhosts[i])
+         count++;
+   return count;
+}
+
 NetObject *NetConnection::resolveObjectFromGhostIndex(S32 id)
 {
    return mGhostRefs[id].obj;
@@ -1247,6 +1539,31 @@ void NetConnection::ghostWriteStartBlock(ResizeBitStream *stream)
          stream->validate();
       }
    }
+
+   // finally, the snapshot histories, so that recorded snapshot deltas
+   // can be decoded on playback.
+   for(U32 i = 0; i < MaxGhostCount; i++)
+   {
+      if(!mLocalGhosts[i] || !mGhostSnapshots || !mGhostSnapshots[i])
+         continue;
+
+      GhostSnapshotHistory *history = mGhostSnapshots[i];
+      stream->writeFlag(true);
+      stream->writeInt(i, GhostIdBitSize);
+      stream->writeInt(history->next, GhostSnapshotSequenceBits);
+      for(U32 j = 0; j < GhostSnapshotHistorySize; j++)
+      {
+         GhostSnapshot &snapshot = history->snapshots[j];
+         if(stream->writeFlag(snapshot.data != NULL))
+         {
+            stream->writeInt(snapshot.sequence, GhostSnapshotSequenceBits);
+            stream->writeInt(snapshot.bitCount, GhostSnapshotSizeBits);
+            stream->writeBits(snapshot.bitCount, snapshot.data);
+         }
+         stream->validate();
+      }
+   }
+   stream->writeFlag(false);
 }
 
 void NetConnection::ghostReadStartBlock(BitStream *stream)
@@ -1289,6 +1606,39 @@ void NetConnection::ghostReadStartBlock(BitStream *stream)
          addObject(mLocalGhosts[i]);
       }
    }
+
+   // and the snapshot histories.
+   while(stream->readFlag())
+   {
+      U32 index = stream->readInt(GhostIdBitSize);
+      clearGhostSnapshots(index);
+      if(!mGhostSnapshots)
+      {
+         mGhostSnapshots = new GhostSnapshotHistory *[MaxGhostCount];
+         for(S32 i = 0; i < MaxGhostCount; i++)
+            mGhostSnapshots[i] = NULL;
+      }
+
+      GhostSnapshotHistory *history = new GhostSnapshotHistory;
+      dMemset(history, 0, sizeof(GhostSnapshotHistory));
+      mGhostSnapshots[index] = history;
+
+      history->next = stream->readInt(GhostSnapshotSequenceBits) % GhostSnapshotHistorySize;
+      for(U32 j = 0; j < GhostSnapshotHistorySize; j++)
+      {
+         if(!stream->readFlag())
+            continue;
+
+         GhostSnapshot &snapshot = history->snapshots[j];
+         snapshot.sequence = stream->readInt(GhostSnapshotSequenceBits);
+         snapshot.bitCount = stream->readInt(GhostSnapshotSizeBits);
+         snapshot.data = allocSnapshot(snapshot.bitCount);
+         stream->readBits(snapshot.bitCount, snapshot.data);
+         if(snapshot.bitCount & 0x7)
+            snapshot.data[snapshot.bitCount >> 3] &= (1 << (snapshot.bitCount & 0x7)) - 1;
+      }
+   }
+
    // MARKF - TODO - looks like we could have memory leaks here
    // if there are errors.
 }
@@ -27,6 +27,7 @@
 #include "sim/netObject.h"
 #include "console/consoleTypes.h"
 #include "console/engineAPI.h"
+#include "platform/threads/mutex.h"
 
 IMPLEMENT_CONOBJECT(NetObject);
 
@@ -37,6 +38,11 @@ ConsoleDocClass( NetObject,
 
 //----------------------------------------------------------------------------
 NetObject *NetObject::mDirtyList = NULL;
+bool NetObject::smDeferMaskBits = false;
+
+// Objects that have mask bits recorded while dirty list updates are deferred.
+static Mutex sDeferredMaskBitsMutex;
+static Vector< NetObject* > sDeferredMaskBitsObjects;
 
 NetObject::NetObject()
 {
@@ -46,10 +52,13 @@ NetObject::NetObject()
    mPrevDirtyList = NULL;
    mNextDirtyList = NULL;
    mDirtyMaskBits = 0;
+   mDeferredMaskBits = 0;
 }
 
 NetObject::~NetObject()
 {
+   AssertFatal(!mDeferredMaskBits, "NetObject::~NetObject - object deleted with deferred mask bits pending");
+
    if(mDirtyMaskBits)
    {
       if(mPrevDirtyList)
@@ -76,6 +85,18 @@ String NetObject::describeSelf() const
 void NetObject::setMaskBits(U32 orMask)
 {
    AssertFatal(orMask != 0, "Invalid net mask bits set.");
+
+   if(smDeferMaskBits)
+   {
+      MutexHandle handle;
+      handle.lock(&sDeferredMaskBitsMutex, true);
+
+      if(!mDeferredMaskBits)
+         sDeferredMaskBitsObjects.push_back(this);
+      mDeferredMaskBits |= orMask;
+      return;
+   }
+
    AssertFatal(mDirtyMaskBits == 0 || (mPrevDirtyList != NULL || mNextDirtyList != NULL || mDirtyList == this), "Invalid dirty list state.");
    if(!mDirtyMaskBits)
    {
@@ -91,6 +112,44 @@ void NetObject::setMaskBits(U32 orMask)
    AssertFatal(mDirtyMaskBits == 0 || (mPrevDirtyList != NULL || mNextDirtyList != NULL || mDirtyList == this), "Invalid dirty list state.");
 }
 
+static S32 QSORT_CALLBACK compareNetObjectIds(const void* a, const void* b)
+{
+   const NetObject* objA = *(const NetObject* const*) a;
+   const NetObject* objB = *(const NetObject* const*) b;
+
+   return S32(objA->getId()) - S32(objB->getId());
+}
+
+void NetObject::beginDeferredMaskBits()
+{
+   AssertFatal(!smDeferMaskBits, "NetObject::beginDeferredMaskBits - already deferring");
+   smDeferMaskBits = true;
+}
+
+void NetObject::endDeferredMaskBits()
+{
+   AssertFatal(smDeferMaskBits, "NetObject::endDeferredMaskBits - not deferring");
+   smDeferMaskBits = false;
+
+   if(sDeferredMaskBitsObjects.empty())
+      return;
+
+   dQsort(sDeferredMaskBitsObjects.address(), sDeferredMaskBitsObjects.size(), sizeof(NetObject*), compareNetObjectIds);
+
+   for(U32 i = 0; i < sDeferredMaskBitsObjects.size(); i++)
+   {
+      NetObject *obj = sDeferredMaskBitsObjects[i];
+      U32 orMask = obj->mDeferredMaskBits;
+      obj->mDeferredMaskBits = 0;
+
+      // The bits already went through any setMaskBits() override
+      // when they were recorded.
+      obj->NetObject::setMaskBits(orMask);
+   }
+
+   sDeferredMaskBitsObjects.clear();
+}
+
 void NetObject::clearMaskBits(U32 orMask)
 {
    if(isDeleted())
@@ -252,6 +252,13 @@ private:
    /// Previous item in the dirty list...
    NetObject *mNextDirtyList;
 
+   /// Mask bits set while the dirty list update is deferred.
+   /// @see beginDeferredMaskBits
+   U32 mDeferredMaskBits;
+
+   /// If true, setMaskBits() only records the bits in #mDeferredMaskBits.
+   static bool smDeferMaskBits;
+
    /// @}
 protected:
 
@@ -294,6 +301,23 @@ public:
 
    static void collapseDirtyList();
 
+   /// Start deferring dirty list updates done by setMaskBits().
+   ///
+   /// While deferred, setMaskBits() may be called on any thread.  This is used
+   /// while objects are ticked on several threads.
+   static void beginDeferredMaskBits();
+
+   /// Stop deferring and apply all mask bits recorded since beginDeferredMaskBits()
+   /// in the order of the object IDs.
+   static void endDeferredMaskBits();
+
+   /// Return the most recently dirtied object.  The dirty list continues
+   /// through getNextDirtyObject() in reverse order of insertion.
+   static NetObject* getDirtyList() { return mDirtyList; }
+
+   /// Return the object dirtied before this one or NULL.
+   NetObject* getNextDirtyObject() const { return mNextDirtyList; }
+
    /// Used to mark a bit as dirty; ie, that its corresponding set of fields need to be transmitted next update.
    ///
    /// @param   orMask   Bit(s) to set
@@ -0,0 +1,99 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _NETGHOSTTESTUTILS_H_
+#define _NETGHOSTTESTUTILS_H_
+
+#ifndef _NETCONNECTION_H_
+#include "sim/netConnection.h"
+#endif
+#ifndef _NETOBJECT_H_
+#include "sim/netObject.h"
+#endif
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+
+
+// Helpers shared by the ghosting unit tests.
+
+
+/// Scope object that puts all objects of a test in scope for a camera at
+/// mCameraPos.
+template< class T >
+class GhostTestScope : public NetObject
+{
+   public:
+
+      typedef NetObject Parent;
+
+      Vector< T* >* mObjects;
+      Point3F mCameraPos;
+
+      GhostTestScope( Vector< T* >* objects )
+         : mObjects( objects ),
+           mCameraPos( 0.0f, 0.0f, 0.0f ) {}
+
+      void onCameraScopeQuery( NetConnection* cr, CameraScopeQuery* camInfo )
+      {
+         camInfo->pos = mCameraPos;
+         camInfo->visibleDistance = 500.0f;
+
+         for( U32 i = 0; i < mObjects->size(); ++ i )
+            cr->objectInScope( ( *mObjects )[ i ] );
+      }
+};
+
+/// Connection that can be made to ghost from the server side without a
+/// connection handshake.
+class GhostTestConnection : public NetConnection
+{
+   public:
+
+      typedef NetConnection Parent;
+
+      void startGhosting()
+      {
+         setGhostFrom( true );
+         for( U32 i = 0; i < MaxGhostCount; ++ i )
+         {
+            mGhostArray[ i ] = mGhostRefs + i;
+            mGhostArray[ i ]->arrayIndex = i;
+         }
+
+         mScoping = true;
+         mGhosting = true;
+      }
+
+      void stopGhosting()
+      {
+         mGhosting = false;
+         mScoping = false;
+         clearGhostInfo();
+      }
+
+      U32 getNumDirtyGhosts() const { return mGhostZeroUpdateIndex; }
+      NetObject* getLocalGhost( U32 index ) const { return mLocalGhosts[ index ]; }
+      S32 getGhostIndex( NetObject* object ) { return Parent::getGhostIndex( object ); }
+};
+
+#endif // _NETGHOSTTESTUTILS_H_
@@ -0,0 +1,214 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "sim/netDemoStream.h"
+#include "core/stream/fileStream.h"
+#include "console/console.h"
+#include "math/mRandom.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Writes blocks and keyframes through NetDemoWriteStream, then reads them
+// back in order and through the seek index.
+
+CreateUnitTest( TestNetDemoStream, "Sim/NetDemoStream" )
+{
+   enum
+   {
+      NUM_TICKS = 2000,
+      KEYFRAME_INTERVAL = 250,
+      KEYFRAME_SIZE = 20000,
+   };
+
+   const char* mFileName;
+
+   /// Write the blocks for @a tick into @a stream; a U32 tick followed by
+   /// some mostly repetitive bytes.
+   void writeTick( Stream* stream, U32 tick, MRandomLCG& random )
+   {
+      U8 data[ 512 ];
+      const U32 size = random.randI( 1, sizeof( data ) );
+      for( U32 i = 0; i < size; ++ i )
+         data[ i ] = ( i & 0xF ) ? U8( tick ) : U8( random.randI( 0, 255 ) );
+
+      stream->write( tick );
+      stream->write( size );
+      stream->write( size, data );
+   }
+
+   bool readTick( Stream* stream, U32 tick, MRandomLCG& random )
+   {
+      U8 data[ 512 ];
+      U8 expected[ 512 ];
+      const U32 size = random.randI( 1, sizeof( data ) );
+      for( U32 i = 0; i < size; ++ i )
+         expected[ i ] = ( i & 0xF ) ? U8( tick ) : U8( random.randI( 0, 255 ) );
+
+      U32 readTick, readSize;
+      stream->read( &readTick );
+      stream->read( &readSize );
+      if( readTick != tick || readSize != size || !stream->read( size, data ) )
+         return false;
+      return dMemcmp( data, expected, size ) == 0;
+   }
+
+   void writeKeyframe( Stream* stream, U32 tick )
+   {
+      // Larger than a chunk would be if keyframes were regular blocks.
+      U8 data[ KEYFRAME_SIZE ];
+      dMemset( data, U8( tick ), sizeof( data ) );
+      stream->write( tick );
+      stream->write( U32( KEYFRAME_SIZE ) );
+      stream->write( KEYFRAME_SIZE, data );
+   }
+
+   bool readKeyframe( NetDemoReadStream* stream, U32 tick )
+   {
+      U32 readTick, size;
+      stream->read( &readTick );
+      stream->read( &size );
+      if( readTick != tick || size != KEYFRAME_SIZE )
+         return false;
+      return stream->skip( size );
+   }
+
+   /// Random generator state at the start of every tick, so that reads
+   /// can resume anywhere.
+   MRandomLCG mRandom[ NUM_TICKS ];
+
+   void write( bool compress )
+   {
+      FileStream* fs = FileStream::createAndOpen( mFileName, Torque::FS::File::Write );
+      TEST( fs != NULL );
+      if( !fs )
+         return;
+
+      NetDemoWriteStream* stream = new NetDemoWriteStream( fs, compress );
+
+      MRandomLCG random( 1 );
+      for( U32 tick = 0; tick < NUM_TICKS; ++ tick )
+      {
+         if( ( tick % KEYFRAME_INTERVAL ) == 0 )
+         {
+            stream->beginKeyframe( tick );
+            writeKeyframe( stream, tick );
+         }
+         mRandom[ tick ] = random;
+         writeTick( stream, tick, random );
+      }
+      stream->setTickCount( NUM_TICKS );
+
+      delete stream;
+   }
+
+   NetDemoReadStream* open()
+   {
+      FileStream* fs = FileStream::createAndOpen( mFileName, Torque::FS::File::Read );
+      TEST( fs != NULL );
+      if( !fs )
+         return NULL;
+      return new NetDemoReadStream( fs, true );
+   }
+
+   void testSequential()
+   {
+      NetDemoReadStream* stream = open();
+      if( !stream )
+         return;
+
+      TEST( stream->canSeek() );
+      TEST( stream->getTickCount() == NUM_TICKS );
+
+      bool ok = true;
+      MRandomLCG random( 1 );
+      for( U32 tick = 0; tick < NUM_TICKS && ok; ++ tick )
+      {
+         if( ( tick % KEYFRAME_INTERVAL ) == 0 )
+            ok = readKeyframe( stream, tick );
+         ok = ok && readTick( stream, tick, random );
+      }
+      TEST( ok );
+
+      // The end chunk stops the block data.
+      U32 dummy;
+      TEST( !stream->read( &dummy ) );
+      TEST( stream->getStatus() == Stream::EOS );
+
+      delete stream;
+   }
+
+   void testSeek()
+   {
+      NetDemoReadStream* stream = open();
+      if( !stream )
+         return;
+
+      const U32 seekTicks[] = { 1999, 0, 1000, 1001, 249, 250, 1750 };
+      for( U32 i = 0; i < sizeof( seekTicks ) / sizeof( seekTicks[ 0 ] ); ++ i )
+      {
+         U32 keyframeTick = 0;
+         TEST( stream->seekKeyframe( seekTicks[ i ], keyframeTick ) );
+         TEST( keyframeTick == seekTicks[ i ] - ( seekTicks[ i ] % KEYFRAME_INTERVAL ) );
+         TEST( readKeyframe( stream, keyframeTick ) );
+
+         // Play forward to the requested tick.
+         bool ok = true;
+         for( U32 tick = keyframeTick; tick <= seekTicks[ i ] && ok; ++ tick )
+         {
+            MRandomLCG random = mRandom[ tick ];
+            ok = readTick( stream, tick, random );
+         }
+         TEST( ok );
+      }
+
+      delete stream;
+   }
+
+   void run()
+   {
+      mFileName = "netDemoStreamTest.dem";
+
+      for( U32 compress = 0; compress < 2; ++ compress )
+      {
+         write( compress != 0 );
+         testSequential();
+         testSeek();
+
+         FileStream* fs = FileStream::createAndOpen( mFileName, Torque::FS::File::Read );
+         if( fs )
+         {
+            Con::printf( "Demo stream: %s, %d ticks, %d bytes",
+               compress ? "compressed" : "stored", U32( NUM_TICKS ), fs->getStreamSize() );
+            delete fs;
+         }
+      }
+
+      dFileDelete( mFileName );
+   }
+};
+
+#endif // !TORQUE_SHIPPING
@@ -0,0 +1,253 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "sim/test/netGhostTestUtils.h"
+#include "core/stream/bitStream.h"
+#include "console/console.h"
+#include "core/util/tVector.h"
+#include "math/mRandom.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Drives the ghost update scheduler of several server-side connections
+// directly, without a network in between.  Every simulated packet is
+// written into the packet stream and acknowledged right away.
+
+/// Ghosted object with a distance-based update priority.
+class GhostSchedulingTestObject : public NetObject
+{
+   public:
+
+      typedef NetObject Parent;
+
+      Point3F mPosition;
+
+      /// Number of calls to getUpdatePriority() on all instances.
+      static U32 smNumPriorityCalls;
+
+      GhostSchedulingTestObject()
+         : mPosition( 0.0f, 0.0f, 0.0f )
+      {
+         mNetFlags.set( Ghostable );
+      }
+
+      F32 getUpdatePriority( CameraScopeQuery* camInfo, U32 updateMask, S32 updateSkips )
+      {
+         smNumPriorityCalls ++;
+
+         F32 dist = ( mPosition - camInfo->pos ).len();
+         F32 wDistance = ( dist < camInfo->visibleDistance ) ? 1.0f - dist / camInfo->visibleDistance : 0.0f;
+
+         return wDistance + F32( updateSkips ) * 0.1f;
+      }
+
+      U32 packUpdate( NetConnection* conn, U32 mask, BitStream* stream )
+      {
+         stream->write( mPosition.x );
+         stream->write( mPosition.y );
+         stream->write( mPosition.z );
+         return 0;
+      }
+
+      DECLARE_CONOBJECT( GhostSchedulingTestObject );
+};
+
+IMPLEMENT_CO_NETOBJECT_V1( GhostSchedulingTestObject );
+
+U32 GhostSchedulingTestObject::smNumPriorityCalls;
+
+/// Connection that ghosts without a remote side.
+class GhostSchedulingTestConnection : public GhostTestConnection
+{
+   public:
+
+      typedef GhostTestConnection Parent;
+
+      /// Write a packet and acknowledge it.  Returns the number of ghosts
+      /// that were written and whether they all had a priority at least as
+      /// high as any ghost that was left waiting.
+      U32 sendPacket( U32 packetSize, bool& outInOrder )
+      {
+         BitStream* stream = BitStream::getPacketStream( packetSize );
+         PacketNotify* notify = allocNotify();
+
+         ghostWritePacket( stream, notify );
+
+         U32 numSent = 0;
+         F32 minSent = F32_MAX;
+         for( GhostRef* ref = notify->ghostList; ref; ref = ref->nextRef )
+         {
+            minSent = getMin( minSent, ref->ghost->priority );
+            numSent ++;
+         }
+
+         F32 maxWaiting = -F32_MAX;
+         for( U32 i = 0; i < mGhostZeroUpdateIndex; ++ i )
+         {
+            GhostInfo* ghost = mGhostArray[ i ];
+            if( !( ghost->flags & ( GhostInfo::KillingGhost | GhostInfo::Ghosting ) ) && !( ghost->flags & GhostInfo::PriorityDirty ) )
+               maxWaiting = getMax( maxWaiting, ghost->priority );
+         }
+
+         outInOrder = ( minSent >= maxWaiting );
+
+         ghostPacketReceived( notify );
+         delete notify;
+
+         return numSent;
+      }
+};
+
+CreateUnitTest( TestNetGhostScheduling, "Sim/NetConnection/GhostScheduling" )
+{
+   enum
+   {
+      DEFAULT_NUM_CLIENTS = 16,
+      DEFAULT_NUM_GHOSTS = 2000,
+      DEFAULT_NUM_PACKETS = 200,
+      DEFAULT_PACKET_SIZE = 450,
+   };
+
+   struct Results
+   {
+      U32 time;
+      U32 numPriorityCalls;
+      U32 numGhostUpdates;
+      bool inOrder;
+   };
+
+   void simulate( U32 numClients, U32 numPackets, U32 packetSize, Vector< GhostSchedulingTestObject* >& objects, Results& results )
+   {
+      MRandomLCG random( 1 );
+
+      GhostTestScope< GhostSchedulingTestObject >* scope = new GhostTestScope< GhostSchedulingTestObject >( &objects );
+      scope->registerObject();
+
+      Vector< GhostSchedulingTestConnection* > clients;
+      for( U32 i = 0; i < numClients; ++ i )
+      {
+         GhostSchedulingTestConnection* client = new GhostSchedulingTestConnection;
+         client->startGhosting();
+         client->setScopeObject( scope );
+         clients.push_back( client );
+      }
+
+      GhostSchedulingTestObject::smNumPriorityCalls = 0;
+      results.numGhostUpdates = 0;
+      results.inOrder = true;
+
+      U32 start = Platform::getRealMilliseconds();
+
+      for( U32 packet = 0; packet < numPackets; ++ packet )
+      {
+         // Move a tenth of the objects and the camera.
+
+         for( U32 i = 0; i < objects.size() / 10; ++ i )
+         {
+            GhostSchedulingTestObject* object = objects[ random.randI( 0, objects.size() - 1 ) ];
+            object->mPosition.x += random.randF( -1.0f, 1.0f );
+            object->setMaskBits( 1 );
+         }
+         NetObject::collapseDirtyList();
+
+         scope->mCameraPos.x = F32( packet );
+
+         for( U32 i = 0; i < numClients; ++ i )
+         {
+            bool inOrder;
+            results.numGhostUpdates += clients[ i ]->sendPacket( packetSize, inOrder );
+            results.inOrder &= inOrder;
+         }
+      }
+
+      results.time = Platform::getRealMilliseconds() - start;
+      results.numPriorityCalls = GhostSchedulingTestObject::smNumPriorityCalls;
+
+      // With nothing changing anymore, all ghosts must get sent eventually.
+
+      for( U32 i = 0; i < numClients; ++ i )
+      {
+         bool inOrder;
+         for( U32 n = 0; n < objects.size() && clients[ i ]->getNumDirtyGhosts(); ++ n )
+            clients[ i ]->sendPacket( packetSize, inOrder );
+
+         TEST( clients[ i ]->getNumDirtyGhosts() == 0 );
+
+         clients[ i ]->stopGhosting();
+         delete clients[ i ];
+      }
+
+      scope->deleteObject();
+   }
+
+   void run()
+   {
+      const U32 numClients = Con::getIntVariable( "$testNetGhostScheduling::numClients", DEFAULT_NUM_CLIENTS );
+      const U32 numGhosts = getMin( U32( Con::getIntVariable( "$testNetGhostScheduling::numGhosts", DEFAULT_NUM_GHOSTS ) ),
+                                    U32( NetConnection::MaxGhostCount ) );
+      const U32 numPackets = Con::getIntVariable( "$testNetGhostScheduling::numPackets", DEFAULT_NUM_PACKETS );
+      const U32 packetSize = Con::getIntVariable( "$testNetGhostScheduling::packetSize", DEFAULT_PACKET_SIZE );
+
+      MRandomLCG random( 1 );
+
+      Vector< GhostSchedulingTestObject* > objects;
+      for( U32 i = 0; i < numGhosts; ++ i )
+      {
+         GhostSchedulingTestObject* object = new GhostSchedulingTestObject;
+         object->mPosition.set( random.randF( -500.0f, 500.0f ), random.randF( -500.0f, 500.0f ), 0.0f );
+         object->registerObject();
+         objects.push_back( object );
+      }
+
+      const S32 oldRefresh = Con::getIntVariable( "$Net::ghostPriorityRefresh" );
+
+      // Recompute every priority on every packet.
+
+      Results full;
+      Con::setIntVariable( "$Net::ghostPriorityRefresh", 1 );
+      simulate( numClients, numPackets, packetSize, objects, full );
+
+      // Default incremental scheduling.
+
+      Results incremental;
+      Con::setIntVariable( "$Net::ghostPriorityRefresh", oldRefresh );
+      simulate( numClients, numPackets, packetSize, objects, incremental );
+
+      TEST( full.inOrder );
+      TEST( incremental.inOrder );
+      TEST( incremental.numPriorityCalls <= full.numPriorityCalls );
+
+      Con::printf( "Ghost scheduling: %i clients, %i ghosts, %i packets", numClients, numGhosts, numPackets );
+      Con::printf( "   full:        %ims, %i priority calls, %i ghost updates", full.time, full.numPriorityCalls, full.numGhostUpdates );
+      Con::printf( "   incremental: %ims, %i priority calls, %i ghost updates", incremental.time, incremental.numPriorityCalls, incremental.numGhostUpdates );
+
+      for( U32 i = 0; i < objects.size(); ++ i )
+         objects[ i ]->deleteObject();
+   }
+};
+
+#endif // !TORQUE_SHIPPING
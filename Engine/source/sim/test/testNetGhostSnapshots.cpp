@@ -0,0 +1,241 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "sim/test/netGhostTestUtils.h"
+#include "core/stream/bitStream.h"
+#include "console/console.h"
+#include "core/util/tVector.h"
+#include "math/mRandom.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Ghosts objects from a server-side connection to a client-side connection
+// through a simulated lossy link, with and without snapshot deltas, and
+// checks that the ghosts end up in the same state either way.
+
+/// Ghosted object with slowly changing state.
+class GhostSnapshotTestObject : public NetObject
+{
+   public:
+
+      typedef NetObject Parent;
+
+      enum MaskBits
+      {
+         PositionMask = BIT( 0 ),
+         StateMask = BIT( 1 ),
+      };
+
+      Point3F mPosition;
+      U32 mState;
+
+      GhostSnapshotTestObject()
+         : mPosition( 0.0f, 0.0f, 0.0f ),
+           mState( 0 )
+      {
+         mNetFlags.set( Ghostable );
+      }
+
+      U32 packUpdate( NetConnection* conn, U32 mask, BitStream* stream )
+      {
+         if( stream->writeFlag( mask & PositionMask ) )
+         {
+            stream->write( mPosition.x );
+            stream->write( mPosition.y );
+            stream->write( mPosition.z );
+         }
+         if( stream->writeFlag( mask & StateMask ) )
+            stream->write( mState );
+         return 0;
+      }
+
+      void unpackUpdate( NetConnection* conn, BitStream* stream )
+      {
+         if( stream->readFlag() )
+         {
+            stream->read( &mPosition.x );
+            stream->read( &mPosition.y );
+            stream->read( &mPosition.z );
+         }
+         if( stream->readFlag() )
+            stream->read( &mState );
+      }
+
+      DECLARE_CONOBJECT( GhostSnapshotTestObject );
+};
+
+IMPLEMENT_CO_NETOBJECT_V1( GhostSnapshotTestObject );
+
+/// Connection that exposes both ends of the ghosting protocol.
+class GhostSnapshotTestConnection : public GhostTestConnection
+{
+   public:
+
+      typedef GhostTestConnection Parent;
+
+      /// Write a packet to @a client and either deliver and acknowledge it
+      /// or drop it.  Adds to the number of bits and ghost updates written.
+      void sendPacket( GhostSnapshotTestConnection* client, U32 packetSize, bool drop, U32& numBits, U32& numUpdates )
+      {
+         BitStream* stream = BitStream::getPacketStream( packetSize );
+         PacketNotify* notify = allocNotify();
+
+         ghostWritePacket( stream, notify );
+
+         numBits += stream->getBitPosition();
+         for( GhostRef* ref = notify->ghostList; ref; ref = ref->nextRef )
+            numUpdates ++;
+
+         if( drop )
+            ghostPacketDropped( notify );
+         else
+         {
+            BitStream packet( stream->getBuffer(), stream->getPosition() );
+            client->ghostReadPacket( &packet );
+            ghostPacketReceived( notify );
+         }
+
+         delete notify;
+      }
+};
+
+CreateUnitTest( TestNetGhostSnapshots, "Sim/NetConnection/GhostSnapshots" )
+{
+   enum
+   {
+      DEFAULT_NUM_GHOSTS = 200,
+      DEFAULT_NUM_PACKETS = 300,
+      DEFAULT_PACKET_SIZE = 1024,
+      DROP_PERCENT = 10,
+   };
+
+   /// Run the simulation and return the average number of bits per ghost update.
+   F32 simulate( U32 numPackets, U32 packetSize, Vector< GhostSnapshotTestObject* >& objects )
+   {
+      MRandomLCG random( 1 );
+
+      GhostTestScope< GhostSnapshotTestObject >* scope = new GhostTestScope< GhostSnapshotTestObject >( &objects );
+      scope->registerObject();
+
+      GhostSnapshotTestConnection* server = new GhostSnapshotTestConnection;
+      server->startGhosting();
+      server->setScopeObject( scope );
+
+      GhostSnapshotTestConnection* client = new GhostSnapshotTestConnection;
+      client->setGhostTo( true );
+      client->registerObject();
+
+      NetConnection::getErrorBuffer() = String();
+
+      U32 numBits = 0;
+      U32 numUpdates = 0;
+      for( U32 packet = 0; packet < numPackets; ++ packet )
+      {
+         // Nudge every object a little and occasionally change its state.
+
+         for( U32 i = 0; i < objects.size(); ++ i )
+         {
+            GhostSnapshotTestObject* object = objects[ i ];
+            object->mPosition.x += random.randF( -0.01f, 0.01f );
+            object->mPosition.y += random.randF( -0.01f, 0.01f );
+
+            U32 mask = GhostSnapshotTestObject::PositionMask;
+            if( random.randI( 0, 9 ) == 0 )
+            {
+               object->mState ++;
+               mask |= GhostSnapshotTestObject::StateMask;
+            }
+            object->setMaskBits( mask );
+         }
+         NetObject::collapseDirtyList();
+
+         server->sendPacket( client, packetSize, random.randI( 0, 99 ) < DROP_PERCENT, numBits, numUpdates );
+         TEST( NetConnection::getErrorBuffer().isEmpty() );
+      }
+
+      // Deliver everything that is still dirty and compare.
+
+      for( U32 n = 0; n < objects.size() && server->getNumDirtyGhosts(); ++ n )
+         server->sendPacket( client, packetSize, false, numBits, numUpdates );
+
+      TEST( server->getNumDirtyGhosts() == 0 );
+
+      bool match = true;
+      for( U32 i = 0; i < objects.size(); ++ i )
+      {
+         const S32 index = server->getGhostIndex( objects[ i ] );
+         GhostSnapshotTestObject* ghost = index != -1 ? dynamic_cast< GhostSnapshotTestObject* >( client->getLocalGhost( index ) ) : NULL;
+         match &= ( ghost != NULL && ghost->mPosition == objects[ i ]->mPosition && ghost->mState == objects[ i ]->mState );
+      }
+      TEST( match );
+
+      server->stopGhosting();
+      delete server;
+      client->deleteObject();
+      scope->deleteObject();
+
+      return F32( numBits ) / F32( getMax( numUpdates, U32( 1 ) ) );
+   }
+
+   void run()
+   {
+      const U32 numGhosts = getMin( U32( Con::getIntVariable( "$testNetGhostSnapshots::numGhosts", DEFAULT_NUM_GHOSTS ) ),
+                                    U32( NetConnection::MaxGhostCount ) );
+      const U32 numPackets = Con::getIntVariable( "$testNetGhostSnapshots::numPackets", DEFAULT_NUM_PACKETS );
+      const U32 packetSize = Con::getIntVariable( "$testNetGhostSnapshots::packetSize", DEFAULT_PACKET_SIZE );
+
+      Vector< GhostSnapshotTestObject* > objects;
+      for( U32 i = 0; i < numGhosts; ++ i )
+      {
+         GhostSnapshotTestObject* object = new GhostSnapshotTestObject;
+         object->mPosition.set( F32( i ), 0.0f, 0.0f );
+         object->registerObject();
+         objects.push_back( object );
+      }
+
+      const bool oldDeltas = Con::getBoolVariable( "$Net::ghostSnapshotDeltas" );
+
+      Con::setBoolVariable( "$Net::ghostSnapshotDeltas", false );
+      const F32 fullBits = simulate( numPackets, packetSize, objects );
+
+      Con::setBoolVariable( "$Net::ghostSnapshotDeltas", true );
+      const F32 deltaBits = simulate( numPackets, packetSize, objects );
+
+      Con::setBoolVariable( "$Net::ghostSnapshotDeltas", oldDeltas );
+
+      TEST( deltaBits < fullBits );
+
+      Con::printf( "Ghost snapshots: %i ghosts, %i packets, %i%% dropped", numGhosts, numPackets, DROP_PERCENT );
+      Con::printf( "   full updates:    %.1f bits per update", fullBits );
+      Con::printf( "   snapshot deltas: %.1f bits per update", deltaBits );
+
+      for( U32 i = 0; i < objects.size(); ++ i )
+         objects[ i ]->deleteObject();
+   }
+};
+
+#endif // !TORQUE_SHIPPING
@@ -0,0 +1,256 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "sim/netConnection.h"
+#include "core/stream/bitStream.h"
+#include "core/stream/fileStream.h"
+#include "core/stream/packetCoder.h"
+#include "console/console.h"
+#include "core/util/tVector.h"
+#include "math/mRandom.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Round trips packets through the packet coder.  If a recorded demo is set
+// in $testNetPacketCompression::demoFile, its packets are replayed through
+// the coder as well and the payload bytes per tick are reported.
+
+CreateUnitTest( TestNetPacketCompression, "Sim/NetConnection/PacketCompression" )
+{
+   enum
+   {
+      NUM_PACKETS = 200,
+      HEADER_BITS = 25,    ///< Fixed part of the ConnectionProtocol header.
+   };
+
+   struct Packet
+   {
+      U8 data[ Net::MaxPacketDataSize ];
+      U32 bits;
+   };
+
+   /// Write something resembling ghost updates into @a stream.
+   void writePayload( BitStream* stream, MRandomLCG& random )
+   {
+      const U32 numGhosts = random.randI( 0, 30 );
+      for( U32 i = 0; i < numGhosts; ++ i )
+      {
+         stream->writeFlag( true );
+         stream->writeInt( random.randI( 0, 63 ), 10 );
+         stream->writeFlag( false );
+         if( stream->writeFlag( random.randI( 0, 3 ) == 0 ) )
+            stream->write( random.randF( -100.0f, 100.0f ) );
+         stream->writeFlag( false );
+         stream->writeFlag( false );
+         stream->writeRangedU32( random.randI( 0, 3 ), 0, 15 );
+      }
+      stream->writeFlag( false );
+   }
+
+   void testRoundTrip()
+   {
+      MRandomLCG random( 1 );
+
+      U8 original[ Net::MaxPacketDataSize ];
+      U8 sent[ Net::MaxPacketDataSize ];
+      U8 payload[ Net::MaxPacketDataSize ];
+
+      bool match = true;
+      U32 numCompressed = 0;
+      for( U32 i = 0; i < NUM_PACKETS; ++ i )
+      {
+         dMemset( sent, 0, sizeof( sent ) );
+         BitStream stream( sent, sizeof( sent ) );
+
+         const U32 flagPos = stream.getBitPosition();
+         stream.writeFlag( false );
+         writePayload( &stream, random );
+
+         const U32 payloadBits = stream.getBitPosition() - 1;
+         dMemcpy( original, sent, sizeof( original ) );
+
+         NetConnection::compressPacket( &stream, flagPos );
+
+         BitStream received( sent, stream.getPosition() );
+         BitStream payloadStream( payload, sizeof( payload ) );
+         if( received.readFlag() )
+         {
+            numCompressed ++;
+            match &= NetConnection::decompressPacket( &received, &payloadStream );
+         }
+         else
+         {
+            payloadStream.setBuffer( original, sizeof( original ) );
+            payloadStream.setCurPos( 1 );
+         }
+
+         // Compare the payload bit by bit against what was written.
+         BitStream check( original, sizeof( original ) );
+         check.setCurPos( 1 );
+         for( U32 bit = 0; bit < payloadBits; ++ bit )
+            match &= ( check.readFlag() == payloadStream.readFlag() );
+      }
+
+      TEST( match );
+      TEST( numCompressed > 0 );
+   }
+
+   /// Extract the payload of a recorded packet.  Returns the number of
+   /// payload bits, or 0 if this is not a data packet.
+   U32 readDemoPacket( U8* data, U32 size, U8* payload )
+   {
+      BitStream stream( data, size );
+      stream.setCurPos( HEADER_BITS - 5 );
+      const U32 packetType = stream.readInt( 2 );
+      const U32 ackByteCount = stream.readInt( 3 );
+      if( packetType != 0 || ackByteCount > 4 ) // not a DataPacket
+         return 0;
+      stream.setCurPos( HEADER_BITS + ackByteCount * 8 );
+
+      BitStream payloadStream( payload, Net::MaxPacketDataSize );
+      if( stream.readFlag() )
+      {
+         if( !NetConnection::decompressPacket( &stream, &payloadStream ) )
+            return 0;
+         return payloadStream.getStreamSize() << 3;
+      }
+
+      const U32 start = stream.getBitPosition();
+      const U32 bits = ( size << 3 ) - start;
+      stream.readBits( bits, payload );
+      if( bits & 0x7 )
+         payload[ bits >> 3 ] &= ( 1 << ( bits & 0x7 ) ) - 1;
+      return bits;
+   }
+
+   void replayDemo( const char* fileName )
+   {
+      FileStream* file = FileStream::createAndOpen( fileName, Torque::FS::File::Read );
+      if( !file )
+      {
+         test( false, avar( "Failed to open demo %s", fileName ) );
+         return;
+      }
+
+      // Skip the protocol version and the start block.
+      U32 version, startSize;
+      file->read( &version );
+      file->read( &startSize );
+      file->setPosition( file->getPosition() + startSize );
+
+      Vector< Packet* > packets;
+      U32 numTicks = 0;
+
+      U16 typeSize;
+      while( file->read( &typeSize ) )
+      {
+         const U32 type = typeSize >> 12;
+         const U32 size = typeSize & 0xFFF;
+
+         U8 block[ NetConnection::MaxBlockSize ];
+         if( size && !file->read( size, block ) )
+            break;
+
+         // GameConnection records a move block every tick.
+         if( type == NetConnection::NetConnectionBlockTypeCount )
+            numTicks ++;
+         else if( type == NetConnection::BlockTypePacket )
+         {
+            Packet* packet = new Packet;
+            packet->bits = readDemoPacket( block, size, packet->data );
+            if( packet->bits )
+               packets.push_back( packet );
+            else
+               delete packet;
+         }
+      }
+      delete file;
+
+      if( packets.empty() )
+      {
+         test( false, "No packets in demo" );
+         return;
+      }
+
+      // Train a model on the first half and code the second half with both
+      // the default model and the trained one.
+
+      const U32 half = packets.size() / 2;
+      PacketCoder::Model trained;
+      for( U32 i = 0; i < half; ++ i )
+         trained.train( packets[ i ]->data, packets[ i ]->bits );
+
+      U32 rawBytes = 0;
+      U32 adaptiveBytes = 0;
+      U32 trainedBytes = 0;
+      bool match = true;
+      U8 coded[ Net::MaxPacketDataSize ];
+      U8 decoded[ Net::MaxPacketDataSize ];
+      for( U32 i = half; i < packets.size(); ++ i )
+      {
+         const Packet* packet = packets[ i ];
+         const U32 bytes = ( packet->bits + 7 ) >> 3;
+         rawBytes += bytes;
+
+         U32 size = PacketCoder::encode( packet->data, packet->bits, coded, sizeof( coded ), PacketCoder::getDefaultModel() );
+         adaptiveBytes += size ? getMin( size, bytes ) : bytes;
+
+         size = PacketCoder::encode( packet->data, packet->bits, coded, sizeof( coded ), trained );
+         trainedBytes += size ? getMin( size, bytes ) : bytes;
+
+         if( size )
+         {
+            PacketCoder::decode( coded, size, decoded, packet->bits, trained );
+            match &= ( dMemcmp( decoded, packet->data, bytes ) == 0 );
+         }
+      }
+      TEST( match );
+
+      // Only the second half of the demo was coded.
+      const F32 ticks = F32( getMax( numTicks / 2, U32( 1 ) ) );
+      Con::printf( "Packet compression on %s: %i packets, %i ticks", fileName, packets.size() - half, numTicks / 2 );
+      Con::printf( "   raw:      %.1f bytes/tick", F32( rawBytes ) / ticks );
+      Con::printf( "   adaptive: %.1f bytes/tick", F32( adaptiveBytes ) / ticks );
+      Con::printf( "   trained:  %.1f bytes/tick", F32( trainedBytes ) / ticks );
+
+      for( U32 i = 0; i < packets.size(); ++ i )
+         delete packets[ i ];
+   }
+
+   void run()
+   {
+      testRoundTrip();
+
+      const char* demoFile = Con::getVariable( "$testNetPacketCompression::demoFile" );
+      if( demoFile[ 0 ] )
+         replayDemo( demoFile );
+      else
+         Con::printf( "Set $testNetPacketCompression::demoFile to a recorded demo to measure packet compression." );
+   }
+};
+
+#endif // !TORQUE_SHIPPING
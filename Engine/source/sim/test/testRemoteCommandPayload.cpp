@@ -0,0 +1,92 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "app/net/net.h"
+#include "core/stream/bitStream.h"
+#include "console/console.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Checks that a broadcast payload packs to exactly the same bits as a
+// remote command packed argument by argument.
+
+CreateUnitTest( TestRemoteCommandPayload, "Sim/NetConnection/RemoteCommandPayload" )
+{
+   void run()
+   {
+      NetStringHandle command( "TestBroadcastCommand" );
+      NetStringHandle format( "%1 says %2" );
+
+      char commandTag[ 16 ];
+      char formatTag[ 16 ];
+      commandTag[ 0 ] = StringTagPrefixByte;
+      formatTag[ 0 ] = StringTagPrefixByte;
+      dSprintf( commandTag + 1, sizeof( commandTag ) - 1, "%d", command.getIndex() );
+      dSprintf( formatTag + 1, sizeof( formatTag ) - 1, "%d", format.getIndex() );
+
+      const char* argv[] = { commandTag, "42", "-70000", formatTag, "Player", "hello there", "", "007" };
+      const S32 argc = sizeof( argv ) / sizeof( argv[ 0 ] );
+
+      // Pretend the tags map to these ids on the connection.
+      const U16 ids[] = { 3, 1021 };
+
+      U8 expected[ 512 ];
+      BitStream expectedStream( expected, sizeof( expected ) );
+      expectedStream.writeInt( argc, RemoteCommandEvent::CommandArgsBits );
+      for( S32 i = 0, tag = 0; i < argc; ++ i )
+      {
+         if( U8( argv[ i ][ 0 ] ) == StringTagPrefixByte )
+            NetConnection::packTagString( &expectedStream, ids[ tag ++ ] );
+         else
+            NetConnection::packString( &expectedStream, argv[ i ] );
+      }
+
+      StrongRefPtr< RemoteCommandPayload > payload = new RemoteCommandPayload( argc, argv );
+      TEST( payload->getArgCount() == argc );
+      TEST( payload->getCommand() == command );
+
+      // Pack twice at different bit offsets, as for two connections.
+      for( U32 offset = 0; offset < 2; ++ offset )
+      {
+         U8 packed[ 512 ];
+         BitStream packedStream( packed, sizeof( packed ) );
+         packedStream.writeInt( 0, offset * 3 + 1 );
+         const S32 start = packedStream.getCurPos();
+         payload->pack( &packedStream, ids );
+
+         TEST( packedStream.getCurPos() - start == expectedStream.getCurPos() );
+
+         bool same = true;
+         for( S32 bit = 0; bit < expectedStream.getCurPos(); ++ bit )
+            if( expectedStream.testBit( bit ) != packedStream.testBit( start + bit ) )
+               same = false;
+         TEST( same );
+      }
+   }
+};
+
+#endif // !TORQUE_SHIPPING
@@ -0,0 +1,38 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+
+#ifndef _TSANIMBATCH_ARCH_H_
+#define _TSANIMBATCH_ARCH_H_
+
+#if defined(TORQUE_CPU_X86)
+# // x86 CPU family implementations
+#  // SSE2 needs compiler support for per-function target ISAs, since the
+#  // stock builds only enable SSE.
+#  if (defined(_MSC_VER) && _MSC_VER >= 1700) || defined(__clang__) || \
+      (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#     define TORQUE_TS_ANIM_SSE2
+extern void ts_interpolate_node_transforms_SSE2(const dsize_t count, const Quat16 * const * __restrict rot1, const Quat16 * const * __restrict rot2, const F32 * __restrict interp, const Point3F * __restrict trans, MatrixF * __restrict outMats);
+#  endif
+#
+#else
+# // Other CPU types go here...
+#endif
+
+#endif // _TSANIMBATCH_ARCH_H_
@@ -0,0 +1,179 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include "ts/tsShape.h"
+
+#if defined(TORQUE_CPU_X86)
+#include "ts/tsAnimBatch.h"
+#include "ts/tsTransform.h"
+#include "ts/arch/tsAnimBatch.arch.h"
+
+#if defined(TORQUE_TS_ANIM_SSE2)
+#include <emmintrin.h>
+
+#if defined(_MSC_VER)
+#  define TS_SSE2_TARGET
+#else
+#  define TS_SSE2_TARGET __attribute__((target("sse2")))
+#endif
+
+extern void ts_interpolate_node_transforms_C(const dsize_t count, const Quat16 * const * __restrict rot1, const Quat16 * const * __restrict rot2, const F32 * __restrict interp, const Point3F * __restrict trans, MatrixF * __restrict outMats);
+
+// Load a Quat16 as four floats in [-1,1].
+TS_SSE2_TARGET
+static inline __m128 _loadQuat16(const Quat16 *q, const __m128 &scale)
+{
+   __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(q));
+
+   // Sign extend the four S16s to S32s
+   v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+
+   return _mm_mul_ps(_mm_cvtepi32_ps(v), scale);
+}
+
+TS_SSE2_TARGET
+void ts_interpolate_node_transforms_SSE2(const dsize_t count,
+                                         const Quat16 * const * __restrict rot1,
+                                         const Quat16 * const * __restrict rot2,
+                                         const F32 * __restrict interp,
+                                         const Point3F * __restrict trans,
+                                         MatrixF * __restrict outMats)
+{
+   const __m128 scale = _mm_set1_ps(1.0f / F32(Quat16::MAX_VAL));
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps(1.0f);
+   const __m128 signMask = _mm_set1_ps(-0.0f);
+   const __m128 splitPoint = _mm_set1_ps(0.857f);
+   const __m128 row3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+   dsize_t i = 0;
+
+   // Four nodes at a time in SoA form
+   for(; i + 4 <= count; i += 4)
+   {
+      __m128 x1 = _loadQuat16(rot1[i + 0], scale);
+      __m128 y1 = _loadQuat16(rot1[i + 1], scale);
+      __m128 z1 = _loadQuat16(rot1[i + 2], scale);
+      __m128 w1 = _loadQuat16(rot1[i + 3], scale);
+      _MM_TRANSPOSE4_PS(x1, y1, z1, w1);
+
+      __m128 x2 = _loadQuat16(rot2[i + 0], scale);
+      __m128 y2 = _loadQuat16(rot2[i + 1], scale);
+      __m128 z2 = _loadQuat16(rot2[i + 2], scale);
+      __m128 w2 = _loadQuat16(rot2[i + 3], scale);
+      _MM_TRANSPOSE4_PS(x2, y2, z2, w2);
+
+      // Flip the first quaternion where the two are further than 90 degrees apart
+      __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x1, x2), _mm_mul_ps(y1, y2)),
+                              _mm_add_ps(_mm_mul_ps(z1, z2), _mm_mul_ps(w1, w2)));
+      const __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, zero), signMask);
+      x1 = _mm_xor_ps(x1, flip);
+      y1 = _mm_xor_ps(y1, flip);
+      z1 = _mm_xor_ps(z1, flip);
+      w1 = _mm_xor_ps(w1, flip);
+
+      // Linear interpolation
+      const __m128 t = _mm_loadu_ps(interp + i);
+      __m128 x = _mm_add_ps(x1, _mm_mul_ps(t, _mm_sub_ps(x2, x1)));
+      __m128 y = _mm_add_ps(y1, _mm_mul_ps(t, _mm_sub_ps(y2, y1)));
+      __m128 z = _mm_add_ps(z1, _mm_mul_ps(t, _mm_sub_ps(z2, z1)));
+      __m128 w = _mm_add_ps(w1, _mm_mul_ps(t, _mm_sub_ps(w2, w1)));
+
+      // Renormalize with the same polynomial approximation of 1/sqrt as
+      // TSTransform::interpolate()
+      const __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                                      _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+      const __m128 lo = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.699368f), dist2), _mm_set1_ps(-1.819985f)), dist2), _mm_set1_ps(2.126369f));
+      const __m128 hi = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.454012f), dist2), _mm_set1_ps(-1.403517f)), dist2), _mm_set1_ps(1.949542f));
+      const __m128 useLo = _mm_cmplt_ps(dist2, splitPoint);
+      const __m128 oneOverL = _mm_or_ps(_mm_and_ps(useLo, lo), _mm_andnot_ps(useLo, hi));
+      x = _mm_mul_ps(x, oneOverL);
+      y = _mm_mul_ps(y, oneOverL);
+      z = _mm_mul_ps(z, oneOverL);
+      w = _mm_mul_ps(w, oneOverL);
+
+      // Rotation matrix terms (see m_quatF_set_matF_C)
+      const __m128 xs = _mm_add_ps(x, x);
+      const __m128 ys = _mm_add_ps(y, y);
+      const __m128 zs = _mm_add_ps(z, z);
+      const __m128 wx = _mm_mul_ps(w, xs);
+      const __m128 wy = _mm_mul_ps(w, ys);
+      const __m128 wz = _mm_mul_ps(w, zs);
+      const __m128 xx = _mm_mul_ps(x, xs);
+      const __m128 xy = _mm_mul_ps(x, ys);
+      const __m128 xz = _mm_mul_ps(x, zs);
+      const __m128 yy = _mm_mul_ps(y, ys);
+      const __m128 yz = _mm_mul_ps(y, zs);
+      const __m128 zz = _mm_mul_ps(z, zs);
+
+      __m128 r0c0 = _mm_sub_ps(one, _mm_add_ps(yy, zz));
+      __m128 r0c1 = _mm_add_ps(xy, wz);
+      __m128 r0c2 = _mm_sub_ps(xz, wy);
+      __m128 r0c3 = _mm_set_ps(trans[i + 3].x, trans[i + 2].x, trans[i + 1].x, trans[i].x);
+
+      __m128 r1c0 = _mm_sub_ps(xy, wz);
+      __m128 r1c1 = _mm_sub_ps(one, _mm_add_ps(xx, zz));
+      __m128 r1c2 = _mm_add_ps(yz, wx);
+      __m128 r1c3 = _mm_set_ps(trans[i + 3].y, trans[i + 2].y, trans[i + 1].y, trans[i].y);
+
+      __m128 r2c0 = _mm_add_ps(xz, wy);
+      __m128 r2c1 = _mm_sub_ps(yz, wx);
+      __m128 r2c2 = _mm_sub_ps(one, _mm_add_ps(xx, yy));
+      __m128 r2c3 = _mm_set_ps(trans[i + 3].z, trans[i + 2].z, trans[i + 1].z, trans[i].z);
+
+      // Back to AoS: after each transpose, register n holds the row of node i + n
+      _MM_TRANSPOSE4_PS(r0c0, r0c1, r0c2, r0c3);
+      _MM_TRANSPOSE4_PS(r1c0, r1c1, r1c2, r1c3);
+      _MM_TRANSPOSE4_PS(r2c0, r2c1, r2c2, r2c3);
+
+      F32 *m0 = outMats[i + 0];
+      F32 *m1 = outMats[i + 1];
+      F32 *m2 = outMats[i + 2];
+      F32 *m3 = outMats[i + 3];
+
+      _mm_storeu_ps(m0,      r0c0);
+      _mm_storeu_ps(m0 + 4,  r1c0);
+      _mm_storeu_ps(m0 + 8,  r2c0);
+      _mm_storeu_ps(m0 + 12, row3);
+
+      _mm_storeu_ps(m1,      r0c1);
+      _mm_storeu_ps(m1 + 4,  r1c1);
+      _mm_storeu_ps(m1 + 8,  r2c1);
+      _mm_storeu_ps(m1 + 12, row3);
+
+      _mm_storeu_ps(m2,      r0c2);
+      _mm_storeu_ps(m2 + 4,  r1c2);
+      _mm_storeu_ps(m2 + 8,  r2c2);
+      _mm_storeu_ps(m2 + 12, row3);
+
+      _mm_storeu_ps(m3,      r0c3);
+      _mm_storeu_ps(m3 + 4,  r1c3);
+      _mm_storeu_ps(m3 + 8,  r2c3);
+      _mm_storeu_ps(m3 + 12, row3);
+   }
+
+   // Remainder
+   if(i < count)
+      ts_interpolate_node_transforms_C(count - i, rot1 + i, rot2 + i, interp + i, trans + i, outMats + i);
+}
+
+#endif // TORQUE_TS_ANIM_SSE2
+#endif // TORQUE_CPU_X86
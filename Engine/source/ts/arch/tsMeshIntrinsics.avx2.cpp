@@ -0,0 +1,125 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include "ts/tsMesh.h"
+
+#if defined(TORQUE_CPU_X86)
+#include "ts/tsMeshIntrinsics.h"
+#include "ts/arch/tsMeshIntrinsics.arch.h"
+
+#if defined(TORQUE_TS_AVX2)
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#  define TS_AVX2_TARGET
+#else
+#  define TS_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+
+bool ts_cpu_has_avx2()
+{
+#if defined(_MSC_VER)
+   int info[4];
+
+   // FMA and the OS saving the YMM registers (OSXSAVE + XCR0).
+   __cpuid(info, 1);
+   const bool hasFMA = ( info[2] & ( 1 << 12 ) ) != 0;
+   const bool hasOSXSAVE = ( info[2] & ( 1 << 27 ) ) != 0;
+   if ( !hasFMA || !hasOSXSAVE || ( _xgetbv( 0 ) & 6 ) != 6 )
+      return false;
+
+   __cpuid(info, 0);
+   if ( info[0] < 7 )
+      return false;
+
+   __cpuidex(info, 7, 0);
+   return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+TS_AVX2_TARGET
+void m_matF_x_BatchedVertWeightList_AVX2(const MatrixF &mat, 
+                                    const dsize_t count,
+                                    const TSSkinMesh::BatchData::BatchedVertWeight * __restrict batch,
+                                    U8 * const __restrict outPtr,
+                                    const dsize_t outStride)
+{
+   // Same math as the SSE version, but the position and the normal of a
+   // vertex share one 256 bit register:
+   //
+   //    in  = [ vert.x, vert.y, vert.z, weight | normal.x, normal.y, normal.z, vidx ]
+   //    out = [ _vert, _tangentW               | _normal, _tangent.x             ]
+   //
+   // The matrix columns are duplicated into both lanes, the translation is
+   // only added to the position lane.
+
+   MatrixF transMat;
+   mat.transposeTo(transMat);
+
+   const __m128 col0 = _mm_loadu_ps(&transMat[0]);
+   const __m128 col1 = _mm_loadu_ps(&transMat[4]);
+   const __m128 col2 = _mm_loadu_ps(&transMat[8]);
+   const __m128 col3 = _mm_loadu_ps(&transMat[12]);
+
+   const __m256 avxMat0 = _mm256_insertf128_ps(_mm256_castps128_ps256(col0), col0, 1);
+   const __m256 avxMat1 = _mm256_insertf128_ps(_mm256_castps128_ps256(col1), col1, 1);
+   const __m256 avxMat2 = _mm256_insertf128_ps(_mm256_castps128_ps256(col2), col2, 1);
+   const __m256 avxTrans = _mm256_insertf128_ps(_mm256_castps128_ps256(col3), _mm_setzero_ps(), 1);
+
+   // Masks off the W of both vectors so _tangentW and _tangent.x accumulate
+   // zero and keep their values.
+   const __m256 wMask = _mm256_setr_ps(1.0f, 1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f);
+
+   for(S32 i = 0; i < count; i++)
+   {
+      const TSSkinMesh::BatchData::BatchedVertWeight &inElem = batch[i];
+      F32 *outElem = reinterpret_cast<TSMesh::__TSMeshVertexBase *>(outPtr + inElem.vidx * outStride)->_vert;
+
+      // prefetch input well ahead; output is scattered so leave it to the
+      // hardware prefetcher
+      _mm_prefetch(reinterpret_cast<const char *>(batch + i + 64), _MM_HINT_T0);
+
+      const __m256 in = _mm256_loadu_ps(inElem.vert);
+
+      // x, y and z of each vector across its lane
+      __m256 temp = _mm256_fmadd_ps(_mm256_permute_ps(in, _MM_SHUFFLE(0, 0, 0, 0)), avxMat0, avxTrans);
+      temp = _mm256_fmadd_ps(_mm256_permute_ps(in, _MM_SHUFFLE(1, 1, 1, 1)), avxMat1, temp);
+      temp = _mm256_fmadd_ps(_mm256_permute_ps(in, _MM_SHUFFLE(2, 2, 2, 2)), avxMat2, temp);
+
+      // bone weight across both lanes, with W masked off
+      __m256 weight = _mm256_permute_ps(in, _MM_SHUFFLE(3, 3, 3, 3));
+      weight = _mm256_permute2f128_ps(weight, weight, 0x00);
+      weight = _mm256_mul_ps(weight, wMask);
+
+      // accumulate with previous values
+      const __m256 prev = _mm256_loadu_ps(outElem);
+      _mm256_storeu_ps(outElem, _mm256_fmadd_ps(temp, weight, prev));
+   }
+}
+
+#endif // TORQUE_TS_AVX2
+#endif // TORQUE_CPU_X86
@@ -393,6 +393,19 @@ void ColladaShapeLoader::computeBounds(Box3F& bounds)
    }
 }
 
+void ColladaShapeLoader::compressSequences()
+{
+   if ( !ColladaUtils::getOptions().compressAnimations || !shape->sequences.size() )
+      return;
+
+   updateProgress(Load_InitShape, "Compressing animations...");
+
+   S32 saved = shape->compressSequences( mDegToRad( ColladaUtils::getOptions().animRotationTolerance ),
+                                         ColladaUtils::getOptions().animTranslationTolerance );
+   Con::printf( "Compressed animation keyframes of %s, saved %d bytes",
+      shapePath.getFullFileName().c_str(), saved );
+}
+
 //-----------------------------------------------------------------------------
 /// Find the file extension for an extensionless texture
 String findTextureExtension(const Torque::Path &texPath)
@@ -644,13 +657,11 @@ TSShape* loadColladaShape(const Torque::Path &path)
    // if so, use that instead.
    if (ColladaShapeLoader::canLoadCachedDTS(path))
    {
-      FileStream cachedStream;
-      cachedStream.open(cachedPath.getFullPath(), Torque::FS::File::Read);
-      if (cachedStream.getStatus() == Stream::Ok)
+      Torque::FS::FileRef cachedFile = Torque::FS::OpenFile(cachedPath, Torque::FS::File::Read);
+      if (cachedFile)
       {
          TSShape *shape = new TSShape;
-         bool readSuccess = shape->read(&cachedStream);
-         cachedStream.close();
+         bool readSuccess = shape->read(cachedFile);
 
          if (readSuccess)
          {
@@ -708,12 +719,9 @@ TSShape* loadColladaShape(const Torque::Path &path)
       {
 #ifndef DAE2DTS_TOOL
          // Cache the Collada model to a DTS file for faster loading next time.
-         FileStream dtsStream;
-         if (dtsStream.open(cachedPath.getFullPath(), Torque::FS::File::Write))
-         {
-            Con::printf("Writing cached COLLADA shape to %s", cachedPath.getFullPath().c_str());
-            tss->write(&dtsStream);
-         }
+         Con::printf("Writing cached COLLADA shape to %s", cachedPath.getFullPath().c_str());
+         if (!tss->write(cachedPath))
+            Con::warnf("Failed to write cached COLLADA shape to %s", cachedPath.getFullPath().c_str());
 #endif // DAE2DTS_TOOL
 
          // Add collada materials to materials.cs
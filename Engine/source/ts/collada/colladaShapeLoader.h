@@ -51,6 +51,7 @@ public:
    bool ignoreNode(const String& name);
    bool ignoreMesh(const String& name);
    void computeBounds(Box3F& bounds);
+   void compressSequences();
 
    static bool canLoadCachedDTS(const Torque::Path& path);
    static bool checkAndMountSketchup(const Torque::Path& path, String& mountPoint, Torque::Path& daePath);
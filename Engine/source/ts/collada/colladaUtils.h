@@ -90,6 +90,9 @@ namespace ColladaUtils
       bool           adjustFloor;      // Translate model so origin is at the bottom
       bool           forceUpdateMaterials;   // Force update of materials.cs
       bool           useDiffuseNames;  // Use diffuse texture as the material name
+      bool           compressAnimations;        // Store sequences as compressed keyframe tracks
+      F32            animRotationTolerance;     // Largest rotation error (degrees) allowed by compression
+      F32            animTranslationTolerance;  // Largest translation error allowed by compression
 
       ImportOptions()
       {
@@ -112,6 +115,9 @@ namespace ColladaUtils
          adjustFloor = false;
          forceUpdateMaterials = false;
          useDiffuseNames = false;
+         compressAnimations = false;
+         animRotationTolerance = 0.1f;
+         animTranslationTolerance = 0.001f;
       }
    };
 
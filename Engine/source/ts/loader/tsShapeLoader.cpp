@@ -1222,6 +1222,8 @@ void TSShapeLoader::install()
    shape->radius = (shape->bounds.maxExtents - shape->center).len();
    shape->tubeRadius = shape->radius;
 
+   compressSequences();
+
    shape->init();
 }
 
@@ -140,6 +140,9 @@ protected:
 
    virtual void computeBounds(Box3F& bounds);
 
+   // Reduce the animation keyframes once the shape is complete
+   virtual void compressSequences() { }
+
    // Create objects, materials and sequences
    void recurseSubshape(AppNode* appNode, S32 parentIndex, bool recurseChildren);
 
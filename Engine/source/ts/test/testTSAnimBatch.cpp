@@ -0,0 +1,216 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "ts/tsAnimBatch.h"
+#include "ts/tsTransform.h"
+#include "ts/tsShapeInstance.h"
+#include "core/resourceManager.h"
+#include "console/console.h"
+#include "math/mRandom.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+extern void ts_interpolate_node_transforms_C(const dsize_t count, const Quat16 * const * __restrict rot1, const Quat16 * const * __restrict rot2, const F32 * __restrict interp, const Point3F * __restrict trans, MatrixF * __restrict outMats);
+
+// Checks the active node interpolation kernel against the scalar one and
+// measures both in nodes per second.
+
+CreateUnitTest( TestTSAnimBatchKernel, "TS/AnimBatch/Kernel" )
+{
+   enum
+   {
+      NUM_KEYS = 1024,
+      BATCH_SIZE = 301,    // Not a multiple of the SIMD width
+      DEFAULT_ITERATIONS = 2000,
+   };
+
+   typedef void ( *KernelFn )( const dsize_t, const Quat16* const*, const Quat16* const*, const F32*, const Point3F*, MatrixF* );
+
+   Vector< Quat16 > mKeys;
+   Vector< const Quat16* > mRot1;
+   Vector< const Quat16* > mRot2;
+   Vector< F32 > mInterp;
+   Vector< Point3F > mTrans;
+
+   void setup()
+   {
+      MRandomLCG rand( 1234 );
+
+      mKeys.setSize( NUM_KEYS );
+      for( U32 i = 0; i < NUM_KEYS; ++ i )
+      {
+         QuatF q( rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ) );
+         q.normalize();
+         mKeys[ i ].set( q );
+      }
+
+      mRot1.setSize( BATCH_SIZE );
+      mRot2.setSize( BATCH_SIZE );
+      mInterp.setSize( BATCH_SIZE );
+      mTrans.setSize( BATCH_SIZE );
+      for( U32 i = 0; i < BATCH_SIZE; ++ i )
+      {
+         const U32 key = rand.randI( 0, NUM_KEYS - 2 );
+         mRot1[ i ] = &mKeys[ key ];
+         mRot2[ i ] = &mKeys[ key + 1 ];
+         mInterp[ i ] = rand.randF();
+         mTrans[ i ].set( rand.randF( -2.0f, 2.0f ), rand.randF( -2.0f, 2.0f ), rand.randF( -2.0f, 2.0f ) );
+      }
+   }
+
+   /// Return the nodes per second @a kernel evaluates.
+   F64 measure( KernelFn kernel, U32 iterations, MatrixF* out )
+   {
+      const U32 start = Platform::getRealMilliseconds();
+      for( U32 i = 0; i < iterations; ++ i )
+         kernel( BATCH_SIZE, mRot1.address(), mRot2.address(), mInterp.address(), mTrans.address(), out );
+      const U32 elapsed = getMax( Platform::getRealMilliseconds() - start, U32( 1 ) );
+
+      return F64( iterations ) * BATCH_SIZE * 1000.0 / F64( elapsed );
+   }
+
+   void run()
+   {
+      setup();
+
+      Vector< MatrixF > reference;
+      Vector< MatrixF > result;
+      reference.setSize( BATCH_SIZE );
+      result.setSize( BATCH_SIZE );
+
+      ts_interpolate_node_transforms_C( BATCH_SIZE, mRot1.address(), mRot2.address(), mInterp.address(), mTrans.address(), reference.address() );
+      ts_interpolate_node_transforms( BATCH_SIZE, mRot1.address(), mRot2.address(), mInterp.address(), mTrans.address(), result.address() );
+
+      bool match = true;
+      for( U32 i = 0; i < BATCH_SIZE; ++ i )
+      {
+         const F32* a = reference[ i ];
+         const F32* b = result[ i ];
+         for( U32 j = 0; j < 16; ++ j )
+            if( mFabs( a[ j ] - b[ j ] ) > 0.0001f )
+               match = false;
+      }
+      TEST( match );
+
+      const U32 iterations = Con::getIntVariable( "$testTSAnimBatch::iterations", DEFAULT_ITERATIONS );
+      const F64 scalarRate = measure( ts_interpolate_node_transforms_C, iterations, result.address() );
+      const F64 activeRate = measure( ts_interpolate_node_transforms, iterations, result.address() );
+
+      Con::printf( "TSAnimBatch: scalar %.1f Mnodes/s, active kernel %.1f Mnodes/s (%.2fx)",
+         scalarRate / 1000000.0, activeRate / 1000000.0, activeRate / scalarRate );
+   }
+};
+
+// Animates instances of a real shape at different positions in its first
+// sequence with TSAnimBatch and one by one with TSShapeInstance::animate()
+// and compares the node transforms.  The shape can be overridden with
+// $testTSAnimBatch::shape.
+
+CreateUnitTest( TestTSAnimBatchShape, "TS/AnimBatch/Shape" )
+{
+   enum
+   {
+      NUM_INSTANCES = 9,
+   };
+
+   void run()
+   {
+      const char* path = Con::getVariable( "$testTSAnimBatch::shape" );
+      if( !path[ 0 ] )
+         path = "art/shapes/actors/Soldier/Anims/PlayerAnim_Lurker_Run.dae";
+
+      Resource< TSShape > shape = ResourceManager::get().load( path );
+      if( !bool( shape ) || shape->sequences.empty() )
+      {
+         Con::warnf( "TestTSAnimBatchShape - could not load an animated shape from '%s', skipping", path );
+         return;
+      }
+
+      const bool wasEnabled = TSAnimBatch::smEnabled;
+      TSAnimBatch::smEnabled = true;
+
+      Vector< TSShapeInstance* > batched;
+      Vector< TSShapeInstance* > reference;
+      for( U32 i = 0; i < NUM_INSTANCES; ++ i )
+      {
+         // The last instance sits exactly on a keyframe.
+         const F32 pos = i + 1 < NUM_INSTANCES ? F32( i ) / F32( NUM_INSTANCES - 1 ) + 0.013f : 0.0f;
+
+         for( U32 j = 0; j < 2; ++ j )
+         {
+            TSShapeInstance* inst = new TSShapeInstance( shape, false );
+            inst->setCurrentDetail( 0 );
+            inst->setSequence( inst->addThread(), 0, pos );
+            ( j ? reference : batched ).push_back( inst );
+         }
+      }
+
+      TSAnimBatch batch;
+      for( U32 i = 0; i < NUM_INSTANCES; ++ i )
+         batch.add( batched[ i ] );
+      batch.animate();
+
+      for( U32 i = 0; i < NUM_INSTANCES; ++ i )
+         reference[ i ]->animate();
+
+      // A shape that can't be batched would pass trivially.
+      TEST( batch.getNumBatchedNodes() > 0 );
+      TEST( batch.size() == 0 );
+
+      bool match = true;
+      for( U32 i = 0; i < NUM_INSTANCES; ++ i )
+      {
+         const Vector< MatrixF >& a = reference[ i ]->mNodeTransforms;
+         const Vector< MatrixF >& b = batched[ i ]->mNodeTransforms;
+         if( a.size() != b.size() )
+         {
+            match = false;
+            continue;
+         }
+
+         for( U32 n = 0; n < a.size(); ++ n )
+         {
+            const F32* ma = a[ n ];
+            const F32* mb = b[ n ];
+            for( U32 j = 0; j < 16; ++ j )
+               if( mFabs( ma[ j ] - mb[ j ] ) > 0.001f )
+                  match = false;
+         }
+      }
+      TEST( match );
+
+      for( U32 i = 0; i < NUM_INSTANCES; ++ i )
+      {
+         delete batched[ i ];
+         delete reference[ i ];
+      }
+
+      TSAnimBatch::smEnabled = wasEnabled;
+   }
+};
+
+#endif // !TORQUE_SHIPPING
@@ -0,0 +1,74 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "ts/tsAnimThrottle.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+CreateUnitTest( TestTSAnimThrottleInterval, "TS/AnimThrottle/Interval" )
+{
+   void run()
+   {
+      const bool oldEnabled = TSAnimThrottle::smEnabled;
+      TSAnimThrottle::smEnabled = true;
+
+      TSAnimThrottle::Settings settings;
+
+      // Throttling is off by default.
+      TEST( TSAnimThrottle::getUpdateInterval( settings, 0.0f ) == 1 );
+
+      settings.fullRatePixels = 100.0f;
+      settings.frozenPixels = 10.0f;
+      settings.maxUpdateInterval = 4;
+
+      TEST( TSAnimThrottle::getUpdateInterval( settings, 200.0f ) == 1 );
+      TEST( TSAnimThrottle::getUpdateInterval( settings, 100.0f ) == 1 );
+      TEST( TSAnimThrottle::getUpdateInterval( settings, 55.0f ) == 3 );
+      TEST( TSAnimThrottle::getUpdateInterval( settings, 10.0f ) == 4 );
+      TEST( TSAnimThrottle::getUpdateInterval( settings, 9.0f ) == 0 );
+
+      // The interval never shrinks as the shape gets smaller.
+      U32 last = 1;
+      bool monotonic = true;
+      for ( F32 pixels = 100.0f; pixels >= 10.0f; pixels -= 1.0f )
+      {
+         const U32 interval = TSAnimThrottle::getUpdateInterval( settings, pixels );
+         if ( interval < last || interval > 4 )
+            monotonic = false;
+         last = interval;
+      }
+      TEST( monotonic );
+
+      // Disabling the throttle globally animates everything every frame.
+      TSAnimThrottle::smEnabled = false;
+      TEST( TSAnimThrottle::getUpdateInterval( settings, 9.0f ) == 1 );
+
+      TSAnimThrottle::smEnabled = oldEnabled;
+   }
+};
+
+#endif // !TORQUE_SHIPPING
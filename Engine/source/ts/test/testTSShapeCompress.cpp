@@ -0,0 +1,164 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "ts/tsShape.h"
+#include "ts/tsTransform.h"
+#include "core/stream/memStream.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Compresses and expands sequences of a bare shape and checks every frame
+// stays within tolerance of the original keys.
+
+CreateUnitTest( TestTSShapeCompress, "TS/ShapeCompress" )
+{
+   enum { NUM_FRAMES = 60 };
+
+   Vector< QuatF > mRots;
+   Vector< Point3F > mTrans;
+
+   /// Add a sequence where node 0 spins and moves, with a jump half way,
+   /// and node 1 holds a fixed rotation.
+   void addSequence( TSShape *shape, F32 phase )
+   {
+      shape->sequences.increment();
+      TSShape::Sequence &seq = shape->sequences.last();
+      seq.numKeyframes = NUM_FRAMES;
+      seq.flags = 0;
+      seq.rotationMatters.clearAll();
+      seq.rotationMatters.set( 0 );
+      seq.rotationMatters.set( 1 );
+      seq.translationMatters.clearAll();
+      seq.translationMatters.set( 0 );
+      seq.baseRotation = shape->nodeRotations.size();
+      seq.baseTranslation = shape->nodeTranslations.size();
+
+      for ( S32 i = 0; i < NUM_FRAMES; i++ )
+      {
+         shape->nodeRotations.increment();
+         shape->nodeRotations.last().set( QuatF( EulerF( 0.0f, 0.0f, phase + i * 0.05f ) ) );
+      }
+      for ( S32 i = 0; i < NUM_FRAMES; i++ )
+      {
+         shape->nodeRotations.increment();
+         shape->nodeRotations.last().set( QuatF( EulerF( phase, 0.0f, 0.0f ) ) );
+      }
+      for ( S32 i = 0; i < NUM_FRAMES; i++ )
+         shape->nodeTranslations.push_back( Point3F( phase + i * 0.1f, 0.0f, ( i < NUM_FRAMES / 2 ) ? 0.0f : 1.0f ) );
+   }
+
+   void sample( const TSShape *shape, Vector< QuatF > &rots, Vector< Point3F > &trans )
+   {
+      rots.clear();
+      trans.clear();
+      for ( S32 i = 0; i < shape->sequences.size(); i++ )
+      {
+         const TSShape::Sequence &seq = shape->sequences[i];
+         for ( S32 j = 0; j < seq.rotationMatters.count(); j++ )
+            for ( S32 k = 0; k < seq.numKeyframes; k++ )
+            {
+               QuatF q;
+               rots.push_back( shape->getRotation( seq, k, j, &q ) );
+            }
+         for ( S32 j = 0; j < seq.translationMatters.count(); j++ )
+            for ( S32 k = 0; k < seq.numKeyframes; k++ )
+               trans.push_back( shape->getTranslation( seq, k, j ) );
+      }
+   }
+
+   bool withinTolerance( const TSShape *shape, F32 rotTol, F32 transTol )
+   {
+      Vector< QuatF > rots;
+      Vector< Point3F > trans;
+      sample( shape, rots, trans );
+
+      const F32 minDot = mCos( rotTol * 0.5f );
+      for ( S32 i = 0; i < rots.size(); i++ )
+         if ( mFabs( rots[i].dot( mRots[i] ) ) < minDot )
+            return false;
+      for ( S32 i = 0; i < trans.size(); i++ )
+         if ( ( trans[i] - mTrans[i] ).len() > transTol )
+            return false;
+      return true;
+   }
+
+   void run()
+   {
+      const F32 rotTol = mDegToRad( 0.1f );
+      const F32 transTol = 0.001f;
+
+      TSShape *shape = new TSShape;
+      addSequence( shape, 0.0f );
+      addSequence( shape, 1.0f );
+      sample( shape, mRots, mTrans );
+
+      const U32 denseBytes = shape->getSequenceKeyBytes( shape->sequences[0] );
+
+      // Compress the first sequence, the second must still read the same keys
+      TEST( shape->compressSequence( 0, rotTol, transTol ) );
+      TEST( shape->sequences[0].isCompressed() );
+      TEST( !shape->sequences[1].isCompressed() );
+      TEST( shape->getSequenceKeyBytes( shape->sequences[0] ) < denseBytes / 2 );
+      TEST( shape->nodeRotations.size() == 2 * NUM_FRAMES );
+      TEST( withinTolerance( shape, rotTol * 1.01f, transTol * 1.01f ) );
+
+      // A constant track needs a single key
+      TEST( shape->rotationTracks[ shape->sequences[0].baseRotation + 1 ].numKeys == 1 );
+
+      // Both compressed, then expand the first again
+      TEST( shape->compressSequence( 1, rotTol, transTol ) );
+      TEST( shape->nodeRotations.empty() && shape->nodeTranslations.empty() );
+      TEST( withinTolerance( shape, rotTol * 1.01f, transTol * 1.01f ) );
+
+      // Exporting expands the keys but leaves the shape compressed
+      const S32 numRotKeys = shape->rotationKeys.size();
+      const S32 numTransKeys = shape->translationKeys.size();
+      MemStream stream( 4096 );
+      shape->exportSequences( &stream );
+      TEST( shape->sequences[0].isCompressed() && shape->sequences[1].isCompressed() );
+      TEST( shape->nodeRotations.empty() && shape->nodeTranslations.empty() );
+      TEST( shape->rotationKeys.size() == numRotKeys && shape->translationKeys.size() == numTransKeys );
+      TEST( withinTolerance( shape, rotTol * 1.01f, transTol * 1.01f ) );
+
+      shape->decompressSequence( 0 );
+      TEST( !shape->sequences[0].isCompressed() );
+      TEST( shape->sequences[1].baseRotation == 0 );
+      TEST( shape->rotationTracks.size() == 2 );
+      TEST( withinTolerance( shape, rotTol * 1.01f, transTol * 1.01f ) );
+
+      // Nothing left over once everything is expanded
+      shape->decompressSequences();
+      TEST( shape->rotationTracks.empty() && shape->rotationKeys.empty() );
+      TEST( shape->translationTracks.empty() && shape->translationKeys.empty() );
+      TEST( shape->nodeRotations.size() == 4 * NUM_FRAMES );
+      TEST( withinTolerance( shape, rotTol * 1.01f, transTol * 1.01f ) );
+
+      delete shape;
+   }
+};
+
+#endif // !TORQUE_SHIPPING
@@ -0,0 +1,155 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "ts/tsShape.h"
+#include "core/stream/memStream.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Writes the vertex blocks of a bare shape and reads them back, both in place
+// from the written image (as from a mapped file) and into copies.
+
+namespace
+{
+   /// A standard mesh whose vertex size can be set without a GFX device.
+   class TestBlockMesh : public TSMesh
+   {
+   public:
+      void fill( U32 numVerts, F32 seed )
+      {
+         mVertSize = sizeof( __TSMeshVertexBase );
+
+         void *mem = dMalloc_aligned( mVertSize * numVerts, 16 );
+         dMemset( mem, 0, mVertSize * numVerts );
+         mVertexData.set( mem, mVertSize, numVerts );
+         mVertexData.setReady( true );
+         mNumVerts = numVerts;
+
+         for ( U32 i = 0; i < numVerts; i++ )
+         {
+            mVertexData[i].vert( Point3F( seed + i, seed - i, seed * i ) );
+            mVertexData[i].normal( Point3F( 0.0f, 0.0f, 1.0f ) );
+            mVertexData[i].tvert( Point2F( seed, F32( i ) ) );
+         }
+      }
+   };
+}
+
+CreateUnitTest( TestTSShapeMapped, "TS/ShapeMapped" )
+{
+   enum
+   {
+      IMAGE_SIZE = 4096,
+      LEAD_BYTES = 7,   ///< Misalign the table like the sections before it would
+   };
+
+   TSShape* createShape( bool filled )
+   {
+      TSShape *shape = new TSShape;
+      for ( S32 i = 0; i < 3; i++ )
+      {
+         TestBlockMesh *mesh = new TestBlockMesh;
+         if ( filled && i != 1 )
+            mesh->fill( 5 + i, F32( i ) );
+         shape->meshes.push_back( mesh );
+      }
+      return shape;
+   }
+
+   bool matches( const TSMesh *a, const TSMesh *b )
+   {
+      return b->mVertexData.isReady() &&
+             a->mVertexData.size() == b->mVertexData.size() &&
+             a->mVertexData.vertSize() == b->mVertexData.vertSize() &&
+             dMemcmp( a->mVertexData.address(), b->mVertexData.address(), a->mVertexData.mem_size() ) == 0;
+   }
+
+   void run()
+   {
+      U8 *image = (U8*)dMalloc_aligned( IMAGE_SIZE, 16 );
+      dMemset( image, 0, IMAGE_SIZE );
+
+      TSShape *source = createShape( true );
+      {
+         MemStream stream( IMAGE_SIZE, image );
+         for ( S32 i = 0; i < LEAD_BYTES; i++ )
+            stream.write( U8( 0xCD ) );
+         source->writeVertexBlocks( &stream, 0 );
+         TEST( stream.getStatus() == Stream::Ok );
+      }
+
+      // In place
+      TSShape *mapped = createShape( false );
+      {
+         MemStream stream( IMAGE_SIZE, image, true, false );
+         stream.setPosition( LEAD_BYTES );
+         TEST( mapped->readVertexBlocks( &stream, 0, image ) );
+      }
+      for ( S32 i = 0; i < 3; i += 2 )
+      {
+         const TSMesh *mesh = mapped->meshes[i];
+         const U8 *data = (const U8*)mesh->mVertexData.address();
+         TEST( matches( source->meshes[i], mesh ) );
+         TEST( mesh->mVertexData.isExternal() );
+         TEST( data > image && data < image + IMAGE_SIZE );
+         TEST( ( (dsize_t)data & 15 ) == 0 );
+      }
+      TEST( !mapped->meshes[1]->mVertexData.isReady() );
+
+      // Copied
+      TSShape *copied = createShape( false );
+      {
+         MemStream stream( IMAGE_SIZE, image, true, false );
+         stream.setPosition( LEAD_BYTES );
+         TEST( copied->readVertexBlocks( &stream, 0, NULL ) );
+      }
+      for ( S32 i = 0; i < 3; i += 2 )
+      {
+         TEST( matches( source->meshes[i], copied->meshes[i] ) );
+         TEST( !copied->meshes[i]->mVertexData.isExternal() );
+      }
+
+      // A block that isn't aligned is rejected (the first block's offset is
+      // the fifth word of its table entry)
+      U32 *offset = (U32*)( image + LEAD_BYTES + sizeof( U32 ) * 5 );
+      *offset = convertHostToLEndian( convertLEndianToHost( *offset ) + 4 );
+      TSShape *corrupt = createShape( false );
+      {
+         MemStream stream( IMAGE_SIZE, image, true, false );
+         stream.setPosition( LEAD_BYTES );
+         TEST( !corrupt->readVertexBlocks( &stream, 0, image ) );
+      }
+
+      delete corrupt;
+      delete copied;
+      delete mapped;
+      delete source;
+      dFree_aligned( image );
+   }
+};
+
+#endif // !TORQUE_SHIPPING
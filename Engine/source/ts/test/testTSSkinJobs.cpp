@@ -0,0 +1,167 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "unit/test.h"
+#include "ts/tsSkinJobs.h"
+#include "gfx/gfxVertexFormat.h"
+#include "math/mRandom.h"
+
+#ifndef TORQUE_SHIPPING
+
+using namespace UnitTesting;
+
+#define TEST( x ) test( ( x ), "FAIL: " #x )
+
+// Skins a mesh through the job queue and checks that the shared vertex data
+// ends up the same as after TSSkinMesh::updateSkin() with the same pose.
+
+namespace
+{
+   /// A skinned mesh with two random bone influences per vertex.
+   class TestSkinMesh : public TSSkinMesh
+   {
+   public:
+      void setup( U32 numVerts, U32 numBones, const GFXVertexFormat *format, MRandomLCG &rand )
+      {
+         mVertSize = sizeof( __TSMeshVertexBase );
+         mVertexFormat = format;
+         mNumVerts = numVerts;
+
+         for ( U32 i = 0; i < numBones; i++ )
+         {
+            MatrixF mat( EulerF( rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ) ) );
+            mat.setPosition( Point3F( rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ) ) );
+            batchData.nodeIndex.push_back( i );
+            batchData.initialTransforms.push_back( mat );
+         }
+
+         void *mem = dMalloc_aligned( mVertSize * numVerts, 16 );
+         dMemset( mem, 0, mVertSize * numVerts );
+         mVertexData.set( mem, mVertSize, numVerts );
+         mVertexData.setReady( true );
+
+         for ( U32 i = 0; i < numVerts; i++ )
+         {
+            Point3F vert( rand.randF( -2.0f, 2.0f ), rand.randF( -2.0f, 2.0f ), rand.randF( -2.0f, 2.0f ) );
+            Point3F norm( rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ), 1.0f );
+            norm.normalize();
+
+            batchData.initialVerts.push_back( vert );
+            batchData.initialNorms.push_back( norm );
+
+            mVertexData[i].vert( vert );
+            mVertexData[i].normal( norm );
+            mVertexData[i].tvert( Point2F( F32( i ), 0.5f ) );
+
+            const F32 w = rand.randF( 0.1f, 0.9f );
+            const S32 bone = rand.randI( 0, numBones - 2 );
+            vertexIndex.push_back( i );
+            boneIndex.push_back( bone );
+            weight.push_back( w );
+            vertexIndex.push_back( i );
+            boneIndex.push_back( bone + 1 );
+            weight.push_back( 1.0f - w );
+         }
+
+         createBatchData();
+      }
+   };
+}
+
+CreateUnitTest( TestTSSkinJobs, "TS/SkinJobs" )
+{
+   enum
+   {
+      NUM_VERTS = 257,
+      NUM_BONES = 6,
+   };
+
+   void randomPose( MRandomLCG &rand, Vector< MatrixF > &pose )
+   {
+      pose.setSize( NUM_BONES );
+      for ( U32 i = 0; i < NUM_BONES; i++ )
+      {
+         pose[i].set( EulerF( rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ) ) );
+         pose[i].setPosition( Point3F( rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ), rand.randF( -1.0f, 1.0f ) ) );
+      }
+   }
+
+   void run()
+   {
+      MRandomLCG rand( 1234 );
+
+      GFXVertexFormat format;
+      format.addElement( GFXSemantic::POSITION, GFXDeclType_Float3 );
+      format.addElement( GFXSemantic::TANGENTW, GFXDeclType_Float, 3 );
+      format.addElement( GFXSemantic::NORMAL, GFXDeclType_Float3 );
+      format.addElement( GFXSemantic::TANGENT, GFXDeclType_Float3 );
+      format.addElement( GFXSemantic::TEXCOORD, GFXDeclType_Float2, 0 );
+
+      TestSkinMesh mesh;
+      mesh.setup( NUM_VERTS, NUM_BONES, &format, rand );
+
+      Vector< MatrixF > otherPose;
+      Vector< MatrixF > pose;
+      randomPose( rand, otherPose );
+      randomPose( rand, pose );
+
+      const U32 size = mesh.mVertexData.mem_size();
+      Vector< U8 > bindPose;
+      bindPose.setSize( size );
+      dMemcpy( bindPose.address(), mesh.mVertexData.address(), size );
+
+      // Reference
+      TSVertexBufferHandle vb;
+      GFXPrimitiveBufferHandle pb;
+      mesh.updateSkin( pose, vb, pb );
+
+      Vector< U8 > reference;
+      reference.setSize( size );
+      dMemcpy( reference.address(), mesh.mVertexData.address(), size );
+      TEST( dMemcmp( reference.address(), bindPose.address(), size ) != 0 );
+
+      // Start over from the bind pose and queue two instances of the mesh.
+      // The pose queued last is the one that has to end up in the shared
+      // vertex data.
+      dMemcpy( mesh.mVertexData.address(), bindPose.address(), size );
+      mesh.mHasSkinned = false;
+
+      const bool oldEnabled = TSSkinJobQueue::smEnabled;
+      TSSkinJobQueue::smEnabled = true;
+
+      TSVertexBufferHandle otherVB;
+      TSSkinJobQueue::begin();
+      TSSkinJobQueue::queue( &mesh, otherPose, otherVB );
+      TSSkinJobQueue::queue( &mesh, pose, vb );
+      TEST( TSSkinJobQueue::getNumQueued() == 2 );
+      TSSkinJobQueue::flush();
+
+      TSSkinJobQueue::smEnabled = oldEnabled;
+
+      TEST( TSSkinJobQueue::getNumQueued() == 0 );
+      TEST( TSSkinJobQueue::getLastNumSkinnedVerts() == 2 * NUM_VERTS );
+      TEST( mesh.mHasSkinned );
+      TEST( dMemcmp( mesh.mVertexData.address(), reference.address(), size ) == 0 );
+   }
+};
+
+#endif // !TORQUE_SHIPPING
@@ -0,0 +1,306 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "ts/tsAnimBatch.h"
+
+#include "ts/tsShapeInstance.h"
+#include "ts/tsTransform.h"
+#include "ts/arch/tsAnimBatch.arch.h"
+#include "console/console.h"
+#include "console/consoleTypes.h"
+#include "core/module.h"
+#include "platform/profiler.h"
+
+
+void (*ts_interpolate_node_transforms)(const dsize_t count, const Quat16 * const * __restrict rot1, const Quat16 * const * __restrict rot2, const F32 * __restrict interp, const Point3F * __restrict trans, MatrixF * __restrict outMats) = NULL;
+
+bool TSAnimBatch::smEnabled = true;
+
+//------------------------------------------------------------------------------
+// Default C++ Implementation
+//------------------------------------------------------------------------------
+
+void ts_interpolate_node_transforms_C(const dsize_t count,
+                                      const Quat16 * const * __restrict rot1,
+                                      const Quat16 * const * __restrict rot2,
+                                      const F32 * __restrict interp,
+                                      const Point3F * __restrict trans,
+                                      MatrixF * __restrict outMats)
+{
+   QuatF q1, q2, q;
+
+   for (dsize_t i = 0; i < count; i++)
+   {
+      rot1[i]->getQuatF(&q1);
+      rot2[i]->getQuatF(&q2);
+      TSTransform::interpolate(q1, q2, interp[i], &q);
+      TSTransform::setMatrix(q, trans[i], &outMats[i]);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Initializer.
+//------------------------------------------------------------------------------
+
+MODULE_BEGIN( TSAnimBatch )
+
+   MODULE_INIT_AFTER( 3D )
+
+   MODULE_INIT
+   {
+      ts_interpolate_node_transforms = ts_interpolate_node_transforms_C;
+
+   #if defined(TORQUE_TS_ANIM_SSE2)
+      if(Platform::SystemInfo.processor.properties & CPU_PROP_SSE2)
+         ts_interpolate_node_transforms = ts_interpolate_node_transforms_SSE2;
+   #endif
+
+      Con::addVariable("$TS::batchAnimation", TypeBool, &TSAnimBatch::smEnabled,
+         "@brief If false, TSAnimBatch animates every shape instance on its own.\n"
+         "Useful for comparing the batched node animation path against the scalar one.\n"
+         "@ingroup Rendering\n" );
+   }
+
+MODULE_END;
+
+//------------------------------------------------------------------------------
+// TSAnimBatch
+//------------------------------------------------------------------------------
+
+TSAnimBatch::TSAnimBatch()
+   : mNumBatchedNodes( 0 )
+{
+}
+
+void TSAnimBatch::add( TSShapeInstance *inst )
+{
+   mEntries.increment();
+   Entry &entry = mEntries.last();
+   entry.inst = inst;
+   entry.shape = inst->getShape();
+   entry.subShape = -1;
+   entry.sequence = -1;
+}
+
+bool TSAnimBatch::canBatch( TSShapeInstance *inst, S32 ss )
+{
+   if ( inst->mThreadList.size() != 1 ||
+        inst->inTransition() ||
+        inst->scaleCurrentlyAnimated() )
+      return false;
+
+   const TSThread *th = inst->mThreadList[0];
+   if ( !th->hasSequence() || th->getSequence()->isBlend() || th->getSequence()->isCompressed() )
+      return false;
+
+   // Nodes that are masked, driven by callbacks or by hand need the
+   // full path through animateNodes().
+   if ( inst->mHandsOffNodes.testAll() ||
+        inst->mCallbackNodes.testAll() ||
+        inst->mMaskRotationNodes.testAll() ||
+        inst->mMaskPosXNodes.testAll() ||
+        inst->mMaskPosYNodes.testAll() ||
+        inst->mMaskPosZNodes.testAll() )
+      return false;
+
+   return inst->getShape()->subShapeNumNodes[ss] > 0;
+}
+
+S32 QSORT_CALLBACK TSAnimBatch::_compareEntries( const void *a, const void *b )
+{
+   const Entry *ea = reinterpret_cast<const Entry*>( a );
+   const Entry *eb = reinterpret_cast<const Entry*>( b );
+
+   if ( ea->shape != eb->shape )
+      return ea->shape < eb->shape ? -1 : 1;
+   if ( ea->subShape != eb->subShape )
+      return ea->subShape - eb->subShape;
+   return ea->sequence - eb->sequence;
+}
+
+void TSAnimBatch::animate()
+{
+   PROFILE_SCOPE( TSAnimBatch_animate );
+
+   mNumBatchedNodes = 0;
+
+   // Instances that can't be batched are animated right away.  The rest
+   // are compacted to the front of the list.
+   U32 numBatched = 0;
+   for ( U32 i = 0; i < mEntries.size(); i++ )
+   {
+      Entry entry = mEntries[i];
+      TSShapeInstance *inst = entry.inst;
+
+      const S32 dl = inst->getCurrentDetail();
+      const S32 ss = dl < 0 ? -1 : entry.shape->details[dl].subShapeNum;
+
+      if ( smEnabled && ss >= 0 && ( inst->mDirtyFlags[ss] & TSShapeInstance::TransformDirty ) )
+      {
+         if ( inst->mDirtyFlags[ss] & TSShapeInstance::ThreadDirty )
+         {
+            inst->sortThreads();
+            inst->mDirtyFlags[ss] &= ~TSShapeInstance::ThreadDirty;
+         }
+
+         if ( canBatch( inst, ss ) )
+         {
+            entry.subShape = ss;
+            entry.sequence = inst->mThreadList[0]->getSeqIndex();
+            mEntries[ numBatched++ ] = entry;
+            continue;
+         }
+      }
+
+      inst->animate( dl );
+   }
+   mEntries.setSize( numBatched );
+
+   // Group the instances by shape, subshape and sequence.
+   dQsort( mEntries.address(), mEntries.size(), sizeof( Entry ), _compareEntries );
+
+   for ( U32 start = 0; start < mEntries.size(); )
+   {
+      U32 end = start + 1;
+      while ( end < mEntries.size() && _compareEntries( &mEntries[start], &mEntries[end] ) == 0 )
+         end++;
+
+      _animateGroup( &mEntries[start], end - start );
+      start = end;
+   }
+
+   // Let animate() do the rest of the work (visibility, frames, ...).
+   for ( U32 i = 0; i < mEntries.size(); i++ )
+   {
+      TSShapeInstance *inst = mEntries[i].inst;
+      inst->mDirtyFlags[ mEntries[i].subShape ] &= ~TSShapeInstance::TransformDirty;
+      inst->mNodeSubsetDetail = -1;
+      inst->animate( inst->getCurrentDetail() );
+   }
+
+   mEntries.clear();
+}
+
+void TSAnimBatch::_animateGroup( const Entry *entries, U32 count )
+{
+   PROFILE_SCOPE( TSAnimBatch_animateGroup );
+
+   const TSShape *shape = entries[0].shape;
+   const TSShape::Sequence &seq = shape->sequences[ entries[0].sequence ];
+
+   const S32 a = shape->subShapeFirstNode[ entries[0].subShape ];
+   const S32 b = a + shape->subShapeNumNodes[ entries[0].subShape ];
+
+   mRot1.setSize( count );
+   mRot2.setSize( count );
+   mInterp.setSize( count );
+   mTrans.setSize( count );
+   mLocal.setSize( count );
+
+   for ( U32 k = 0; k < count; k++ )
+   {
+      TSShapeInstance *inst = entries[k].inst;
+      inst->mNodeTransforms.setSize( shape->nodes.size() );
+      mInterp[k] = inst->mThreadList[0]->keyPos;
+   }
+
+   // Indices of the current node among the animated rotations and
+   // translations of the sequence.
+   S32 rotNode = seq.rotationMatters.start();
+   S32 rotNum = 0;
+   S32 tranNode = seq.translationMatters.start();
+   S32 tranNum = 0;
+
+   for ( S32 i = a; i < b; i++ )
+   {
+      while ( rotNode < i )
+      {
+         seq.rotationMatters.next( rotNode );
+         rotNum++;
+      }
+      while ( tranNode < i )
+      {
+         seq.translationMatters.next( tranNode );
+         tranNum++;
+      }
+
+      const bool animRot = rotNode == i;
+      const bool animTran = tranNode == i;
+
+      if ( animTran )
+      {
+         for ( U32 k = 0; k < count; k++ )
+         {
+            const TSThread *th = entries[k].inst->mThreadList[0];
+            const Point3F &p1 = shape->getTranslation( seq, th->keyNum1, tranNum );
+            const Point3F &p2 = shape->getTranslation( seq, th->keyNum2, tranNum );
+            TSTransform::interpolate( p1, p2, th->keyPos, &mTrans[k] );
+         }
+      }
+
+      if ( animRot )
+      {
+         if ( !animTran )
+         {
+            for ( U32 k = 0; k < count; k++ )
+               mTrans[k] = shape->defaultTranslations[i];
+         }
+
+         const Quat16 *keys = &shape->nodeRotations[ seq.baseRotation + rotNum * seq.numKeyframes ];
+         for ( U32 k = 0; k < count; k++ )
+         {
+            const TSThread *th = entries[k].inst->mThreadList[0];
+            mRot1[k] = keys + th->keyNum1;
+            mRot2[k] = keys + th->keyNum2;
+         }
+
+         ts_interpolate_node_transforms( count, mRot1.address(), mRot2.address(), mInterp.address(), mTrans.address(), mLocal.address() );
+      }
+      else
+      {
+         QuatF q;
+         MatrixF mat;
+         TSTransform::setMatrix( shape->defaultRotations[i].getQuatF( &q ), shape->defaultTranslations[i], &mat );
+
+         for ( U32 k = 0; k < count; k++ )
+         {
+            mLocal[k] = mat;
+            if ( animTran )
+               mLocal[k].setColumn( 3, mTrans[k] );
+         }
+      }
+
+      // Nodes are sorted so the parent transform is already final.
+      const S32 parentIdx = shape->nodes[i].parentIndex;
+      for ( U32 k = 0; k < count; k++ )
+      {
+         TSShapeInstance *inst = entries[k].inst;
+         if ( parentIdx < 0 )
+            inst->mNodeTransforms[i] = mLocal[k];
+         else
+            inst->mNodeTransforms[i].mul( inst->mNodeTransforms[parentIdx], mLocal[k] );
+      }
+   }
+
+   mNumBatchedNodes += count * ( b - a );
+}
@@ -0,0 +1,141 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _TSANIMBATCH_H_
+#define _TSANIMBATCH_H_
+
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+#ifndef _MMATRIX_H_
+#include "math/mMatrix.h"
+#endif
+
+class TSShape;
+class TSShapeInstance;
+struct Quat16;
+
+
+/// Interpolate @a count pairs of node rotation keys and build local node
+/// transforms from the results and the given translations.
+///
+/// The rotation is a linear interpolation with the same fast renormalization
+/// as TSTransform::interpolate().
+///
+/// @param count     Number of nodes in the batch
+/// @param rot1      Keys at or before the current position
+/// @param rot2      Keys at or after the current position
+/// @param interp    Interpolation factor between the keys of each node
+/// @param trans     Translation of each node
+/// @param outMats   Receives one local transform per node
+extern void (*ts_interpolate_node_transforms)
+                           (const dsize_t count,
+                            const Quat16 * const * __restrict rot1,
+                            const Quat16 * const * __restrict rot2,
+                            const F32 * __restrict interp,
+                            const Point3F * __restrict trans,
+                            MatrixF * __restrict outMats);
+
+
+/// Animates the nodes of many shape instances at once.
+///
+/// Instances that share a shape, subshape and sequence are evaluated as one
+/// group: for each node, the keys of all instances in the group are
+/// interpolated together by ts_interpolate_node_transforms, which uses SIMD
+/// where the CPU supports it.  This amortizes the per-node bookkeeping of
+/// TSShapeInstance::animateNodes() over the whole crowd.
+///
+/// Only the common case of a single non-blend thread without transitions,
+/// animated scale, masked, callback or hands-off nodes is batched.  Other
+/// instances fall back to TSShapeInstance::animate(), so the results are the
+/// same as animating every instance on its own.
+///
+/// @code
+///    TSAnimBatch batch;
+///    for ( U32 i = 0; i < numBots; i++ )
+///       batch.add( bots[i]->getShapeInstance() );
+///    batch.animate();
+/// @endcode
+class TSAnimBatch
+{
+public:
+
+   /// If false, animate() animates every instance on its own.
+   static bool smEnabled;
+
+   TSAnimBatch();
+
+   /// Queue @a inst to be animated at its current detail level.
+   void add( TSShapeInstance *inst );
+
+   /// Remove all queued instances.
+   void clear() { mEntries.clear(); }
+
+   /// Return the number of queued instances.
+   U32 size() const { return mEntries.size(); }
+
+   /// Animate all queued instances and clear the queue.
+   void animate();
+
+   /// Return the number of node transforms computed by the batched path in
+   /// the last animate().
+   U32 getNumBatchedNodes() const { return mNumBatchedNodes; }
+
+   /// Return true if the node animation of @a inst for subshape @a ss can be
+   /// batched.
+   static bool canBatch( TSShapeInstance *inst, S32 ss );
+
+protected:
+
+   struct Entry
+   {
+      TSShapeInstance *inst;
+      const TSShape *shape;
+      S32 subShape;
+      S32 sequence;
+   };
+
+   static S32 QSORT_CALLBACK _compareEntries( const void *a, const void *b );
+
+   /// Compute the node transforms of @a count instances sharing a shape,
+   /// subshape and sequence.
+   void _animateGroup( const Entry *entries, U32 count );
+
+   Vector<Entry> mEntries;
+
+   U32 mNumBatchedNodes;
+
+   /// @name Group scratch space
+   /// Per node arrays are laid out node-major so that the instances of a
+   /// node are contiguous.
+   /// @{
+
+   Vector<const Quat16*> mRot1;
+   Vector<const Quat16*> mRot2;
+   Vector<F32> mInterp;
+   Vector<Point3F> mTrans;
+   Vector<MatrixF> mLocal;
+
+   /// @}
+};
+
+#endif // _TSANIMBATCH_H_
@@ -0,0 +1,180 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "ts/tsAnimThrottle.h"
+
+#include "ts/tsShapeInstance.h"
+#include "ts/tsTransform.h"
+#include "console/console.h"
+#include "console/consoleTypes.h"
+#include "core/module.h"
+#include "platform/profiler.h"
+
+
+bool TSAnimThrottle::smEnabled = true;
+
+
+MODULE_BEGIN( TSAnimThrottle )
+
+   MODULE_INIT
+   {
+      Con::addVariable( "$TS::animThrottle", TypeBool, &TSAnimThrottle::smEnabled,
+         "@brief If false, shapes animate every frame regardless of their animation "
+         "update rate settings.\n"
+         "@ingroup Rendering\n" );
+   }
+
+MODULE_END;
+
+
+TSAnimThrottle::TSAnimThrottle()
+   :  mLastFrame( 0 ),
+      mLastUpdateFrame( 0 ),
+      mInterval( 1 ),
+      mDetail( -1 ),
+      mHasPoses( false )
+{
+}
+
+U32 TSAnimThrottle::getUpdateInterval( const Settings &settings, F32 pixelRadius )
+{
+   if ( !smEnabled || settings.fullRatePixels <= 0.0f || pixelRadius >= settings.fullRatePixels )
+      return 1;
+
+   if ( pixelRadius < settings.frozenPixels )
+      return 0;
+
+   const S32 maxInterval = getMax( settings.maxUpdateInterval, 1 );
+
+   // Grow linearly from every frame at fullRatePixels to maxInterval at
+   // frozenPixels.
+   const F32 range = getMax( settings.fullRatePixels - settings.frozenPixels, 0.001f );
+   const F32 t = mClampF( ( settings.fullRatePixels - pixelRadius ) / range, 0.0f, 1.0f );
+
+   return 1 + (U32)mFloor( t * ( maxInterval - 1 ) + 0.5f );
+}
+
+void TSAnimThrottle::reset()
+{
+   mHasPoses = false;
+   mDetail = -1;
+}
+
+void TSAnimThrottle::animate( TSShapeInstance *inst, const Settings &settings, F32 pixelRadius, U32 frame )
+{
+   const S32 dl = inst->getCurrentDetail();
+   const U32 interval = inst->scaleCurrentlyAnimated() ? 1 : getUpdateInterval( settings, pixelRadius );
+
+   if ( interval == 1 )
+   {
+      PROFILE_SCOPE( TSAnimThrottle_Full );
+
+      inst->animate();
+
+      mHasPoses = false;
+      mInterval = 1;
+      mLastFrame = frame;
+      mDetail = dl;
+      return;
+   }
+
+   if ( frame == mLastFrame && dl == mDetail )
+      return;
+
+   const bool detailChanged = dl != mDetail;
+   mLastFrame = frame;
+   mDetail = dl;
+   mInterval = interval;
+
+   if ( interval == 0 )
+   {
+      PROFILE_SCOPE( TSAnimThrottle_Frozen );
+
+      // Keep the last pose, unless a new detail level may need nodes it
+      // doesn't have.
+      if ( detailChanged )
+         inst->animate();
+
+      mHasPoses = false;
+      return;
+   }
+
+   PROFILE_SCOPE( TSAnimThrottle_Interpolated );
+
+   if ( !mHasPoses || detailChanged || inst->mNodeTransforms.size() != mNextRot.size() )
+   {
+      inst->setDirty( TSShapeInstance::TransformDirty );
+      inst->animate();
+
+      _storePose( inst );
+      mPrevRot = mNextRot;
+      mPrevPos = mNextPos;
+      mLastUpdateFrame = frame;
+      mHasPoses = true;
+   }
+   else if ( frame - mLastUpdateFrame >= interval )
+   {
+      PROFILE_SCOPE( TSAnimThrottle_Update );
+
+      // The node transforms hold an interpolated pose, so make sure they
+      // are recomputed even if no thread advanced.
+      inst->setDirty( TSShapeInstance::TransformDirty );
+      inst->animate();
+
+      // Continue from the pose we showed last.
+      mPrevRot = mNextRot;
+      mPrevPos = mNextPos;
+      _storePose( inst );
+      mLastUpdateFrame = frame;
+   }
+
+   // Interpolating the matrices directly would shear and shrink the
+   // rotations, so blend the rotations and translations instead.
+   const F32 t = F32( frame - mLastUpdateFrame ) / F32( interval );
+   const U32 numNodes = mNextRot.size();
+
+   MatrixF *out = inst->mNodeTransforms.address();
+
+   QuatF q;
+   Point3F p;
+   for ( U32 i = 0; i < numNodes; i++ )
+   {
+      TSTransform::interpolate( mPrevRot[i], mNextRot[i], t, &q );
+      TSTransform::interpolate( mPrevPos[i], mNextPos[i], t, &p );
+      TSTransform::setMatrix( q, p, &out[i] );
+   }
+}
+
+void TSAnimThrottle::_storePose( TSShapeInstance *inst )
+{
+   const U32 numNodes = inst->mNodeTransforms.size();
+   mNextRot.setSize( numNodes );
+   mNextPos.setSize( numNodes );
+
+   for ( U32 i = 0; i < numNodes; i++ )
+   {
+      const MatrixF &mat = inst->mNodeTransforms[i];
+      mNextRot[i].set( mat );
+      mat.getColumn( 3, &mNextPos[i] );
+   }
+}
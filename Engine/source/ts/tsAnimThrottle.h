@@ -0,0 +1,131 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _TSANIMTHROTTLE_H_
+#define _TSANIMTHROTTLE_H_
+
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+#ifndef _MMATRIX_H_
+#include "math/mMatrix.h"
+#endif
+#ifndef _MQUAT_H_
+#include "math/mQuat.h"
+#endif
+
+class TSShapeInstance;
+
+
+/// Lowers the animation update rate of a shape instance as it gets smaller
+/// on screen.
+///
+/// Shapes at least TSAnimThrottle::Settings::fullRatePixels in projected
+/// radius animate every frame.  Below that they animate every Nth frame,
+/// with N growing towards TSAnimThrottle::Settings::maxUpdateInterval as the
+/// radius approaches TSAnimThrottle::Settings::frozenPixels, and the node
+/// rotations and translations of the frames in between are interpolated.
+/// Shapes smaller than that keep their last pose.  Shapes with animated
+/// scale animate every frame, as their node transforms can't be
+/// decomposed into a rotation and a translation.
+///
+/// Interpolating between the last two updates delays the animation by up to
+/// one update interval, which is not noticeable at the sizes it is used at.
+///
+/// Each object owns one throttle and calls animate() in place of
+/// TSShapeInstance::animate() while preparing to render.
+class TSAnimThrottle
+{
+public:
+
+   /// Per shape settings, usually filled from datablock fields.
+   struct Settings
+   {
+      /// Projected radius in pixels at or above which the shape animates
+      /// every frame.  Zero disables throttling.
+      F32 fullRatePixels;
+
+      /// Projected radius in pixels below which the shape stops animating.
+      /// Zero never freezes the shape.
+      F32 frozenPixels;
+
+      /// Most frames between two animation updates.
+      S32 maxUpdateInterval;
+
+      Settings()
+         :  fullRatePixels( 0.0f ),
+            frozenPixels( 0.0f ),
+            maxUpdateInterval( 4 )
+      {
+      }
+   };
+
+   /// If false, every shape animates every frame.
+   static bool smEnabled;
+
+   TSAnimThrottle();
+
+   /// Return the number of frames between animation updates of a shape
+   /// with the given projected radius, or 0 if it shouldn't animate.
+   static U32 getUpdateInterval( const Settings &settings, F32 pixelRadius );
+
+   /// Animate @a inst at its current detail level, interpolate its pose or
+   /// leave it as it is.  Repeated calls for the same @a frame, e.g. from
+   /// shadow and reflection passes, only do the work once.
+   void animate( TSShapeInstance *inst, const Settings &settings, F32 pixelRadius, U32 frame );
+
+   /// Animate on the next call, e.g. after the shape instance changed.
+   void reset();
+
+   /// Return the update interval of the last animate().
+   U32 getUpdateInterval() const { return mInterval; }
+
+protected:
+
+   /// The frame of the last animate() call.
+   U32 mLastFrame;
+
+   /// The frame of the last animation update.
+   U32 mLastUpdateFrame;
+
+   U32 mInterval;
+
+   /// The detail level of the last animate() call.
+   S32 mDetail;
+
+   /// True if the poses below are valid.
+   bool mHasPoses;
+
+   /// Node rotations and translations of the last two animation updates.
+   /// @{
+   Vector<QuatF> mPrevRot;
+   Vector<QuatF> mNextRot;
+   Vector<Point3F> mPrevPos;
+   Vector<Point3F> mNextPos;
+   /// @}
+
+   /// Store the node transforms of @a inst as the pose of the latest
+   /// update.
+   void _storePose( TSShapeInstance *inst );
+};
+
+#endif // _TSANIMTHROTTLE_H_
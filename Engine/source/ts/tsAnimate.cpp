@@ -58,7 +58,7 @@ void TSShapeInstance::clearDirty(U32 dirty)
 // Animate nodes
 //-------------------------------------------------------------------------------------
 
-void TSShapeInstance::animateNodes(S32 ss)
+void TSShapeInstance::animateNodes(S32 ss, const TSIntegerSet *nodeSubset)
 {
    PROFILE_SCOPE( TSShapeInstance_animateNodes );
 
@@ -130,6 +130,37 @@ void TSShapeInstance::animateNodes(S32 ss)
       }
    }
 
+   // nodes outside the subset keep their default transform too
+   if (nodeSubset)
+   {
+      TSIntegerSet skipNodes;
+      skipNodes.setAll(mShape->nodes.size());
+      skipNodes.takeAway(*nodeSubset);
+      skipNodes.takeAway(mAlwaysAnimatedNodes);
+      skipNodes.takeAway(mCallbackNodes);
+      skipNodes.takeAway(mHandsOffNodes);
+
+      for (i=skipNodes.start(); i<b; skipNodes.next(i))
+      {
+         if (i<a)
+            continue;
+         if (!rotBeenSet.test(i))
+         {
+            mShape->defaultRotations[i].getQuatF(&smNodeCurrentRotations[i]);
+            smRotationThreads[i] = NULL;
+         }
+         if (!tranBeenSet.test(i))
+         {
+            smNodeCurrentTranslations[i] = mShape->defaultTranslations[i];
+            smTranslationThreads[i] = NULL;
+         }
+      }
+
+      // so the sequences skip them
+      rotBeenSet.overlap(skipNodes);
+      tranBeenSet.overlap(skipNodes);
+   }
+
    // don't want a transform in these cases...
    rotBeenSet.overlap(mHandsOffNodes);
    rotBeenSet.overlap(mCallbackNodes);
@@ -853,9 +884,25 @@ void TSShapeInstance::animate(S32 dl)
    if (dirtyFlags & ThreadDirty)
       sortThreads();
 
+   // nodes used by this detail but not by the last animated subset?
+   if (mNodeSubsetDetail>=0 && (!mAnimateUsedNodesOnly || mNodeSubsetDetail!=dl))
+      dirtyFlags |= TransformDirty;
+
    // animate nodes?
    if (dirtyFlags & TransformDirty)
-      animateNodes(ss);
+   {
+      if (mAnimateUsedNodesOnly && dl<mShape->detailNodes.size())
+      {
+         PROFILE_SCOPE( TSShapeInstance_animateNodeSubset );
+         animateNodes(ss,&mShape->detailNodes[dl]);
+         mNodeSubsetDetail = dl;
+      }
+      else
+      {
+         animateNodes(ss);
+         mNodeSubsetDetail = -1;
+      }
+   }
 
    // animate objects?
    if (dirtyFlags & VisDirty)
@@ -886,6 +933,16 @@ void TSShapeInstance::animateNodeSubtrees(bool forceFull)
          mDirtyFlags[i] &= ~TransformDirty;
       }
    }
+   mNodeSubsetDetail = -1;
+}
+
+void TSShapeInstance::addAlwaysAnimatedNode(S32 nodeIndex)
+{
+   for (S32 i=nodeIndex; i>=0 && !mAlwaysAnimatedNodes.test(i); i=mShape->nodes[i].parentIndex)
+      mAlwaysAnimatedNodes.set(i);
+
+   if (mNodeSubsetDetail>=0)
+      setDirty(TransformDirty);
 }
 
 void TSShapeInstance::animateSubtrees(bool forceFull)
@@ -24,6 +24,7 @@
 #include "ts/tsMesh.h"
 
 #include "ts/tsMeshIntrinsics.h"
+#include "ts/tsSkinJobs.h"
 #include "ts/tsDecal.h"
 #include "ts/tsSortedMesh.h"
 #include "ts/tsShape.h"
@@ -1201,18 +1202,53 @@ void TSSkinMesh::updateSkin( const Vector<MatrixF> &transforms, TSVertexBufferHa
 
    static Vector<MatrixF> sBoneTransforms;
    sBoneTransforms.setSize( batchData.nodeIndex.size() );
+   computeBoneTransforms( transforms, sBoneTransforms.address() );
+
+   U8 *outPtr = reinterpret_cast<U8 *>(mVertexData.address());
+   dsize_t outStride = mVertexData.vertSize();
+
+#if defined(USE_MEM_VERTEX_BUFFERS)
+   if ( batchData.vertexBatchOperations.empty() )
+   {
+      // Initialize it if NULL. 
+      // Skinning includes readbacks from memory (argh) so don't allocate with PAGE_WRITECOMBINE
+      if( instanceVB.isNull() )
+         instanceVB.set( GFX, outStride, mVertexFormat, mNumVerts, GFXBufferTypeDynamic );
+
+      // Grow if needed
+      if( instanceVB.getPointer()->mNumVerts < mNumVerts )
+         instanceVB.resize( mNumVerts );
+
+      // Lock, and skin directly into the final memory destination
+      outPtr = (U8 *)instanceVB.lock();
+      if(!outPtr) return;
+   }
+#endif
+
+   skin( sBoneTransforms.address(), outPtr, outStride );
+
+#if defined(USE_MEM_VERTEX_BUFFERS)
+   if ( batchData.vertexBatchOperations.empty() )
+      instanceVB.unlock();
+#endif
+
+   // andrewmac: Has Skinned Flag.
+   mHasSkinned = true;
+}
+
+void TSSkinMesh::computeBoneTransforms( const Vector<MatrixF> &transforms, MatrixF *outBones ) const
+{
+   PROFILE_SCOPE( TSSkinMesh_UpdateTransforms );
 
-   // set up bone transforms
-   PROFILE_START(TSSkinMesh_UpdateTransforms);
    for( S32 i=0; i<batchData.nodeIndex.size(); i++ )
    {
       S32 node = batchData.nodeIndex[i];
-      sBoneTransforms[i].mul( transforms[node], batchData.initialTransforms[i] );
+      outBones[i].mul( transforms[node], batchData.initialTransforms[i] );
    }
-   const MatrixF * matrices = &sBoneTransforms[0];
-   PROFILE_END();
+}
 
-   // Perform skinning
+void TSSkinMesh::skin( const MatrixF *matrices, U8 *outPtr, dsize_t outStride )
+{
    const bool bBatchByVert = !batchData.vertexBatchOperations.empty();
    if(bBatchByVert)
    {
@@ -1248,30 +1284,13 @@ void TSSkinMesh::updateSkin( const Vector<MatrixF> &transforms, TSVertexBufferHa
          }
 
          // Assign results 
-         __TSMeshVertexBase &dest = mVertexData[curVert.vertexIndex];
+         __TSMeshVertexBase &dest = *reinterpret_cast<__TSMeshVertexBase *>(outPtr + curVert.vertexIndex * outStride);
          dest.vert(skinnedVert);
          dest.normal(skinnedNorm);
       }
    }
    else // Batch by transform
    {
-      U8 *outPtr = reinterpret_cast<U8 *>(mVertexData.address());
-      dsize_t outStride = mVertexData.vertSize();
-
-#if defined(USE_MEM_VERTEX_BUFFERS)
-      // Initialize it if NULL. 
-      // Skinning includes readbacks from memory (argh) so don't allocate with PAGE_WRITECOMBINE
-      if( instanceVB.isNull() )
-         instanceVB.set( GFX, outStride, mVertexFormat, mNumVerts, GFXBufferTypeDynamic );
-
-      // Grow if needed
-      if( instanceVB.getPointer()->mNumVerts < mNumVerts )
-         instanceVB.resize( mNumVerts );
-
-      // Lock, and skin directly into the final memory destination
-      outPtr = (U8 *)instanceVB.lock();
-      if(!outPtr) return;
-#endif
       // Set position/normal to zero so we can accumulate
       zero_vert_normal_bulk(mNumVerts, outPtr, outStride);
 
@@ -1288,13 +1307,7 @@ void TSSkinMesh::updateSkin( const Vector<MatrixF> &transforms, TSVertexBufferHa
          m_matF_x_BatchedVertWeightList(curBoneMat, numVerts, curTransform.alignedMem,
             outPtr, outStride);
       }
-#if defined(USE_MEM_VERTEX_BUFFERS)
-      instanceVB.unlock();
-#endif
    }
-
-   // andrewmac: Has Skinned Flag.
-   mHasSkinned = true;
 }
 
 S32 QSORT_CALLBACK _sort_BatchedVertWeight( const void *a, const void *b )
@@ -1504,7 +1517,17 @@ void TSSkinMesh::render(   TSMaterialList *materials,
    const bool vertsChanged = vertexBuffer.isNull() || vertexBuffer->mNumVerts != mNumVerts;
    const bool primsChanged = primitiveBuffer.isNull() || primitiveBuffer->mIndexCount != indices.size();
 
-   if ( primsChanged || vertsChanged || isSkinDirty )
+   if ( vertexOverride == NULL && TSSkinJobQueue::isCollecting() )
+   {
+      // Skin later on a worker thread.  The buffers still have to exist
+      // for the render instance batched below.
+      if ( primsChanged || vertsChanged )
+         _createVBIB( vertexBuffer, primitiveBuffer );
+
+      if ( primsChanged || vertsChanged || isSkinDirty )
+         TSSkinJobQueue::queue( this, transforms, vertexBuffer );
+   }
+   else if ( primsChanged || vertsChanged || isSkinDirty )
    {
 		// Perform skinning
 		// andrewmac: no point in doing this if we're overriding.
@@ -2487,52 +2510,62 @@ void TSMesh::assemble( bool skip )
    tsalloc.get32( (S32*)&mCenter, 3 );
    mRadius = (F32)tsalloc.get32();
 
-   S32 numVerts = tsalloc.get32();
-   S32 *ptr32 = getSharedData32( parentMesh, 3 * numVerts, (S32**)smVertsList.address(), skip );
-   verts.set( (Point3F*)ptr32, numVerts );
+   // from version 28 on the vertex data of standard meshes is stored in an
+   // aligned block after the rest of the shape, TSShape::readVertexBlocks()
+   // points us at it once the meshes are assembled
+   bool vertexBlock = false;
+   if ( TSShape::smReadVersion > 27 )
+      vertexBlock = tsalloc.get32() != 0;
 
-   S32 numTVerts = tsalloc.get32();
-   ptr32 = getSharedData32( parentMesh, 2 * numTVerts, (S32**)smTVertsList.address(), skip );
-   tverts.set( (Point2F*)ptr32, numTVerts );
-
-   if ( TSShape::smReadVersion > 25 )
+   if ( !vertexBlock )
    {
-      numTVerts = tsalloc.get32();
-      ptr32 = getSharedData32( parentMesh, 2 * numTVerts, (S32**)smTVerts2List.address(), skip );
-      tverts2.set( (Point2F*)ptr32, numTVerts );
+      S32 numVerts = tsalloc.get32();
+      S32 *ptr32 = getSharedData32( parentMesh, 3 * numVerts, (S32**)smVertsList.address(), skip );
+      verts.set( (Point3F*)ptr32, numVerts );
 
-      S32 numVColors = tsalloc.get32();
-      ptr32 = getSharedData32( parentMesh, numVColors, (S32**)smColorsList.address(), skip );
-      colors.set( (ColorI*)ptr32, numVColors );
-   }
+      S32 numTVerts = tsalloc.get32();
+      ptr32 = getSharedData32( parentMesh, 2 * numTVerts, (S32**)smTVertsList.address(), skip );
+      tverts.set( (Point2F*)ptr32, numTVerts );
 
-   S8 *ptr8;
-   if ( TSShape::smReadVersion > 21 && TSMesh::smUseEncodedNormals)
-   {
-      // we have encoded normals and we want to use them...
-      if ( parentMesh < 0 )
-         tsalloc.getPointer32( numVerts * 3 ); // advance past norms, don't use
-      norms.set( NULL, 0 );
+      if ( TSShape::smReadVersion > 25 )
+      {
+         numTVerts = tsalloc.get32();
+         ptr32 = getSharedData32( parentMesh, 2 * numTVerts, (S32**)smTVerts2List.address(), skip );
+         tverts2.set( (Point2F*)ptr32, numTVerts );
 
-      ptr8 = getSharedData8( parentMesh, numVerts, (S8**)smEncodedNormsList.address(), skip );
-      encodedNorms.set( ptr8, numVerts );
-   }
-   else if ( TSShape::smReadVersion > 21 )
-   {
-      // we have encoded normals but we don't want to use them...
-      ptr32 = getSharedData32( parentMesh, 3 * numVerts, (S32**)smNormsList.address(), skip );
-      norms.set( (Point3F*)ptr32, numVerts );
+         S32 numVColors = tsalloc.get32();
+         ptr32 = getSharedData32( parentMesh, numVColors, (S32**)smColorsList.address(), skip );
+         colors.set( (ColorI*)ptr32, numVColors );
+      }
 
-      if ( parentMesh < 0 )
-         tsalloc.getPointer8( numVerts ); // advance past encoded normls, don't use
-      encodedNorms.set( NULL, 0 );
-   }
-   else
-   {
-      // no encoded normals...
-      ptr32 = getSharedData32( parentMesh, 3 * numVerts, (S32**)smNormsList.address(), skip );
-      norms.set( (Point3F*)ptr32, numVerts );
-      encodedNorms.set( NULL, 0 );
+      S8 *ptr8;
+      if ( TSShape::smReadVersion > 21 && TSMesh::smUseEncodedNormals)
+      {
+         // we have encoded normals and we want to use them...
+         if ( parentMesh < 0 )
+            tsalloc.getPointer32( numVerts * 3 ); // advance past norms, don't use
+         norms.set( NULL, 0 );
+
+         ptr8 = getSharedData8( parentMesh, numVerts, (S8**)smEncodedNormsList.address(), skip );
+         encodedNorms.set( ptr8, numVerts );
+      }
+      else if ( TSShape::smReadVersion > 21 )
+      {
+         // we have encoded normals but we don't want to use them...
+         ptr32 = getSharedData32( parentMesh, 3 * numVerts, (S32**)smNormsList.address(), skip );
+         norms.set( (Point3F*)ptr32, numVerts );
+
+         if ( parentMesh < 0 )
+            tsalloc.getPointer8( numVerts ); // advance past encoded normls, don't use
+         encodedNorms.set( NULL, 0 );
+      }
+      else
+      {
+         // no encoded normals...
+         ptr32 = getSharedData32( parentMesh, 3 * numVerts, (S32**)smNormsList.address(), skip );
+         norms.set( (Point3F*)ptr32, numVerts );
+         encodedNorms.set( NULL, 0 );
+      }
    }
 
    // copy the primitives and indices...how we do this depends on what
@@ -2632,7 +2665,7 @@ void TSMesh::assemble( bool skip )
    if ( tsalloc.allocShape32( 0 ) && TSShape::smReadVersion < 19 )
       computeBounds(); // only do this if we copied the data...
 
-   if(getMeshType() != SkinMeshType)
+   if ( getMeshType() != SkinMeshType && !vertexBlock )
       createTangents(verts, norms);
 }
 
@@ -2647,68 +2680,77 @@ void TSMesh::disassemble()
    tsalloc.copyToBuffer32( (S32*)&mCenter, 3 );
    tsalloc.set32( (S32)mRadius );
 
-   // Re-create the vectors
-   if(mVertexData.isReady())
-   {
-      verts.setSize(mNumVerts);
-      tverts.setSize(mNumVerts);
-      norms.setSize(mNumVerts);
-
-      if(mHasColor)
-         colors.setSize(mNumVerts);
-      if(mHasTVert2)
-         tverts2.setSize(mNumVerts);
+   // standard meshes write their vertex data as a block after the rest of
+   // the shape, see TSShape::writeVertexBlocks()
+   const bool vertexBlock = TSShape::smVersion > 27 && hasVertexBlock();
+   if ( TSShape::smVersion > 27 )
+      tsalloc.set32( vertexBlock );
 
-      // Fill arrays
-      for(U32 i = 0; i < mNumVerts; i++)
+   if ( !vertexBlock )
+   {
+      // Re-create the vectors
+      if(mVertexData.isReady())
       {
-         const __TSMeshVertexBase &cv = mVertexData[i];
-         verts[i] = cv.vert();
-         tverts[i] = cv.tvert();
-         norms[i] = cv.normal();
+         verts.setSize(mNumVerts);
+         tverts.setSize(mNumVerts);
+         norms.setSize(mNumVerts);
 
          if(mHasColor)
-            cv.color().getColor(&colors[i]);
+            colors.setSize(mNumVerts);
          if(mHasTVert2)
-            tverts2[i] = cv.tvert2();
-      }
-   }
+            tverts2.setSize(mNumVerts);
 
-   // verts...
-   tsalloc.set32( verts.size() );
-   if ( parentMesh < 0 )
-      tsalloc.copyToBuffer32( (S32*)verts.address(), 3 * verts.size() ); // if no parent mesh, then save off our verts
-
-   // tverts...
-   tsalloc.set32( tverts.size() );
-   if ( parentMesh < 0 )
-      tsalloc.copyToBuffer32( (S32*)tverts.address(), 2 * tverts.size() ); // if no parent mesh, then save off our tverts
+         // Fill arrays
+         for(U32 i = 0; i < mNumVerts; i++)
+         {
+            const __TSMeshVertexBase &cv = mVertexData[i];
+            verts[i] = cv.vert();
+            tverts[i] = cv.tvert();
+            norms[i] = cv.normal();
+
+            if(mHasColor)
+               cv.color().getColor(&colors[i]);
+            if(mHasTVert2)
+               tverts2[i] = cv.tvert2();
+         }
+      }
 
-   if (TSShape::smVersion > 25)
-   {
-      // tverts2...
-      tsalloc.set32( tverts2.size() );
+      // verts...
+      tsalloc.set32( verts.size() );
       if ( parentMesh < 0 )
-         tsalloc.copyToBuffer32( (S32*)tverts2.address(), 2 * tverts2.size() ); // if no parent mesh, then save off our tverts
+         tsalloc.copyToBuffer32( (S32*)verts.address(), 3 * verts.size() ); // if no parent mesh, then save off our verts
 
-      // colors
-      tsalloc.set32( colors.size() );
+      // tverts...
+      tsalloc.set32( tverts.size() );
       if ( parentMesh < 0 )
-         tsalloc.copyToBuffer32( (S32*)colors.address(), colors.size() ); // if no parent mesh, then save off our tverts
-   }
+         tsalloc.copyToBuffer32( (S32*)tverts.address(), 2 * tverts.size() ); // if no parent mesh, then save off our tverts
 
-   // norms...
-   if ( parentMesh < 0 ) // if no parent mesh, then save off our norms
-      tsalloc.copyToBuffer32( (S32*)norms.address(), 3 * norms.size() ); // norms.size()==verts.size() or error...
+      if (TSShape::smVersion > 25)
+      {
+         // tverts2...
+         tsalloc.set32( tverts2.size() );
+         if ( parentMesh < 0 )
+            tsalloc.copyToBuffer32( (S32*)tverts2.address(), 2 * tverts2.size() ); // if no parent mesh, then save off our tverts
+
+         // colors
+         tsalloc.set32( colors.size() );
+         if ( parentMesh < 0 )
+            tsalloc.copyToBuffer32( (S32*)colors.address(), colors.size() ); // if no parent mesh, then save off our tverts
+      }
 
-   // encoded norms...
-   if ( parentMesh < 0 )
-   {
-      // if no parent mesh, compute encoded normals and copy over
-      for ( S32 i = 0; i < norms.size(); i++ )
+      // norms...
+      if ( parentMesh < 0 ) // if no parent mesh, then save off our norms
+         tsalloc.copyToBuffer32( (S32*)norms.address(), 3 * norms.size() ); // norms.size()==verts.size() or error...
+
+      // encoded norms...
+      if ( parentMesh < 0 )
       {
-         U8 normIdx = encodedNorms.size() ? encodedNorms[i] : encodeNormal( norms[i] );
-         tsalloc.copyToBuffer8( (S8*)&normIdx, 1 );
+         // if no parent mesh, compute encoded normals and copy over
+         for ( S32 i = 0; i < norms.size(); i++ )
+         {
+            U8 normIdx = encodedNorms.size() ? encodedNorms[i] : encodeNormal( norms[i] );
+            tsalloc.copyToBuffer8( (S8*)&normIdx, 1 );
+         }
       }
    }
 
@@ -2722,7 +2764,7 @@ void TSMesh::disassemble()
          // only optimize triangle lists (strips and fans are assumed to be already optimized)
          if ( (prim.matIndex & TSDrawPrimitive::TypeMask) == TSDrawPrimitive::Triangles )
          {
-            TriListOpt::OptimizeTriangleOrdering(verts.size(), prim.numElements,
+            TriListOpt::OptimizeTriangleOrdering(vertexBlock ? mNumVerts : verts.size(), prim.numElements,
                indices.address() + prim.start, tmpIdxs.address());
             dCopyArray(indices.address() + prim.start, tmpIdxs.address(), 
                prim.numElements);
@@ -3053,6 +3095,16 @@ void TSMesh::convertToAlignedMeshData()
 }
 
 
+bool TSMesh::hasVertexBlock() const
+{
+   // Skins keep their rest pose in vectors for skinning, so only standard
+   // meshes can use their vertex data straight from the shape file.
+   return getMeshType() == StandardMeshType &&
+          mVertexData.isReady() &&
+          mNumVerts > 0 &&
+          mVertexData.vertSize() == mVertSize;
+}
+
 void TSSkinMesh::convertToAlignedMeshData()
 {
    if(!mVertexData.isReady())
@@ -210,19 +210,29 @@ class TSMesh
       U8 *base;
       dsize_t vertSz;
       bool vertexDataReady;
+      bool ownsBase;
       U32 numElements;
 
    public:
-      TSMeshVertexArray() : base(NULL), vertexDataReady(false), numElements(0) {}
+      TSMeshVertexArray() : base(NULL), vertexDataReady(false), ownsBase(true), numElements(0) {}
       virtual ~TSMeshVertexArray() { set(NULL, 0, 0); }
 
       virtual void set(void *b, dsize_t s, U32 n, bool autoFree = true ) 
       {
-         if(base && autoFree) 
+         if(base && autoFree && ownsBase) 
             dFree_aligned(base); 
          base = reinterpret_cast<U8 *>(b); 
          vertSz = s; 
          numElements = n; 
+         ownsBase = true;
+      }
+
+      /// Use vertex data that lives elsewhere, such as in a memory mapped
+      /// shape file.  It is never freed by this array.
+      void setExternal(void *b, dsize_t s, U32 n)
+      {
+         set(b, s, n);
+         ownsBase = false;
       }
 
       // Vector-like interface
@@ -233,6 +243,7 @@ class TSMesh
       dsize_t vertSize() const { return vertSz; }
       bool isReady() const { return vertexDataReady; }
       void setReady(bool r) { vertexDataReady = r; }
+      bool isExternal() const { return base && !ownsBase; }
    };
 
    bool mHasColor;
@@ -241,6 +252,10 @@ class TSMesh
    TSMeshVertexArray mVertexData;
    dsize_t mNumVerts;
    virtual void convertToAlignedMeshData();
+
+   /// Returns true if the vertex data is written as an aligned block after
+   /// the rest of the shape instead of as separate arrays (version 28 and up).
+   bool hasVertexBlock() const;
    /// @}
 
    /// @name Vertex data
@@ -421,6 +436,8 @@ class TSMesh
 
 class TSSkinMesh : public TSMesh
 {
+   friend class TSSkinJobQueue;
+
 public:
    struct BatchData
    {
@@ -532,6 +549,15 @@ public:
    /// set verts and normals...
    void updateSkin( const Vector<MatrixF> &transforms, TSVertexBufferHandle &instanceVB, GFXPrimitiveBufferHandle &instancePB );
 
+   /// Compute the skinning matrix of every bone from the node @a transforms.
+   /// @a outBones must hold batchData.nodeIndex.size() matrices.
+   void computeBoneTransforms( const Vector<MatrixF> &transforms, MatrixF *outBones ) const;
+
+   /// Write skinned positions and normals into a copy of the aligned vertex
+   /// data at @a outPtr.  Other vertex components are left untouched.  Safe
+   /// to call from any thread once the batch data is initialized.
+   void skin( const MatrixF *bones, U8 *outPtr, dsize_t outStride );
+
    // render methods..
    void render( TSVertexBufferHandle &instanceVB, GFXPrimitiveBufferHandle &instancePB );
    void render(   TSMaterialList *, 
@@ -100,6 +100,11 @@ MODULE_BEGIN( TSMeshIntrinsics )
          zero_vert_normal_bulk = zero_vert_normal_bulk_SSE;
          m_matF_x_BatchedVertWeightList = m_matF_x_BatchedVertWeightList_SSE;
 
+   #if defined(TORQUE_TS_AVX2)
+         if(ts_cpu_has_avx2())
+            m_matF_x_BatchedVertWeightList = m_matF_x_BatchedVertWeightList_AVX2;
+   #endif
+
          /* This code still has a bug left in it
    #if (_MSC_VER >= 1500)
          if(Platform::SystemInfo.processor.properties & CPU_PROP_SSE4_1)
@@ -42,7 +42,7 @@ extern TSShape* loadColladaShape(const Torque::Path &path);
 #endif
 
 /// most recent version -- this is the version we write
-S32 TSShape::smVersion = 26;
+S32 TSShape::smVersion = 28;
 /// the version currently being read...valid only during a read
 S32 TSShape::smReadVersion = -1;
 const U32 TSShape::smMostRecentExporterVersion = DTS_EXPORTER_CURRENT_VERSION;
@@ -152,6 +152,9 @@ TSShape::~TSShape()
 
    if( mShapeData )
       delete[] mShapeData;
+
+   if( mMappedFile )
+      mMappedFile->unmap();
 }
 
 const String& TSShape::getName( S32 nameIndex ) const
@@ -545,10 +548,59 @@ void TSShape::init()
          detailCollisionAccelerators[dca] = NULL;
    }
 
+   initDetailNodes();
    initVertexFeatures();
    initMaterialList();
 }
 
+void TSShape::initDetailNodes()
+{
+   detailNodes.setSize(details.size());
+
+   for (S32 i=0; i<details.size(); i++)
+   {
+      TSIntegerSet & used = detailNodes[i];
+      used.clearAll();
+
+      S32 ss = details[i].subShapeNum;
+      S32 od = details[i].objectDetailNum;
+      if (ss<0)
+         continue;
+
+      S32 start = subShapeFirstObject[ss];
+      S32 end   = start + subShapeNumObjects[ss];
+      for (S32 j=start; j<end; j++)
+      {
+         const Object & obj = objects[j];
+         if (od>=obj.numMeshes)
+            continue;
+
+         TSMesh * mesh = meshes[obj.startMeshIndex+od];
+         if (!mesh)
+            continue;
+
+         if (obj.nodeIndex>=0)
+            used.set(obj.nodeIndex);
+
+         if (mesh->getMeshType() == TSMesh::SkinMeshType)
+         {
+            const Vector<S32> & bones = static_cast<TSSkinMesh*>(mesh)->batchData.nodeIndex;
+            for (S32 k=0; k<bones.size(); k++)
+               used.set(bones[k]);
+         }
+      }
+
+      // a node transform depends on all of its ancestors
+      for (S32 j=0; j<nodes.size(); j++)
+      {
+         if (!used.test(j))
+            continue;
+         for (S32 parent=nodes[j].parentIndex; parent>=0 && !used.test(parent); parent=nodes[parent].parentIndex)
+            used.set(parent);
+      }
+   }
+}
+
 void TSShape::initVertexFeatures()
 {
    bool hasColors = false;
@@ -1469,9 +1521,26 @@ bool TSShape::canWriteOldFormat() const
 void TSShape::write(Stream * s, bool saveOldFormat)
 {
    S32 currentVersion = smVersion;
+
+   // Old versions can only store a key per frame, so write the sequences
+   // decompressed and put the compressed tracks back afterwards.
+   SequenceKeys compressedKeys;
+   bool restoreKeys = false;
    if (saveOldFormat)
+   {
       smVersion = 24;
 
+      if (hasCompressedSequences())
+      {
+         saveSequenceKeys(compressedKeys);
+         decompressSequences();
+         restoreKeys = true;
+      }
+   }
+
+   // vertex block offsets are relative to the start of the shape
+   const U32 shapeStart = s->getPosition();
+
    // write version
    s->write(smVersion | (mExporterVersion<<16));
 
@@ -1520,19 +1589,66 @@ void TSShape::write(Stream * s, bool saveOldFormat)
    // write material list - write will properly endian-flip.
    materialList->write(*s);
 
+   // write compressed keyframes
+   if (smVersion >= 27)
+      writeCompressedKeys(s);
+
+   // write mesh vertex blocks
+   if (smVersion >= 28)
+      writeVertexBlocks(s, shapeStart);
+
    delete [] buffer32;
    delete [] buffer16;
    delete [] buffer8;
 
+   if (restoreKeys)
+      restoreSequenceKeys(compressedKeys);
+
    smVersion = currentVersion;
 }
 
+bool TSShape::write(const Torque::Path & path, bool saveOldFormat)
+{
+   // Write to a temporary file and move it into place when done so that a
+   // shape still mapped from the old file never sees it change.
+   const String tempPath = path.getFullPath() + ".tmp";
+
+   FileStream stream;
+   if (!stream.open(tempPath, Torque::FS::File::Write))
+      return false;
+
+   write(&stream, saveOldFormat);
+   const bool writeOk = (stream.getStatus() == Stream::Ok);
+   stream.close();
+
+   if (!writeOk)
+   {
+      Torque::FS::Remove(tempPath);
+      return false;
+   }
+
+   // Not every file system will rename over an existing file.
+   if (!Torque::FS::Rename(tempPath, path))
+   {
+      Torque::FS::Remove(path);
+      if (!Torque::FS::Rename(tempPath, path))
+      {
+         Torque::FS::Remove(tempPath);
+         return false;
+      }
+   }
+
+   return true;
+}
+
 //-------------------------------------------------
 // read whole shape
 //-------------------------------------------------
 
-bool TSShape::read(Stream * s)
+bool TSShape::read(Stream * s, U8 * image, bool mapped)
 {
+   const U32 shapeStart = s->getPosition();
+
    // read version - read handles endian-flip
    s->read(&smReadVersion);
    mExporterVersion = smReadVersion >> 16;
@@ -1572,8 +1688,23 @@ bool TSShape::read(Stream * s)
          return false;
       }
 
-      S32 * tmp = new S32[sizeMemBuffer];
-      s->read(sizeof(S32)*sizeMemBuffer,(U8*)tmp);
+      // buffers in memory are assembled from where they are
+      S32 * tmp;
+      if (image)
+      {
+         if (s->getPosition() + sizeof(S32)*sizeMemBuffer > s->getStreamSize())
+         {
+            Con::errorf(ConsoleLogEntry::General, "Error: bad shape file.");
+            return false;
+         }
+         tmp = (S32*)(image + s->getPosition());
+         s->setPosition(s->getPosition() + sizeof(S32)*sizeMemBuffer);
+      }
+      else
+      {
+         tmp = new S32[sizeMemBuffer];
+         s->read(sizeof(S32)*sizeMemBuffer,(U8*)tmp);
+      }
       memBuffer32 = tmp;
       memBuffer16 = (S16*)(tmp+startU16);
       memBuffer8  = (S8*)(tmp+startU8);
@@ -1599,6 +1730,10 @@ bool TSShape::read(Stream * s)
       delete materialList; // just in case...
       materialList = new TSMaterialList;
       materialList->read(*s);
+
+      // read compressed keyframes
+      if (smReadVersion >= 27)
+         readCompressedKeys(s);
    }
 
 	// since we read in the buffers, we need to endian-flip their entire contents...
@@ -1613,7 +1748,15 @@ bool TSShape::read(Stream * s)
    assembleShape(); // copy to buffer
    AssertFatal(tsalloc.getSize()==mShapeDataSize,"TSShape::read: shape data buffer size mis-calculated");
 
-   delete [] memBuffer32;
+   if (!image)
+      delete [] memBuffer32;
+
+   // give the meshes their vertex blocks now that they exist
+   if (smReadVersion >= 28 && !readVertexBlocks(s, shapeStart, mapped ? image : NULL))
+   {
+      Con::errorf(ConsoleLogEntry::General, "Error: bad shape file.");
+      return false;
+   }
 
    if (smInitOnRead)
       init();
@@ -1988,16 +2131,15 @@ template<> void *Resource<TSShape>::create(const Torque::Path &path)
 
    if ( extension.equal( "dts", String::NoCase ) )
    {
-      FileStream stream;
-      stream.open( path.getFullPath(), Torque::FS::File::Read );
-      if ( stream.getStatus() != Stream::Ok )
+      Torque::FS::FileRef file = Torque::FS::OpenFile( path, Torque::FS::File::Read );
+      if ( !file )
       {
          Con::errorf( "Resource<TSShape>::create - Could not open '%s'", path.getFullPath().c_str() );
          return NULL;
       }
 
       ret = new TSShape;
-      readSuccess = ret->read(&stream);
+      readSuccess = ret->read(file);
    }
    else if ( extension.equal( "dae", String::NoCase ) || extension.equal( "kmz", String::NoCase ) )
    {
@@ -2010,15 +2152,14 @@ template<> void *Resource<TSShape>::create(const Torque::Path &path)
       Torque::Path cachedPath = path;
       cachedPath.setExtension("cached.dts");
        
-      FileStream stream;
-      stream.open( cachedPath.getFullPath(), Torque::FS::File::Read );
-      if ( stream.getStatus() != Stream::Ok )
+      Torque::FS::FileRef file = Torque::FS::OpenFile( cachedPath, Torque::FS::File::Read );
+      if ( !file )
       {
          Con::errorf( "Resource<TSShape>::create - Could not open '%s'", cachedPath.getFullPath().c_str() );
          return NULL;
       }
       ret = new TSShape;
-      readSuccess = ret->read(&stream);
+      readSuccess = ret->read(file);
 #endif
    }
    else
@@ -35,6 +35,9 @@
 #ifndef _TSSHAPEALLOC_H_
 #include "ts/tsShapeAlloc.h"
 #endif
+#ifndef _VOLUME_H_
+#include "core/volume.h"
+#endif
 
 
 #define DTS_EXPORTER_CURRENT_VERSION 124
@@ -74,6 +77,7 @@ class TSShape
          Cyclic         = BIT(4),
          MakePath       = BIT(5),
          HasTranslucency= BIT(6),
+         Compressed     = BIT(7),
          AnyScale       = UniformScale | AlignedScale | ArbitraryScale
       };
 
@@ -187,6 +191,7 @@ class TSShape
       bool isBlend() const                { return testFlags(Blend); }
       bool isCyclic() const               { return testFlags(Cyclic); }
       bool makePath() const               { return testFlags(MakePath); }
+      bool isCompressed() const           { return testFlags(Compressed); }
       /// @}
 
       /// @name IO
@@ -311,6 +316,45 @@ class TSShape
       ;
    /// @}
 
+   /// The nodes the meshes of each detail level are attached to or skinned
+   /// to, plus all their ancestors.  Nodes outside the set of a detail don't
+   /// affect how it renders.
+   /// @see TSShapeInstance::setAnimateUsedNodesOnly
+   Vector<TSIntegerSet> detailNodes;
+
+   /// A node rotation or translation track of a compressed sequence.  Tracks
+   /// only hold the keyframes needed to reproduce the sequence within the
+   /// tolerances it was compressed with; frames in between are interpolated.
+   struct KeyTrack
+   {
+      S32 firstKey;     ///< Index into the key frame and key arrays
+      S32 numKeys;
+   };
+
+   /// Translation keys are quantized to 16 bits per axis over the range of
+   /// the track.
+   struct TranslationTrack : public KeyTrack
+   {
+      Point3F offset;   ///< Translation of a zero key
+      Point3F scale;    ///< Translation per quantization step
+   };
+
+   /// Copy of the sequences and their node rotation and translation keys.
+   /// Lets the shape be decompressed for writing an older format and then
+   /// put back exactly as it was.
+   struct SequenceKeys
+   {
+      Vector<TSShape::Sequence> sequences;
+      Vector<Quat16> nodeRotations;
+      Vector<Point3F> nodeTranslations;
+      Vector<KeyTrack> rotationTracks;
+      Vector<U16> rotationKeyFrames;
+      Vector<Quat16> rotationKeys;
+      Vector<TranslationTrack> translationTracks;
+      Vector<U16> translationKeyFrames;
+      Vector<U16> translationKeys;
+   };
+
    /// @name Resizeable vectors
    /// @{
 
@@ -330,6 +374,23 @@ class TSShape
 
    /// @}
 
+   /// @name Compressed Keyframes
+   /// Sequences with the Compressed flag store a track per animated node in
+   /// these arrays instead of a key per frame in nodeRotations and
+   /// nodeTranslations.  Their baseRotation and baseTranslation index the
+   /// first track, and tracks follow the order of rotationMatters and
+   /// translationMatters.
+   /// @{
+
+   Vector<KeyTrack>                 rotationTracks;
+   Vector<U16>                      rotationKeyFrames;
+   Vector<Quat16>                   rotationKeys;
+   Vector<TranslationTrack>         translationTracks;
+   Vector<U16>                      translationKeyFrames;
+   Vector<U16>                      translationKeys;     ///< 3 per key
+
+   /// @}
+
    TSMaterialList * materialList;
 
    /// @name Bounding
@@ -394,6 +455,11 @@ class TSShape
    S8* mShapeData;
    U32 mShapeDataSize;
 
+   /// The file this shape was mapped from, while any mesh vertex blocks
+   /// point into it.  The file itself is closed once it is mapped.
+   /// @see readVertexBlocks()
+   Torque::FS::FileRef mMappedFile;
+
    // shape class has few methods --
    // just constructor/destructor, io, and lookup methods
 
@@ -410,6 +476,10 @@ class TSShape
    /// all detail meshes in the shape.
    void initVertexFeatures();
 
+   /// Called from init() to find the nodes used by each detail level.
+   /// @see detailNodes
+   void initDetailNodes();
+
    bool getSequencesConstructed() const { return mSequencesConstructed; }
    void setSequencesConstructed(const bool c) { mSequencesConstructed = c; }
 
@@ -419,13 +489,75 @@ class TSShape
    /// @{
 
    QuatF & getRotation(const Sequence & seq, S32 keyframeNum, S32 rotNum, QuatF *) const;
-   const Point3F & getTranslation(const Sequence & seq, S32 keyframeNum, S32 tranNum) const;
+   Point3F getTranslation(const Sequence & seq, S32 keyframeNum, S32 tranNum) const;
    F32 getUniformScale(const Sequence & seq, S32 keyframeNum, S32 scaleNum) const;
    const Point3F & getAlignedScale(const Sequence & seq, S32 keyframeNum, S32 scaleNum) const;
    TSScale & getArbitraryScale(const Sequence & seq, S32 keyframeNum, S32 scaleNum, TSScale *) const;
    const ObjectState & getObjectState(const Sequence & seq, S32 keyframeNum, S32 objectNum) const;
    /// @}
 
+   /// @name Keyframe Compression
+   /// Implemented in tsShapeCompress.cpp
+   /// @{
+
+   /// Replace the node rotation and translation keys of a sequence with
+   /// compressed tracks.  Keys are removed while every frame stays within
+   /// @a rotTol radians and @a transTol units (or the 16 bit quantization
+   /// step of a translation track, if larger) of the original.  Returns
+   /// false and leaves the sequence alone if it would not get any smaller.
+   bool compressSequence(S32 seqIndex, F32 rotTol, F32 transTol);
+
+   /// Expand the tracks of a compressed sequence back into a key per frame.
+   void decompressSequence(S32 seqIndex);
+
+   /// Compress every sequence, returns the number of bytes saved.
+   S32 compressSequences(F32 rotTol, F32 transTol);
+   void decompressSequences();
+
+   /// Return true if any sequence is compressed.
+   bool hasCompressedSequences() const;
+
+   /// Save and restore the sequence keys around a temporary
+   /// decompressSequences().
+   /// @{
+   void saveSequenceKeys(SequenceKeys & keys) const;
+   void restoreSequenceKeys(const SequenceKeys & keys);
+   /// @}
+
+   /// Size in bytes of the rotation and translation keys of a sequence.
+   U32 getSequenceKeyBytes(const Sequence & seq) const;
+
+   QuatF & getCompressedRotation(const Sequence & seq, S32 keyframeNum, S32 rotNum, QuatF *) const;
+   Point3F getCompressedTranslation(const Sequence & seq, S32 keyframeNum, S32 tranNum) const;
+
+   /// Requantize the keys of a translation track after they have been changed.
+   void setTranslationTrackKeys(S32 trackIndex, const Point3F * keys);
+   void getTranslationTrackKey(S32 trackIndex, S32 keyNum, Point3F * key) const;
+
+   void eraseRotationTracks(S32 firstTrack, S32 numTracks);
+   void eraseTranslationTracks(S32 firstTrack, S32 numTracks);
+
+   void readCompressedKeys(Stream * s);
+   void writeCompressedKeys(Stream * s) const;
+   /// @}
+
+   /// @name Vertex Blocks
+   /// From version 28 on the interleaved vertex data of standard meshes is
+   /// written after the rest of the shape as 16 byte aligned blocks in the
+   /// runtime layout, so a mapped shape file can be used in place.
+   /// Implemented in tsShapeMapped.cpp
+   /// @{
+
+   /// Write the block table and blocks of every mesh that hasVertexBlock().
+   /// @a shapeStart is the stream position the shape starts at.
+   void writeVertexBlocks(Stream * s, U32 shapeStart) const;
+
+   /// Read the block table and give each assembled mesh its vertex data.
+   /// With a @a mappedImage (the memory @a s reads from) the meshes point
+   /// straight into it, otherwise each block is read into its own buffer.
+   bool readVertexBlocks(Stream * s, U32 shapeStart, U8 * mappedImage);
+   /// @}
+
    /// build LOS collision detail
    void computeAccelerator(S32 dl);
    bool buildConvexHull(S32 dl) const;
@@ -564,7 +696,19 @@ class TSShape
 
    bool canWriteOldFormat() const;
    void write(Stream *, bool saveOldFormat=false);
-   bool read(Stream *);
+
+   /// Write the shape to a temporary file and move it over @a path, so a
+   /// shape still mapped from the old file never sees it change.
+   bool write(const Torque::Path & path, bool saveOldFormat=false);
+
+   /// Read the shape from a stream.  When @a s reads from memory, @a image is
+   /// that memory; the shape buffers are then used where they lie instead of
+   /// being read into a temporary copy.  If @a mapped, @a image also outlives
+   /// the shape and mesh vertex blocks are used in place.
+   bool read(Stream * s, U8 * image = NULL, bool mapped = false);
+
+   /// Read the shape from a file, mapping it where the file system allows.
+   bool read(const Torque::FS::FileRef & file);
    void readOldShape(Stream * s, S32 * &, S16 * &, S8 * &, S32 &, S32 &, S32 &);
    void writeName(Stream *, S32 nameIndex);
    S32  readName(Stream *, bool addName);
@@ -659,11 +803,15 @@ class TSShape
 
 inline QuatF & TSShape::getRotation(const Sequence & seq, S32 keyframeNum, S32 rotNum, QuatF * quat) const
 {
+   if (seq.isCompressed())
+      return getCompressedRotation(seq,keyframeNum,rotNum,quat);
    return nodeRotations[seq.baseRotation + rotNum*seq.numKeyframes + keyframeNum].getQuatF(quat);
 }
 
-inline const Point3F & TSShape::getTranslation(const Sequence & seq, S32 keyframeNum, S32 tranNum) const
+inline Point3F TSShape::getTranslation(const Sequence & seq, S32 keyframeNum, S32 tranNum) const
 {
+   if (seq.isCompressed())
+      return getCompressedTranslation(seq,keyframeNum,tranNum);
    return nodeTranslations[seq.baseTranslation + tranNum*seq.numKeyframes + keyframeNum];
 }
 
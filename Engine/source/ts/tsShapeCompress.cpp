@@ -0,0 +1,709 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "ts/tsShape.h"
+
+#include "ts/tsTransform.h"
+#include "console/engineAPI.h"
+#include "core/resourceManager.h"
+#include "core/stream/stream.h"
+#include "math/mathIO.h"
+
+
+//-----------------------------------------------------------------------------
+// Helpers
+
+namespace
+{
+   /// Erase a range of a vector (which may be empty).
+   template<class T> void eraseRange(Vector<T>& vec, S32 index, S32 count)
+   {
+      if (count > 0)
+         vec.erase(index, count);
+   }
+
+   /// Insert a block of values into a vector.
+   template<class T> void insertRange(Vector<T>& vec, S32 index, const Vector<T>& values)
+   {
+      if (values.empty())
+         return;
+
+      S32 oldSize = vec.size();
+      vec.increment(values.size());
+      if (index < oldSize)
+         dMemmove(&vec[index + values.size()], &vec[index], (oldSize - index) * sizeof(T));
+      dCopyArray(&vec[index], values.address(), values.size());
+   }
+
+   /// Shift the key indices of the uncompressed sequences after @a seqIndex
+   /// once keys have been added to or removed from the per-frame arrays.
+   void shiftFrameKeys(Vector<TSShape::Sequence>& sequences, S32 seqIndex, S32 rotDelta, S32 transDelta)
+   {
+      for (S32 i = seqIndex + 1; i < sequences.size(); i++)
+      {
+         if (!sequences[i].isCompressed())
+         {
+            sequences[i].baseRotation += rotDelta;
+            sequences[i].baseTranslation += transDelta;
+         }
+      }
+   }
+
+   /// Index of the last key at or before @a frame.
+   S32 findKey(const U16* keyFrames, S32 numKeys, S32 frame)
+   {
+      S32 lo = 0, hi = numKeys - 1;
+      while (lo < hi)
+      {
+         S32 mid = (lo + hi + 1) >> 1;
+         if (keyFrames[mid] <= frame)
+            lo = mid;
+         else
+            hi = mid - 1;
+      }
+      return lo;
+   }
+
+   /// Tests rotation frames against the interpolation of the keys at two
+   /// other frames.
+   struct RotationFit
+   {
+      const Vector<QuatF>& frames;
+      F32 minDot;    ///< Cosine of half the tolerance angle
+
+      RotationFit(const Vector<QuatF>& f, F32 tol) : frames(f), minDot(mCos(tol * 0.5f)) { }
+
+      bool matches(S32 first, S32 last, S32 frame) const
+      {
+         QuatF q(frames[first]);
+         if (last != first)
+            TSTransform::interpolate(frames[first], frames[last], F32(frame - first) / F32(last - first), &q);
+         return mFabs(q.dot(frames[frame])) >= minDot;
+      }
+   };
+
+   /// Tests translation frames against the interpolation of the quantized
+   /// keys at two other frames.
+   struct TranslationFit
+   {
+      const Vector<Point3F>& frames;
+      const Vector<Point3F>& quantized;
+      F32 tolSq;
+
+      TranslationFit(const Vector<Point3F>& f, const Vector<Point3F>& q, F32 tol) : frames(f), quantized(q), tolSq(tol * tol) { }
+
+      bool matches(S32 first, S32 last, S32 frame) const
+      {
+         Point3F p(quantized[first]);
+         if (last != first)
+            TSTransform::interpolate(quantized[first], quantized[last], F32(frame - first) / F32(last - first), &p);
+         return (p - frames[frame]).lenSquared() <= tolSq;
+      }
+   };
+
+   /// Choose the frames of a track to keep as keys.  Each key is placed as
+   /// far from the previous one as possible while every frame skipped in
+   /// between stays within tolerance.  The first and last frames are always
+   /// kept, unless the whole track is within tolerance of the first frame.
+   template<class Fit> void fitKeys(const Fit& fit, S32 numFrames, Vector<U16>& keyFrames)
+   {
+      keyFrames.push_back(0);
+
+      S32 frame;
+      for (frame = 1; frame < numFrames; frame++)
+      {
+         if (!fit.matches(0, 0, frame))
+            break;
+      }
+      if (frame == numFrames)
+         return;
+
+      S32 start = 0;
+      while (start < numFrames - 1)
+      {
+         S32 end = start + 1;
+         for (S32 next = end + 1; next < numFrames; next++)
+         {
+            bool ok = true;
+            for (frame = start + 1; ok && (frame < next); frame++)
+               ok = fit.matches(start, next, frame);
+            if (!ok)
+               break;
+            end = next;
+         }
+         keyFrames.push_back(end);
+         start = end;
+      }
+   }
+
+   void quantizeTranslation(const Point3F& p, const TSShape::TranslationTrack& track, U16* key)
+   {
+      for (S32 i = 0; i < 3; i++)
+      {
+         F32 steps = (track.scale[i] > 0.0f) ? (p[i] - track.offset[i]) / track.scale[i] : 0.0f;
+         key[i] = (U16)mClampF(mFloor(steps + 0.5f), 0.0f, 65535.0f);
+      }
+   }
+
+   void setTranslationRange(const Point3F* values, S32 count, TSShape::TranslationTrack& track)
+   {
+      Box3F range(values[0], values[0]);
+      for (S32 i = 1; i < count; i++)
+         range.extend(values[i]);
+
+      track.offset = range.minExtents;
+      track.scale = (range.maxExtents - range.minExtents) / 65535.0f;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Evaluation
+
+QuatF & TSShape::getCompressedRotation(const Sequence & seq, S32 keyframeNum, S32 rotNum, QuatF * quat) const
+{
+   const KeyTrack& track = rotationTracks[seq.baseRotation + rotNum];
+   const U16* keyFrames = &rotationKeyFrames[track.firstKey];
+   const Quat16* keys = &rotationKeys[track.firstKey];
+
+   S32 k = findKey(keyFrames, track.numKeys, keyframeNum);
+   if ((k == track.numKeys - 1) || (keyFrames[k] == keyframeNum))
+      return keys[k].getQuatF(quat);
+
+   QuatF q1, q2;
+   F32 t = F32(keyframeNum - keyFrames[k]) / F32(keyFrames[k+1] - keyFrames[k]);
+   return TSTransform::interpolate(keys[k].getQuatF(&q1), keys[k+1].getQuatF(&q2), t, quat);
+}
+
+Point3F TSShape::getCompressedTranslation(const Sequence & seq, S32 keyframeNum, S32 tranNum) const
+{
+   S32 trackIndex = seq.baseTranslation + tranNum;
+   const TranslationTrack& track = translationTracks[trackIndex];
+   const U16* keyFrames = &translationKeyFrames[track.firstKey];
+
+   Point3F p1;
+   S32 k = findKey(keyFrames, track.numKeys, keyframeNum);
+   getTranslationTrackKey(trackIndex, k, &p1);
+   if ((k == track.numKeys - 1) || (keyFrames[k] == keyframeNum))
+      return p1;
+
+   Point3F p2, p;
+   getTranslationTrackKey(trackIndex, k + 1, &p2);
+   F32 t = F32(keyframeNum - keyFrames[k]) / F32(keyFrames[k+1] - keyFrames[k]);
+   return TSTransform::interpolate(p1, p2, t, &p);
+}
+
+void TSShape::getTranslationTrackKey(S32 trackIndex, S32 keyNum, Point3F * key) const
+{
+   const TranslationTrack& track = translationTracks[trackIndex];
+   const U16* q = &translationKeys[(track.firstKey + keyNum) * 3];
+   key->set(track.offset.x + q[0] * track.scale.x,
+            track.offset.y + q[1] * track.scale.y,
+            track.offset.z + q[2] * track.scale.z);
+}
+
+void TSShape::setTranslationTrackKeys(S32 trackIndex, const Point3F * keys)
+{
+   TranslationTrack& track = translationTracks[trackIndex];
+   setTranslationRange(keys, track.numKeys, track);
+   for (S32 i = 0; i < track.numKeys; i++)
+      quantizeTranslation(keys[i], track, &translationKeys[(track.firstKey + i) * 3]);
+}
+
+U32 TSShape::getSequenceKeyBytes(const Sequence & seq) const
+{
+   S32 numRots = seq.rotationMatters.count();
+   S32 numTrans = seq.translationMatters.count();
+
+   if (!seq.isCompressed())
+      return (numRots * sizeof(Quat16) + numTrans * sizeof(Point3F)) * seq.numKeyframes;
+
+   U32 bytes = numRots * sizeof(KeyTrack) + numTrans * sizeof(TranslationTrack);
+   for (S32 i = 0; i < numRots; i++)
+      bytes += rotationTracks[seq.baseRotation + i].numKeys * (sizeof(U16) + sizeof(Quat16));
+   for (S32 i = 0; i < numTrans; i++)
+      bytes += translationTracks[seq.baseTranslation + i].numKeys * (sizeof(U16) + 3 * sizeof(U16));
+   return bytes;
+}
+
+//-----------------------------------------------------------------------------
+// Compression
+
+bool TSShape::compressSequence(S32 seqIndex, F32 rotTol, F32 transTol)
+{
+   Sequence& seq = sequences[seqIndex];
+   if (seq.isCompressed() || (seq.numKeyframes < 2) || (seq.numKeyframes > 65536))
+      return false;
+
+   const S32 numFrames = seq.numKeyframes;
+   const S32 numRots = seq.rotationMatters.count();
+   const S32 numTrans = seq.translationMatters.count();
+
+   // Fit the rotation tracks
+   Vector<KeyTrack> newRotTracks;
+   Vector<U16> newRotKeyFrames;
+   Vector<Quat16> newRotKeys;
+   Vector<QuatF> rotFrames(numFrames);
+   rotFrames.setSize(numFrames);
+   for (S32 i = 0; i < numRots; i++)
+   {
+      const Quat16* keys = &nodeRotations[seq.baseRotation + i * numFrames];
+      for (S32 j = 0; j < numFrames; j++)
+         keys[j].getQuatF(&rotFrames[j]);
+
+      newRotTracks.increment();
+      KeyTrack& track = newRotTracks.last();
+      track.firstKey = rotationKeyFrames.size() + newRotKeyFrames.size();
+
+      S32 first = newRotKeyFrames.size();
+      fitKeys(RotationFit(rotFrames, rotTol), numFrames, newRotKeyFrames);
+      track.numKeys = newRotKeyFrames.size() - first;
+      for (S32 j = first; j < newRotKeyFrames.size(); j++)
+         newRotKeys.push_back(keys[newRotKeyFrames[j]]);
+   }
+
+   // Quantize and fit the translation tracks.  Quantization error is part of
+   // the fit, so the tolerance can't be tighter than the quantization step.
+   Vector<TranslationTrack> newTransTracks;
+   Vector<U16> newTransKeyFrames;
+   Vector<U16> newTransKeys;
+   Vector<Point3F> quantized(numFrames);
+   quantized.setSize(numFrames);
+   Vector<Point3F> transFrames(numFrames);
+   transFrames.setSize(numFrames);
+   for (S32 i = 0; i < numTrans; i++)
+   {
+      dCopyArray(transFrames.address(), &nodeTranslations[seq.baseTranslation + i * numFrames], numFrames);
+
+      newTransTracks.increment();
+      TranslationTrack& track = newTransTracks.last();
+      track.firstKey = translationKeyFrames.size() + newTransKeyFrames.size();
+      setTranslationRange(transFrames.address(), numFrames, track);
+
+      Vector<U16> steps(numFrames * 3);
+      steps.setSize(numFrames * 3);
+      for (S32 j = 0; j < numFrames; j++)
+      {
+         U16* q = &steps[j * 3];
+         quantizeTranslation(transFrames[j], track, q);
+         quantized[j].set(track.offset.x + q[0] * track.scale.x,
+                          track.offset.y + q[1] * track.scale.y,
+                          track.offset.z + q[2] * track.scale.z);
+      }
+
+      S32 first = newTransKeyFrames.size();
+      fitKeys(TranslationFit(transFrames, quantized, getMax(transTol, track.scale.len())), numFrames, newTransKeyFrames);
+      track.numKeys = newTransKeyFrames.size() - first;
+      for (S32 j = first; j < newTransKeyFrames.size(); j++)
+         newTransKeys.merge(&steps[newTransKeyFrames[j] * 3], 3);
+   }
+
+   // Keep the per-frame keys if the tracks are no smaller
+   U32 oldBytes = getSequenceKeyBytes(seq);
+   U32 newBytes = newRotTracks.size() * sizeof(KeyTrack) + newRotKeyFrames.size() * (sizeof(U16) + sizeof(Quat16)) +
+                  newTransTracks.size() * sizeof(TranslationTrack) + newTransKeyFrames.size() * (sizeof(U16) + 3 * sizeof(U16));
+   if (newBytes >= oldBytes)
+      return false;
+
+   // Replace the per-frame keys with the tracks
+   eraseRange(nodeRotations, seq.baseRotation, numRots * numFrames);
+   eraseRange(nodeTranslations, seq.baseTranslation, numTrans * numFrames);
+   shiftFrameKeys(sequences, seqIndex, -numRots * numFrames, -numTrans * numFrames);
+
+   seq.baseRotation = rotationTracks.size();
+   rotationTracks.merge(newRotTracks);
+   rotationKeyFrames.merge(newRotKeyFrames);
+   rotationKeys.merge(newRotKeys);
+
+   seq.baseTranslation = translationTracks.size();
+   translationTracks.merge(newTransTracks);
+   translationKeyFrames.merge(newTransKeyFrames);
+   translationKeys.merge(newTransKeys);
+
+   seq.flags |= Compressed;
+
+   return true;
+}
+
+void TSShape::decompressSequence(S32 seqIndex)
+{
+   Sequence& seq = sequences[seqIndex];
+   if (!seq.isCompressed())
+      return;
+
+   const S32 numFrames = seq.numKeyframes;
+   const S32 numRots = seq.rotationMatters.count();
+   const S32 numTrans = seq.translationMatters.count();
+
+   // Expand the tracks, keeping the stored keys as they are
+   Vector<Quat16> rots(numRots * numFrames);
+   for (S32 i = 0; i < numRots; i++)
+   {
+      const KeyTrack& track = rotationTracks[seq.baseRotation + i];
+      for (S32 j = 0; j < numFrames; j++)
+      {
+         S32 k = findKey(&rotationKeyFrames[track.firstKey], track.numKeys, j);
+         if (rotationKeyFrames[track.firstKey + k] == j)
+            rots.push_back(rotationKeys[track.firstKey + k]);
+         else
+         {
+            QuatF q;
+            rots.increment();
+            rots.last().set(getCompressedRotation(seq, j, i, &q));
+         }
+      }
+   }
+
+   Vector<Point3F> trans(numTrans * numFrames);
+   for (S32 i = 0; i < numTrans; i++)
+   {
+      for (S32 j = 0; j < numFrames; j++)
+         trans.push_back(getCompressedTranslation(seq, j, i));
+   }
+
+   eraseRotationTracks(seq.baseRotation, numRots);
+   eraseTranslationTracks(seq.baseTranslation, numTrans);
+
+   // Per-frame keys are stored in sequence order, so insert them before those
+   // of the next uncompressed sequence
+   S32 rotIndex = nodeRotations.size();
+   S32 transIndex = nodeTranslations.size();
+   for (S32 i = seqIndex + 1; i < sequences.size(); i++)
+   {
+      if (!sequences[i].isCompressed())
+      {
+         rotIndex = sequences[i].baseRotation;
+         transIndex = sequences[i].baseTranslation;
+         break;
+      }
+   }
+
+   insertRange(nodeRotations, rotIndex, rots);
+   insertRange(nodeTranslations, transIndex, trans);
+   shiftFrameKeys(sequences, seqIndex, rots.size(), trans.size());
+
+   seq.baseRotation = rotIndex;
+   seq.baseTranslation = transIndex;
+   seq.flags &= ~Compressed;
+}
+
+S32 TSShape::compressSequences(F32 rotTol, F32 transTol)
+{
+   S32 saved = 0;
+   for (S32 i = 0; i < sequences.size(); i++)
+   {
+      U32 oldBytes = getSequenceKeyBytes(sequences[i]);
+      if (compressSequence(i, rotTol, transTol))
+         saved += oldBytes - getSequenceKeyBytes(sequences[i]);
+   }
+   return saved;
+}
+
+void TSShape::decompressSequences()
+{
+   for (S32 i = 0; i < sequences.size(); i++)
+      decompressSequence(i);
+}
+
+bool TSShape::hasCompressedSequences() const
+{
+   for (S32 i = 0; i < sequences.size(); i++)
+   {
+      if (sequences[i].isCompressed())
+         return true;
+   }
+   return false;
+}
+
+void TSShape::saveSequenceKeys(SequenceKeys & keys) const
+{
+   keys.sequences = sequences;
+   keys.nodeRotations = nodeRotations;
+   keys.nodeTranslations = nodeTranslations;
+   keys.rotationTracks = rotationTracks;
+   keys.rotationKeyFrames = rotationKeyFrames;
+   keys.rotationKeys = rotationKeys;
+   keys.translationTracks = translationTracks;
+   keys.translationKeyFrames = translationKeyFrames;
+   keys.translationKeys = translationKeys;
+}
+
+void TSShape::restoreSequenceKeys(const SequenceKeys & keys)
+{
+   sequences = keys.sequences;
+   nodeRotations = keys.nodeRotations;
+   nodeTranslations = keys.nodeTranslations;
+   rotationTracks = keys.rotationTracks;
+   rotationKeyFrames = keys.rotationKeyFrames;
+   rotationKeys = keys.rotationKeys;
+   translationTracks = keys.translationTracks;
+   translationKeyFrames = keys.translationKeyFrames;
+   translationKeys = keys.translationKeys;
+}
+
+void TSShape::eraseRotationTracks(S32 firstTrack, S32 numTracks)
+{
+   if (numTracks <= 0)
+      return;
+
+   // Tracks and their keys are stored in the same order
+   const KeyTrack& last = rotationTracks[firstTrack + numTracks - 1];
+   S32 firstKey = rotationTracks[firstTrack].firstKey;
+   S32 numKeys = last.firstKey + last.numKeys - firstKey;
+
+   eraseRange(rotationKeyFrames, firstKey, numKeys);
+   eraseRange(rotationKeys, firstKey, numKeys);
+   eraseRange(rotationTracks, firstTrack, numTracks);
+
+   for (S32 i = firstTrack; i < rotationTracks.size(); i++)
+      rotationTracks[i].firstKey -= numKeys;
+   for (S32 i = 0; i < sequences.size(); i++)
+   {
+      if (sequences[i].isCompressed() && (sequences[i].baseRotation > firstTrack))
+         sequences[i].baseRotation -= numTracks;
+   }
+}
+
+void TSShape::eraseTranslationTracks(S32 firstTrack, S32 numTracks)
+{
+   if (numTracks <= 0)
+      return;
+
+   const TranslationTrack& last = translationTracks[firstTrack + numTracks - 1];
+   S32 firstKey = translationTracks[firstTrack].firstKey;
+   S32 numKeys = last.firstKey + last.numKeys - firstKey;
+
+   eraseRange(translationKeyFrames, firstKey, numKeys);
+   eraseRange(translationKeys, firstKey * 3, numKeys * 3);
+   eraseRange(translationTracks, firstTrack, numTracks);
+
+   for (S32 i = firstTrack; i < translationTracks.size(); i++)
+      translationTracks[i].firstKey -= numKeys;
+   for (S32 i = 0; i < sequences.size(); i++)
+   {
+      if (sequences[i].isCompressed() && (sequences[i].baseTranslation > firstTrack))
+         sequences[i].baseTranslation -= numTracks;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// IO
+
+void TSShape::writeCompressedKeys(Stream * s) const
+{
+   s->write(rotationTracks.size());
+   for (S32 i = 0; i < rotationTracks.size(); i++)
+   {
+      s->write(rotationTracks[i].firstKey);
+      s->write(rotationTracks[i].numKeys);
+   }
+   s->write(rotationKeyFrames.size());
+   for (S32 i = 0; i < rotationKeyFrames.size(); i++)
+   {
+      s->write(rotationKeyFrames[i]);
+      s->write(rotationKeys[i].x);
+      s->write(rotationKeys[i].y);
+      s->write(rotationKeys[i].z);
+      s->write(rotationKeys[i].w);
+   }
+
+   s->write(translationTracks.size());
+   for (S32 i = 0; i < translationTracks.size(); i++)
+   {
+      const TranslationTrack& track = translationTracks[i];
+      s->write(track.firstKey);
+      s->write(track.numKeys);
+      mathWrite(*s, track.offset);
+      mathWrite(*s, track.scale);
+   }
+   s->write(translationKeyFrames.size());
+   for (S32 i = 0; i < translationKeyFrames.size(); i++)
+   {
+      s->write(translationKeyFrames[i]);
+      s->write(translationKeys[i*3+0]);
+      s->write(translationKeys[i*3+1]);
+      s->write(translationKeys[i*3+2]);
+   }
+}
+
+void TSShape::readCompressedKeys(Stream * s)
+{
+   S32 sz;
+   s->read(&sz);
+   rotationTracks.setSize(sz);
+   for (S32 i = 0; i < sz; i++)
+   {
+      s->read(&rotationTracks[i].firstKey);
+      s->read(&rotationTracks[i].numKeys);
+   }
+   s->read(&sz);
+   rotationKeyFrames.setSize(sz);
+   rotationKeys.setSize(sz);
+   for (S32 i = 0; i < sz; i++)
+   {
+      s->read(&rotationKeyFrames[i]);
+      s->read(&rotationKeys[i].x);
+      s->read(&rotationKeys[i].y);
+      s->read(&rotationKeys[i].z);
+      s->read(&rotationKeys[i].w);
+   }
+
+   s->read(&sz);
+   translationTracks.setSize(sz);
+   for (S32 i = 0; i < sz; i++)
+   {
+      TranslationTrack& track = translationTracks[i];
+      s->read(&track.firstKey);
+      s->read(&track.numKeys);
+      mathRead(*s, &track.offset);
+      mathRead(*s, &track.scale);
+   }
+   s->read(&sz);
+   translationKeyFrames.setSize(sz);
+   translationKeys.setSize(sz * 3);
+   for (S32 i = 0; i < sz; i++)
+   {
+      s->read(&translationKeyFrames[i]);
+      s->read(&translationKeys[i*3+0]);
+      s->read(&translationKeys[i*3+1]);
+      s->read(&translationKeys[i*3+2]);
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Report
+
+/// Evaluate every node rotation and translation key of every sequence,
+/// optionally storing them.
+static F32 evaluateSequenceKeys(const TSShape* shape, Vector<QuatF>* rots, Vector<Point3F>* trans)
+{
+   F32 sum = 0.0f;
+   for (S32 i = 0; i < shape->sequences.size(); i++)
+   {
+      const TSShape::Sequence& seq = shape->sequences[i];
+      for (S32 j = 0; j < seq.rotationMatters.count(); j++)
+      {
+         for (S32 k = 0; k < seq.numKeyframes; k++)
+         {
+            QuatF q;
+            sum += shape->getRotation(seq, k, j, &q).w;
+            if (rots)
+               rots->push_back(q);
+         }
+      }
+      for (S32 j = 0; j < seq.translationMatters.count(); j++)
+      {
+         for (S32 k = 0; k < seq.numKeyframes; k++)
+         {
+            Point3F p = shape->getTranslation(seq, k, j);
+            sum += p.x;
+            if (trans)
+               trans->push_back(p);
+         }
+      }
+   }
+   return sum;
+}
+
+/// Return the time in nanoseconds to evaluate one key.
+static F64 timeSequenceKeys(const TSShape* shape, U32 numKeys, S32 iterations)
+{
+   F32 sum = 0.0f;
+   U32 start = Platform::getRealMilliseconds();
+   for (S32 i = 0; i < iterations; i++)
+      sum += evaluateSequenceKeys(shape, NULL, NULL);
+   U32 elapsed = getMax(Platform::getRealMilliseconds() - start, U32(1));
+
+   // Keep the evaluation from being optimized away
+   if (sum == F32_MAX)
+      Con::printf("%g", sum);
+
+   return F64(elapsed) * 1000000.0 / (F64(numKeys) * iterations);
+}
+
+DefineEngineFunction( reportAnimationCompression, void, ( const char *shapePath, F32 rotationTolerance, F32 translationTolerance, S32 iterations ), ( 0.1f, 0.001f, 100 ),
+   "@brief Compress the keyframes of a shape and report the bytes saved, the error and the evaluation cost.\n\n"
+   "Replaces the node rotation and translation keys of every sequence of the loaded shape with "
+   "compressed tracks, then prints the key bytes before and after, the largest error over all "
+   "frames and the time to evaluate a key before and after.  The shape stays compressed in "
+   "memory until it is reloaded; its file is not changed.\n\n"
+   "@param shapePath Path of the shape.\n"
+   "@param rotationTolerance Largest rotation error allowed, in degrees.\n"
+   "@param translationTolerance Largest translation error allowed.\n"
+   "@param iterations Number of times every key is evaluated for the timings.\n"
+   "@ingroup Rendering\n" )
+{
+   Resource<TSShape> hShape = ResourceManager::get().load( shapePath );
+   if ( !hShape )
+   {
+      Con::errorf( "reportAnimationCompression - Could not load '%s'", shapePath );
+      return;
+   }
+   TSShape *shape = const_cast<TSShape*>( (const TSShape*)hShape );
+
+   Vector<QuatF> rots;
+   Vector<Point3F> trans;
+   evaluateSequenceKeys( shape, &rots, &trans );
+
+   const U32 numKeys = rots.size() + trans.size();
+   if ( !numKeys )
+   {
+      Con::printf( "%s: no animated nodes", shapePath );
+      return;
+   }
+
+   U32 oldBytes = 0;
+   for ( S32 i = 0; i < shape->sequences.size(); i++ )
+      oldBytes += shape->getSequenceKeyBytes( shape->sequences[i] );
+
+   iterations = getMax( iterations, 1 );
+   const F64 oldTime = timeSequenceKeys( shape, numKeys, iterations );
+
+   const S32 saved = shape->compressSequences( mDegToRad( rotationTolerance ), translationTolerance );
+
+   S32 numCompressed = 0;
+   for ( S32 i = 0; i < shape->sequences.size(); i++ )
+   {
+      if ( shape->sequences[i].isCompressed() )
+         numCompressed++;
+   }
+
+   const F64 newTime = timeSequenceKeys( shape, numKeys, iterations );
+
+   // Largest difference from the original keys
+   Vector<QuatF> newRots;
+   Vector<Point3F> newTrans;
+   evaluateSequenceKeys( shape, &newRots, &newTrans );
+
+   F32 minDot = 1.0f;
+   for ( S32 i = 0; i < rots.size(); i++ )
+      minDot = getMin( minDot, mFabs( rots[i].dot( newRots[i] ) ) );
+   F32 maxDist = 0.0f;
+   for ( S32 i = 0; i < trans.size(); i++ )
+      maxDist = getMax( maxDist, ( trans[i] - newTrans[i] ).len() );
+
+   Con::printf( "%s: %d of %d sequences compressed, keys %u -> %u bytes (%.1f%% saved), "
+      "max error %.3f deg %.5f units, %.1f -> %.1f ns per key",
+      shapePath, numCompressed, shape->sequences.size(), oldBytes, oldBytes - saved,
+      100.0f * saved / oldBytes, mRadToDeg( 2.0f * mAcos( mClampF( minDot, -1.0f, 1.0f ) ) ), maxDist,
+      oldTime, newTime );
+}
@@ -265,6 +265,22 @@ void TSShapeConstructor::initPersistFields()
       "Forces update of the materials.cs file in the same folder as the COLLADA "
       "(.dae) file, even if Materials already exist. No effect for DTS files.\n"
       "Normally only Materials that are not already defined are written to materials.cs." );
+
+   addField( "compressAnimations", TypeBool, Offset(mOptions.compressAnimations, TSShapeConstructor),
+      "Store the sequences of the COLLADA model as compressed keyframe tracks. No effect for DTS files.\n"
+      "Node rotation and translation keys are removed wherever they can be interpolated "
+      "from their neighbours within animRotationTolerance and animTranslationTolerance, "
+      "and translations are quantized to 16 bits.\n"
+      "@see animRotationTolerance\n"
+      "@see animTranslationTolerance" );
+
+   addField( "animRotationTolerance", TypeF32, Offset(mOptions.animRotationTolerance, TSShapeConstructor),
+      "Largest node rotation error in degrees allowed by compressAnimations.\n"
+      "@see compressAnimations" );
+
+   addField( "animTranslationTolerance", TypeF32, Offset(mOptions.animTranslationTolerance, TSShapeConstructor),
+      "Largest node translation error allowed by compressAnimations.\n"
+      "@see compressAnimations" );
    endGroup( "Collada" );
 
    addGroup( "Sequences" );
@@ -600,17 +616,9 @@ DefineTSShapeConstructorMethod( saveShape, void, ( const char* filename ),,
    char filenameBuf[1024];
    Con::expandScriptFilename( filenameBuf, sizeof(filenameBuf), filename );
 
-   FileStream* dtsStream = new FileStream;
-   if ( dtsStream->open( filenameBuf, Torque::FS::File::Write ) )
-   {
-      mShape->write( dtsStream );
-      dtsStream->close();
-   }
-   else
-   {
-      Con::errorf( "saveShape failed: Could not open '%s' for writing", filenameBuf );
-   }
-   delete dtsStream;
+   // The shape may be mapped from the file it is saved over
+   if ( !mShape->write( Torque::Path( filenameBuf ) ) )
+      Con::errorf( "saveShape failed: Could not write '%s'", filenameBuf );
 }}
 
 DefineTSShapeConstructorMethod( writeChangeSet, void, (),,
@@ -554,10 +554,20 @@ bool TSShape::removeNode(const String& name)
       TSShape::Sequence& seq = sequences[iSeq];
 
       // Remove animated node transforms
-      if (seq.translationMatters.test(nodeIndex))
-         eraseStates(nodeTranslations, seq.translationMatters, seq.baseTranslation, seq.numKeyframes, nodeIndex);
-      if (seq.rotationMatters.test(nodeIndex))
-         eraseStates(nodeRotations, seq.rotationMatters, seq.baseRotation, seq.numKeyframes, nodeIndex);
+      if (seq.isCompressed())
+      {
+         if (seq.translationMatters.test(nodeIndex))
+            eraseTranslationTracks(seq.baseTranslation + seq.translationMatters.count(nodeIndex), 1);
+         if (seq.rotationMatters.test(nodeIndex))
+            eraseRotationTracks(seq.baseRotation + seq.rotationMatters.count(nodeIndex), 1);
+      }
+      else
+      {
+         if (seq.translationMatters.test(nodeIndex))
+            eraseStates(nodeTranslations, seq.translationMatters, seq.baseTranslation, seq.numKeyframes, nodeIndex);
+         if (seq.rotationMatters.test(nodeIndex))
+            eraseStates(nodeRotations, seq.rotationMatters, seq.baseRotation, seq.numKeyframes, nodeIndex);
+      }
       if (seq.scaleMatters.test(nodeIndex))
       {
          if (seq.flags & TSShape::ArbitraryScale)
@@ -1500,6 +1510,7 @@ bool TSShape::addSequence(const Torque::Path& path, const String& fromSeq,
    TSShape::Sequence& seq = sequences.last();
    srcSeq = &srcShape->sequences[seqIndex]; // update pointer as it may have changed!
    seq = *srcSeq;
+   seq.flags &= ~TSShape::Compressed;  // keys are copied per frame
 
    seq.nameIndex = addName(name);
    seq.numKeyframes = endFrame - startFrame + 1;
@@ -1705,9 +1716,18 @@ bool TSShape::addSequence(const Torque::Path& path, const String& fromSeq,
 
       if (seq.translationMatters.test(nodeMap[i]))
       {
-         S32 src = srcSeq->baseTranslation + srcSeq->numKeyframes * srcSeq->translationMatters.count(i) + startFrame;
          S32 dest = seq.baseTranslation + seq.numKeyframes * seq.translationMatters.count(nodeMap[i]);
-         dCopyArray(&nodeTranslations[dest], &srcShape->nodeTranslations[src], seq.numKeyframes);
+         if (srcSeq->isCompressed())
+         {
+            S32 tranNum = srcSeq->translationMatters.count(i);
+            for (S32 j = 0; j < seq.numKeyframes; j++)
+               nodeTranslations[dest + j] = srcShape->getTranslation(*srcSeq, startFrame + j, tranNum);
+         }
+         else
+         {
+            S32 src = srcSeq->baseTranslation + srcSeq->numKeyframes * srcSeq->translationMatters.count(i) + startFrame;
+            dCopyArray(&nodeTranslations[dest], &srcShape->nodeTranslations[src], seq.numKeyframes);
+         }
       }
       else if (padTransKeys && (defaultTranslations[nodeMap[i]] != srcShape->defaultTranslations[i]))
       {
@@ -1719,9 +1739,21 @@ bool TSShape::addSequence(const Torque::Path& path, const String& fromSeq,
 
       if (seq.rotationMatters.test(nodeMap[i]))
       {
-         S32 src = srcSeq->baseRotation + srcSeq->numKeyframes * srcSeq->rotationMatters.count(i) + startFrame;
          S32 dest = seq.baseRotation + seq.numKeyframes * seq.rotationMatters.count(nodeMap[i]);
-         dCopyArray(&nodeRotations[dest], &srcShape->nodeRotations[src], seq.numKeyframes);
+         if (srcSeq->isCompressed())
+         {
+            S32 rotNum = srcSeq->rotationMatters.count(i);
+            for (S32 j = 0; j < seq.numKeyframes; j++)
+            {
+               QuatF rot;
+               nodeRotations[dest + j].set(srcShape->getRotation(*srcSeq, startFrame + j, rotNum, &rot));
+            }
+         }
+         else
+         {
+            S32 src = srcSeq->baseRotation + srcSeq->numKeyframes * srcSeq->rotationMatters.count(i) + startFrame;
+            dCopyArray(&nodeRotations[dest], &srcShape->nodeRotations[src], seq.numKeyframes);
+         }
       }
       else if (padRotKeys && (defaultRotations[nodeMap[i]] != srcShape->defaultRotations[i]))
       {
@@ -1769,6 +1801,12 @@ bool TSShape::addSequence(const Torque::Path& path, const String& fromSeq,
    seq.sourceData.start = startFrame;
    seq.sourceData.end = endFrame;
 
+   // Compress the copied keys again if they came from compressed tracks.  The
+   // frames between the source keys are interpolated exactly, so a small
+   // tolerance finds the same keys again.
+   if (srcSeq->isCompressed())
+      compressSequence(sequences.size() - 1, mDegToRad(0.05f), 0.0001f);
+
    return true;
 }
 
@@ -1785,8 +1823,18 @@ bool TSShape::removeSequence(const String& name)
    TSShape::Sequence& seq = sequences[seqIndex];
 
    // Remove the node transforms for this sequence
-   S32 transCount = eraseStates(nodeTranslations, seq.translationMatters, seq.baseTranslation, seq.numKeyframes);
-   S32 rotCount = eraseStates(nodeRotations, seq.rotationMatters, seq.baseRotation, seq.numKeyframes);
+   S32 transCount = 0;
+   S32 rotCount = 0;
+   if (seq.isCompressed())
+   {
+      eraseTranslationTracks(seq.baseTranslation, seq.translationMatters.count());
+      eraseRotationTracks(seq.baseRotation, seq.rotationMatters.count());
+   }
+   else
+   {
+      transCount = eraseStates(nodeTranslations, seq.translationMatters, seq.baseTranslation, seq.numKeyframes);
+      rotCount = eraseStates(nodeRotations, seq.rotationMatters, seq.baseRotation, seq.numKeyframes);
+   }
    S32 scaleCount = 0;
    if (seq.flags & TSShape::ArbitraryScale)
    {
@@ -1813,8 +1861,11 @@ bool TSShape::removeSequence(const String& name)
    // Fixup the base indices of the other sequences
    for (S32 i = seqIndex + 1; i < sequences.size(); i++)
    {
-      sequences[i].baseTranslation -= transCount;
-      sequences[i].baseRotation -= rotCount;
+      if (!sequences[i].isCompressed())
+      {
+         sequences[i].baseTranslation -= transCount;
+         sequences[i].baseRotation -= rotCount;
+      }
       sequences[i].baseScale -= scaleCount;
       sequences[i].baseObjectState -= objCount;
       sequences[i].firstGroundFrame -= seq.numGroundFrames;
@@ -1966,19 +2017,13 @@ void TSShape::getNodeKeyframe(S32 nodeIndex, const TSShape::Sequence& seq, S32 k
    // Get the node rotation and translation
    QuatF rot;
    if (seq.rotationMatters.test(nodeIndex))
-   {
-      S32 index = seq.rotationMatters.count(nodeIndex) * seq.numKeyframes + keyframe;
-      nodeRotations[seq.baseRotation + index].getQuatF(&rot);
-   }   
+      getRotation(seq, keyframe, seq.rotationMatters.count(nodeIndex), &rot);
    else
       defaultRotations[nodeIndex].getQuatF(&rot);
 
    Point3F trans;
    if (seq.translationMatters.test(nodeIndex))
-   {
-      S32 index = seq.translationMatters.count(nodeIndex) * seq.numKeyframes + keyframe;
-      trans = nodeTranslations[seq.baseTranslation + index];
-   }
+      trans = getTranslation(seq, keyframe, seq.translationMatters.count(nodeIndex));
    else
       trans = defaultTranslations[nodeIndex];
 
@@ -2038,6 +2083,39 @@ bool TSShape::setSequenceBlend(const String& seqName, bool blend, const String&
       if (blend)
          refMat.inverse();
 
+      if (seq.isCompressed())
+      {
+         // Rotating or translating every key of a track also transforms
+         // the frames interpolated between them
+         if (seq.rotationMatters.test(nodeIndex))
+         {
+            const KeyTrack& track = rotationTracks[seq.baseRotation + seq.rotationMatters.count(nodeIndex)];
+            for (S32 key = track.firstKey; key < track.firstKey + track.numKeys; key++)
+            {
+               QuatF rot;
+               MatrixF oldMat;
+               rotationKeys[key].getQuatF(&rot).setMatrix(&oldMat);
+
+               MatrixF newMat;
+               newMat.mul(refMat, oldMat);
+               rotationKeys[key].set(QuatF(newMat));
+            }
+         }
+         if (seq.translationMatters.test(nodeIndex))
+         {
+            S32 trackIndex = seq.baseTranslation + seq.translationMatters.count(nodeIndex);
+            Vector<Point3F> keys(translationTracks[trackIndex].numKeys);
+            keys.setSize(translationTracks[trackIndex].numKeys);
+            for (S32 key = 0; key < keys.size(); key++)
+            {
+               getTranslationTrackKey(trackIndex, key, &keys[key]);
+               refMat.mulP(keys[key]);
+            }
+            setTranslationTrackKeys(trackIndex, keys.address());
+         }
+         continue;
+      }
+
       bool updateRot(false), updateTrans(false);
       S32 rotOffset(0), transOffset(0);
       if (seq.rotationMatters.test(nodeIndex))
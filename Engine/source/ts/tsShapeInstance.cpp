@@ -175,6 +175,10 @@ void TSShapeInstance::buildInstanceData(TSShape * _shape, bool loadMaterials)
    mData = 0;
    mScaleCurrentlyAnimated = false;
 
+   mAnimateUsedNodesOnly = false;
+   mNodeSubsetDetail = -1;
+   mAlwaysAnimatedNodes.clearAll();
+
    if(loadMaterials)
       setMaterialList(mShape->materialList);
 
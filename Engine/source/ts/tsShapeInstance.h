@@ -102,6 +102,7 @@ class TSShapeInstance
    friend class TSThread;
    friend class TSLastDetail;
    friend class TSPartInstance;
+   friend class TSAnimBatch;
 
    /// Base class for all renderable objects, including mesh objects and decal objects.
    ///
@@ -311,6 +312,21 @@ protected:
    TSIntegerSet mHandsOffNodes;        ///< Nodes that aren't animated through threads automatically
    TSIntegerSet mCallbackNodes;
 
+   /// @name Node Subset Animation
+   /// @{
+
+   /// Nodes that are animated even if they aren't used by the detail.
+   TSIntegerSet mAlwaysAnimatedNodes;
+
+   /// If true, animate() only evaluates the nodes of the detail level.
+   bool mAnimateUsedNodesOnly;
+
+   /// The detail level whose nodes were last animated, or -1 if all nodes
+   /// were animated.
+   S32 mNodeSubsetDetail;
+
+   /// @}
+
    // node callbacks
    Vector<TSCallbackRecord> mNodeCallbacks;
 
@@ -395,6 +411,23 @@ protected:
    U32  getNodeAnimationState(S32 nodeIndex);
    /// @}
 
+   /// @name Node Subset Animation
+   /// Distant detail levels often only use a few of the nodes, e.g. when the
+   /// fingers are no longer skinned.  When enabled, animate() leaves nodes
+   /// that the meshes of the current detail level don't depend on in their
+   /// default pose.
+   /// @see TSShape::detailNodes
+   /// @{
+
+   void setAnimateUsedNodesOnly( bool enable ) { mAnimateUsedNodesOnly = enable; }
+   bool getAnimateUsedNodesOnly() const { return mAnimateUsedNodesOnly; }
+
+   /// Keep animating @a nodeIndex and its ancestors at every detail level,
+   /// e.g. for mount points and eye nodes.
+   void addAlwaysAnimatedNode( S32 nodeIndex );
+
+   /// @}
+
    /// @name Trigger states
    /// check trigger value
    /// @{
@@ -497,7 +530,7 @@ protected:
 
    void animate() { animate( mCurrentDetailLevel ); }
    void animate(S32 dl);
-   void animateNodes(S32 ss);
+   void animateNodes(S32 ss, const TSIntegerSet *nodeSubset = NULL);
    void animateVisibility(S32 ss);
    void animateFrame(S32 ss);
    void animateMatFrame(S32 ss);
@@ -702,6 +735,7 @@ protected:
 class TSThread
 {
    friend class TSShapeInstance;
+   friend class TSAnimBatch;
 
    S32 priority;
 
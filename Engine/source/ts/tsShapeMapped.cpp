@@ -0,0 +1,362 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "ts/tsShape.h"
+
+#include "console/engineAPI.h"
+#include "core/stream/fileStream.h"
+#include "core/stream/memStream.h"
+#include "core/util/endian.h"
+
+#if defined( TORQUE_OS_LINUX ) || defined( TORQUE_OS_MAC )
+#include <sys/resource.h>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// Helpers
+
+namespace
+{
+   enum VertexBlockFlags
+   {
+      BlockHasColor  = BIT(0),
+      BlockHasTVert2 = BIT(1),
+   };
+
+   /// An entry of the vertex block table.  Offsets are relative to the start
+   /// of the shape.
+   struct VertexBlock
+   {
+      S32 meshIndex;
+      U32 numVerts;
+      U32 vertSize;
+      U32 flags;
+      U32 offset;
+   };
+
+   /// Size of a table entry in the file.
+   const U32 VertexBlockEntrySize = 5 * sizeof(U32);
+
+   inline bool isLittleEndian()
+   {
+      return 0x12345678 == convertLEndianToHost(0x12345678);
+   }
+
+   /// Vertex blocks are little endian like the rest of the file.  Every
+   /// element of a vertex is 32 bits wide, including the packed color.
+   void writeBlockData(Stream * s, const void * data, U32 size)
+   {
+      if (isLittleEndian())
+         s->write(size, data);
+      else
+      {
+         const U32 * words = (const U32*)data;
+         for (U32 i = 0; i < size / 4; i++)
+            s->write(words[i]);
+      }
+   }
+
+   void fixBlockEndian(void * data, U32 size)
+   {
+      if (!isLittleEndian())
+      {
+         U32 * words = (U32*)data;
+         for (U32 i = 0; i < size / 4; i++)
+            words[i] = convertLEndianToHost(words[i]);
+      }
+   }
+
+   /// Zero bytes up to the next 16 byte boundary from @a start.
+   void padTo16(Stream * s, U32 start)
+   {
+      while ((s->getPosition() - start) & 15)
+         s->write(U8(0));
+   }
+}
+
+//-----------------------------------------------------------------------------
+// IO
+
+void TSShape::writeVertexBlocks(Stream * s, U32 shapeStart) const
+{
+   Vector<VertexBlock> blocks;
+   for (S32 i = 0; i < meshes.size(); i++)
+   {
+      const TSMesh * mesh = meshes[i];
+      if (!mesh || !mesh->hasVertexBlock())
+         continue;
+
+      blocks.increment();
+      VertexBlock & block = blocks.last();
+      block.meshIndex = i;
+      block.numVerts = mesh->mVertexData.size();
+      block.vertSize = mesh->mVertexData.vertSize();
+      block.flags = (mesh->mHasColor ? BlockHasColor : 0) | (mesh->mHasTVert2 ? BlockHasTVert2 : 0);
+   }
+
+   // blocks start on the first 16 byte boundary after the table
+   U32 offset = s->getPosition() - shapeStart + sizeof(U32) + blocks.size() * VertexBlockEntrySize;
+   for (S32 i = 0; i < blocks.size(); i++)
+   {
+      offset = (offset + 15) & ~15;
+      blocks[i].offset = offset;
+      offset += blocks[i].numVerts * blocks[i].vertSize;
+   }
+
+   s->write(U32(blocks.size()));
+   for (S32 i = 0; i < blocks.size(); i++)
+   {
+      s->write(blocks[i].meshIndex);
+      s->write(blocks[i].numVerts);
+      s->write(blocks[i].vertSize);
+      s->write(blocks[i].flags);
+      s->write(blocks[i].offset);
+   }
+
+   for (S32 i = 0; i < blocks.size(); i++)
+   {
+      padTo16(s, shapeStart);
+      AssertFatal(s->getPosition() - shapeStart == blocks[i].offset, "TSShape::writeVertexBlocks - block offset mismatch");
+
+      const TSMesh * mesh = meshes[blocks[i].meshIndex];
+      writeBlockData(s, mesh->mVertexData.address(), mesh->mVertexData.mem_size());
+   }
+}
+
+bool TSShape::readVertexBlocks(Stream * s, U32 shapeStart, U8 * mappedImage)
+{
+   U32 numBlocks;
+   s->read(&numBlocks);
+   if (s->getStatus() != Stream::Ok || numBlocks > meshes.size())
+      return false;
+
+   Vector<VertexBlock> blocks;
+   blocks.setSize(numBlocks);
+   for (S32 i = 0; i < blocks.size(); i++)
+   {
+      s->read(&blocks[i].meshIndex);
+      s->read(&blocks[i].numVerts);
+      s->read(&blocks[i].vertSize);
+      s->read(&blocks[i].flags);
+      s->read(&blocks[i].offset);
+   }
+   if (s->getStatus() != Stream::Ok)
+      return false;
+
+   // Only the pointers are fixed up here; the pages of a mapped block are not
+   // touched until the mesh is first used.
+   const U32 imageSize = s->getStreamSize() - shapeStart;
+   for (S32 i = 0; i < blocks.size(); i++)
+   {
+      const VertexBlock & block = blocks[i];
+      if (block.meshIndex < 0 || block.meshIndex >= meshes.size() ||
+          (block.vertSize != sizeof(TSMesh::__TSMeshVertexBase) &&
+           block.vertSize != sizeof(TSMesh::__TSMeshVertex_3xUVColor)) ||
+          (block.offset & 15) || block.offset > imageSize ||
+          block.numVerts > (imageSize - block.offset) / block.vertSize)
+         return false;
+
+      // skipped detail level
+      TSMesh * mesh = meshes[block.meshIndex];
+      if (!mesh)
+         continue;
+      if (mesh->getMeshType() != TSMesh::StandardMeshType)
+         return false;
+
+      const U32 size = block.numVerts * block.vertSize;
+      if (mappedImage)
+      {
+         U8 * data = mappedImage + shapeStart + block.offset;
+         fixBlockEndian(data, size);
+         mesh->mVertexData.setExternal(data, block.vertSize, block.numVerts);
+      }
+      else
+      {
+         void * data = dMalloc_aligned(size, 16);
+         s->setPosition(shapeStart + block.offset);
+         s->read(size, data);
+         fixBlockEndian(data, size);
+         mesh->mVertexData.set(data, block.vertSize, block.numVerts);
+      }
+
+      mesh->mVertexData.setReady(true);
+      mesh->mNumVerts = block.numVerts;
+      mesh->mHasColor = (block.flags & BlockHasColor) != 0;
+      mesh->mHasTVert2 = (block.flags & BlockHasTVert2) != 0;
+   }
+
+   return s->getStatus() == Stream::Ok;
+}
+
+bool TSShape::read(const Torque::FS::FileRef & file)
+{
+   PROFILE_SCOPE(TSShape_ReadFile);
+
+   const U32 size = file->getSize();
+   if (!size)
+      return false;
+
+   U8 * image = (U8*)file->map();
+   const bool mapped = (image != NULL);
+   if (mapped)
+   {
+      // The mapping outlives the handle, so don't hold a file descriptor
+      // open for every resident shape.
+      file->close();
+   }
+   else
+   {
+      // File systems that can't map files (Win32, zips, memory files) read
+      // the whole file into one block that is freed once the shape is read.
+      image = (U8*)dMalloc_aligned(size, 16);
+
+      file->setPosition(0, Torque::FS::File::Begin);
+      if (file->read(image, size) != size)
+      {
+         dFree_aligned(image);
+         return false;
+      }
+   }
+
+   MemStream stream(size, image, true, false);
+   const bool success = read(&stream, image, mapped);
+
+   if (mapped)
+   {
+      // Keep the file mapped for as long as a mesh uses a block in it
+      bool inUse = false;
+      for (S32 i = 0; i < meshes.size() && !inUse; i++)
+         inUse = meshes[i] && meshes[i]->mVertexData.isExternal();
+
+      if (success && inUse)
+         mMappedFile = file;
+      else
+         file->unmap();
+   }
+   else
+      dFree_aligned(image);
+
+   return success;
+}
+
+//-----------------------------------------------------------------------------
+// Benchmark
+
+/// Peak resident set size of the process in KB, 0 where it isn't known.
+static U32 getPeakResidentKB()
+{
+#if defined( TORQUE_OS_LINUX )
+   struct rusage usage;
+   return getrusage( RUSAGE_SELF, &usage ) == 0 ? U32( usage.ru_maxrss ) : 0;
+#elif defined( TORQUE_OS_MAC )
+   struct rusage usage;
+   return getrusage( RUSAGE_SELF, &usage ) == 0 ? U32( usage.ru_maxrss / 1024 ) : 0;
+#else
+   return 0;
+#endif
+}
+
+DefineEngineFunction( benchmarkShapeLoading, void, ( const char* path, bool mapped, S32 iterations ), ( true, 1 ),
+   "@brief Load every DTS file under a directory and report the wall time and peak memory use.\n\n"
+   "Each iteration reads every shape in the directory and its subdirectories, keeps them all "
+   "loaded, and then frees them again.  Shape scripts are not run and the resource cache is "
+   "bypassed.  The peak resident set size only grows within a process, so compare mapped and "
+   "streamed loading in separate runs.\n\n"
+   "@param path Directory to search for .dts files.\n"
+   "@param mapped Read the shapes from memory mapped files, or through a FileStream.\n"
+   "@param iterations Number of times to load the directory.\n"
+   "@ingroup Rendering\n" )
+{
+   char pathBuf[1024];
+   Con::expandScriptFilename( pathBuf, sizeof( pathBuf ), path );
+
+   Torque::Path dirPath( pathBuf );
+   if ( dirPath.isRelative() )
+      dirPath = Torque::Path::Join( Torque::FS::GetCwd(), '/', dirPath );
+
+   Vector<String> files;
+   if ( Torque::FS::FindByPattern( dirPath, "*.dts", true, files ) <= 0 )
+   {
+      Con::errorf( "benchmarkShapeLoading - No shapes found in '%s'", pathBuf );
+      return;
+   }
+
+   U64 totalBytes = 0;
+   for ( S32 i = 0; i < files.size(); i++ )
+   {
+      Torque::FS::FileNode::Attributes attr;
+      if ( Torque::FS::GetFileAttributes( files[i], &attr ) )
+         totalBytes += attr.size;
+   }
+
+   const U32 startKB = getPeakResidentKB();
+
+   Vector<TSShape*> shapes;
+   for ( S32 iter = 0; iter < getMax( iterations, 1 ); iter++ )
+   {
+      S32 numFailed = 0;
+      const U32 start = Platform::getRealMilliseconds();
+
+      for ( S32 i = 0; i < files.size(); i++ )
+      {
+         TSShape *shape = new TSShape;
+         bool success = false;
+         if ( mapped )
+         {
+            Torque::FS::FileRef file = Torque::FS::OpenFile( files[i], Torque::FS::File::Read );
+            success = file && shape->read( file );
+         }
+         else
+         {
+            FileStream stream;
+            success = stream.open( files[i], Torque::FS::File::Read ) && shape->read( &stream );
+         }
+
+         if ( success )
+            shapes.push_back( shape );
+         else
+         {
+            Con::errorf( "benchmarkShapeLoading - Error reading '%s'", files[i].c_str() );
+            delete shape;
+            numFailed++;
+         }
+      }
+
+      const U32 elapsed = Platform::getRealMilliseconds() - start;
+
+      for ( S32 i = 0; i < shapes.size(); i++ )
+         delete shapes[i];
+      shapes.clear();
+
+      Con::printf( "benchmarkShapeLoading: %s, %d shapes (%d failed, %.1f MB) in %u ms, %.2f ms per shape",
+         mapped ? "mapped" : "streamed", files.size(), numFailed, totalBytes / ( 1024.0f * 1024.0f ),
+         elapsed, F32( elapsed ) / files.size() );
+   }
+
+   const U32 peakKB = getPeakResidentKB();
+   if ( peakKB )
+      Con::printf( "benchmarkShapeLoading: peak resident set %u KB (%u KB before loading)", peakKB, startKB );
+   else
+      Con::printf( "benchmarkShapeLoading: peak resident set not available on this platform" );
+}
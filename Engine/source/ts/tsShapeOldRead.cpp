@@ -190,6 +190,16 @@ void TSShape::fixupOldSkins(S32 numMeshes, S32 numSkins, S32 numDetails, S32 * d
 //-------------------------------------------------
 void TSShape::exportSequences(Stream * s)
 {
+   // DSQs store a key per frame, so expand compressed sequences while
+   // writing and put their tracks back afterwards.
+   SequenceKeys compressedKeys;
+   const bool restoreKeys = hasCompressedSequences();
+   if (restoreKeys)
+   {
+      saveSequenceKeys(compressedKeys);
+      decompressSequences();
+   }
+
    // write version
    s->write(smVersion);
 
@@ -288,6 +298,9 @@ void TSShape::exportSequences(Stream * s)
       s->write(triggers[i].state);
       s->write(triggers[i].pos);
    }
+
+   if (restoreKeys)
+      restoreSequenceKeys(compressedKeys);
 }
 
 //-------------------------------------------------
@@ -318,21 +331,57 @@ void TSShape::exportSequence(Stream * s, const TSShape::Sequence& seq, bool save
    // write node states -- skip default node states
    S32 count = seq.rotationMatters.count() * seq.numKeyframes;
    s->write( count );
-   for ( S32 i = seq.baseRotation; i < seq.baseRotation + count; i++ )
+   if ( seq.isCompressed() )
+   {
+      // DSQs store a key per frame
+      for ( S32 i = 0; i < seq.rotationMatters.count(); i++ )
+      {
+         for ( S32 j = 0; j < seq.numKeyframes; j++ )
+         {
+            QuatF q;
+            Quat16 rot;
+            rot.set( getRotation( seq, j, i, &q ) );
+            s->write( rot.x );
+            s->write( rot.y );
+            s->write( rot.z );
+            s->write( rot.w );
+         }
+      }
+   }
+   else
    {
-      s->write( nodeRotations[i].x );
-      s->write( nodeRotations[i].y );
-      s->write( nodeRotations[i].z );
-      s->write( nodeRotations[i].w );
+      for ( S32 i = seq.baseRotation; i < seq.baseRotation + count; i++ )
+      {
+         s->write( nodeRotations[i].x );
+         s->write( nodeRotations[i].y );
+         s->write( nodeRotations[i].z );
+         s->write( nodeRotations[i].w );
+      }
    }
 
    count = seq.translationMatters.count() * seq.numKeyframes;
    s->write( count );
-   for ( S32 i = seq.baseTranslation; i < seq.baseTranslation + count; i++ )
+   if ( seq.isCompressed() )
    {
-      s->write( nodeTranslations[i].x );
-      s->write( nodeTranslations[i].y );
-      s->write( nodeTranslations[i].z );
+      for ( S32 i = 0; i < seq.translationMatters.count(); i++ )
+      {
+         for ( S32 j = 0; j < seq.numKeyframes; j++ )
+         {
+            Point3F trans = getTranslation( seq, j, i );
+            s->write( trans.x );
+            s->write( trans.y );
+            s->write( trans.z );
+         }
+      }
+   }
+   else
+   {
+      for ( S32 i = seq.baseTranslation; i < seq.baseTranslation + count; i++ )
+      {
+         s->write( nodeTranslations[i].x );
+         s->write( nodeTranslations[i].y );
+         s->write( nodeTranslations[i].z );
+      }
    }
 
    count = seq.scaleMatters.count() * seq.numKeyframes;
@@ -601,6 +650,7 @@ bool TSShape::importSequences(Stream * s, const String& sequencePath)
 
       // read the rest of the sequence
       seq.read(s,false);
+      seq.flags &= ~Compressed;   // DSQs store a key per frame
       seq.baseRotation = nodeRotations.size();
       seq.baseTranslation = nodeTranslations.size();
 
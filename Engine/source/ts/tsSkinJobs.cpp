@@ -0,0 +1,386 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "ts/tsSkinJobs.h"
+
+#include "ts/tsShapeInstance.h"
+#include "scene/sceneRenderState.h"
+#include "gfx/gfxDevice.h"
+#include "console/consoleTypes.h"
+#include "console/engineAPI.h"
+#include "core/module.h"
+#include "core/resourceManager.h"
+#include "platform/profiler.h"
+#include "platform/threads/jobSystem.h"
+#include "platform/platformIntrinsics.h"
+
+
+bool TSSkinJobQueue::smEnabled = true;
+S32 TSSkinJobQueue::smMaxThreads = 0;
+Vector<TSSkinJobQueue::Job> TSSkinJobQueue::smJobs;
+Vector<MatrixF> TSSkinJobQueue::smBones;
+U8 *TSSkinJobQueue::smOutBuffer = NULL;
+U32 TSSkinJobQueue::smOutBufferSize = 0;
+U32 TSSkinJobQueue::smOutSize = 0;
+U32 TSSkinJobQueue::smCollectDepth = 0;
+U32 TSSkinJobQueue::smLastNumSkinnedVerts = 0;
+U32 TSSkinJobQueue::smLastNumThreads = 0;
+
+
+MODULE_BEGIN( TSSkinJobQueue )
+
+   MODULE_INIT
+   {
+      Con::addVariable( "$pref::TS::parallelSkinning", TypeBool, &TSSkinJobQueue::smEnabled,
+         "@brief If true, skinned meshes visible in a scene pass are skinned on worker threads.\n"
+         "If false, every mesh is skinned on the render thread when it is rendered.\n"
+         "@ingroup Rendering\n" );
+
+      Con::addVariable( "$pref::TS::skinThreads", TypeS32, &TSSkinJobQueue::smMaxThreads,
+         "@brief Most threads, including the render thread, used for parallel skinning.\n"
+         "The default value of 0 uses all worker threads.\n"
+         "@see $pref::TS::parallelSkinning\n"
+         "@ingroup Rendering\n" );
+
+      TSSkinJobQueue::init();
+   }
+
+   MODULE_SHUTDOWN
+   {
+      TSSkinJobQueue::shutdown();
+   }
+
+MODULE_END;
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+/// Shared state of a TSSkinJobQueue::flush() call.
+struct SkinJobBatch
+{
+   struct Job
+   {
+      TSSkinMesh *mesh;
+      const MatrixF *bones;
+      U8 *out;
+   };
+
+   Vector< Job > jobs;
+
+   U32 numJobs;
+   volatile U32 nextJob;
+
+   SkinJobBatch()
+      : numJobs( 0 ), nextJob( 0 ) {}
+
+   /// Claim and skin the next job.
+   /// @return False if there are no more jobs left.
+   bool processNextJob()
+   {
+      U32 index;
+      do
+      {
+         index = dAtomicRead( nextJob );
+         if ( index >= numJobs )
+            return false;
+      }
+      while ( !dCompareAndSwap( nextJob, index, index + 1 ) );
+
+      const Job &job = jobs[ index ];
+      const TSMesh::TSMeshVertexArray &src = job.mesh->mVertexData;
+
+      // Start from the shared vertex data for the components that aren't
+      // skinned and then skin positions and normals over it.
+      dMemcpy( job.out, src.address(), src.mem_size() );
+      job.mesh->skin( job.bones, job.out, src.vertSize() );
+      return true;
+   }
+};
+
+/// JobSystem job that keeps processing jobs of a SkinJobBatch.
+void processSkinJobs( void *data )
+{
+   SkinJobBatch *batch = reinterpret_cast<SkinJobBatch*>( data );
+   while ( batch->processNextJob() );
+}
+
+/// A skinned mesh of an instance measured by benchmarkSkinning().
+struct SkinBenchmarkTarget
+{
+   TSShapeInstance *inst;
+   TSSkinMesh *mesh;
+   TSVertexBufferHandle vb;
+};
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+
+void TSSkinJobQueue::init()
+{
+   SceneRenderState::getPrepRenderImagesSignal().notify( &TSSkinJobQueue::_onPrepRenderImages );
+}
+
+void TSSkinJobQueue::shutdown()
+{
+   SceneRenderState::getPrepRenderImagesSignal().remove( &TSSkinJobQueue::_onPrepRenderImages );
+
+   smJobs.clear();
+   smBones.clear();
+   smOutSize = 0;
+
+   if ( smOutBuffer )
+      dFree_aligned( smOutBuffer );
+   smOutBuffer = NULL;
+   smOutBufferSize = 0;
+}
+
+void TSSkinJobQueue::_onPrepRenderImages( SceneRenderState *state, bool begin )
+{
+   if ( begin )
+      TSSkinJobQueue::begin();
+   else
+      flush();
+}
+
+void TSSkinJobQueue::begin()
+{
+   smCollectDepth++;
+}
+
+void TSSkinJobQueue::queue( TSSkinMesh *mesh, const Vector<MatrixF> &transforms, TSVertexBufferHandle &vb )
+{
+   AssertFatal( isCollecting(), "TSSkinJobQueue::queue - Not collecting skin jobs" );
+
+   if ( !mesh->mVertexData.isReady() )
+      mesh->_convertToAlignedMeshData( mesh->mVertexData, mesh->batchData.initialVerts, mesh->batchData.initialNorms );
+   if ( !mesh->batchDataInitialized )
+      mesh->createBatchData();
+
+   if ( GFXDevice::devicePresent() && ( vb.isNull() || vb->mNumVerts < mesh->mNumVerts ) )
+      vb.set( GFX, mesh->mVertSize, mesh->mVertexFormat, mesh->mNumVerts, GFXBufferTypeDynamic );
+
+   Job job;
+   job.mesh = mesh;
+   job.firstBone = smBones.size();
+   job.outOffset = smOutSize;
+   job.vb = vb;
+   smJobs.push_back( job );
+
+   smBones.setSize( job.firstBone + mesh->batchData.nodeIndex.size() );
+   mesh->computeBoneTransforms( transforms, smBones.address() + job.firstBone );
+
+   // Keep every slice 16 byte aligned for the SIMD skinning loops.
+   smOutSize += ( mesh->mVertexData.mem_size() + 15 ) & ~15;
+}
+
+void TSSkinJobQueue::flush()
+{
+   if ( smCollectDepth > 0 )
+      smCollectDepth--;
+
+   smLastNumSkinnedVerts = 0;
+   smLastNumThreads = 0;
+
+   if ( smJobs.empty() )
+      return;
+
+   PROFILE_SCOPE( TSSkinJobQueue_flush );
+
+   if ( smOutSize > smOutBufferSize )
+   {
+      if ( smOutBuffer )
+         dFree_aligned( smOutBuffer );
+
+      smOutBufferSize = getMax( smOutSize, smOutBufferSize * 2 );
+      smOutBuffer = reinterpret_cast<U8*>( dMalloc_aligned( smOutBufferSize, 16 ) );
+   }
+
+   SkinJobBatch batch;
+   batch.jobs.setSize( smJobs.size() );
+   for ( U32 i = 0; i < smJobs.size(); i++ )
+   {
+      SkinJobBatch::Job &job = batch.jobs[i];
+      job.mesh = smJobs[i].mesh;
+      job.bones = smBones.address() + smJobs[i].firstBone;
+      job.out = smOutBuffer + smJobs[i].outOffset;
+   }
+   batch.numJobs = smJobs.size();
+
+   JobSystem &jobs = JobSystem::GLOBAL();
+   U32 numItems = getMin( jobs.getNumThreads(), batch.numJobs - 1 );
+   if ( smMaxThreads > 0 )
+      numItems = getMin( numItems, U32( smMaxThreads - 1 ) );
+
+   JobSystem::Counter counter;
+   for ( U32 i = 0; i < numItems; i++ )
+      jobs.run( &processSkinJobs, &batch, &counter );
+
+   // Help out with the jobs and then wait for the rest to finish.
+   while ( batch.processNextJob() );
+   jobs.wait( counter );
+
+   // Copy the last pose skinned for every mesh back into its shared vertex
+   // data so CPU-side readers such as ray casts, poly lists and cloth see
+   // the same result as with serial skinning.
+   PROFILE_START( TSSkinJobQueue_writeBack );
+   for ( U32 i = 0; i < smJobs.size(); i++ )
+      smJobs[i].mesh->mHasSkinned = false;
+   for ( S32 i = smJobs.size() - 1; i >= 0; i-- )
+   {
+      Job &job = smJobs[i];
+      if ( job.mesh->mHasSkinned )
+         continue;
+
+      dMemcpy( job.mesh->mVertexData.address(), smOutBuffer + job.outOffset, job.mesh->mVertexData.mem_size() );
+      job.mesh->mHasSkinned = true;
+   }
+   PROFILE_END();
+
+   // Copy the results into the vertex buffers.
+   PROFILE_START( TSSkinJobQueue_upload );
+   for ( U32 i = 0; i < smJobs.size(); i++ )
+   {
+      Job &job = smJobs[i];
+      smLastNumSkinnedVerts += job.mesh->mNumVerts;
+
+      if ( job.vb.isNull() )
+         continue;
+
+      U8 *dst = job.vb.lock();
+      if ( dst )
+      {
+         dMemcpy( dst, smOutBuffer + job.outOffset, job.mesh->mVertexData.mem_size() );
+         job.vb.unlock();
+      }
+   }
+   PROFILE_END();
+
+   smLastNumThreads = numItems + 1;
+
+   smJobs.clear();
+   smBones.clear();
+   smOutSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+DefineEngineFunction( benchmarkSkinning, void, ( const char *shapePath, S32 numInstances, S32 iterations, S32 maxThreads ), ( 64, 50, 0 ),
+   "@brief Measure parallel skinning throughput for a shape at each thread count.\n\n"
+   "Creates @a numInstances animated instances of the shape and skins all their skinned "
+   "meshes at the highest detail @a iterations times for every thread count from one up to "
+   "@a maxThreads, printing the skinned vertices per second.  Works headless with the Null "
+   "GFX device.\n\n"
+   "@param shapePath Path of the shape to skin.\n"
+   "@param numInstances Number of shape instances.\n"
+   "@param iterations Number of times every instance is skinned per thread count.\n"
+   "@param maxThreads Highest thread count to measure or 0 to use all worker threads "
+   "of the job system plus the calling thread.\n"
+   "@ingroup Rendering\n" )
+{
+   Resource<TSShape> shape = ResourceManager::get().load( shapePath );
+   if ( !shape )
+   {
+      Con::errorf( "benchmarkSkinning - Could not load '%s'", shapePath );
+      return;
+   }
+
+   if ( shape->details.empty() || numInstances <= 0 || iterations <= 0 )
+      return;
+
+   const S32 od = shape->details[0].objectDetailNum;
+
+   Vector<TSShapeInstance*> instances;
+   Vector<SkinBenchmarkTarget> targets;
+   U32 vertsPerPass = 0;
+
+   for ( S32 i = 0; i < numInstances; i++ )
+   {
+      TSShapeInstance *inst = new TSShapeInstance( shape, false );
+      instances.push_back( inst );
+
+      // Spread the instances over the first sequence so they don't all
+      // share the same pose.
+      if ( shape->sequences.size() )
+      {
+         TSThread *thread = inst->addThread();
+         inst->setSequence( thread, 0, F32( i ) / F32( numInstances ) );
+      }
+      inst->animate( 0 );
+
+      for ( U32 j = 0; j < inst->mMeshObjects.size(); j++ )
+      {
+         TSMesh *mesh = inst->mMeshObjects[j].getMesh( od );
+         if ( !mesh || mesh->getMeshType() != TSMesh::SkinMeshType )
+            continue;
+
+         SkinBenchmarkTarget target;
+         target.inst = inst;
+         target.mesh = static_cast<TSSkinMesh*>( mesh );
+         targets.push_back( target );
+         vertsPerPass += mesh->mNumVerts;
+      }
+   }
+
+   if ( targets.empty() )
+      Con::warnf( "benchmarkSkinning - '%s' has no skinned meshes", shapePath );
+   else
+   {
+      const bool oldEnabled = TSSkinJobQueue::smEnabled;
+      const S32 oldMaxThreads = TSSkinJobQueue::smMaxThreads;
+      TSSkinJobQueue::smEnabled = true;
+
+      const S32 poolThreads = JobSystem::GLOBAL().getNumThreads() + 1;
+      if ( maxThreads <= 0 )
+         maxThreads = poolThreads;
+
+      Con::printf( "benchmarkSkinning: %d instances, %d skinned meshes, %d verts per pass",
+         numInstances, targets.size(), vertsPerPass );
+
+      for ( S32 threads = 1; threads <= maxThreads; threads++ )
+      {
+         TSSkinJobQueue::smMaxThreads = threads;
+
+         const U32 start = Platform::getRealMilliseconds();
+         for ( S32 i = 0; i < iterations; i++ )
+         {
+            TSSkinJobQueue::begin();
+            for ( U32 j = 0; j < targets.size(); j++ )
+               TSSkinJobQueue::queue( targets[j].mesh, targets[j].inst->mNodeTransforms, targets[j].vb );
+            TSSkinJobQueue::flush();
+         }
+         const U32 elapsed = getMax( Platform::getRealMilliseconds() - start, U32( 1 ) );
+
+         const F64 vertsPerSec = F64( vertsPerPass ) * iterations * 1000.0 / F64( elapsed );
+         Con::printf( "   %d thread(s): %dms, %.2f Mverts/s", TSSkinJobQueue::getLastNumThreads(), elapsed, vertsPerSec / 1000000.0 );
+      }
+
+      TSSkinJobQueue::smEnabled = oldEnabled;
+      TSSkinJobQueue::smMaxThreads = oldMaxThreads;
+   }
+
+   targets.clear();
+   for ( U32 i = 0; i < instances.size(); i++ )
+      delete instances[i];
+}
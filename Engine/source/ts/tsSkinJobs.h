@@ -0,0 +1,121 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2012 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _TSSKINJOBS_H_
+#define _TSSKINJOBS_H_
+
+#ifndef _TSMESH_H_
+#include "ts/tsMesh.h"
+#endif
+
+class SceneRenderState;
+
+
+/// Skins meshes on the worker threads of the global JobSystem.
+///
+/// While objects batch their render instances in
+/// SceneRenderState::renderObjects(), TSSkinMesh::render() does not skin on
+/// the spot.  It queues a job with the bone transforms of the instance and
+/// the instance's vertex buffer instead.  Once all objects are batched,
+/// flush() skins every queued job into its own slice of a shared scratch
+/// buffer, spread over the worker threads, and then copies the slices into
+/// the vertex buffers on the calling thread.
+///
+/// Jobs never touch the vertex data shared by all instances of a mesh, so
+/// several instances of the same mesh can be skinned at the same time.
+/// Once they are done, the last pose skinned for each mesh is copied back
+/// into its vertex data, which is what ray casts, poly lists and cloth read
+/// after serial skinning too.
+class TSSkinJobQueue
+{
+public:
+
+   /// If false, meshes are skinned immediately on the render thread.
+   static bool smEnabled;
+
+   /// Most threads, including the calling one, that flush() may use.  Zero
+   /// means every worker thread of the job system plus the calling thread.
+   static S32 smMaxThreads;
+
+   /// Return true if skinning is currently being deferred.
+   static bool isCollecting() { return smEnabled && smCollectDepth > 0; }
+
+   /// Start deferring skinning.  Calls nest.
+   static void begin();
+
+   /// Queue skinning @a mesh with the node @a transforms into @a vb.  The
+   /// vertex buffer is created if needed.  The transforms are copied, the
+   /// buffer handle must stay valid until the next flush().
+   static void queue( TSSkinMesh *mesh, const Vector<MatrixF> &transforms, TSVertexBufferHandle &vb );
+
+   /// Skin all queued jobs and stop deferring if this ends the outermost
+   /// begin().
+   static void flush();
+
+   /// Return the number of jobs waiting for flush().
+   static U32 getNumQueued() { return smJobs.size(); }
+
+   /// Return the number of vertices skinned by the last flush().
+   static U32 getLastNumSkinnedVerts() { return smLastNumSkinnedVerts; }
+
+   /// Return the number of threads used by the last flush().
+   static U32 getLastNumThreads() { return smLastNumThreads; }
+
+   /// Hook into scene batching.  Called on module init.
+   static void init();
+
+   /// Release the scratch buffer.  Called on module shutdown.
+   static void shutdown();
+
+protected:
+
+   struct Job
+   {
+      TSSkinMesh *mesh;
+
+      /// Index of the first bone transform in #smBones.
+      U32 firstBone;
+
+      /// Byte offset of the vertex data in the scratch buffer.
+      U32 outOffset;
+
+      TSVertexBufferHandle vb;
+   };
+
+   static Vector<Job> smJobs;
+   static Vector<MatrixF> smBones;
+
+   /// Aligned scratch buffer the jobs skin into.
+   static U8 *smOutBuffer;
+   static U32 smOutBufferSize;
+
+   /// Bytes of #smOutBuffer used by the queued jobs.
+   static U32 smOutSize;
+
+   static U32 smCollectDepth;
+   static U32 smLastNumSkinnedVerts;
+   static U32 smLastNumThreads;
+
+   static void _onPrepRenderImages( SceneRenderState *state, bool begin );
+};
+
+#endif // _TSSKINJOBS_H_
@@ -0,0 +1,40 @@
+// Headless animation compression report, see headless.cs.
+//
+// Usage: <executable> animCompressionReport.cs [-shape path] [-rotTol degrees] [-transTol units] [-iterations N]
+//
+// Compresses the keyframes of each shape in memory and prints the key bytes
+// saved, the largest error and the time to evaluate a key before and after.
+// -shape may be given more than once.  Without it, reports on the animated
+// shapes shipped with the template.
+
+exec( "./headless.cs" );
+
+$AnimCompressionReport::shapes = getCommandLineArgs( "-shape",
+   "art/shapes/actors/Soldier/soldier_rigged.DAE" TAB
+   "art/shapes/actors/Soldier/FP/FP_SoldierArms.DAE" TAB
+   "art/shapes/Cheetah/Cheetah_Body.DAE" TAB
+   "art/shapes/weapons/Turret/Turret_Legs.DAE" TAB
+   "art/shapes/weapons/Ryder/FP_Ryder.DAE" TAB
+   "art/shapes/weapons/Grenade/grenade.dae" TAB
+   "art/shapes/teleporter/teleporter.DAE" );
+$AnimCompressionReport::rotTol = getCommandLineArg( "-rotTol", 0.1 );
+$AnimCompressionReport::transTol = getCommandLineArg( "-transTol", 0.001 );
+$AnimCompressionReport::iterations = getCommandLineArg( "-iterations", 100 );
+
+initHeadless();
+
+for ( %i = 0; %i < getFieldCount( $AnimCompressionReport::shapes ); %i++ )
+{
+   %shape = getField( $AnimCompressionReport::shapes, %i );
+
+   // The shape's constructor adds sequences from other files.
+   %constructor = filePath( %shape ) @ "/" @ fileBase( %shape ) @ ".cs";
+   if ( isFile( %constructor ) )
+      exec( %constructor );
+
+   reportAnimationCompression( %shape,
+      $AnimCompressionReport::rotTol, $AnimCompressionReport::transTol,
+      $AnimCompressionReport::iterations );
+}
+
+quit();
@@ -54,12 +54,8 @@ function messageTeamExcept(%client, %msgType, %msgString, %a1, %a2, %a3, %a4, %a
 
 function messageAll(%msgType, %msgString, %a1, %a2, %a3, %a4, %a5, %a6, %a7, %a8, %a9, %a10, %a11, %a12, %a13)
 {
-   %count = ClientGroup.getCount();
-   for(%cl = 0; %cl < %count; %cl++)
-   {
-      %client = ClientGroup.getObject(%cl);
-      messageClient(%client, %msgType, %msgString, %a1, %a2, %a3, %a4, %a5, %a6, %a7, %a8, %a9, %a10, %a11, %a12, %a13);
-   }
+   // Packs the message once for all clients.
+   commandToAllClients('ServerMessage', %msgType, %msgString, %a1, %a2, %a3, %a4, %a5, %a6, %a7, %a8, %a9, %a10, %a11, %a12, %a13);
 }
 
 function messageAllExcept(%client, %team, %msgtype, %msgString, %a1, %a2, %a3, %a4, %a5, %a6, %a7, %a8, %a9, %a10, %a11, %a12, %a13)
@@ -0,0 +1,49 @@
+// Shared setup for the headless entry scripts: loadTest.cs, skinBenchmark.cs,
+// animCompressionReport.cs and shapeLoadBenchmark.cs.
+//
+// Each is run in place of main.cs, as in "<executable> skinBenchmark.cs -threads 4",
+// and execs this file first.  Nothing of the game is loaded; the scripts only
+// use the engine functions they need.
+
+// Return the value following %name on the command line, or %default if
+// %name isn't given.
+function getCommandLineArg( %name, %default )
+{
+   for ( %i = 1; %i < $Game::argc - 1; %i++ )
+   {
+      if ( $Game::argv[%i] $= %name )
+         return $Game::argv[%i + 1];
+   }
+   return %default;
+}
+
+// Return all the values following %name on the command line as a tab
+// separated list, or %default if %name isn't given.
+function getCommandLineArgs( %name, %default )
+{
+   %values = "";
+   for ( %i = 1; %i < $Game::argc - 1; %i++ )
+   {
+      if ( $Game::argv[%i] $= %name )
+         %values = trim( %values TAB $Game::argv[%i + 1] );
+   }
+   return %values $= "" ? %default : %values;
+}
+
+// Return true if the flag %name is on the command line.
+function hasCommandLineArg( %name )
+{
+   for ( %i = 1; %i < $Game::argc; %i++ )
+   {
+      if ( $Game::argv[%i] $= %name )
+         return true;
+   }
+   return false;
+}
+
+// Log to the console and file only and create the Null GFX device.
+function initHeadless()
+{
+   setLogMode(2);
+   GFXInit::createNullDevice();
+}
@@ -0,0 +1,59 @@
+// Headless load-test client (TORQUE_LOADTEST builds), see headless.cs.
+//
+// Usage: <executable> loadTest.cs [-address IP:host:port] [-clients N] [-duration seconds]
+//
+// Connects N simulated clients to a running dedicated server and prints
+// bandwidth, ghost and packet loss statistics every few seconds.
+
+exec( "./headless.cs" );
+
+$LoadTest::address = getCommandLineArg( "-address", "IP:127.0.0.1:28000" );
+$LoadTest::clients = getCommandLineArg( "-clients", 16 );
+$LoadTest::duration = getCommandLineArg( "-duration", 0 );
+
+initHeadless();
+sfxCreateDevice( "Null", "SFX Null Device", false, -1 );
+setNetPort(0);
+
+// Mission download handshake.  These run with the simulated client as the
+// connection to the server, so commandToServer() answers on the right one.
+function clientCmdMissionStartPhase1( %seq, %missionName, %musicTrack )
+{
+   commandToServer( 'MissionStartPhase1Ack', %seq );
+}
+
+function clientCmdMissionStartPhase2( %seq, %missionName )
+{
+   commandToServer( 'MissionStartPhase2Ack', %seq, "" );
+}
+
+function clientCmdMissionStartPhase3( %seq, %missionName )
+{
+   commandToServer( 'MissionStartPhase3Ack', %seq );
+}
+
+function onDataBlockObjectReceived( %index, %total ) {}
+function onGhostAlwaysStarted( %ghostCount ) {}
+function onGhostAlwaysObjectReceived() {}
+
+function GameConnection::onConnectionAccepted( %this ) {}
+
+function GameConnection::onConnectionDropped( %this, %msg )
+{
+   warn( "LoadTest: client" SPC %this SPC "dropped:" SPC %msg );
+}
+
+function GameConnection::onConnectRequestRejected( %this, %msg )
+{
+   warn( "LoadTest: client" SPC %this SPC "rejected:" SPC %msg );
+}
+
+new LoadTest( ServerLoad )
+{
+   address = $LoadTest::address;
+   numClients = $LoadTest::clients;
+};
+ServerLoad.start();
+
+if ( $LoadTest::duration > 0 )
+   schedule( $LoadTest::duration * 1000, 0, "quit" );
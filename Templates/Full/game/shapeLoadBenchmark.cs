@@ -0,0 +1,21 @@
+// Headless shape loading benchmark, see headless.cs.
+//
+// Usage: <executable> shapeLoadBenchmark.cs [-path directory] [-streamed] [-iterations N]
+//
+// Loads every DTS file under a directory and prints the wall time and the
+// peak resident set size.  Shapes are memory mapped unless -streamed is
+// given; the peak only grows within a process, so compare the two modes in
+// separate runs.  Without -path, loads the shapes shipped with the template.
+
+exec( "./headless.cs" );
+
+$ShapeLoadBenchmark::path = getCommandLineArg( "-path", "art/shapes" );
+$ShapeLoadBenchmark::mapped = !hasCommandLineArg( "-streamed" );
+$ShapeLoadBenchmark::iterations = getCommandLineArg( "-iterations", 1 );
+
+initHeadless();
+
+benchmarkShapeLoading( $ShapeLoadBenchmark::path, $ShapeLoadBenchmark::mapped,
+   $ShapeLoadBenchmark::iterations );
+
+quit();
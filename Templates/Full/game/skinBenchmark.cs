@@ -0,0 +1,20 @@
+// Headless skinning benchmark, see headless.cs.
+//
+// Usage: <executable> skinBenchmark.cs [-shape path] [-instances N] [-iterations N] [-threads N]
+//
+// Skins N animated instances of a shape with the Null GFX device and prints
+// the skinned vertices per second for each thread count up to -threads.
+
+exec( "./headless.cs" );
+
+$SkinBenchmark::shape = getCommandLineArg( "-shape", "art/shapes/actors/Soldier/soldier_rigged.DAE" );
+$SkinBenchmark::instances = getCommandLineArg( "-instances", 64 );
+$SkinBenchmark::iterations = getCommandLineArg( "-iterations", 50 );
+$SkinBenchmark::threads = getCommandLineArg( "-threads", 0 );
+
+initHeadless();
+
+benchmarkSkinning( $SkinBenchmark::shape, $SkinBenchmark::instances,
+   $SkinBenchmark::iterations, $SkinBenchmark::threads );
+
+quit();
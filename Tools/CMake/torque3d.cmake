@@ -58,6 +58,8 @@ option(TORQUE_HIFI "HIFI? support" OFF)
 mark_as_advanced(TORQUE_HIFI)
 option(TORQUE_EXTENDED_MOVE "Extended move support" OFF)
 mark_as_advanced(TORQUE_EXTENDED_MOVE)
+option(TORQUE_LOADTEST "Headless load-test client" OFF)
+mark_as_advanced(TORQUE_LOADTEST)
 option(TORQUE_NAVIGATION "Enable Navigation module" OFF)
 #mark_as_advanced(TORQUE_NAVIGATION)
 if(WIN32)
@@ -66,6 +68,9 @@ if(WIN32)
 else()
 	set(TORQUE_OPENGL ON) # we need OpenGL to render on Linux/Mac
 	option(TORQUE_DEDICATED "Torque dedicated" OFF)
+	if(TORQUE_LOADTEST)
+		set(TORQUE_DEDICATED ON) # the load-test client runs headless
+	endif()
 endif()
 
 #Oculus VR
@@ -158,6 +163,7 @@ addPath("${srcDir}/sfx")
 addPath("${srcDir}/component")
 addPath("${srcDir}/component/interfaces")
 addPath("${srcDir}/console")
+addPath("${srcDir}/console/test")
 addPath("${srcDir}/core")
 addPath("${srcDir}/core/stream")
 addPath("${srcDir}/core/strings")
@@ -170,6 +176,7 @@ addPath("${srcDir}/core/util/zip/unitTests")
 addPath("${srcDir}/core/util/zip/compressors")
 addPath("${srcDir}/i18n")
 addPath("${srcDir}/sim")
+addPath("${srcDir}/sim/test")
 #addPath("${srcDir}/unit/tests")
 addPath("${srcDir}/unit")
 addPath("${srcDir}/util")
@@ -216,6 +223,7 @@ addPath("${srcDir}/lighting")
 addPath("${srcDir}/lighting/common")
 addPath("${srcDir}/renderInstance")
 addPath("${srcDir}/scene")
+addPath("${srcDir}/scene/test")
 addPath("${srcDir}/scene/culling")
 addPath("${srcDir}/scene/zones")
 addPath("${srcDir}/scene/mixin")
@@ -226,6 +234,7 @@ addPath("${srcDir}/forest")
 addPath("${srcDir}/forest/ts")
 addPath("${srcDir}/ts")
 addPath("${srcDir}/ts/arch")
+addPath("${srcDir}/ts/test")
 addPath("${srcDir}/physics")
 addPath("${srcDir}/gui/3d")
 addPath("${srcDir}/postFx")
@@ -238,6 +247,8 @@ addPath("${srcDir}/T3D/physics")
 addPath("${srcDir}/T3D/decal")
 addPath("${srcDir}/T3D/sfx")
 addPath("${srcDir}/T3D/gameBase")
+addPath("${srcDir}/T3D/gameBase/test")
+addPath("${srcDir}/T3D/test")
 addPath("${srcDir}/T3D/turret")
 addPath("${srcDir}/main/")
 addPathRec("${srcDir}/ts/collada")
@@ -327,6 +338,11 @@ else()
     addPath("${srcDir}/T3D/gameBase/std")
 endif()
 
+if(TORQUE_LOADTEST)
+    addPath("${srcDir}/T3D/gameBase/loadTest")
+    addDef(TORQUE_LOADTEST)
+endif()
+
 if(TORQUE_NAVIGATION)
    include( "modules/module_navigation.cmake" )
 endif()